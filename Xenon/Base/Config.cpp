@@ -120,9 +120,12 @@ void _debug::from_toml(const toml::value &value) {
   startHalted = toml::find_or<bool>(value, "StartHalted", startHalted);
   softHaltOnAssertions = toml::find_or<bool>(value, "SoftHaltOnAssertions", softHaltOnAssertions);
   autoContinueOnGuestAssertion = toml::find_or<bool>(value, "AutoContinueOnGuestAssertion", autoContinueOnGuestAssertion);
-#ifdef DEBUG_BUILD
   createTraceFile = toml::find_or<bool>(value, "CreateTraceFile", createTraceFile);
-#endif
+  traceRegisters = toml::find_or<bool>(value, "TraceRegisters", traceRegisters);
+  traceMemory = toml::find_or<bool>(value, "TraceMemory", traceMemory);
+  guestProfilerRate = toml::find_or<u32&>(value, "GuestProfilerRate", guestProfilerRate);
+  guestProfilerSymbols = toml::find_or<std::string>(value, "GuestProfilerSymbols", guestProfilerSymbols);
+  jitPerfMap = toml::find_or<bool>(value, "JITPerfMap", jitPerfMap);
 }
 void _debug::to_toml(toml::value &value) {
   value["HaltOnRead"].comments().clear();
@@ -147,12 +150,26 @@ void _debug::to_toml(toml::value &value) {
   value["AutoContinueOnGuestAssertion"].comments().clear();
   value["AutoContinueOnGuestAssertion"] = autoContinueOnGuestAssertion;
   value["AutoContinueOnGuestAssertion"].comments().push_back("# Automatically continues on guest assertion");
-#ifdef DEBUG_BUILD
   value["CreateTraceFile"].comments().clear();
   value["CreateTraceFile"] = createTraceFile;
-  value["CreateTraceFile"].comments().push_back("# Creates a trace file with every single jump/bc opcode");
-  value["CreateTraceFile"].comments().push_back("# Note: This can create an log file of up to 20Gb without any limit");
-#endif
+  value["CreateTraceFile"].comments().push_back("# Records a compressed binary trace of executed instructions, exceptions, TLB fills and MMIO to xenon.xtrace");
+  value["CreateTraceFile"].comments().push_back("# in the log directory. xenon-trace converts it to text or queries it");
+  value["TraceRegisters"].comments().clear();
+  value["TraceRegisters"] = traceRegisters;
+  value["TraceRegisters"].comments().push_back("# Also records the GPRs every instruction changed");
+  value["TraceMemory"].comments().clear();
+  value["TraceMemory"] = traceMemory;
+  value["TraceMemory"].comments().push_back("# Also records the effective and real address of every data access");
+  value["GuestProfilerRate"].comments().clear();
+  value["GuestProfilerRate"] = guestProfilerRate;
+  value["GuestProfilerRate"].comments().push_back("# Samples every guest hardware thread's PC this many times a second, 0 disables it");
+  value["GuestProfilerRate"].comments().push_back("# Hot functions are logged and folded stacks written to the log directory on shutdown");
+  value["GuestProfilerSymbols"].comments().clear();
+  value["GuestProfilerSymbols"] = guestProfilerSymbols;
+  value["GuestProfilerSymbols"].comments().push_back("# ELF or map file (address name per line, nm or XDK linker map) to name sampled addresses with");
+  value["JITPerfMap"].comments().clear();
+  value["JITPerfMap"] = jitPerfMap;
+  value["JITPerfMap"].comments().push_back("# Describes JIT blocks in /tmp/perf-<pid>.map and /tmp/jit-<pid>.dump so Linux perf can attribute samples to them");
 }
 bool _debug::verify_toml(toml::value &value) {
   to_toml(value);
@@ -162,9 +179,12 @@ bool _debug::verify_toml(toml::value &value) {
   cache_value(startHalted);
   cache_value(softHaltOnAssertions);
   cache_value(autoContinueOnGuestAssertion);
-#ifdef DEBUG_BUILD
   cache_value(createTraceFile);
-#endif
+  cache_value(traceRegisters);
+  cache_value(traceMemory);
+  cache_value(guestProfilerRate);
+  cache_value(guestProfilerSymbols);
+  cache_value(jitPerfMap);
   from_toml(value);
   verify_value(haltOnReadAddress);
   verify_value(haltOnWriteAddress);
@@ -172,9 +192,12 @@ bool _debug::verify_toml(toml::value &value) {
   verify_value(startHalted);
   verify_value(softHaltOnAssertions);
   verify_value(autoContinueOnGuestAssertion);
-#ifdef DEBUG_BUILD
   verify_value(createTraceFile);
-#endif
+  verify_value(traceRegisters);
+  verify_value(traceMemory);
+  verify_value(guestProfilerRate);
+  verify_value(guestProfilerSymbols);
+  verify_value(jitPerfMap);
   return true;
 }
 
@@ -187,6 +210,7 @@ void _smc::from_toml(const toml::value &value) {
 #endif
   socketIp = toml::find_or<std::string>(value, "SocketIP", socketIp);
   socketPort = toml::find_or<u16&>(value, "SocketPort", socketPort);
+  uartFile = toml::find_or<std::string>(value, "UARTFile", uartFile);
   // Ensure it's lowercase
   uartSystem = Base::ToLower(uartSystem);
 }
@@ -209,6 +233,7 @@ void _smc::to_toml(toml::value &value) {
   value["UARTSystem"].comments().push_back("# vcom is vCOM, only present on Windows");
   value["UARTSystem"].comments().push_back("# socket is Socket, available via Netcat/Socat (ex, nc64 -Lp 7000)");
   value["UARTSystem"].comments().push_back("# print is Printf, directly to log");
+  value["UARTSystem"].comments().push_back("# file writes everything the console sends to UARTFile");
   value["UARTSystem"].comments().push_back("# null is no UART driver");
 #ifdef _WIN32
   value["COMPort"].comments().clear();
@@ -223,6 +248,9 @@ void _smc::to_toml(toml::value &value) {
   value["SocketPort"].comments().clear();
   value["SocketPort"] = socketPort;
   value["SocketPort"].comments().push_back("# Socket Port, which port the UART netcat/socat implementation listens for");
+  value["UARTFile"].comments().clear();
+  value["UARTFile"] = uartFile;
+  value["UARTFile"].comments().push_back("# File the 'file' UART system writes to");
 }
 bool _smc::verify_toml(toml::value &value) {
   to_toml(value);
@@ -234,6 +262,7 @@ bool _smc::verify_toml(toml::value &value) {
 #endif
   cache_value(socketIp);
   cache_value(socketPort);
+  cache_value(uartFile);
   from_toml(value);
   verify_value(avPackType);
   verify_value(powerOnReason);
@@ -243,6 +272,7 @@ bool _smc::verify_toml(toml::value &value) {
 #endif
   verify_value(socketIp);
   verify_value(socketPort);
+  verify_value(uartFile);
   return true;
 }
 
@@ -324,18 +354,30 @@ bool _xcpu::verify_toml(toml::value &value) {
 
 void _xgpu::from_toml(const toml::value &value) {
   internal.from_toml("Internal", value);
+  frameDumpPath = toml::find_or<std::string>(value, "FrameDumpPath", frameDumpPath);
+  frameDumpFormat = toml::find_or<std::string>(value, "FrameDumpFormat", frameDumpFormat);
 }
 void _xgpu::to_toml(toml::value &value) {
   value["Internal"].comments().clear();
   internal.to_toml(value["Internal"]);
   value["Internal"].comments().push_back("# Internal Resolution (The width of what XeLL uses, do not modify)");
+  value["FrameDumpPath"].comments().clear();
+  value["FrameDumpPath"] = frameDumpPath;
+  value["FrameDumpPath"].comments().push_back("# Writes every changed frame to this directory, untiled on the CPU (none is disabled)");
+  value["FrameDumpFormat"].comments().clear();
+  value["FrameDumpFormat"] = frameDumpFormat;
+  value["FrameDumpFormat"].comments().push_back("# Frame dump format (PNG, Raw). Raw is RGBA8 with no header");
 }
 bool _xgpu::verify_toml(toml::value &value) {
   to_toml(value);
   cache_value(internal);
+  cache_value(frameDumpPath);
+  cache_value(frameDumpFormat);
   from_toml(value);
   verify_value(internal.width);
   verify_value(internal.height);
+  verify_value(frameDumpPath);
+  verify_value(frameDumpFormat);
   return true;
 }
 
@@ -343,9 +385,13 @@ void _filepaths::from_toml(const toml::value &value) {
   fuses = toml::find_or<std::string>(value, "Fuses", fuses);
   oneBl = toml::find_or<std::string>(value, "OneBL", oneBl);
   nand = toml::find_or<std::string>(value, "Nand", nand);
+  nandMapping = toml::find_or<std::string>(value, "NandMapping", nandMapping);
+  nandOverlay = toml::find_or<std::string>(value, "NandOverlay", nandOverlay);
   oddImage = toml::find_or<std::string>(value, "ODDImage", oddImage);
   dvdKeyPath = toml::find_or<std::string>(value, "DVDKeyPath", dvdKeyPath);
   hddImage = toml::find_or<std::string>(value, "HDDImage", hddImage);
+  hddOverlay = toml::find_or<std::string>(value, "HDDOverlay", hddOverlay);
+  hddOverlayOnExit = toml::find_or<std::string>(value, "HDDOverlayOnExit", hddOverlayOnExit);
   elfBinary = toml::find_or<std::string>(value, "ElfBinary", elfBinary);
   instrTestsPath = toml::find_or<std::string>(value, "InstrTestsPath", instrTestsPath);
   instrTestsBinPath = toml::find_or<std::string>(value, "InstrTestsBinPath", instrTestsBinPath);
@@ -353,18 +399,26 @@ void _filepaths::from_toml(const toml::value &value) {
 void _filepaths::to_toml(toml::value &value) {
   value.comments().clear();
   value.comments().push_back("# Only Fuses, OneBL, and Nand are required");
+  value.comments().push_back("# NandMapping is how Nand is mapped: Private (NAND writes are lost on exit) or Shared (NAND writes are written back to Nand)");
+  value.comments().push_back("# NandOverlay is a copy-on-write delta file that keeps NAND writes across runs with a Private mapping. 'none' to disable");
   value.comments().push_back("# ElfBinary is used in the elf loader");
   value.comments().push_back("# ODDImage is Optical Disc Drive Image, takes an ISO file for Linux");
   value.comments().push_back("# DVDKeyPath is the Optical Disc Drive Key, used for auth with Xbox 360 HV routines");
   value.comments().push_back("# HDDImage is the Hard Drive Disc Image, takes an Xbox360 Formatted (FATX) HDD image for the Xbox System/Linux storage purposes");
+  value.comments().push_back("# HDDOverlay is a copy-on-write delta file for HDDImage, the image is then only opened read-only. 'none' to disable");
+  value.comments().push_back("# HDDOverlayOnExit is what to do with the overlay on exit: Keep, Commit (merge into HDDImage) or Discard");
   value.comments().push_back("# InstrTestsPath is the base path for instruction test files (.s) for use in the test runner");
   value.comments().push_back("# InstrTestsBinPath is the path for the generated binary instruction test files (.bin)");
   value["Fuses"] = fuses;
   value["OneBL"] = oneBl;
   value["Nand"] = nand;
+  value["NandMapping"] = nandMapping;
+  value["NandOverlay"] = nandOverlay;
   value["ODDImage"] = oddImage;
   value["DVDKeyPath"] = dvdKeyPath;
   value["HDDImage"] = hddImage;
+  value["HDDOverlay"] = hddOverlay;
+  value["HDDOverlayOnExit"] = hddOverlayOnExit;
   value["ElfBinary"] = elfBinary;
   value["InstrTestsPath"] = instrTestsPath;
   value["InstrTestsBinPath"] = instrTestsBinPath;
@@ -374,9 +428,13 @@ bool _filepaths::verify_toml(toml::value &value) {
   cache_value(fuses);
   cache_value(oneBl);
   cache_value(nand);
+  cache_value(nandMapping);
+  cache_value(nandOverlay);
   cache_value(oddImage);
   cache_value(dvdKeyPath);
   cache_value(hddImage);
+  cache_value(hddOverlay);
+  cache_value(hddOverlayOnExit);
   cache_value(elfBinary);
   cache_value(instrTestsPath);
   cache_value(instrTestsBinPath);
@@ -384,9 +442,13 @@ bool _filepaths::verify_toml(toml::value &value) {
   verify_value(fuses);
   verify_value(oneBl);
   verify_value(nand);
+  verify_value(nandMapping);
+  verify_value(nandOverlay);
   verify_value(oddImage);
   verify_value(dvdKeyPath);
   verify_value(hddImage);
+  verify_value(hddOverlay);
+  verify_value(hddOverlayOnExit);
   verify_value(elfBinary);
   verify_value(instrTestsPath);
   verify_value(instrTestsBinPath);
@@ -399,6 +461,7 @@ void _log::from_toml(const toml::value &value) {
   currentLevel = static_cast<Base::Log::Level>(tmpLevel);
   type = toml::find_or<std::string>(value, "Type", type);
   advanced = toml::find_or<bool>(value, "Advanced", advanced);
+  binary = toml::find_or<bool>(value, "Binary", binary);
 #ifdef DEBUG_BUILD
   debugOnly = toml::find_or<bool>(value, "EnableDebugOnly", debugOnly);
 #endif
@@ -419,6 +482,10 @@ void _log::to_toml(toml::value &value) {
   value["Advanced"].comments().clear();
   value["Advanced"] = advanced;
   value["Advanced"].comments().push_back("# Show more details on the log (ex, debug symbols)");
+  value["Binary"].comments().clear();
+  value["Binary"] = binary;
+  value["Binary"].comments().push_back("# Writes a binary log (.xlog) instead of the text one, only async logging skips formatting for it");
+  value["Binary"].comments().push_back("# Convert it to text with xenon-log");
 #ifdef DEBUG_BUILD
   value["EnableDebugOnly"].comments().clear();
   value["EnableDebugOnly"] = debugOnly;
@@ -430,6 +497,7 @@ bool _log::verify_toml(toml::value &value) {
   cache_value(currentLevel);
   cache_value(type);
   cache_value(advanced);
+  cache_value(binary);
 #ifdef DEBUG_BUILD
   cache_value(debugOnly);
 #endif
@@ -437,6 +505,7 @@ bool _log::verify_toml(toml::value &value) {
   verify_value(currentLevel);
   verify_value(type);
   verify_value(advanced);
+  verify_value(binary);
 #ifdef DEBUG_BUILD
   verify_value(debugOnly);
 #endif
@@ -479,6 +548,7 @@ void _network::from_toml(const toml::value &value) {
   enabled = toml::find_or<bool>(value, "Enabled", enabled);
   backend = toml::find_or<std::string>(value, "Backend", backend);
   backendConfig = toml::find_or<std::string>(value, "BackendConfig", backendConfig);
+  captureFile = toml::find_or<std::string>(value, "CaptureFile", captureFile);
   // Ensure lowercase
   backend = Base::ToLower(backend);
 }
@@ -494,22 +564,32 @@ void _network::to_toml(toml::value &value) {
   value["Backend"].comments().push_back("# Network backend type:");
   value["Backend"].comments().push_back("# none - Disabled, packets dropped");
   value["Backend"].comments().push_back("# tap - TAP/TUN virtual network device");
+  value["Backend"].comments().push_back("# switch - Virtual switch shared with other emulator instances on this machine");
+  value["Backend"].comments().push_back("# replay - Plays back the frames the guest received in a capture, on guest time");
   value["BackendConfig"].comments().clear();
   value["BackendConfig"] = backendConfig;
   value["BackendConfig"].comments().push_back("# Backend-specific configuration:");
   value["BackendConfig"].comments().push_back("# For TAP: device name, GUID, or 'auto' to auto-detect");
   value["BackendConfig"].comments().push_back("# Windows: Install TAP-Windows (OpenVPN) or WinTun");
   value["BackendConfig"].comments().push_back("# Linux: Create TAP device with 'sudo ip tuntap add tap0 mode tap'");
+  value["BackendConfig"].comments().push_back("# For switch: segment name ('auto' for the default one), instances on the same segment are linked");
+  value["BackendConfig"].comments().push_back("# Optional shaping: 'name,latency=<microseconds>,loss=<percent>'");
+  value["BackendConfig"].comments().push_back("# For replay: 'capture.pcapng[,loop][,speed=<factor>][,start=boot|tx]'");
+  value["CaptureFile"].comments().clear();
+  value["CaptureFile"] = captureFile;
+  value["CaptureFile"].comments().push_back("# Writes every frame the guest sends and receives to this pcapng file, leave empty to disable");
 }
 bool _network::verify_toml(toml::value &value) {
   to_toml(value);
   cache_value(enabled);
   cache_value(backend);
   cache_value(backendConfig);
+  cache_value(captureFile);
   from_toml(value);
   verify_value(enabled);
   verify_value(backend);
   verify_value(backendConfig);
+  verify_value(captureFile);
   return true;
 }
 
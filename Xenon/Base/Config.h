@@ -104,10 +104,18 @@ inline struct _debug {
   bool softHaltOnAssertions = true;
   // Automatically continue on guest assertion
   bool autoContinueOnGuestAssertion = false;
-#ifdef DEBUG_BUILD
-  // Create a trace file | NOTE: This can create up to a 20GB file
+  // Record a binary execution trace (xenon.xtrace in the log directory), see Core/XCPU/Trace/TraceFormat.h
   bool createTraceFile = false;
-#endif
+  // Also trace the GPRs every instruction changed
+  bool traceRegisters = false;
+  // Also trace the EA/RA of every data access
+  bool traceMemory = false;
+  // Guest PC sampling profiler rate in Hz, 0 disables it
+  u32 guestProfilerRate = 0;
+  // ELF or map file the guest profiler symbolizes samples with, none uses only a loaded ELF
+  std::string guestProfilerSymbols = "none";
+  // Describe JIT blocks to Linux perf (/tmp/perf-<pid>.map and jitdump)
+  bool jitPerfMap = false;
 
   // TOML Conversion
   void to_toml(toml::value &value);
@@ -128,6 +136,7 @@ inline struct _smc {
   // vcom is vCOM, only present on Windows
   // socket is Socket, avaliable via Netcat/socat
   // print is Printf, directly to log
+  // file writes everything the console sends to uartFile
 #ifdef _WIN32
   std::string uartSystem = "vcom";
 #else
@@ -145,6 +154,8 @@ inline struct _smc {
   std::string socketIp = "127.0.0.1";
   // Socket Port to listen on, default is 7000
   u16 socketPort = 7000;
+  // File UART output goes to, when uartSystem is file
+  std::string uartFile = "uart.log";
 
   // TOML Conversion
   void to_toml(toml::value &value);
@@ -169,7 +180,7 @@ inline struct _xcpu {
   // Instruction tests execution
   bool runInstrTests = false;
   // Instruction tests mode
-  u8 instrTestsMode = 0; // See ePPUTestingMode
+  u8 instrTestsMode = 0; // See ePPUTestingMode: 0 Interpreter, 1 JITx86, 2 Differential
   // TOML Conversion
   void to_toml(toml::value &value);
   void from_toml(const toml::value &value);
@@ -182,6 +193,10 @@ inline struct _xcpu {
 inline struct _xgpu {
   // Internal Resolution | The resolution XeLL uses
   _resolution internal{ 1280, 720 };
+  // Directory to dump changed frames to, none is disabled
+  std::string frameDumpPath = "none";
+  // Frame dump format (PNG, Raw)
+  std::string frameDumpFormat = "PNG";
 
   // TOML Conversion
   void to_toml(toml::value &value);
@@ -199,12 +214,20 @@ inline struct _filepaths {
   std::string oneBl = "1bl.bin";
   // nand.bin path
   std::string nand = "nand.bin";
+  // How nand.bin is mapped: "Private" (writes are dropped on exit) or "Shared" (writes land in nand.bin)
+  std::string nandMapping = "Private";
+  // NAND copy-on-write overlay path, used with a private mapping to keep writes across runs. "none" to disable
+  std::string nandOverlay = "none";
   // ODD Image path
   std::string oddImage = "xenon.iso";
   // DVD Key path
   std::string dvdKeyPath = "dvdkey.txt";
   // HDD Image path
   std::string hddImage = "xenonHDD.img";
+  // HDD copy-on-write overlay path, "none" writes straight into the HDD image
+  std::string hddOverlay = "none";
+  // What happens to the overlay on exit: "Keep", "Commit" or "Discard"
+  std::string hddOverlayOnExit = "Keep";
   // Elf binary path
   std::string elfBinary = "kernel.elf";
   // Instruction tests base path.
@@ -252,6 +275,8 @@ inline struct _log {
   std::string type = "async";
   // Show more details on log
   bool advanced = false;
+  // Writes a binary log (.xlog) instead of the text one, messages are formatted when it's read back
+  bool binary = false;
   // Show debug-only log statements
 #ifdef DEBUG_BUILD
   bool debugOnly = false;
@@ -298,11 +323,15 @@ inline struct _highlyExperimental {
 inline struct _network {
   // Enable network bridging
   bool enabled = false;
-  // Network backend type: none, tap
+  // Network backend type: none, tap, switch
   std::string backend = "none";
   // Backend configuration string
   // For TAP: device name or "auto" (e.g., "tap0", "{GUID}", "auto")
+  // For switch: segment name and shaping options (e.g., "lan0", "lan0,latency=2000,loss=1")
+  // For replay: capture file and options (e.g., "boot.pcapng", "boot.pcapng,loop,speed=2,start=tx")
   std::string backendConfig = "auto";
+  // pcapng file every frame the guest sends and receives is written to, empty to disable
+  std::string captureFile = "";
 
   // TOML Conversion
   void to_toml(toml::value &value);
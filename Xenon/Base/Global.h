@@ -64,7 +64,7 @@ namespace XeMain {
 
 extern void Shutdown();
 
-extern void StartCPU();
+extern void StartCPU(bool parked = false);
 
 extern void ShutdownCPU();
 
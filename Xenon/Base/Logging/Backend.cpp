@@ -2,11 +2,14 @@
 /* Copyright 2025 Xenon Emulator Project. All rights reserved. */
 /***************************************************************/
 
+#include <condition_variable>
+#include <cstring>
 #include <fmt/format.h>
 #include <functional>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 
-#include "Base/BoundedQueue.h"
 #include "Base/Hash.h"
 #include "Base/IoFile.h"
 #include "Base/PathUtil.h"
@@ -14,6 +17,7 @@
 #include "Base/Thread.h"
 
 #include "Backend.h"
+#include "BinaryLog.h"
 #include "Log.h"
 #include "LogEntry.h"
 #include "TextFormatter.h"
@@ -23,6 +27,121 @@ namespace Log {
 
 using namespace Base::FS;
 
+// Kinds of records in the thread rings
+enum class eRecordKind : u8 {
+  Padding,    // Fills the end of the buffer when a record doesn't fit there
+  Deferred,   // Format string and captured arguments, formatted by the log thread
+  Formatted,  // Message formatted by the thread that logged it
+  Raw         // Unformatted output (NoFmtMessage)
+};
+
+// Header of every record in a thread ring. Deferred records are followed by the format string if it isn't static
+// (format is nullptr), then by the captured arguments. Formatted and raw records are followed by the message.
+struct sRecordHeader {
+  // Whole record, a multiple of 8 bytes
+  u32 size;
+  eRecordKind kind;
+  Class logClass;
+  Level logLevel;
+  u8 argCount;
+  u32 lineNum;
+  // Size of the format string, or of the message
+  u32 formatSize;
+  // steady_clock ticks
+  u64 timestamp;
+  const char *filename;
+  const char *function;
+  const char *format;
+};
+static_assert(sizeof(sRecordHeader) % 8 == 0);
+
+// Size of each thread's ring, a power of two. Bigger records bypass it
+constexpr u32 threadRingSize = 0x40000;
+
+// Single producer, single consumer byte ring owned by one logging thread. Records are contiguous, when one doesn't
+// fit at the end of the buffer a padding record takes the rest of it.
+class LogRing {
+public:
+  LogRing() : buffer(std::make_unique<u8[]>(threadRingSize)) {}
+
+  // Producer side, returns nullptr if there's no room for size bytes
+  sRecordHeader *Reserve(u32 size) {
+    u64 pos = writePos.load(std::memory_order_relaxed);
+    const u64 tail = threadRingSize - (pos & (threadRingSize - 1));
+    const u64 needed = size + (tail < size ? tail : 0);
+    if (pos + needed - cachedReadPos > threadRingSize) {
+      cachedReadPos = readPos.load(std::memory_order_acquire);
+      if (pos + needed - cachedReadPos > threadRingSize) {
+        return nullptr;
+      }
+    }
+    if (tail < size) {
+      sRecordHeader *padding = at(pos);
+      padding->size = static_cast<u32>(tail);
+      padding->kind = eRecordKind::Padding;
+      pos += tail;
+    }
+    pendingPos = pos + size;
+    return at(pos);
+  }
+
+  void Commit() {
+    writePos.store(pendingPos, std::memory_order_release);
+  }
+
+  u64 Used() const {
+    return writePos.load(std::memory_order_relaxed) - readPos.load(std::memory_order_relaxed);
+  }
+
+  // Consumer side, returns the next record written before end, nullptr if there's none
+  u64 End() const {
+    return writePos.load(std::memory_order_acquire);
+  }
+
+  const sRecordHeader *Peek(u64 end) {
+    while (consumerPos != end) {
+      const sRecordHeader *record = at(consumerPos);
+      if (record->kind != eRecordKind::Padding) {
+        return record;
+      }
+      Pop(record);
+    }
+    return nullptr;
+  }
+
+  void Pop(const sRecordHeader *record) {
+    consumerPos += record->size;
+    readPos.store(consumerPos, std::memory_order_release);
+  }
+
+  // Set once the owning thread exited, the ring is dropped when it's empty
+  std::atomic<bool> orphaned = false;
+
+private:
+  sRecordHeader *at(u64 pos) const {
+    return reinterpret_cast<sRecordHeader*>(buffer.get() + (pos & (threadRingSize - 1)));
+  }
+
+  std::unique_ptr<u8[]> buffer;
+  alignas(64) std::atomic<u64> writePos = 0;
+  u64 pendingPos = 0;
+  u64 cachedReadPos = 0;
+  alignas(64) std::atomic<u64> readPos = 0;
+  u64 consumerPos = 0;
+};
+
+// The calling thread's ring, created along with its first message
+struct sThreadRing {
+  ~sThreadRing() {
+    if (ring) {
+      ring->orphaned.store(true, std::memory_order_release);
+    }
+  }
+  std::shared_ptr<LogRing> ring = {};
+  sRecordHeader *pending = nullptr;
+};
+thread_local sThreadRing threadRing = {};
+
 // Base backend with shell functions
 class BaseBackend {
 public:
@@ -53,6 +172,10 @@ public:
     enabled = enabled_;
   }
 
+  bool IsEnabled() const {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
 private:
   std::atomic<bool> enabled = true;
 };
@@ -103,6 +226,110 @@ private:
   size_t bytesWritten = 0;
 };
 
+// Backend that writes messages with their captured arguments instead of text, see BinaryLog.h
+class BinaryFileBackend {
+public:
+  explicit BinaryFileBackend(const fs::path &filename)
+    : file(filename, FS::FileAccessMode::Write, FS::FileMode::BinaryMode) {
+    sBinaryLogHeader header = {};
+    header.startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+    file.WriteObject(header);
+  }
+
+  ~BinaryFileBackend() {
+    file.Close();
+  }
+
+  // Writes a deferred message with a static format string
+  void WriteMessage(const sRecordHeader &record, const Entry &entry, const u8 *args, const u8 *end) {
+    if (!enabled) {
+      return;
+    }
+    const sSiteKey key = { record.format, record.filename, record.lineNum };
+    auto site = sites.find(key);
+    if (site == sites.end()) {
+      site = sites.emplace(key, static_cast<u32>(sites.size())).first;
+      const std::string_view filename = record.filename ? record.filename : "";
+      const std::string_view function = record.function ? record.function : "";
+      put(eBinaryLogRecord::Site);
+      put(site->second);
+      put(record.lineNum);
+      putString<u16>(filename);
+      putString<u16>(function);
+      putString<u32>({ record.format, record.formatSize });
+    }
+    put(eBinaryLogRecord::Message);
+    put(site->second);
+    put(record.logClass);
+    put(record.logLevel);
+    put(static_cast<u64>(entry.timestamp.count()));
+    put(record.argCount);
+    putString<u32>({ reinterpret_cast<const char*>(args), static_cast<size_t>(end - args) });
+    finish(record.logLevel);
+  }
+
+  // Writes a message that's already formatted, or raw output
+  void WriteText(const Entry &entry) {
+    if (!enabled) {
+      return;
+    }
+    put(eBinaryLogRecord::Text);
+    put(entry.logClass);
+    put(entry.logLevel);
+    put(static_cast<u8>(entry.formatted));
+    put(static_cast<u64>(entry.timestamp.count()));
+    putString<u32>(entry.message);
+    finish(entry.logLevel);
+  }
+
+  void Flush() {
+    file.Flush();
+  }
+
+private:
+  struct sSiteKey {
+    const char *format;
+    const char *filename;
+    u32 lineNum;
+    bool operator==(const sSiteKey &other) const = default;
+  };
+  struct sSiteKeyHash {
+    size_t operator()(const sSiteKey &key) const {
+      return std::hash<const void*>{}(key.format) ^ (std::hash<const void*>{}(key.filename) << 1) ^ key.lineNum;
+    }
+  };
+
+  template <typename T>
+  void put(const T &value) {
+    bytesWritten += file.WriteRaw<u8>(&value, sizeof(value));
+  }
+
+  template <typename Size>
+  void putString(std::string_view string) {
+    const Size size = static_cast<Size>(std::min<size_t>(string.size(), std::numeric_limits<Size>::max()));
+    put(size);
+    bytesWritten += file.WriteRaw<u8>(string.data(), size);
+  }
+
+  void finish(Level level) {
+    // Same limit as the text log
+    constexpr u64 writeLimit = 100_MB;
+    const bool writeLimitExceeded = bytesWritten > writeLimit;
+    if (level >= Level::Error || writeLimitExceeded) {
+      if (writeLimitExceeded) {
+        enabled = false;
+      }
+      file.Flush();
+    }
+  }
+
+  Base::FS::IOFile file;
+  std::unordered_map<sSiteKey, u32, sSiteKeyHash> sites = {};
+  bool enabled = true;
+  size_t bytesWritten = 0;
+};
+
 bool currentlyInitialising = true;
 
 // Static state as a singleton.
@@ -147,42 +374,106 @@ public:
 
   void SetGlobalFilter(const Filter& f) {
     filter = f;
+    for (u8 i = 0; i != static_cast<u8>(Class::Count); ++i) {
+      classThresholds[i].store(filter.GetClassLevel(static_cast<Class>(i)), std::memory_order_relaxed);
+    }
   }
 
   void SetColorConsoleBackendEnabled(bool enabled) {
     colorConsoleBackend->SetEnabled(enabled);
   }
 
-  void PushEntry(Class logClass, Level logLevel, const char *filename, u32 lineNum,
-           const char *function, const std::string &message) {
-
-    if (!filter.CheckMessage(logClass, logLevel)) {
+  void ApplyConfig() {
+    asyncMode.store(Base::JoaatStringHash(Config::log.type) == "async"_jLower, std::memory_order_relaxed);
+    if (!Config::log.binary) {
       return;
     }
+    fs::path binaryFilename = fileBackendFilename;
+    binaryFilename.replace_extension(".xlog");
+    {
+      std::lock_guard lock{ backendMutex };
+      if (binaryBackend) {
+        return;
+      }
+      CleanupOldLogs(binaryFilename.filename().string(), binaryFilename.parent_path());
+      binaryBackend = std::make_unique<BinaryFileBackend>(binaryFilename);
+      // The binary log replaces the text one
+      fileBackend.reset();
+    }
+    LOG_INFO(Log, "Writing a binary log to '{}'", binaryFilename.string());
+  }
 
-    using std::chrono::duration_cast;
-    using std::chrono::microseconds;
-    using std::chrono::steady_clock;
-
-    const Entry entry = {
-      .timestamp = duration_cast<microseconds>(steady_clock::now() - timeOrigin),
-      .logClass = logClass,
-      .logLevel = logLevel,
-      .filename = filename,
-      .lineNum = lineNum,
-      .function = function,
-      .message = message,
-    };
-    if (Base::JoaatStringHash(Config::log.type) == "async"_jLower) {
-      messageQueue.EmplaceWait(entry);
+  void SetLogFile(const fs::path &filename) {
+    std::lock_guard lock{ backendMutex };
+    fileBackendFilename = filename;
+    if (binaryBackend) {
+      fs::path binaryFilename = filename;
+      binaryFilename.replace_extension(".xlog");
+      binaryBackend = std::make_unique<BinaryFileBackend>(binaryFilename);
     } else {
-      ForEachBackend([&entry](BaseBackend* backend) { if (backend) { backend->Write(entry); } });
-      std::fflush(stdout);
+      fileBackend = std::make_unique<FileBackend>(filename);
     }
   }
 
-  void PushEntryNoFmt(Class logClass, Level logLevel, const std::string &message) {
-    if (!filter.CheckMessage(logClass, logLevel)) {
+  // Reserves a record in the calling thread's ring. Returns nullptr when the message has to be written right away,
+  // in sync mode, without a log thread, or when it's too large for the ring.
+  sRecordHeader *BeginRecord(eRecordKind kind, Class logClass, Level logLevel, const char *filename, u32 lineNum,
+                             const char *function, u32 payloadSize) {
+    const u64 size = (sizeof(sRecordHeader) + payloadSize + 7) & ~7ULL;
+    if (!asyncMode.load(std::memory_order_relaxed) || !backendActive.load(std::memory_order_acquire) ||
+      size > threadRingSize / 4) {
+      return nullptr;
+    }
+    if (!threadRing.ring) [[unlikely]] {
+      threadRing.ring = std::make_shared<LogRing>();
+      std::lock_guard lock{ ringsMutex };
+      rings.push_back(threadRing.ring);
+    }
+    LogRing *ring = threadRing.ring.get();
+    sRecordHeader *record = ring->Reserve(static_cast<u32>(size));
+    while (!record) {
+      // The log thread fell behind, wait for room rather than dropping the message
+      Wake();
+      std::this_thread::yield();
+      if (!backendActive.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      record = ring->Reserve(static_cast<u32>(size));
+    }
+    record->size = static_cast<u32>(size);
+    record->kind = kind;
+    record->logClass = logClass;
+    record->logLevel = logLevel;
+    record->argCount = 0;
+    record->lineNum = lineNum;
+    record->formatSize = 0;
+    record->timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    record->filename = filename;
+    record->function = function;
+    record->format = nullptr;
+    threadRing.pending = record;
+    return record;
+  }
+
+  void CommitRecord() {
+    LogRing *ring = threadRing.ring.get();
+    const Level logLevel = threadRing.pending->logLevel;
+    ring->Commit();
+    threadRing.pending = nullptr;
+    if (logLevel >= Level::Error || ring->Used() > threadRingSize / 2) {
+      Wake();
+    }
+  }
+
+  // Logs an already formatted message, or raw output
+  void PushText(eRecordKind kind, Class logClass, Level logLevel, const char *filename, u32 lineNum,
+                const char *function, const std::string_view &message) {
+    sRecordHeader *record = BeginRecord(kind, logClass, logLevel, filename, lineNum, function,
+                                        static_cast<u32>(message.size()));
+    if (record) {
+      record->formatSize = static_cast<u32>(message.size());
+      std::memcpy(record + 1, message.data(), message.size());
+      CommitRecord();
       return;
     }
 
@@ -194,20 +485,23 @@ public:
       .timestamp = duration_cast<microseconds>(steady_clock::now() - timeOrigin),
       .logClass = logClass,
       .logLevel = logLevel,
-      .message = message,
-      .formatted = false
+      .filename = filename,
+      .lineNum = lineNum,
+      .function = function,
+      .message = std::string{ message },
+      .formatted = kind == eRecordKind::Formatted
     };
-    if (Base::JoaatStringHash(Config::log.type) == "async"_jLower) {
-      messageQueue.EmplaceWait(entry);
-    } else {
-      ForEachBackend([&entry](BaseBackend* backend) { if (backend) { backend->Write(entry); } });
-      std::fflush(stdout);
+    std::lock_guard lock{ backendMutex };
+    if (binaryBackend) {
+      binaryBackend->WriteText(entry);
     }
+    ForEachBackend([&entry](BaseBackend* backend) { backend->Write(entry); });
+    std::fflush(stdout);
   }
 
 private:
   Impl(const fs::path &fileBackendFilename, const Filter &filter) :
-    filter(filter) {
+    fileBackendFilename(fileBackendFilename) {
 #ifdef _WIN32
     HANDLE conOut = GetStdHandle(STD_OUTPUT_HANDLE);
     // Get current console mode
@@ -219,52 +513,150 @@ private:
     // Write adjusted mode back
     SetConsoleMode(conOut, mode);
 #endif
+    SetGlobalFilter(filter);
+    asyncMode = Base::JoaatStringHash(Config::log.type) == "async"_jLower;
     colorConsoleBackend = std::make_unique<ColorConsoleBackend>();
     fileBackend = std::make_unique<FileBackend>(fileBackendFilename);
   }
 
   ~Impl() {
     Stop();
+    binaryBackend.reset();
     fileBackend.reset();
     colorConsoleBackend.reset();
   }
 
   void StartBackendThread() {
+    backendActive = true;
     backendThread = std::jthread([this](std::stop_token stopToken) {
       Base::SetCurrentThreadName("[Xe] Log");
-      Entry entry = {};
-      const auto writeLogs = [this, &entry]() {
-        ForEachBackend([&entry](BaseBackend *backend) { backend->Write(entry); });
-      };
       while (!stopToken.stop_requested()) {
-        if (messageQueue.PopWait(entry, stopToken))
-          writeLogs();
-      }
-      // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a
-      // case where a system is repeatedly spamming logs even on close.
-      s32 maxLogsToWrite = filter.IsDebug() ? std::numeric_limits<s32>::max() : 100;
-      while (maxLogsToWrite-- > 0) {
-        if (messageQueue.TryPop(entry)) {
-          writeLogs();
-        } else {
-          break;
+        if (!DrainRings()) {
+          // Producers only wake us up for errors and filling rings, everything else waits for the timeout
+          std::unique_lock lock{ wakeMutex };
+          wakeCV.wait_for(lock, stopToken, std::chrono::milliseconds(5),
+            [this] { return wakeRequested.exchange(false, std::memory_order_acq_rel); });
         }
       }
+      // Write out whatever was logged before stopping, the rings bound it even if something keeps spamming
+      DrainRings();
     });
   }
 
   void StopBackendThread() {
+    // Messages logged from now on are written by their own threads
+    backendActive = false;
     backendThread.request_stop();
     if (backendThread.joinable()) {
       backendThread.join();
     }
 
+    std::lock_guard lock{ backendMutex };
+    if (binaryBackend) {
+      binaryBackend->Flush();
+    }
     ForEachBackend([](BaseBackend *backend) { backend->Flush(); });
   }
 
+  void Wake() {
+    if (!wakeRequested.exchange(true, std::memory_order_acq_rel)) {
+      wakeCV.notify_one();
+    }
+  }
+
+  // Writes out everything the rings held when called, oldest first across threads.
+  // Returns false if there was nothing to write.
+  bool DrainRings() {
+    {
+      std::lock_guard lock{ ringsMutex };
+      drainList.assign(rings.begin(), rings.end());
+    }
+    drainEnds.resize(drainList.size());
+    for (size_t i = 0; i != drainList.size(); ++i) {
+      drainEnds[i] = drainList[i]->End();
+    }
+    bool wrote = false;
+    {
+      std::lock_guard lock{ backendMutex };
+      while (true) {
+        const sRecordHeader *oldest = nullptr;
+        LogRing *oldestRing = nullptr;
+        for (size_t i = 0; i != drainList.size(); ++i) {
+          const sRecordHeader *record = drainList[i]->Peek(drainEnds[i]);
+          if (record && (!oldest || record->timestamp < oldest->timestamp)) {
+            oldest = record;
+            oldestRing = drainList[i].get();
+          }
+        }
+        if (!oldest) {
+          break;
+        }
+        WriteRecord(*oldest);
+        oldestRing->Pop(oldest);
+        wrote = true;
+      }
+    }
+    if (wrote) {
+      std::fflush(stdout);
+    }
+    drainList.clear();
+    // Forget the rings of threads that exited once they're empty
+    std::lock_guard lock{ ringsMutex };
+    std::erase_if(rings, [](const std::shared_ptr<LogRing> &ring) {
+      return ring->orphaned.load(std::memory_order_acquire) && ring->Used() == 0;
+    });
+    return wrote;
+  }
+
+  // Formats a record (when there's a text backend to write it to) and hands it to the backends.
+  // Runs on the log thread with backendMutex held.
+  void WriteRecord(const sRecordHeader &record) {
+    const u8 *payload = reinterpret_cast<const u8*>(&record + 1);
+    const u8 *end = reinterpret_cast<const u8*>(&record) + record.size;
+    const bool textOutput = colorConsoleBackend->IsEnabled() || fileBackend;
+    const bool deferred = record.kind == eRecordKind::Deferred;
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    entry.timestamp = duration_cast<microseconds>(
+      std::chrono::steady_clock::duration(record.timestamp) - timeOrigin.time_since_epoch());
+    entry.logClass = record.logClass;
+    entry.logLevel = record.logLevel;
+    entry.filename = record.kind == eRecordKind::Raw ? nullptr : record.filename;
+    entry.lineNum = record.lineNum;
+    entry.function = record.function;
+    entry.formatted = record.kind != eRecordKind::Raw;
+    entry.message.clear();
+    if (deferred) {
+      const u8 *args = payload + (record.format ? 0 : record.formatSize);
+      if (binaryBackend && record.format) {
+        binaryBackend->WriteMessage(record, entry, args, end);
+        if (!textOutput) {
+          return;
+        }
+      }
+      const std::string_view format = record.format ? std::string_view{ record.format, record.formatSize } :
+        std::string_view{ reinterpret_cast<const char*>(payload), record.formatSize };
+      FormatCapturedArgs(entry.message, format, args, end, record.argCount);
+      if (binaryBackend && !record.format) {
+        binaryBackend->WriteText(entry);
+      }
+    } else {
+      entry.message.assign(reinterpret_cast<const char*>(payload), record.formatSize);
+      if (binaryBackend) {
+        binaryBackend->WriteText(entry);
+      }
+    }
+    if (textOutput) {
+      ForEachBackend([this](BaseBackend *backend) { backend->Write(entry); });
+    }
+  }
+
   void ForEachBackend(std::function<void(BaseBackend*)> lambda) {
     lambda(colorConsoleBackend.get());
-    lambda(fileBackend.get());
+    if (fileBackend) {
+      lambda(fileBackend.get());
+    }
   }
 
   static void Deleter(Impl* ptr) {
@@ -274,10 +666,30 @@ private:
   static inline std::unique_ptr<Impl, decltype(&Deleter)> instance{ nullptr, Deleter };
 
   Filter filter;
+  fs::path fileBackendFilename = {};
+  // Guards the backends, held by the log thread while draining and by threads writing in sync mode
+  std::mutex backendMutex = {};
   std::unique_ptr<ColorConsoleBackend> colorConsoleBackend = {};
   std::unique_ptr<FileBackend> fileBackend = {};
+  std::unique_ptr<BinaryFileBackend> binaryBackend = {};
+
+  // Rings of every thread that logged something
+  std::mutex ringsMutex = {};
+  std::vector<std::shared_ptr<LogRing>> rings = {};
+  // Log thread copies of the above, and where each ring ended when draining started
+  std::vector<std::shared_ptr<LogRing>> drainList = {};
+  std::vector<u64> drainEnds = {};
+  // Log thread entry, reused so its message keeps its allocation
+  Entry entry = {};
+
+  // Cached Config::log.type, see ApplyConfig
+  std::atomic<bool> asyncMode = true;
+  // Set while the log thread runs
+  std::atomic<bool> backendActive = false;
+  std::mutex wakeMutex = {};
+  std::condition_variable_any wakeCV = {};
+  std::atomic<bool> wakeRequested = false;
 
-  MPSCQueue<Entry> messageQueue = {};
   std::chrono::steady_clock::time_point timeOrigin = std::chrono::steady_clock::now();
   std::jthread backendThread;
 };
@@ -427,19 +839,47 @@ void SetColorConsoleBackendEnabled(bool enabled) {
   Impl::Instance().SetColorConsoleBackendEnabled(enabled);
 }
 
+void ApplyConfig() {
+  Impl::Instance().ApplyConfig();
+}
+
+void SetLogFile(const fs::path &logFile) {
+  Impl::Instance().SetLogFile(logFile);
+}
+
+u8 *BeginDeferredMessage(Class logClass, Level logLevel, const char *filename, u32 lineNum,
+                         const char *function, const char *format, u32 formatSize, u8 argCount, u32 payloadSize) {
+  if (currentlyInitialising) [[unlikely]] {
+    return nullptr;
+  }
+  sRecordHeader *record = Impl::Instance().BeginRecord(eRecordKind::Deferred, logClass, logLevel, filename,
+                                                       lineNum, function, payloadSize);
+  if (!record) {
+    return nullptr;
+  }
+  record->format = format;
+  record->formatSize = formatSize;
+  record->argCount = argCount;
+  return reinterpret_cast<u8*>(record + 1);
+}
+
+void CommitDeferredMessage() {
+  Impl::Instance().CommitRecord();
+}
+
 void FmtLogMessageImpl(Class logClass, Level logLevel, const char *filename,
-             u32 lineNum, const char *function, const std::string &format,
+             u32 lineNum, const char *function, std::string_view format,
              const FMT_ARGS &args) {
-  if (!currentlyInitialising) [[likely]] {
-    Impl::Instance().PushEntry(logClass, logLevel, filename, lineNum, function,
-                   VFMT(format, args));
+  if (!currentlyInitialising && IsEnabled(logClass, logLevel)) [[likely]] {
+    Impl::Instance().PushText(eRecordKind::Formatted, logClass, logLevel, filename, lineNum, function,
+                              VFMT(format, args));
   }
 }
 
 void NoFmtMessage(Class logClass, Level logLevel, const std::string &message) {
-  if (!currentlyInitialising) [[likely]] {
-    Impl::Instance().PushEntryNoFmt(logClass, logLevel, message);
+  if (!currentlyInitialising && IsEnabled(logClass, logLevel)) [[likely]] {
+    Impl::Instance().PushText(eRecordKind::Raw, logClass, logLevel, nullptr, 0, nullptr, message);
   }
 }
 } // namespace Log
-} // namespace Base
+} // namespace Base
\ No newline at end of file
@@ -35,5 +35,11 @@ void SetGlobalFilter(const Filter &filter);
 
 void SetColorConsoleBackendEnabled(bool enabled);
 
+/// Applies Config::log to the running logger (sync/async mode, binary log), call once the config is loaded
+void ApplyConfig();
+
+/// Moves the log (binary or text) to a new file, the old one is closed. Forked processes use it to log on their own
+void SetLogFile(const fs::path &logFile);
+
 } // namespace Log
 } // namespace Base
@@ -0,0 +1,125 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include <fstream>
+#include <unordered_map>
+
+#include "BinaryLog.h"
+#include "TextFormatter.h"
+
+namespace Base {
+namespace Log {
+
+namespace {
+
+struct sSite {
+  std::string filename = {};
+  std::string function = {};
+  std::string format = {};
+  u32 lineNum = 0;
+};
+
+template <typename T>
+bool readValue(std::ifstream &file, T &value) {
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+// fileSize bounds the size prefix, so a broken one can't make us allocate more than the file holds
+template <typename Size>
+bool readString(std::ifstream &file, u64 fileSize, std::string &string) {
+  Size size = 0;
+  if (!readValue(file, size) || size > fileSize - static_cast<u64>(file.tellg())) {
+    return false;
+  }
+  string.resize(size);
+  return size == 0 || static_cast<bool>(file.read(string.data(), size));
+}
+
+} // anonymous namespace
+
+bool ReadBinaryLog(const std::filesystem::path &path, const std::function<bool(const Entry &)> &callback) {
+  std::ifstream file{ path, std::ios::binary };
+  sBinaryLogHeader header{};
+  if (!file || !readValue(file, header) || header.magic != XE_BINARY_LOG_MAGIC) {
+    LOG_ERROR(Log, "'{}' isn't a binary log", path.string());
+    return false;
+  }
+  if (header.version != XE_BINARY_LOG_VERSION) {
+    LOG_ERROR(Log, "'{}' is a version {} binary log, expected version {}", path.string(), header.version,
+      XE_BINARY_LOG_VERSION);
+    return false;
+  }
+  std::error_code error{};
+  const u64 fileSize = std::filesystem::file_size(path, error);
+  if (error) {
+    LOG_ERROR(Log, "Couldn't get the size of '{}': {}", path.string(), error.message());
+    return false;
+  }
+
+  std::unordered_map<u32, sSite> sites{};
+  std::string args{};
+  Entry entry{};
+  u8 kind = 0;
+  while (readValue(file, kind)) {
+    u8 logClass = 0, logLevel = 0;
+    u64 timestamp = 0;
+    bool valid = true;
+    switch (static_cast<eBinaryLogRecord>(kind)) {
+    case eBinaryLogRecord::Site: {
+      u32 id = 0;
+      sSite site{};
+      valid = readValue(file, id) && readValue(file, site.lineNum) && readString<u16>(file, fileSize, site.filename) &&
+        readString<u16>(file, fileSize, site.function) && readString<u32>(file, fileSize, site.format);
+      if (valid) {
+        sites[id] = std::move(site);
+        continue;
+      }
+    } break;
+    case eBinaryLogRecord::Message: {
+      u32 id = 0;
+      u8 argCount = 0;
+      valid = readValue(file, id) && readValue(file, logClass) && readValue(file, logLevel) &&
+        readValue(file, timestamp) && readValue(file, argCount) && readString<u32>(file, fileSize, args);
+      const auto site = sites.find(id);
+      if (!valid || site == sites.end()) {
+        valid = false;
+        break;
+      }
+      entry.filename = site->second.filename.c_str();
+      entry.function = site->second.function.c_str();
+      entry.lineNum = site->second.lineNum;
+      entry.formatted = true;
+      entry.message.clear();
+      const u8 *data = reinterpret_cast<const u8*>(args.data());
+      FormatCapturedArgs(entry.message, site->second.format, data, data + args.size(), argCount);
+    } break;
+    case eBinaryLogRecord::Text: {
+      u8 formatted = 0;
+      valid = readValue(file, logClass) && readValue(file, logLevel) && readValue(file, formatted) &&
+        readValue(file, timestamp) && readString<u32>(file, fileSize, entry.message);
+      entry.filename = nullptr;
+      entry.function = nullptr;
+      entry.lineNum = 0;
+      entry.formatted = formatted != 0;
+    } break;
+    default:
+      valid = false;
+      break;
+    }
+    if (!valid || logClass >= static_cast<u8>(Class::Count) || logLevel >= static_cast<u8>(Level::Count)) {
+      LOG_ERROR(Log, "Broken record at offset 0x{:X} of '{}'", static_cast<u64>(file.tellg()), path.string());
+      return false;
+    }
+    entry.timestamp = std::chrono::microseconds{ timestamp };
+    entry.logClass = static_cast<Class>(logClass);
+    entry.logLevel = static_cast<Level>(logLevel);
+    if (!callback(entry)) {
+      break;
+    }
+  }
+  return true;
+}
+
+} // namespace Log
+} // namespace Base
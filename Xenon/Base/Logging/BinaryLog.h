@@ -0,0 +1,51 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+
+#include "LogEntry.h"
+
+//
+// Binary log (.xlog) layout, written by the log thread when Config::log.binary is set.
+// Messages are stored with their captured arguments (see ArgType in Log.h), nothing gets formatted until the
+// log is read back.
+//
+// File: sBinaryLogHeader, then records. Every record is an eBinaryLogRecord byte followed by, little endian:
+//   Site     u32 id, u32 line, u16 size + file, u16 size + function, u32 size + format
+//            defines a call site the first time one of its messages is written
+//   Message  u32 site, u8 class, u8 level, u64 timestamp (us), u8 argCount, u32 size + captured arguments
+//   Text     u8 class, u8 level, u8 formatted, u64 timestamp (us), u32 size + message
+//            messages that were formatted before reaching the log thread, unformatted ones are raw output
+//
+
+#define XE_BINARY_LOG_MAGIC 0x474F4C58 // 'XLOG'
+#define XE_BINARY_LOG_VERSION 1
+
+namespace Base {
+namespace Log {
+
+enum class eBinaryLogRecord : u8 {
+  Site,
+  Message,
+  Text
+};
+
+#pragma pack(push, 1)
+struct sBinaryLogHeader {
+  u32 magic = XE_BINARY_LOG_MAGIC;
+  u32 version = XE_BINARY_LOG_VERSION;
+  // Host time the log started at (ns since the unix epoch)
+  u64 startTime = 0;
+};
+#pragma pack(pop)
+
+/// Reads a binary log back, formatting every message. Stops early when callback returns false.
+/// Returns false if the file isn't a binary log, or it ends with a broken record.
+bool ReadBinaryLog(const std::filesystem::path &path, const std::function<bool(const Entry &)> &callback);
+
+} // namespace Log
+} // namespace Base
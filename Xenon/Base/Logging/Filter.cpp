@@ -164,6 +164,10 @@ bool Filter::CheckMessage(Class logClass, Level level) const {
          static_cast<u8>(classLevels[static_cast<size_t>(logClass)]);
 }
 
+Level Filter::GetClassLevel(Class logClass) const {
+  return classLevels[static_cast<size_t>(logClass)];
+}
+
 bool Filter::IsDebug() const {
   return std::any_of(classLevels.begin(), classLevels.end(), [](const Level& l) {
     return static_cast<u8>(l) <= static_cast<u8>(Level::Debug);
@@ -57,6 +57,9 @@ public:
   /// Matches class/level combination against the filter, returning true if it passed.
   bool CheckMessage(Class logClass, Level level) const;
 
+  /// Returns the minimum level of `logClass`.
+  Level GetClassLevel(Class logClass) const;
+
   /// Returns true if any logging classes are set to debug
   bool IsDebug() const;
 
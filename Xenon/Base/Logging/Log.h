@@ -7,12 +7,28 @@
 #ifndef TOOL
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <fmt/format.h>
 
 #include "Base/Config.h"
 
 #include "LogTypes.h"
 
+// Lowest level compiled in, see Base::Log::Level. Messages below it compile to nothing, arguments included.
+// Defaults to Trace on debug builds and Info otherwise, set XENON_LOG_COMPILE_LEVEL in CMake to change it.
+#ifndef XE_LOG_COMPILE_LEVEL
+#ifdef DEBUG_BUILD
+#define XE_LOG_COMPILE_LEVEL 0
+#else
+#define XE_LOG_COMPILE_LEVEL 2
+#endif
+#endif
+
 namespace Base {
 namespace Log {
 
@@ -24,17 +40,150 @@ constexpr const char* TrimSourcePath(const std::string_view &source) {
   return source.data() + idx;
 }
 
-/// Logs a message to the global logger, using fmt
+/// Lowest level of every class the global filter lets through, mirrors it so filtered
+/// messages are dropped before their arguments are even evaluated
+inline std::array<std::atomic<Level>, static_cast<size_t>(Class::Count)> classThresholds{};
+
+inline bool IsEnabled(Class logClass, Level logLevel) {
+  return static_cast<u8>(logLevel) >=
+         static_cast<u8>(classThresholds[static_cast<size_t>(logClass)].load(std::memory_order_relaxed));
+}
+
+/*
+ * Messages are normally not formatted on the thread logging them. The format string and the arguments are
+ * captured into a ring owned by the calling thread, and the log thread formats them later on.
+ * Every captured argument is an ArgType byte followed by its value:
+ *   String  u32 size, then the characters (std::string, std::string_view, C strings)
+ *   Others  8 bytes, the value zero/sign extended (floats keep their own bit pattern in the low bytes)
+ * Messages with other argument types are formatted right away, like in sync mode.
+ */
+enum class ArgType : u8 {
+  Bool,
+  Char,
+  S64,
+  U64,
+  F32,
+  F64,
+  Pointer,
+  String
+};
+
+template <typename T>
+inline constexpr bool IsStringArg = std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+  std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+template <typename T>
+inline constexpr bool IsIntegerArg = std::is_integral_v<T> && sizeof(T) <= sizeof(u64) &&
+  !std::is_same_v<T, bool> && !std::is_same_v<T, char> && !std::is_same_v<T, wchar_t> &&
+  !std::is_same_v<T, char8_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+template <typename T>
+inline constexpr bool IsScalarArg = std::is_same_v<T, bool> || std::is_same_v<T, char> || IsIntegerArg<T> ||
+  std::is_same_v<T, f32> || std::is_same_v<T, f64> || std::is_same_v<T, const void*> ||
+  std::is_same_v<T, void*> || (std::is_enum_v<T> && sizeof(T) <= sizeof(u64));
+
+/// True if an argument of type T can be captured and formatted later on
+template <typename T>
+inline constexpr bool IsDeferrableArg = IsStringArg<std::decay_t<T>> || IsScalarArg<std::decay_t<T>>;
+
+template <typename T>
+inline std::string_view GetStringArg(const T &arg) {
+  if constexpr (std::is_pointer_v<std::decay_t<T>>) {
+    return arg ? std::string_view{ arg } : std::string_view{};
+  } else {
+    return std::string_view{ arg };
+  }
+}
+
+/// Bytes a captured argument takes
+template <typename T>
+inline u32 GetArgSize(const T &arg) {
+  if constexpr (IsStringArg<std::decay_t<T>>) {
+    return 1 + sizeof(u32) + static_cast<u32>(GetStringArg(arg).size());
+  } else {
+    return 1 + sizeof(u64);
+  }
+}
+
+/// Captures an argument, see ArgType
+template <typename T>
+inline void WriteArg(u8 *&out, const T &arg) {
+  using Type = std::decay_t<T>;
+  if constexpr (IsStringArg<Type>) {
+    const std::string_view string = GetStringArg(arg);
+    const u32 size = static_cast<u32>(string.size());
+    *out++ = static_cast<u8>(ArgType::String);
+    std::memcpy(out, &size, sizeof(size));
+    std::memcpy(out + sizeof(size), string.data(), size);
+    out += sizeof(size) + size;
+  } else {
+    ArgType type = ArgType::U64;
+    u64 bits = 0;
+    if constexpr (std::is_same_v<Type, bool>) {
+      type = ArgType::Bool;
+      bits = arg;
+    } else if constexpr (std::is_same_v<Type, char>) {
+      type = ArgType::Char;
+      bits = static_cast<u8>(arg);
+    } else if constexpr (std::is_same_v<Type, f32> || std::is_same_v<Type, f64>) {
+      type = std::is_same_v<Type, f32> ? ArgType::F32 : ArgType::F64;
+      std::memcpy(&bits, &arg, sizeof(arg));
+    } else if constexpr (std::is_pointer_v<Type>) {
+      type = ArgType::Pointer;
+      bits = reinterpret_cast<uintptr_t>(arg);
+    } else if constexpr (std::is_enum_v<Type>) {
+      using Underlying = std::underlying_type_t<Type>;
+      type = std::is_signed_v<Underlying> ? ArgType::S64 : ArgType::U64;
+      bits = static_cast<u64>(static_cast<Underlying>(arg));
+    } else {
+      type = std::is_signed_v<Type> ? ArgType::S64 : ArgType::U64;
+      bits = static_cast<u64>(arg);
+    }
+    *out++ = static_cast<u8>(type);
+    std::memcpy(out, &bits, sizeof(bits));
+    out += sizeof(bits);
+  }
+}
+
+/// Reserves a record for a message with captured arguments in the calling thread's log ring.
+/// format is nullptr when the format string isn't static, it then has to be copied in front of the arguments.
+/// Returns where the argument bytes go, or nullptr if the message must go through FmtLogMessageImpl instead.
+u8 *BeginDeferredMessage(Class logClass, Level logLevel, const char *filename, u32 lineNum,
+                         const char *function, const char *format, u32 formatSize, u8 argCount, u32 payloadSize);
+
+/// Hands the record started by BeginDeferredMessage over to the log thread
+void CommitDeferredMessage();
+
+/// Logs a message to the global logger, formatting it right away
 void FmtLogMessageImpl(Class logClass, Level logLevel, const char *filename,
-                       u32 lineNum, const char *function, const std::string &format,
+                       u32 lineNum, const char *function, std::string_view format,
                        const FMT_ARGS& args);
 
 /// Logs a message without any formatting
 void NoFmtMessage(Class logClass, Level logLevel, const std::string &message);
 
-template <typename... Args>
+/// LiteralFormat is whether the format was spelled as a string literal at the call site, see LOG_IMPL
+template <bool LiteralFormat, typename Format, typename... Args>
 void FmtLogMessage(Class logClass, Level logLevel, const char *filename, u32 lineNum,
-                   const char *function, const std::string &format, const Args&... args) {
+                   const char *function, const Format &format, const Args&... args) {
+  if constexpr ((IsDeferrableArg<Args> && ...) && sizeof...(Args) <= 0xFF) {
+    // String literals live as long as the program does, anything else (char buffers included) gets copied
+    constexpr bool staticFormat = LiteralFormat && std::is_array_v<Format>;
+    const std::string_view formatView{ format };
+    const u32 payloadSize = (staticFormat ? 0 : static_cast<u32>(formatView.size())) + (GetArgSize(args) + ... + 0);
+    u8 *out = BeginDeferredMessage(logClass, logLevel, filename, lineNum, function,
+                                   staticFormat ? formatView.data() : nullptr,
+                                   static_cast<u32>(formatView.size()), sizeof...(Args), payloadSize);
+    if (out) {
+      if constexpr (!staticFormat) {
+        std::memcpy(out, formatView.data(), formatView.size());
+        out += formatView.size();
+      }
+      (WriteArg(out, args), ...);
+      CommitDeferredMessage();
+      return;
+    }
+  }
   FmtLogMessageImpl(logClass, logLevel, filename, lineNum, function, format,
                     MK_FMT_ARGS(args...));
 }
@@ -42,48 +191,54 @@ void FmtLogMessage(Class logClass, Level logLevel, const char *filename, u32 lin
 } // namespace Log
 } // namespace Base
 
+// Checks the runtime filter before anything else, so filtered messages don't evaluate their arguments.
+// The format comes first in the arguments, so their spelling starts with a quote when it's a string literal.
+#define LOG_IMPL(logClass, logLevel, ...)                                                \
+  (Base::Log::IsEnabled(logClass, logLevel) ?                                            \
+    Base::Log::FmtLogMessage<(#__VA_ARGS__)[0] == '"'>(logClass, logLevel,               \
+                             Base::Log::TrimSourcePath(__FILE__),                        \
+                             __LINE__, __func__, __VA_ARGS__) : void())
+
 // Define the fmt lib macros
 #define LOG_GENERIC(logClass, logLevel, ...)                                             \
-  Base::Log::FmtLogMessage(logClass, logLevel, Base::Log::TrimSourcePath(__FILE__),      \
-                             __LINE__, __func__, __VA_ARGS__)
+  LOG_IMPL(logClass, logLevel, __VA_ARGS__)
+#if XE_LOG_COMPILE_LEVEL <= 0
 #ifdef DEBUG_BUILD
 #define LOG_TRACE(logClass, ...)                                                         \
-if (Config::log.debugOnly)                                                               \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Trace,          \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  (Config::log.debugOnly ?                                                               \
+    LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Trace, __VA_ARGS__) : void())
 #else
-#define LOG_TRACE(logClass, ...) ;
+#define LOG_TRACE(logClass, ...)                                                         \
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Trace, __VA_ARGS__)
+#endif
+#else
+#define LOG_TRACE(logClass, ...) ((void)0)
 #endif
 
-#ifdef DEBUG_BUILD
+#if XE_LOG_COMPILE_LEVEL <= 1
 #define LOG_DEBUG(logClass, ...)                                                         \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Debug,          \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Debug, __VA_ARGS__)
 #else
-#define LOG_DEBUG(logClass, ...) ;
+#define LOG_DEBUG(logClass, ...) ((void)0)
 #endif
+#if XE_LOG_COMPILE_LEVEL <= 2
 #define LOG_INFO(logClass, ...)                                                          \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Info,           \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(logClass, ...) ((void)0)
+#endif
+#if XE_LOG_COMPILE_LEVEL <= 3
 #define LOG_WARNING(logClass, ...)                                                       \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Warning,        \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(logClass, ...) ((void)0)
+#endif
 #define LOG_ERROR(logClass, ...)                                                         \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Error,          \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Error, __VA_ARGS__)
 #define LOG_CRITICAL(logClass, ...)                                                      \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Critical,       \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Critical, __VA_ARGS__)
 #define LOG_XBOX(logClass, ...)                                                          \
-  Base::Log::FmtLogMessage(Base::Log::Class::logClass, Base::Log::Level::Guest,          \
-                           Base::Log::TrimSourcePath(__FILE__), __LINE__, __func__,      \
-                           __VA_ARGS__)
+  LOG_IMPL(Base::Log::Class::logClass, Base::Log::Level::Guest, __VA_ARGS__)
 #else
 
 #include <format>
@@ -21,7 +21,7 @@ struct Entry {
   Level logLevel = {};
   const char *filename = nullptr;
   u32 lineNum = 0;
-  std::string function = {};
+  const char *function = nullptr;
   std::string message = {};
   bool formatted = true;
 };
@@ -1,6 +1,10 @@
 /***************************************************************/
 /* Copyright 2025 Xenon Emulator Project. All rights reserved. */
 /***************************************************************/
+#include <cstring>
+#include <iterator>
+#include <fmt/args.h>
+
 #include "Base/Assert.h"
 #include "Base/Config.h"
 
@@ -12,6 +16,63 @@
 namespace Base {
 namespace Log {
 
+bool FormatCapturedArgs(std::string &out, std::string_view format, const u8 *args, const u8 *end, u8 argCount) {
+  fmt::dynamic_format_arg_store<fmt::format_context> store{};
+  store.reserve(argCount, 0);
+  for (u8 i = 0; i != argCount; ++i) {
+    if (args >= end) {
+      return false;
+    }
+    const ArgType type = static_cast<ArgType>(*args++);
+    if (type == ArgType::String) {
+      u32 size = 0;
+      if (end - args < static_cast<ptrdiff_t>(sizeof(size))) {
+        return false;
+      }
+      std::memcpy(&size, args, sizeof(size));
+      args += sizeof(size);
+      if (static_cast<u64>(end - args) < size) {
+        return false;
+      }
+      // Views aren't copied by the store, they point into the record until the message is formatted
+      store.push_back(fmt::string_view{ reinterpret_cast<const char*>(args), size });
+      args += size;
+      continue;
+    }
+    u64 bits = 0;
+    if (end - args < static_cast<ptrdiff_t>(sizeof(bits))) {
+      return false;
+    }
+    std::memcpy(&bits, args, sizeof(bits));
+    args += sizeof(bits);
+    switch (type) {
+    case ArgType::Bool: store.push_back(bits != 0); break;
+    case ArgType::Char: store.push_back(static_cast<char>(bits)); break;
+    case ArgType::S64: store.push_back(static_cast<s64>(bits)); break;
+    case ArgType::U64: store.push_back(bits); break;
+    case ArgType::F32: {
+      f32 value = 0.f;
+      std::memcpy(&value, &bits, sizeof(value));
+      store.push_back(value);
+    } break;
+    case ArgType::F64: {
+      f64 value = 0.0;
+      std::memcpy(&value, &bits, sizeof(value));
+      store.push_back(value);
+    } break;
+    case ArgType::Pointer: store.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(bits))); break;
+    default: return false;
+    }
+  }
+  try {
+    fmt::vformat_to(std::back_inserter(out), fmt::string_view{ format.data(), format.size() }, store);
+  } catch (const fmt::format_error &error) {
+    out.append(FMT("<format error '{}' in \"{}\">", error.what(), format));
+    return false;
+  }
+  return true;
+}
+
 std::string FormatLogMessage(const Entry &entry) {
   const char *className = GetLogClassName(entry.logClass);
   const char *levelName = GetLevelName(entry.logLevel);
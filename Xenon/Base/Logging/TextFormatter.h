@@ -12,6 +12,10 @@ namespace Log {
 
 struct Entry;
 
+/// Formats a message from its format string and captured arguments (see ArgType in Log.h), appending it to `out`.
+/// Returns false if the arguments are malformed or don't match the format string.
+bool FormatCapturedArgs(std::string &out, std::string_view format, const u8 *args, const u8 *end, u8 argCount);
+
 /// Formats a log entry into the provided text buffer.
 std::string FormatLogMessage(const Entry &entry);
 
@@ -0,0 +1,112 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "Types.h"
+
+namespace Base {
+
+// Small table of threads waiting for a range of addresses (guest memory, register indices) to be written.
+// Writers call Notify on every write, which costs a single relaxed load while nobody is waiting.
+// Notify isn't ordered against the writer's own store, so a waiter also re-checks its predicate
+// every RecheckInterval to recover from a notification that raced with arming.
+class WaitTable {
+public:
+  static constexpr u32 MaxWaiters = 8;
+  static constexpr std::chrono::milliseconds RecheckInterval{ 1 };
+
+  // Blocks until pred() returns true or stop() returns true.
+  // Returns the last result of pred().
+  template <typename Pred, typename Stop>
+  bool WaitUntil(u64 address, u64 size, Pred &&pred, Stop &&stop) {
+    if (pred())
+      return true;
+    u64 sequence = 0;
+    const u32 slot = Arm(address, size, sequence);
+    bool result = false;
+    // pred() runs without the table lock held, writers may notify while holding their own locks
+    while (!(result = pred()) && !stop()) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait_for(lock, RecheckInterval, [&] { return notifySequence != sequence; });
+      sequence = notifySequence;
+    }
+    Disarm(slot);
+    return result;
+  }
+
+  // Called after every write to [address, address + size)
+  void Notify(u64 address, u64 size) {
+    if (armedCount.load(std::memory_order_relaxed) == 0) [[likely]]
+      return;
+    NotifySlow(address, size);
+  }
+
+  // Wakes every waiter so it can re-check its stop condition
+  void WakeAll() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++notifySequence;
+    }
+    cv.notify_all();
+  }
+
+private:
+  struct Waiter {
+    std::atomic<u64> begin = 0;
+    std::atomic<u64> end = 0;
+  };
+
+  u32 Arm(u64 address, u64 size, u64 &sequence) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sequence = notifySequence;
+    for (u32 i = 0; i != MaxWaiters; ++i) {
+      Waiter &waiter = waiters[i];
+      if (waiter.end.load(std::memory_order_relaxed) == 0) {
+        waiter.begin.store(address, std::memory_order_relaxed);
+        waiter.end.store(address + size, std::memory_order_relaxed);
+        armedCount.fetch_add(1, std::memory_order_seq_cst);
+        return i;
+      }
+    }
+    // Table is full, this waiter falls back to the periodic re-check
+    return MaxWaiters;
+  }
+
+  void Disarm(u32 slot) {
+    if (slot == MaxWaiters)
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    waiters[slot].end.store(0, std::memory_order_relaxed);
+    armedCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void NotifySlow(u64 address, u64 size) {
+    const u64 end = address + size;
+    bool hit = false;
+    for (const Waiter &waiter : waiters) {
+      const u64 waiterEnd = waiter.end.load(std::memory_order_relaxed);
+      if (waiterEnd != 0 && address < waiterEnd && waiter.begin.load(std::memory_order_relaxed) < end) {
+        hit = true;
+        break;
+      }
+    }
+    if (hit)
+      WakeAll();
+  }
+
+  std::atomic<u32> armedCount = 0;
+  std::array<Waiter, MaxWaiters> waiters{};
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  u64 notifySequence = 0;
+};
+
+} // namespace Base
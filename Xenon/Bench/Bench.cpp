@@ -0,0 +1,487 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-bench
+// Boots the configured NAND (or an ELF) headless, runs it to a list of milestones and reports how long it took.
+// Milestones are reached in the order given:
+// - post:<code>   The guest wrote this code to the POST bus.
+// - pc:<address>  A PPU thread executed this address. The JIT only sees block entries, use block starts.
+// - instrs:<n>    All PPUs retired n instructions between them.
+// Each milestone can be named, name=kind:value, the report uses the spec otherwise.
+//
+// Example: xenon-bench -elf xell.elf -mode Interpreted,JIT -repeat 5 -milestone cb=post:0x20 xell=post:0xF0
+//
+// Boot once, benchmark from there: -savestate writes a save state as soon as a run reached every milestone,
+// -loadstate starts every run from one instead of booting (milestone times then count from the load).
+// Example: xenon-bench -milestone booted=post:0x7F -savestate booted.xstate
+//          xenon-bench -loadstate booted.xstate -mode Interpreted,JIT -repeat 5 -milestone instrs:500000000
+//
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+
+#include "Base/Hangup.h"
+#include "Base/Param.h"
+#include "Base/Thread.h"
+#include "Core/XeMain.h"
+#include "Core/XCPU/Context/PostBus/PostBus.h"
+#include "Core/XCPU/JIT/PPU_JIT.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(nand, "NAND image to boot, defaults to the configured one");
+PARAM(elf, "ELF binary to load instead of booting the NAND");
+PARAM(mode, "CPU executors to benchmark: Interpreted, JIT, Hybrid. Defaults to the configured one");
+PARAM(milestone, "Milestones in the order they're reached: [name=]post:<code>, [name=]pc:<address>, [name=]instrs:<count>");
+PARAM(repeat, "Runs per executor, defaults to 1");
+PARAM(timeout, "Seconds a run may take before its remaining milestones are given up, defaults to 60");
+PARAM(out, "Path of the JSON report, defaults to xenon-bench.json");
+PARAM(log, "Log level while benchmarking, defaults to Warning");
+PARAM(savestate, "Saves a state here once a run reached every milestone");
+PARAM(loadstate, "Starts every run from this save state instead of booting");
+
+namespace {
+
+  constexpr u32 PPU_COUNT = 3;
+  // How often a run checks for reached milestones
+  constexpr auto POLL_INTERVAL = 1ms;
+
+  enum class eMilestoneKind : u8 {
+    POST,
+    PC,
+    Instrs
+  };
+
+  struct sMilestone {
+    std::string name;
+    eMilestoneKind kind;
+    u64 value;
+  };
+
+  struct sMilestoneResult {
+    bool reached = false;
+    // Since the CPU was started
+    f64 timeMs = 0.0;
+    // Instructions all PPUs retired by then
+    u64 retiredInstrs = 0;
+  };
+
+  struct sRunResult {
+    std::vector<sMilestoneResult> milestones;
+    bool completed = false;
+    f64 wallMs = 0.0;
+    // Time the save state took to load, with -loadstate
+    f64 loadStateMs = 0.0;
+    std::array<u64, PPU_COUNT> retiredInstrs{};
+    std::array<f64, PPU_COUNT> mips{};
+    u64 jitBlocksCompiled = 0;
+    f64 jitCompileMs = 0.0;
+    u64 mmioReads = 0;
+    u64 mmioWrites = 0;
+    u64 interruptsGenerated = 0;
+    u64 interruptsAcknowledged = 0;
+  };
+
+  struct sStatistics {
+    u64 samples = 0;
+    f64 min = 0.0;
+    f64 max = 0.0;
+    f64 mean = 0.0;
+    f64 median = 0.0;
+    f64 stddev = 0.0;
+  };
+
+  // Steady clock time, in ns, every POST code was first written at during the current run. 0 if it wasn't.
+  std::array<std::atomic<u64>, 0x100> postTimes{};
+
+  u64 steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void onPOST(u64 postCode) {
+    if (postCode < postTimes.size()) {
+      u64 unset = 0;
+      postTimes[postCode].compare_exchange_strong(unset, steadyNs(), std::memory_order_relaxed);
+    }
+  }
+
+  // Parses [name=]kind:value
+  bool parseMilestone(const std::string &spec, sMilestone &milestone) {
+    const size_t equal = spec.find('=');
+    const std::string body = equal == std::string::npos ? spec : spec.substr(equal + 1);
+    milestone.name = equal == std::string::npos ? spec : spec.substr(0, equal);
+
+    const size_t colon = body.find(':');
+    if (colon == std::string::npos || colon + 1 == body.size()) {
+      return false;
+    }
+    const std::string kind = body.substr(0, colon);
+    const std::string value = body.substr(colon + 1);
+    char *end = nullptr;
+    milestone.value = strtoull(value.c_str(), &end, 0);
+    if (*end != '\0') {
+      return false;
+    }
+
+    switch (Base::JoaatStringHash(kind)) {
+    case "post"_jLower:
+      milestone.kind = eMilestoneKind::POST;
+      return milestone.value < postTimes.size();
+    case "pc"_jLower:
+      milestone.kind = eMilestoneKind::PC;
+      return milestone.value != 0;
+    case "instrs"_jLower:
+      milestone.kind = eMilestoneKind::Instrs;
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  const char *milestoneKindName(eMilestoneKind kind) {
+    switch (kind) {
+    case eMilestoneKind::POST: return "post";
+    case eMilestoneKind::PC: return "pc";
+    case eMilestoneKind::Instrs: return "instrs";
+    }
+    return "unknown";
+  }
+
+  u64 totalRetiredInstrs(Xe::XCPU::XenonCPU *cpu) {
+    u64 total = 0;
+    for (u8 i = 0; i != PPU_COUNT; ++i) {
+      if (PPU *ppu = cpu->GetPPU(i)) {
+        total += ppu->GetRetiredInstrs();
+      }
+    }
+    return total;
+  }
+
+  // Boots the system once (or loads the state) and waits for every milestone, in order.
+  // savePath is cleared once the state got saved there.
+  sRunResult run(const std::vector<sMilestone> &milestones, std::chrono::seconds timeout, std::string &savePath) {
+    sRunResult result{};
+    result.milestones.resize(milestones.size());
+    for (auto &time : postTimes) {
+      time.store(0, std::memory_order_relaxed);
+    }
+    const u64 mmioReadsBefore = XeMain::rootBus->GetMMIOReads();
+    const u64 mmioWritesBefore = XeMain::rootBus->GetMMIOWrites();
+
+    // The first milestone being a PC must be watched before anything executes
+    size_t current = 0;
+    auto armPCWatch = [&] {
+      if (current < milestones.size() && milestones[current].kind == eMilestoneKind::PC) {
+        XeMain::GetCPU()->WatchPC(milestones[current].value);
+      }
+    };
+    armPCWatch();
+
+    if (PARAM_loadstate.Present()) {
+      const u64 loadNs = steadyNs();
+      if (!XeMain::LoadState(PARAM_loadstate.Get())) {
+        // Nothing else would load either
+        XeRunning = false;
+        return result;
+      }
+      result.loadStateMs = (steadyNs() - loadNs) / 1e6;
+    }
+    const u64 startNs = steadyNs();
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    if (!PARAM_loadstate.Present()) {
+      XeMain::StartCPU();
+    }
+    Xe::XCPU::XenonCPU *cpu = XeMain::GetCPU();
+
+    while (current < milestones.size() && XeRunning && XeMain::CPUStarted && std::chrono::steady_clock::now() < deadline) {
+      const sMilestone &milestone = milestones[current];
+      u64 reachedNs = 0;
+      switch (milestone.kind) {
+      case eMilestoneKind::POST:
+        reachedNs = postTimes[milestone.value].load(std::memory_order_relaxed);
+        break;
+      case eMilestoneKind::PC:
+        reachedNs = cpu->GetPCWatchHitTime();
+        break;
+      case eMilestoneKind::Instrs:
+        if (totalRetiredInstrs(cpu) >= milestone.value) {
+          reachedNs = steadyNs();
+        }
+        break;
+      }
+      if (!reachedNs) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        continue;
+      }
+      sMilestoneResult &reached = result.milestones[current];
+      reached.reached = true;
+      reached.timeMs = (reachedNs - startNs) / 1e6;
+      reached.retiredInstrs = totalRetiredInstrs(cpu);
+      ++current;
+      armPCWatch();
+    }
+    result.completed = current == milestones.size();
+    result.wallMs = (steadyNs() - startNs) / 1e6;
+    if (!XeMain::CPUStarted) {
+      return result;
+    }
+    if (result.completed && !savePath.empty() && XeMain::SaveState(savePath)) {
+      fmt::print("State saved to '{}'\n", savePath);
+      savePath.clear();
+    }
+
+    // Collect everything before the CPU (and its PPUs) get torn down
+    cpu->Halt();
+    for (u8 i = 0; i != PPU_COUNT; ++i) {
+      PPU *ppu = cpu->GetPPU(i);
+      if (!ppu) {
+        continue;
+      }
+      result.retiredInstrs[i] = ppu->GetRetiredInstrs();
+      result.mips[i] = result.wallMs > 0.0 ? result.retiredInstrs[i] / (result.wallMs * 1e3) : 0.0;
+      if (PPU_JIT *jit = ppu->GetPPUJIT()) {
+        result.jitBlocksCompiled += jit->GetStats().blocksCompiled.Get();
+        result.jitCompileMs += jit->GetStats().compileTimeNs.Get() / 1e6;
+      }
+    }
+    result.mmioReads = XeMain::rootBus->GetMMIOReads() - mmioReadsBefore;
+    result.mmioWrites = XeMain::rootBus->GetMMIOWrites() - mmioWritesBefore;
+    result.interruptsGenerated = cpu->GetIICPointer()->GetInterruptsGenerated();
+    result.interruptsAcknowledged = cpu->GetIICPointer()->GetInterruptsAcknowledged();
+    cpu->WatchPC(0);
+
+    XeMain::ShutdownCPU();
+    return result;
+  }
+
+  sStatistics statistics(std::vector<f64> values) {
+    sStatistics stats{};
+    if (values.empty()) {
+      return stats;
+    }
+    std::sort(values.begin(), values.end());
+    stats.samples = values.size();
+    stats.min = values.front();
+    stats.max = values.back();
+    const size_t mid = values.size() / 2;
+    stats.median = values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+    f64 sum = 0.0;
+    for (const f64 value : values) {
+      sum += value;
+    }
+    stats.mean = sum / values.size();
+    f64 variance = 0.0;
+    for (const f64 value : values) {
+      variance += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stddev = values.size() > 1 ? std::sqrt(variance / (values.size() - 1)) : 0.0;
+    return stats;
+  }
+
+  std::string jsonStatistics(const sStatistics &stats) {
+    return fmt::format("{{ \"samples\": {}, \"min\": {:.3f}, \"max\": {:.3f}, \"mean\": {:.3f}, \"median\": {:.3f}, \"stddev\": {:.3f} }}",
+      stats.samples, stats.min, stats.max, stats.mean, stats.median, stats.stddev);
+  }
+
+  // Paths and names are the only user provided strings
+  std::string jsonEscape(const std::string &str) {
+    std::string escaped;
+    for (const char c : str) {
+      switch (c) {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      default:
+        if (static_cast<u8>(c) < 0x20) {
+          escaped += fmt::format("\\u{:04x}", static_cast<u8>(c));
+        } else {
+          escaped += c;
+        }
+        break;
+      }
+    }
+    return escaped;
+  }
+
+  void writeMode(std::ofstream &file, const std::string &mode, const std::vector<sMilestone> &milestones,
+    const std::vector<sRunResult> &runs) {
+    file << fmt::format("\n    {{\n      \"executor\": \"{}\",\n      \"runs\": [", jsonEscape(mode));
+    for (size_t r = 0; r != runs.size(); ++r) {
+      const sRunResult &run = runs[r];
+      file << fmt::format("{}\n        {{ \"completed\": {}, \"wallMs\": {:.3f}, \"loadStateMs\": {:.3f}, \"milestones\": [",
+        r ? "," : "", run.completed, run.wallMs, run.loadStateMs);
+      for (size_t m = 0; m != run.milestones.size(); ++m) {
+        const sMilestoneResult &milestone = run.milestones[m];
+        file << fmt::format("{}{{ \"name\": \"{}\", \"reached\": {}, \"timeMs\": {:.3f}, \"retiredInstrs\": {} }}",
+          m ? ", " : "", jsonEscape(milestones[m].name), milestone.reached, milestone.timeMs, milestone.retiredInstrs);
+      }
+      file << "], \"retiredInstrs\": [";
+      for (u32 i = 0; i != PPU_COUNT; ++i) {
+        file << fmt::format("{}{}", i ? ", " : "", run.retiredInstrs[i]);
+      }
+      file << "], \"mips\": [";
+      for (u32 i = 0; i != PPU_COUNT; ++i) {
+        file << fmt::format("{}{:.3f}", i ? ", " : "", run.mips[i]);
+      }
+      file << fmt::format("], \"jitBlocksCompiled\": {}, \"jitCompileMs\": {:.3f}, \"mmioReads\": {}, \"mmioWrites\": {}, "
+        "\"interruptsGenerated\": {}, \"interruptsAcknowledged\": {} }}",
+        run.jitBlocksCompiled, run.jitCompileMs, run.mmioReads, run.mmioWrites,
+        run.interruptsGenerated, run.interruptsAcknowledged);
+    }
+
+    // Statistics only cover the runs that reached the milestone in question
+    file << "\n      ],\n      \"statistics\": {\n        \"wallMs\": ";
+    std::vector<f64> values{};
+    for (const sRunResult &run : runs) {
+      if (run.completed) {
+        values.push_back(run.wallMs);
+      }
+    }
+    file << jsonStatistics(statistics(values));
+    file << ",\n        \"milestones\": {";
+    for (size_t m = 0; m != milestones.size(); ++m) {
+      values.clear();
+      for (const sRunResult &run : runs) {
+        if (run.milestones[m].reached) {
+          values.push_back(run.milestones[m].timeMs);
+        }
+      }
+      const sStatistics stats = statistics(values);
+      file << fmt::format("{}\n          \"{}\": {}", m ? "," : "", jsonEscape(milestones[m].name), jsonStatistics(stats));
+      fmt::print("{:<12} {:<24} {:>4}/{:<4} median {:>10.3f} ms  mean {:>10.3f} ms  stddev {:>8.3f} ms\n",
+        mode, milestones[m].name, stats.samples, runs.size(), stats.median, stats.mean, stats.stddev);
+    }
+    file << "\n        },\n        \"mips\": [";
+    for (u32 i = 0; i != PPU_COUNT; ++i) {
+      values.clear();
+      for (const sRunResult &run : runs) {
+        values.push_back(run.mips[i]);
+      }
+      const sStatistics stats = statistics(values);
+      file << fmt::format("{}{}", i ? ", " : "", jsonStatistics(stats));
+      fmt::print("{:<12} PPU{} {:>43.3f} MIPS (mean)\n", mode, i, stats.mean);
+    }
+    values.clear();
+    for (const sRunResult &run : runs) {
+      values.push_back(run.jitCompileMs);
+    }
+    file << "],\n        \"jitCompileMs\": " << jsonStatistics(statistics(values)) << "\n      }\n    }";
+  }
+
+} // anonymous namespace
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present()) {
+    ::Base::Param::Help();
+    return 0;
+  }
+
+  std::vector<sMilestone> milestones{};
+  for (const std::string &spec : PARAM_milestone.GetAll()) {
+    sMilestone milestone{};
+    if (!parseMilestone(spec, milestone)) {
+      fmt::print("Invalid milestone '{}', expected [name=]post:<code>, [name=]pc:<address> or [name=]instrs:<count>\n", spec);
+      return 1;
+    }
+    milestones.push_back(milestone);
+  }
+  if (milestones.empty()) {
+    fmt::print("Nothing to benchmark, give at least one -milestone\n");
+    ::Base::Param::Help();
+    return 1;
+  }
+  const s32 repeat = PARAM_repeat.Present() ? std::max(PARAM_repeat.Get<s32>(), 1) : 1;
+  const std::chrono::seconds timeout{ PARAM_timeout.Present() ? std::max(PARAM_timeout.Get<s32>(), 1) : 60 };
+  const std::string outPath = PARAM_out.Present() ? PARAM_out.Get() : "xenon-bench.json";
+
+  Base::SetCurrentThreadName("[Xe] Bench");
+  if (Base::InstallHangup() != 0) {
+    printf("Failed to install signal handler. Clean shutdown is not possible through console\n");
+  }
+
+  // Benchmarks never write the user's config back
+  XeMain::saveConfigOnShutdown = false;
+  XeMain::Create([] {
+    // Headless, nothing but the console itself
+    Config::rendering.backend = "Dummy";
+    Config::rendering.enable = false;
+    Config::network.enabled = false;
+    Config::network.backend = "none";
+    Config::network.captureFile = "";
+    Config::smc.uartSystem = "null";
+    Config::debug.haltOnAddress = 0;
+    Config::debug.haltOnReadAddress = 0;
+    Config::debug.haltOnWriteAddress = 0;
+    Config::debug.softHaltOnAssertions = false;
+    Config::debug.autoContinueOnGuestAssertion = true;
+    Config::log.currentLevel = Base::Log::Level::Warning;
+    if (PARAM_log.Present()) {
+      switch (Base::JoaatStringHash(PARAM_log.Get())) {
+      case "Trace"_jLower: Config::log.currentLevel = Base::Log::Level::Trace; break;
+      case "Debug"_jLower: Config::log.currentLevel = Base::Log::Level::Debug; break;
+      case "Info"_jLower: Config::log.currentLevel = Base::Log::Level::Info; break;
+      case "Error"_jLower: Config::log.currentLevel = Base::Log::Level::Error; break;
+      default: break;
+      }
+    }
+    if (PARAM_nand.Present()) {
+      Config::filepaths.nand = PARAM_nand.Get();
+    }
+    Config::xcpu.elfLoader = PARAM_elf.Present();
+    if (PARAM_elf.Present()) {
+      Config::filepaths.elfBinary = PARAM_elf.Get();
+    }
+  });
+  Xe::XCPU::POSTBUS::SetObserver(onPOST);
+
+  std::vector<std::string> modes = PARAM_mode.GetAll();
+  if (modes.empty()) {
+    modes.push_back(Config::highlyExperimental.cpuExecutor);
+  }
+
+  std::ofstream file(outPath, std::ios::trunc);
+  if (!file.is_open()) {
+    fmt::print("Unable to open '{}' for writing\n", outPath);
+    XeMain::Shutdown();
+    return 1;
+  }
+  file << fmt::format("{{\n  \"image\": \"{}\",\n  \"repeat\": {},\n  \"timeoutSeconds\": {},\n  \"milestones\": [",
+    jsonEscape(Config::xcpu.elfLoader ? Config::filepaths.elfBinary : Config::filepaths.nand), repeat, timeout.count());
+  for (size_t m = 0; m != milestones.size(); ++m) {
+    const char *format = milestones[m].kind == eMilestoneKind::Instrs ? "{}{{ \"name\": \"{}\", \"kind\": \"{}\", \"value\": {} }}"
+                                                                       : "{}{{ \"name\": \"{}\", \"kind\": \"{}\", \"value\": \"0x{:X}\" }}";
+    file << fmt::format(fmt::runtime(format), m ? ", " : "", jsonEscape(milestones[m].name),
+      milestoneKindName(milestones[m].kind), milestones[m].value);
+  }
+  file << "],\n  \"executors\": [";
+
+  s32 exitCode = 0;
+  std::string savePath = PARAM_savestate.Present() ? PARAM_savestate.Get() : "";
+  for (size_t i = 0; i != modes.size() && XeRunning; ++i) {
+    // Read by the PPUs as StartCPU creates them
+    Config::highlyExperimental.cpuExecutor = modes[i];
+    std::vector<sRunResult> runs{};
+    for (s32 r = 0; r != repeat && XeRunning; ++r) {
+      runs.push_back(run(milestones, timeout, savePath));
+      if (!runs.back().completed) {
+        exitCode = 2;
+      }
+    }
+    file << (i ? "," : "");
+    writeMode(file, modes[i], milestones, runs);
+  }
+  file << "\n  ]\n}\n";
+  file.close();
+  fmt::print("Report written to '{}'\n", outPath);
+
+  Xe::XCPU::POSTBUS::SetObserver(nullptr);
+  XeMain::Shutdown();
+  if (Base::RemoveHangup() != 0) {
+    printf("Failed to remove signal handler. (this is more of a warning, than an issue)\n");
+  }
+  return exitCode;
+}
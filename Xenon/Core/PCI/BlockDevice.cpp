@@ -0,0 +1,567 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "BlockDevice.h"
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define BLOCK_IO_URING
+#endif
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+
+namespace Xe::PCIDev {
+
+#ifdef _WIN32
+static const BlockFileHandle InvalidBlockHandle = INVALID_HANDLE_VALUE;
+#else
+static constexpr BlockFileHandle InvalidBlockHandle = -1;
+#endif
+
+// Largest single transfer handed to the host, bigger requests complete in pieces
+static constexpr u64 MaxTransferSize = 1_GiB;
+
+void BlockBufferDeleter::operator()(u8 *buffer) const {
+  ::operator delete[](buffer, std::align_val_t{ BLOCK_DIRECT_IO_ALIGNMENT });
+}
+
+BlockBuffer AllocateBlockBuffer(u64 size) {
+  // Round up so direct transfers of the whole buffer are legal
+  const u64 alignedSize = (size + BLOCK_DIRECT_IO_ALIGNMENT - 1) & ~static_cast<u64>(BLOCK_DIRECT_IO_ALIGNMENT - 1);
+  return BlockBuffer{ static_cast<u8 *>(::operator new[](alignedSize, std::align_val_t{ BLOCK_DIRECT_IO_ALIGNMENT })) };
+}
+
+static inline bool IsDirectAligned(u64 value) {
+  return (value & (BLOCK_DIRECT_IO_ALIGNMENT - 1)) == 0;
+}
+
+//
+// Thread pool engine, positional reads/writes on a few worker threads
+//
+
+class ThreadPoolBlockEngine : public BlockIOEngine {
+public:
+  ThreadPoolBlockEngine(CompletionFn &&completionFn, u32 threadCount) :
+    completion(std::move(completionFn)) {
+    for (u32 i = 0; i != threadCount; ++i) {
+      workers.emplace_back(&ThreadPoolBlockEngine::WorkerLoop, this);
+    }
+  }
+  ~ThreadPoolBlockEngine() override {
+    {
+      std::lock_guard lock(mutex);
+      running = false;
+    }
+    cv.notify_all();
+    for (auto &worker : workers) {
+      if (worker.joinable())
+        worker.join();
+    }
+  }
+
+  const char *Name() const override { return "thread pool"; }
+
+  void Submit(BlockIORequest *request) override {
+    {
+      std::lock_guard lock(mutex);
+      pending.push_back(request);
+    }
+    cv.notify_one();
+  }
+private:
+  static s64 Transfer(BlockIORequest *request) {
+    u8 *buffer = request->buffer + request->done;
+    const u64 offset = request->offset + request->done;
+    const u64 size = std::min(request->size - request->done, MaxTransferSize);
+#ifdef _WIN32
+    OVERLAPPED over = {};
+    over.Offset = static_cast<DWORD>(offset);
+    over.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD transferred = 0;
+    const BOOL result = request->op == eBlockIOOp::Read ?
+      ReadFile(request->handle, buffer, static_cast<DWORD>(size), &transferred, &over) :
+      WriteFile(request->handle, buffer, static_cast<DWORD>(size), &transferred, &over);
+    if (!result)
+      return GetLastError() == ERROR_HANDLE_EOF ? 0 : -static_cast<s64>(GetLastError());
+    return transferred;
+#else
+    for (;;) {
+      const ssize_t result = request->op == eBlockIOOp::Read ?
+        pread(request->handle, buffer, size, static_cast<off_t>(offset)) :
+        pwrite(request->handle, buffer, size, static_cast<off_t>(offset));
+      if (result >= 0)
+        return result;
+      if (errno != EINTR)
+        return -errno;
+    }
+#endif
+  }
+
+  void WorkerLoop() {
+    Base::SetCurrentThreadName("[Xe] Block I/O");
+    for (;;) {
+      BlockIORequest *request = nullptr;
+      {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this] { return !running || !pending.empty(); });
+        if (pending.empty())
+          return;
+        request = pending.front();
+        pending.pop_front();
+      }
+      completion(request, Transfer(request));
+    }
+  }
+
+  CompletionFn completion{};
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  std::deque<BlockIORequest *> pending{};
+  std::vector<std::thread> workers{};
+  bool running = true;
+};
+
+#ifdef BLOCK_IO_URING
+//
+// io_uring engine, raw syscalls so we don't depend on liburing
+//
+
+class IoUringBlockEngine : public BlockIOEngine {
+public:
+  static constexpr u32 QueueDepth = 64;
+
+  explicit IoUringBlockEngine(CompletionFn &&completionFn) :
+    completion(std::move(completionFn))
+  {}
+  ~IoUringBlockEngine() override {
+    if (reaper.joinable()) {
+      // A NOP with no request attached tells the reaper to exit
+      SubmitEntry(IORING_OP_NOP, nullptr);
+      reaper.join();
+    }
+    if (sqes)
+      munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing)
+      munmap(cqRing, cqRingSize);
+    if (sqRing)
+      munmap(sqRing, sqRingSize);
+    if (ringFd != -1)
+      close(ringFd);
+  }
+
+  // Sets the ring up, returns false if the kernel can't do what we need
+  bool Init() {
+    io_uring_params params = {};
+    ringFd = static_cast<s32>(syscall(__NR_io_uring_setup, QueueDepth, &params));
+    if (ringFd < 0) {
+      LOG_DEBUG(PCIBridge, "BlockDevice: io_uring_setup failed ({}), using the thread pool", errno);
+      ringFd = -1;
+      return false;
+    }
+    if (!SupportsReadWrite())
+      return false;
+
+    sqEntries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+      sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    sqRing = static_cast<u8 *>(mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING));
+    if (sqRing == MAP_FAILED) {
+      sqRing = nullptr;
+      return false;
+    }
+    if (singleMmap) {
+      cqRing = sqRing;
+    } else {
+      cqRing = static_cast<u8 *>(mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING));
+      if (cqRing == MAP_FAILED) {
+        cqRing = nullptr;
+        return false;
+      }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+      sqes = nullptr;
+      return false;
+    }
+
+    sqHead = reinterpret_cast<u32 *>(sqRing + params.sq_off.head);
+    sqTail = reinterpret_cast<u32 *>(sqRing + params.sq_off.tail);
+    sqMask = *reinterpret_cast<u32 *>(sqRing + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<u32 *>(sqRing + params.sq_off.array);
+    cqHead = reinterpret_cast<u32 *>(cqRing + params.cq_off.head);
+    cqTail = reinterpret_cast<u32 *>(cqRing + params.cq_off.tail);
+    cqMask = *reinterpret_cast<u32 *>(cqRing + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cqRing + params.cq_off.cqes);
+
+    reaper = std::thread(&IoUringBlockEngine::ReaperLoop, this);
+    return true;
+  }
+
+  const char *Name() const override { return "io_uring"; }
+
+  void Submit(BlockIORequest *request) override {
+    SubmitEntry(request->op == eBlockIOOp::Read ? IORING_OP_READ : IORING_OP_WRITE, request);
+  }
+private:
+  // IORING_OP_READ/WRITE need 5.6+, older kernels only have the vectored variants
+  bool SupportsReadWrite() {
+    constexpr u32 opCount = 256;
+    std::vector<u8> probeStorage(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+    io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(probeStorage.data());
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0)
+      return false;
+    const auto supported = [probe](u32 op) {
+      return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+  }
+
+  void SubmitEntry(u8 opcode, BlockIORequest *request) {
+    std::unique_lock lock(submitMutex);
+    // Keep roughly sqEntries in flight. Resubmissions come from the reaper itself, which can't
+    // wait on a slot only it frees; the kernel buffers any completion ring overflow (FEAT_NODROP).
+    if (std::this_thread::get_id() != reaper.get_id())
+      slotCV.wait(lock, [this] { return inFlight < sqEntries; });
+    ++inFlight;
+
+    const u32 tail = std::atomic_ref(*sqTail).load(std::memory_order_relaxed);
+    const u32 index = tail & sqMask;
+    io_uring_sqe &sqe = sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.user_data = reinterpret_cast<u64>(request);
+    if (request) {
+      sqe.fd = request->handle;
+      sqe.off = request->offset + request->done;
+      sqe.addr = reinterpret_cast<u64>(request->buffer + request->done);
+      sqe.len = static_cast<u32>(std::min(request->size - request->done, MaxTransferSize));
+    }
+    sqArray[index] = index;
+    std::atomic_ref(*sqTail).store(tail + 1, std::memory_order_release);
+
+    while (syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0) < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      LOG_ERROR(PCIBridge, "BlockDevice: io_uring_enter failed ({})", errno);
+      break;
+    }
+  }
+
+  void ReaperLoop() {
+    Base::SetCurrentThreadName("[Xe] Block I/O");
+    for (;;) {
+      u32 head = std::atomic_ref(*cqHead).load(std::memory_order_relaxed);
+      u32 tail = std::atomic_ref(*cqTail).load(std::memory_order_acquire);
+      if (head == tail) {
+        // Sleep in the kernel until something completes
+        syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        continue;
+      }
+      bool exit = false;
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & cqMask];
+        BlockIORequest *request = reinterpret_cast<BlockIORequest *>(cqe.user_data);
+        const s64 result = cqe.res;
+        // Hand the entry back before completing, the completion may resubmit
+        std::atomic_ref(*cqHead).store(head + 1, std::memory_order_release);
+        ReleaseSlot();
+        if (request)
+          completion(request, result);
+        else
+          exit = true;
+      }
+      if (exit)
+        return;
+    }
+  }
+
+  void ReleaseSlot() {
+    {
+      std::lock_guard lock(submitMutex);
+      --inFlight;
+    }
+    slotCV.notify_all();
+  }
+
+  CompletionFn completion{};
+  s32 ringFd = -1;
+  u32 sqEntries = 0;
+  u64 sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+  u8 *sqRing = nullptr;
+  u8 *cqRing = nullptr;
+  io_uring_sqe *sqes = nullptr;
+  u32 *sqHead = nullptr, *sqTail = nullptr, *sqArray = nullptr;
+  u32 sqMask = 0;
+  u32 *cqHead = nullptr, *cqTail = nullptr;
+  u32 cqMask = 0;
+  io_uring_cqe *cqes = nullptr;
+  std::mutex submitMutex{};
+  std::condition_variable slotCV{};
+  u32 inFlight = 0;
+  std::thread reaper{};
+};
+#endif // BLOCK_IO_URING
+
+//
+// Block Device
+//
+
+BlockDevice::BlockDevice(const std::string &imagePath, bool writable) :
+  path(imagePath), handle(InvalidBlockHandle), directHandle(InvalidBlockHandle) {
+#ifdef _WIN32
+  const DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+  handle = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == InvalidBlockHandle)
+    return;
+  LARGE_INTEGER fileSize = {};
+  if (GetFileSizeEx(handle, &fileSize))
+    imageSize = static_cast<u64>(fileSize.QuadPart);
+  if (IsDirectAligned(imageSize)) {
+    directHandle = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, nullptr);
+  }
+#else
+  const s32 flags = (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC;
+  handle = open(path.c_str(), flags);
+  if (handle == InvalidBlockHandle)
+    return;
+  struct stat st = {};
+  if (fstat(handle, &st) == 0)
+    imageSize = static_cast<u64>(st.st_size);
+  // Raw block devices report a zero st_size
+  if (imageSize == 0) {
+    const off_t end = lseek(handle, 0, SEEK_END);
+    imageSize = end > 0 ? static_cast<u64>(end) : 0;
+  }
+#ifdef O_DIRECT
+  // Not every filesystem allows it (tmpfs, some FUSE mounts), buffered I/O is always there
+  if (IsDirectAligned(imageSize))
+    directHandle = open(path.c_str(), flags | O_DIRECT);
+#endif
+#endif
+
+  BlockIOEngine::CompletionFn completionFn = [this](BlockIORequest *request, s64 result) {
+    Complete(request, result);
+  };
+#ifdef BLOCK_IO_URING
+  auto ring = std::make_unique<IoUringBlockEngine>(BlockIOEngine::CompletionFn{ completionFn });
+  if (ring->Init())
+    engine = std::move(ring);
+#endif
+  if (!engine)
+    engine = std::make_unique<ThreadPoolBlockEngine>(std::move(completionFn), 4);
+
+  LOG_INFO(PCIBridge, "BlockDevice: '{}' ({:#x} bytes) using {}{}", path, imageSize, engine->Name(),
+    directHandle != InvalidBlockHandle ? ", direct I/O" : "");
+}
+
+BlockDevice::~BlockDevice() {
+  WaitAll();
+  engine.reset();
+#ifdef _WIN32
+  if (directHandle != InvalidBlockHandle)
+    CloseHandle(directHandle);
+  if (handle != InvalidBlockHandle)
+    CloseHandle(handle);
+#else
+  if (directHandle != InvalidBlockHandle)
+    close(directHandle);
+  if (handle != InvalidBlockHandle)
+    close(handle);
+#endif
+}
+
+bool BlockDevice::IsOpen() const {
+  return handle != InvalidBlockHandle;
+}
+
+const char *BlockDevice::EngineName() const {
+  return engine ? engine->Name() : "none";
+}
+
+u64 BlockDevice::ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback) {
+  auto request = std::make_unique<BlockIORequest>();
+  request->op = eBlockIOOp::Read;
+  request->offset = offset;
+  request->buffer = destination;
+  request->size = size;
+  request->callback = std::move(callback);
+  return Submit(std::move(request));
+}
+
+u64 BlockDevice::WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback) {
+  auto request = std::make_unique<BlockIORequest>();
+  request->op = eBlockIOOp::Write;
+  request->offset = offset;
+  request->ownedBuffer = AllocateBlockBuffer(size);
+  memcpy(request->ownedBuffer.get(), source, size);
+  request->buffer = request->ownedBuffer.get();
+  request->size = size;
+  request->callback = std::move(callback);
+  return Submit(std::move(request));
+}
+
+u64 BlockDevice::Submit(std::unique_ptr<BlockIORequest> request) {
+  BlockIORequest *rawRequest = request.get();
+  u64 ticket = 0;
+  {
+    std::lock_guard lock(mutex);
+    // Requests to the same sectors land in the order they were issued. One that can't start yet is
+    // started by the completion that frees it up, the caller (maybe a completion callback) never waits.
+    ticket = rawRequest->ticket = nextTicket++;
+    rawRequest->deferred = MustWait(*rawRequest);
+    if (rawRequest->deferred)
+      deferredRequests.push_back(rawRequest);
+    inFlight.emplace(ticket, std::move(request));
+    if (rawRequest->deferred)
+      return ticket;
+  }
+  // The request may be freed by the time Submit returns
+  Start(rawRequest);
+  return ticket;
+}
+
+void BlockDevice::Start(BlockIORequest *request) {
+  if (!IsOpen() || request->size == 0) {
+    Complete(request, IsOpen() ? 0 : -1);
+    return;
+  }
+  SelectHandle(request);
+  engine->Submit(request);
+}
+
+void BlockDevice::SelectHandle(BlockIORequest *request) {
+  const bool aligned = IsDirectAligned(request->offset + request->done) &&
+    IsDirectAligned(request->size - request->done) &&
+    IsDirectAligned(reinterpret_cast<u64>(request->buffer + request->done));
+  request->handle = (aligned && directHandle != InvalidBlockHandle) ? directHandle : handle;
+}
+
+void BlockDevice::Complete(BlockIORequest *request, s64 result) {
+  bool success = result >= 0;
+  if (result > 0) {
+    request->done += static_cast<u64>(result);
+    if (request->done < request->size) {
+      // Short transfer, queue the rest
+      SelectHandle(request);
+      engine->Submit(request);
+      return;
+    }
+  } else if (result < 0 && request->handle == directHandle && directHandle != InvalidBlockHandle) {
+    // The filesystem refused the unbuffered transfer, retry it through the page cache
+    request->handle = handle;
+    engine->Submit(request);
+    return;
+  }
+  if (request->done < request->size) {
+    // Past the end of the image (or failed), what's left reads as zeroes
+    if (request->op == eBlockIOOp::Read)
+      memset(request->buffer + request->done, 0, request->size - request->done);
+    success = false;
+    LOG_ERROR(PCIBridge, "BlockDevice: {} of {:#x} bytes at {:#x} in '{}' failed ({}), {:#x} bytes transferred",
+      request->op == eBlockIOOp::Read ? "Read" : "Write", request->size, request->offset, path, result, request->done);
+  }
+  // Out of the in flight set before the callback runs, so it can queue requests overlapping this one
+  std::unique_ptr<BlockIORequest> finished{};
+  std::vector<BlockIORequest *> ready{};
+  {
+    std::lock_guard lock(mutex);
+    auto it = inFlight.find(request->ticket);
+    if (it != inFlight.end()) {
+      finished = std::move(it->second);
+      inFlight.erase(it);
+    }
+    if (request->callback)
+      completing.insert(request->ticket);
+    else if (!success)
+      failedTickets.insert(request->ticket);
+    // Start whatever was only waiting on this one, in issue order
+    for (auto deferred = deferredRequests.begin(); deferred != deferredRequests.end();) {
+      if (MustWait(**deferred)) {
+        ++deferred;
+        continue;
+      }
+      (*deferred)->deferred = false;
+      ready.push_back(*deferred);
+      deferred = deferredRequests.erase(deferred);
+    }
+  }
+  for (BlockIORequest *next : ready)
+    Start(next);
+  if (request->callback) {
+    completionCV.notify_all();
+    request->callback(success);
+    std::lock_guard lock(mutex);
+    completing.erase(request->ticket);
+  }
+  completionCV.notify_all();
+}
+
+bool BlockDevice::MustWait(const BlockIORequest &request) const {
+  for (const auto &[ticket, other] : inFlight) {
+    if (other.get() == &request || (other->deferred && other->ticket > request.ticket))
+      continue;
+    if (request.op == eBlockIOOp::Read && other->op != eBlockIOOp::Write)
+      continue;
+    if (request.offset < other->offset + other->size && other->offset < request.offset + request.size)
+      return true;
+  }
+  return false;
+}
+
+bool BlockDevice::Wait(u64 ticket) {
+  std::unique_lock lock(mutex);
+  completionCV.wait(lock, [&] { return !inFlight.contains(ticket) && !completing.contains(ticket); });
+  return failedTickets.erase(ticket) == 0;
+}
+
+bool BlockDevice::Flush() {
+  if (!IsOpen())
+    return false;
+#ifdef _WIN32
+  const bool success = FlushFileBuffers(handle) != 0;
+#elif defined(__APPLE__)
+  const bool success = fsync(handle) == 0;
+#else
+  const bool success = fdatasync(handle) == 0;
+#endif
+  if (!success) {
+    LOG_ERROR(PCIBridge, "BlockDevice: Unable to flush '{}'", path);
+  }
+  return success;
+}
+
+bool BlockDevice::WaitAll() {
+  std::unique_lock lock(mutex);
+  completionCV.wait(lock, [this] { return inFlight.empty() && completing.empty(); });
+  const bool success = failedTickets.empty();
+  failedTickets.clear();
+  return success;
+}
+
+} // namespace Xe::PCIDev
@@ -0,0 +1,155 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Base/Types.h"
+
+/*
+ *	BlockDevice.h Asynchronous image backed block storage, used by the HDD and ODD.
+ *
+ *	Requests are issued through io_uring when the host kernel supports it, otherwise through a small
+ *	pool of pread/pwrite threads. Any number of requests may be outstanding, a read or write
+ *	overlapping an earlier write is held back until it completes so the guest always sees its own
+ *	writes. Submitting never blocks, completion callbacks can queue requests freely.
+ */
+
+namespace Xe::PCIDev {
+
+// Offset, size and buffer address alignment needed to bypass the host page cache
+#define BLOCK_DIRECT_IO_ALIGNMENT 4096
+
+#ifdef _WIN32
+using BlockFileHandle = void *;
+#else
+using BlockFileHandle = s32;
+#endif
+
+// Buffers aligned to BLOCK_DIRECT_IO_ALIGNMENT, so transfers into them can skip the page cache
+struct BlockBufferDeleter {
+  void operator()(u8 *buffer) const;
+};
+using BlockBuffer = std::unique_ptr<u8[], BlockBufferDeleter>;
+BlockBuffer AllocateBlockBuffer(u64 size);
+
+enum class eBlockIOOp : u8 {
+  Read,
+  Write
+};
+
+struct BlockIORequest {
+  eBlockIOOp op = eBlockIOOp::Read;
+  // Ticket handed back to the caller
+  u64 ticket = 0;
+  u64 offset = 0;
+  u8 *buffer = nullptr;
+  u64 size = 0;
+  // Bytes transferred so far, short transfers get resubmitted for the rest
+  u64 done = 0;
+  // Handle used for the current submission (buffered or direct)
+  BlockFileHandle handle{};
+  // Writes own a copy of their data, the caller's buffer may be reused right away
+  BlockBuffer ownedBuffer{};
+  // Held back behind an overlapping request, not handed to the engine yet
+  bool deferred = false;
+  std::function<void(bool)> callback{};
+};
+
+// Backend that moves the bytes. Completions are reported from the engine's own thread(s).
+class BlockIOEngine {
+public:
+  // result is the number of bytes transferred, or -errno
+  using CompletionFn = std::function<void(BlockIORequest *request, s64 result)>;
+
+  virtual ~BlockIOEngine() = default;
+  virtual const char *Name() const = 0;
+  // Transfers request->size - request->done bytes, starting at request->done
+  virtual void Submit(BlockIORequest *request) = 0;
+};
+
+// Storage a drive can be backed by (a plain image, or an overlay on top of one)
+class IBlockStorage {
+public:
+  virtual ~IBlockStorage() = default;
+
+  virtual bool IsOpen() const = 0;
+  // Size in bytes
+  virtual u64 Size() const = 0;
+
+  // Queues a read into destination, which must stay valid until the request completes.
+  // Returns a ticket for Wait(). With a callback, the result is only reported to it. Callbacks run on
+  // the I/O thread, they may queue requests but must not wait on them.
+  virtual u64 ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback = {}) = 0;
+  // Queues a write. The data is copied, source may be reused once this returns.
+  virtual u64 WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback = {}) = 0;
+
+  // Blocks until the request completes, returns whether it succeeded
+  virtual bool Wait(u64 ticket) = 0;
+  // Blocks until every outstanding request completes. Failures nobody waited on are dropped,
+  // returns false if there was one.
+  virtual bool WaitAll() = 0;
+
+  // Synchronous helpers
+  bool Read(u64 offset, u8 *destination, u64 size) { return Wait(ReadAsync(offset, destination, size)); }
+  bool Write(u64 offset, const u8 *source, u64 size) { return Wait(WriteAsync(offset, source, size)); }
+};
+
+class BlockDevice : public IBlockStorage {
+public:
+  BlockDevice(const std::string &imagePath, bool writable);
+  // Waits for every outstanding request
+  ~BlockDevice() override;
+
+  bool IsOpen() const override;
+  u64 Size() const override { return imageSize; }
+  // Engine in use ("io_uring" or "thread pool")
+  const char *EngineName() const;
+
+  u64 ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback = {}) override;
+  u64 WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback = {}) override;
+  bool Wait(u64 ticket) override;
+  bool WaitAll() override;
+  // Makes the writes that completed so far durable. Returns false if the host couldn't.
+  bool Flush();
+private:
+  u64 Submit(std::unique_ptr<BlockIORequest> request);
+  // Hands a request to the engine
+  void Start(BlockIORequest *request);
+  // Picks the direct handle when the remaining transfer is aligned
+  void SelectHandle(BlockIORequest *request);
+  // Engine callback
+  void Complete(BlockIORequest *request, s64 result);
+  // Whether request has to wait for another one: an overlapping started request, or an overlapping
+  // deferred one issued before it. Reads only wait on writes.
+  bool MustWait(const BlockIORequest &request) const;
+
+  std::string path{};
+  u64 imageSize = 0;
+  BlockFileHandle handle{};
+  // Opened only when the image size is aligned, invalid otherwise
+  BlockFileHandle directHandle{};
+  std::unique_ptr<BlockIOEngine> engine{};
+
+  std::mutex mutex{};
+  std::condition_variable completionCV{};
+  u64 nextTicket = 1;
+  std::unordered_map<u64, std::unique_ptr<BlockIORequest>> inFlight{};
+  // In flight requests held back by MustWait, in the order they were issued
+  std::vector<BlockIORequest *> deferredRequests{};
+  // Completed tickets whose callback is still running
+  std::unordered_set<u64> completing{};
+  // Completed tickets that failed, until someone Waits on them (or WaitAll drops them)
+  std::unordered_set<u64> failedTickets{};
+};
+
+} // namespace Xe::PCIDev
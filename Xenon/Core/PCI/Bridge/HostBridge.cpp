@@ -86,6 +86,11 @@ void HostBridge::RegisterPCIBridge(std::shared_ptr<PCIBridge> bridge) {
   pciBridge = std::move(bridge);
 }
 
+void HostBridge::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lck(mutex);
+  stream.Do(hostBridgeConfigSpace, hostBridgeRegs, biuRegs);
+}
+
 bool HostBridge::Read(u64 readAddress, u8 *data, u64 size) {
   MICROPROFILE_SCOPEI("[Xe::PCI]", "HostBridge::Read", MP_AUTO);
   std::lock_guard lck(mutex);
@@ -72,6 +72,8 @@ public:
 
   // Configuration Write
   bool ConfigWrite(u64 writeAddress, const u8 *data, u64 size);
+  // Save states, the bridge's own registers (the XGPU and PCI bridge are stored on their own)
+  void SerializeState(Xe::SaveState::StateStream &stream);
 
 private:
   std::mutex mutex{};
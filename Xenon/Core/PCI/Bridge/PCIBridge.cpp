@@ -2,6 +2,8 @@
 /* Copyright 2025 Xenon Emulator Project. All rights reserved. */
 /***************************************************************/
 
+#include <algorithm>
+
 #include "Base/Logging/Log.h"
 #include "Base/Global.h"
 
@@ -322,6 +324,65 @@ void PCIBridge::ResetPCIDevice(std::shared_ptr<PCIDevice> device) {
   }
 }
 
+void PCIBridge::SerializeState(Xe::SaveState::StateStream &stream) {
+  stream.Do(pciBridgeConfig, pciBridgeState, pciBridgeConfigSpace);
+
+  // Devices are stored by name, each in a block of its own, so one that's only attached on one side gets skipped
+  std::vector<std::string> names{};
+  for (const auto &[name, device] : connectedPCIDevices) {
+    if (device)
+      names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  u32 deviceCount = static_cast<u32>(names.size());
+  stream.Do(deviceCount);
+  for (u32 i = 0; i != deviceCount && !stream.Failed(); ++i) {
+    std::string name = stream.IsSaving() ? names[i] : std::string{};
+    stream.DoString(name);
+    std::vector<u8> block{};
+    if (stream.IsSaving()) {
+      Xe::SaveState::StateStream deviceStream{};
+      connectedPCIDevices[name]->SerializeState(deviceStream);
+      block = deviceStream.TakeData();
+    }
+    stream.DoVector(block);
+    if (stream.IsSaving() || stream.Failed()) {
+      continue;
+    }
+    const auto it = connectedPCIDevices.find(name);
+    if (it == connectedPCIDevices.end() || !it->second) {
+      LOG_WARNING(PCIBridge, "The save state has device '{}', which isn't attached. Skipping it.", name);
+      continue;
+    }
+    Xe::SaveState::StateStream deviceStream{ block.data(), block.size() };
+    it->second->SerializeState(deviceStream);
+    if (deviceStream.Failed()) {
+      LOG_ERROR(PCIBridge, "The save state of device '{}' is broken.", name);
+      stream.Fail();
+    }
+    std::erase(names, name);
+  }
+  if (stream.IsLoading()) {
+    for (const std::string &name : names) {
+      LOG_WARNING(PCIBridge, "Device '{}' isn't part of the save state, it keeps its current state.", name);
+    }
+  }
+}
+
+void PCIBridge::QuiesceDevices() {
+  for (auto &[name, device] : connectedPCIDevices) {
+    if (device)
+      device->Quiesce();
+  }
+}
+
+void PCIBridge::ResumeDevices() {
+  for (auto &[name, device] : connectedPCIDevices) {
+    if (device)
+      device->Resume();
+  }
+}
+
 bool PCIBridge::Read(u64 readAddress, u8 *data, u64 size) {
   // Reading to our own space?
   if (readAddress >= PCI_BRIDGE_BASE_ADDRESS &&
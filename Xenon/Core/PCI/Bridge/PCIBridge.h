@@ -106,6 +106,12 @@ public:
   bool RouteInterrupt(u8 prio, u8 targetCPU = 0xFF);
   void CancelInterrupt(u8 prio);
 
+  // Save states, the bridge and every attached device (see PCIDevice::SerializeState)
+  void SerializeState(Xe::SaveState::StateStream &stream);
+  // Quiesces/resumes every attached device
+  void QuiesceDevices();
+  void ResumeDevices();
+
 private:
   // IIC Pointer used for interrupts
   Xe::XCPU::XenonIIC *xenonIIC;
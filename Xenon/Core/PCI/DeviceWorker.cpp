@@ -0,0 +1,140 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "DeviceWorker.h"
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+
+namespace Xe::PCIDev {
+
+DeviceWorkerPool &DeviceWorkerPool::Get() {
+  // Device work is short and mostly memcpy bound, two threads cover HDD + ODD + NAND in parallel
+  static DeviceWorkerPool pool{ 2 };
+  return pool;
+}
+
+DeviceWorkerPool &DeviceWorkerPool::GetStorage() {
+  // Disc reads, disc read-ahead and the HDD/NAND overlays can all be busy at once
+  static DeviceWorkerPool pool{ 4, "Storage Worker" };
+  return pool;
+}
+
+DeviceWorkerPool::DeviceWorkerPool(u32 threadCount, const std::string &threadName) :
+  name(threadName), workerCount(threadCount) {
+  Start();
+}
+
+DeviceWorkerPool::~DeviceWorkerPool() {
+  Stop();
+}
+
+void DeviceWorkerPool::Stop() {
+  {
+    std::lock_guard lock(mutex);
+    running = false;
+  }
+  cv.notify_all();
+  for (auto &worker : workers) {
+    if (worker.joinable())
+      worker.join();
+  }
+  workers.clear();
+}
+
+void DeviceWorkerPool::Start() {
+  std::lock_guard lock(mutex);
+  if (running)
+    return;
+  running = true;
+  for (u32 i = 0; i != workerCount; ++i) {
+    workers.emplace_back(&DeviceWorkerPool::WorkerLoop, this, i);
+  }
+}
+
+bool DeviceWorkerPool::Submit(std::function<void()> &&work) {
+  {
+    std::lock_guard lock(mutex);
+    // Nothing would ever pick it up
+    if (!running)
+      return false;
+    pending.emplace_back(std::move(work));
+  }
+  cv.notify_one();
+  return true;
+}
+
+void DeviceWorkerPool::WorkerLoop(u32 index) {
+  Base::SetCurrentThreadName(FMT("[Xe] {} {}", name, index));
+  for (;;) {
+    std::function<void()> work{};
+    {
+      std::unique_lock lock(mutex);
+      cv.wait(lock, [this] { return !running || !pending.empty(); });
+      if (pending.empty())
+        return;
+      work = std::move(pending.front());
+      pending.pop_front();
+    }
+    work();
+  }
+}
+
+DeviceWorkQueue::~DeviceWorkQueue() {
+  Stop();
+}
+
+void DeviceWorkQueue::Post(std::function<void()> &&work) {
+  {
+    std::lock_guard lock(mutex);
+    if (stopped)
+      return;
+    items.emplace_back(std::move(work));
+    // A drain is already in flight, it'll pick this up
+    if (draining)
+      return;
+    draining = true;
+  }
+  // The pool is stopped (shutdown, or around a fork), run it here so WaitIdle and tickets still complete
+  if (!pool.Submit([this] { Drain(); }))
+    Drain();
+}
+
+void DeviceWorkQueue::Stop() {
+  std::unique_lock lock(mutex);
+  stopped = true;
+  if (!items.empty())
+    LOG_DEBUG(PCIBridge, "{}: Dropping {} queued work item(s)", name, items.size());
+  items.clear();
+  idleCV.wait(lock, [this] { return !draining; });
+}
+
+bool DeviceWorkQueue::Busy() {
+  std::lock_guard lock(mutex);
+  return draining;
+}
+
+void DeviceWorkQueue::WaitIdle() {
+  std::unique_lock lock(mutex);
+  idleCV.wait(lock, [this] { return !draining; });
+}
+
+void DeviceWorkQueue::Drain() {
+  for (;;) {
+    std::function<void()> work{};
+    {
+      std::lock_guard lock(mutex);
+      if (items.empty()) {
+        draining = false;
+        idleCV.notify_all();
+        return;
+      }
+      work = std::move(items.front());
+      items.pop_front();
+    }
+    work();
+  }
+}
+
+} // namespace Xe::PCIDev
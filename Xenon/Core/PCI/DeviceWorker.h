@@ -0,0 +1,95 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Base/Types.h"
+
+/*
+ *	DeviceWorker.h Shared executor for device side work (DMA transfers, NAND commands, ATAPI packets).
+ *
+ *	Devices used to own a thread each, spinning on their command registers. Now an MMIO write that
+ *	starts work posts it to the device's queue, a small shared pool runs it, and nothing runs while idle.
+ *
+ *	Work on a pool must never wait on work queued on the same pool, it could be waiting on itself once
+ *	every worker is busy. Device commands wait on storage (disc cache, overlays), so storage layers run
+ *	on their own pool, and storage work only ever waits on BlockDevice I/O.
+ */
+
+namespace Xe::PCIDev {
+
+// Fixed size pool of worker threads, shared by every device
+class DeviceWorkerPool {
+public:
+  // Process wide pool for device work
+  static DeviceWorkerPool &Get();
+  // Process wide pool for storage layers (disc cache, overlays), device work waits on it
+  static DeviceWorkerPool &GetStorage();
+
+  explicit DeviceWorkerPool(u32 threadCount, const std::string &threadName = "Device Worker");
+  ~DeviceWorkerPool();
+
+  // Runs work on one of the worker threads. Returns false, leaving work untouched, while the pool is stopped
+  bool Submit(std::function<void()> &&work);
+
+  // Runs everything pending, then joins the worker threads. fork() only carries the calling thread over,
+  // so the fork launcher stops the pool before forking and starts it again in every child
+  void Stop();
+  void Start();
+private:
+  void WorkerLoop(u32 index);
+
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  std::deque<std::function<void()>> pending{};
+  std::vector<std::thread> workers{};
+  std::string name{};
+  u32 workerCount = 0;
+  bool running = false;
+};
+
+// Per device work queue. Items posted to the same queue run one at a time, in order,
+// so a device never sees its own work items race each other.
+class DeviceWorkQueue {
+public:
+  explicit DeviceWorkQueue(const std::string &queueName, DeviceWorkerPool &workerPool = DeviceWorkerPool::Get()) :
+    name(queueName), pool(workerPool)
+  {}
+  // Drops anything still queued and waits for the running item
+  ~DeviceWorkQueue();
+
+  // Queues work for this device (usually from an MMIO write)
+  void Post(std::function<void()> &&work);
+
+  // Drops queued items and waits for the running one to finish
+  void Stop();
+
+  // Whether something is queued or running
+  bool Busy();
+
+  // Waits until everything queued so far has run (save states quiesce devices with it)
+  void WaitIdle();
+private:
+  // Runs queued items until the queue is empty
+  void Drain();
+
+  std::string name{};
+  DeviceWorkerPool &pool;
+  std::mutex mutex{};
+  std::condition_variable idleCV{};
+  std::deque<std::function<void()>> items{};
+  // A drain is scheduled or running on the pool
+  bool draining = false;
+  bool stopped = false;
+};
+
+} // namespace Xe::PCIDev
@@ -149,6 +149,12 @@ void Xe::PCIDev::EHCI::Write(u64 writeAddress, const u8 *data, u64 size) {
 void Xe::PCIDev::EHCI::MemSet(u64 writeAddress, s32 data, u64 size)
 {}
 
+void Xe::PCIDev::EHCI::SerializeState(Xe::SaveState::StateStream &stream) {
+  PCIDevice::SerializeState(stream);
+  stream.Do(capLength, hcsParams, hccParams, hcspPortRoute, usbCmd, usbSts, usbIntr, frameIndex, ctrlDsSegment,
+    periodicListBase, asyncListAddr, configFlag, portSC);
+}
+
 void Xe::PCIDev::EHCI::ConfigRead(u64 readAddress, u8 *data, u64 size) {
   memcpy(data, &pciConfigSpace.data[static_cast<u8>(readAddress)], size);
 }
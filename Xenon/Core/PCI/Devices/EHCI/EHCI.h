@@ -20,6 +20,8 @@ public:
   void ConfigRead(u64 readAddress, u8 *data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8 *data, u64 size) override;
 
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+
 private:
   // Internal data
   s32 instance;
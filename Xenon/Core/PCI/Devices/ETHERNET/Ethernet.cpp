@@ -82,6 +82,11 @@ Xe::PCIDev::ETHERNET::ETHERNET(const std::string &deviceName, u64 size, PCIBridg
   // Initialize max packet size
   ethPciState.maxPacketSizeReg = ETH_MAX_FRAME_SIZE;
   
+  // Start capturing traffic if configured
+  if (!Config::network.captureFile.empty()) {
+    capture = std::make_unique<Network::PcapWriter>(Config::network.captureFile);
+  }
+  
   // Initialize network bridge if configured
   InitializeNetworkBridge();
   
@@ -98,14 +103,15 @@ Xe::PCIDev::ETHERNET::ETHERNET(const std::string &deviceName, u64 size, PCIBridg
 Xe::PCIDev::ETHERNET::~ETHERNET() {
   // Stop worker thread
   workerRunning = false;
-  workerCV.notify_all();
+  WakeWorker();
   
   if (workerThread.joinable()) {
     workerThread.join();
   }
   
-  // Detach from network bridge
+  // Detach from network bridge, the backend lets go of our pool before this returns
   Network::GetNetworkBridge().DetachEthernetDevice();
+  DropPendingRxPackets();
   
   LOG_INFO(ETH, "Ethernet controller shutdown. Transmitted: {} TX packets, {} RX packets",
     stats.txPackets.load(), stats.rxPackets.load());
@@ -159,10 +165,8 @@ void Xe::PCIDev::ETHERNET::Reset() {
   rxTail = 0;
   
   // Clear RX queue
-  {
-    std::lock_guard<std::mutex> lock(rxQueueMutex);
-    while (!pendingRxPackets.empty()) pendingRxPackets.pop();
-  }
+  rxFlushPending = true;
+  WakeWorker();
   
   // Disable TX/RX
   txRing0Enabled = false;
@@ -327,7 +331,7 @@ void Xe::PCIDev::ETHERNET::Write(u64 writeAddress, const u8 *data, u64 size) {
         DEBUGP("TX enabled, descriptor base: {:#08x}", ethPciState.txDescriptor0BaseReg);
       }
       // Notify worker thread to process pending TX
-      workerCV.notify_one();
+      WakeWorker();
     } else if (txRing0Enabled && !(val & 0x01)) {
       // TX is being disabled.
       txRing0Enabled = false;
@@ -344,7 +348,7 @@ void Xe::PCIDev::ETHERNET::Write(u64 writeAddress, const u8 *data, u64 size) {
         DEBUGP("TX enabled, descriptor base: {:#08x}", ethPciState.txDescriptor1BaseReg);
       }
       // Notify worker thread to process pending TX
-      workerCV.notify_one();
+      WakeWorker();
     } else if (txRing1Enabled && !(val & 0x10)) {
       // TX is being disabled.
       txRing1Enabled = false;
@@ -357,10 +361,13 @@ void Xe::PCIDev::ETHERNET::Write(u64 writeAddress, const u8 *data, u64 size) {
     if (!(ethPciState.txConfigReg & TX_CFG_RING_SEL)) { ethPciState.txDescriptor0BaseReg = val; }
     else { ethPciState.txDescriptor1BaseReg = val; }
     DEBUGP("[Write] TX_DESCRIPTOR_BASE = {:#08x}", val);
+    WakeWorker();
     break;   
   case NEXT_FREE_TX_DESCR:
     ethPciState.txDescriptorStatusReg = val;
     DEBUGP("[Write] NEXT_FREE_TX_DESCR = {:#08x}", val);
+    // Doorbell, new descriptors were queued
+    WakeWorker();
     break;
   case RX_CONFIG:
     ethPciState.rxConfigReg = val;
@@ -375,6 +382,8 @@ void Xe::PCIDev::ETHERNET::Write(u64 writeAddress, const u8 *data, u64 size) {
         rxEnabled = true;
         rxHead = 0;
         DEBUGP("RX enabled, descriptor base: {:#08x}", ethPciState.rxDescriptorBaseReg);
+        // Deliver anything that arrived while RX was off
+        WakeWorker();
       }
     } else if (rxEnabled && !(val & 0x01)) {
       // RX is being disabled
@@ -428,10 +437,8 @@ void Xe::PCIDev::ETHERNET::Write(u64 writeAddress, const u8 *data, u64 size) {
       rxEnabled = false;
       
       // Clear pending RX packets
-      {
-        std::lock_guard<std::mutex> lock(rxQueueMutex);
-        while (!pendingRxPackets.empty()) pendingRxPackets.pop();
-      }
+      rxFlushPending = true;
+      WakeWorker();
     }
     break;  
   case POWER:
@@ -501,6 +508,34 @@ void Xe::PCIDev::ETHERNET::MemSet(u64 writeAddress, s32 data, u64 size) {
   Write(writeAddress, buffer, size);
 }
 
+// Save states
+void Xe::PCIDev::ETHERNET::SerializeState(Xe::SaveState::StateStream &stream) {
+  PCIDevice::SerializeState(stream);
+  stream.Do(ethPciState, mdioRegisters, txRing0Head, txRing1Head, txRing0Tail, txRing1Tail, rxHead, rxTail);
+  stream.DoAtomic(rxEnabled);
+  stream.DoAtomic(txRing0Enabled);
+  stream.DoAtomic(txRing1Enabled);
+  stream.DoAtomic(linkUp);
+  stream.DoAtomic(enableInterrutps);
+  if (stream.IsLoading()) {
+    // Whatever the backend queued belongs to the session the state replaced
+    rxFlushPending = true;
+  }
+}
+
+void Xe::PCIDev::ETHERNET::Quiesce() {
+  std::lock_guard<std::mutex> lock(workerPauseMutex);
+  workerPaused = true;
+}
+
+void Xe::PCIDev::ETHERNET::Resume() {
+  {
+    std::lock_guard<std::mutex> lock(workerPauseMutex);
+    workerPaused = false;
+  }
+  WakeWorker();
+}
+
 // MDIO Read
 u32 Xe::PCIDev::ETHERNET::MdioRead(u32 addr) {
   // If the busy bit is set, it means that the previous write op was either a write without the write bit set 
@@ -602,6 +637,7 @@ bool Xe::PCIDev::ETHERNET::WriteTxDescriptor(bool ring0, u32 index, const XE_TX_
   }
   
   memcpy(ptr, &desc, sizeof(XE_TX_DESCRIPTOR));
+  ramPtr->MarkWritten(descAddr, sizeof(XE_TX_DESCRIPTOR));
   return true;
 }
 
@@ -634,17 +670,18 @@ bool Xe::PCIDev::ETHERNET::WriteRxDescriptor(u32 index, const XE_RX_DESCRIPTOR&
   }
   
   memcpy(ptr, &desc, sizeof(XE_RX_DESCRIPTOR));
+  ramPtr->MarkWritten(descAddr, sizeof(XE_RX_DESCRIPTOR));
   
   return true;
 }
 
 // TX Descriptors Processing
-void Xe::PCIDev::ETHERNET::ProcessTxDescriptors(bool ring0) {
+u32 Xe::PCIDev::ETHERNET::ProcessTxDescriptors(bool ring0) {
   bool txEnabled = ring0 ? txRing0Enabled : txRing1Enabled;
   bool baseRegValid = ring0 ? ethPciState.txDescriptor0BaseReg != 0 : ethPciState.txDescriptor1BaseReg != 0;
   
   // Check TX enabled and valid base reg
-  if (!txEnabled || !baseRegValid) { return; }
+  if (!txEnabled || !baseRegValid) { return 0; }
   
   // Get descriptor count
   u8 descriptorCount = ring0 ? NUM_RING0_TX_DESCRIPTORS : NUM_RING1_TX_DESCRIPTORS;
@@ -707,22 +744,25 @@ void Xe::PCIDev::ETHERNET::ProcessTxDescriptors(bool ring0) {
   if (processedCount > 0) {
     RaiseInterrupt(ring0 ? INT_TX_RING0: INT_TX_RING1);
   }
+  return processedCount;
 }
 // RX Descriptors Processing
-void Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
+// Drains every queued frame in one go, each one is copied once, from its pooled buffer into the guest buffer.
+u32 Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
 
-  if (!rxEnabled || ethPciState.rxDescriptorBaseReg == 0) { return; }
-  
-  std::lock_guard<std::mutex> lock(rxQueueMutex);
+  if (!rxEnabled || ethPciState.rxDescriptorBaseReg == 0) { return 0; }
   
   u32 processedCount = 0;
   
-  while (!pendingRxPackets.empty()) {
+  Network::PacketBuffer* packet = nullptr;
+  while (pendingRxPackets.TryPop(packet)) {
     XE_RX_DESCRIPTOR desc;
     u32 index = rxHead;
     
     if (!ReadRxDescriptor(index, desc)) {
       LOG_ERROR(ETH, "Failed to read RX descriptor {}", index);
+      stats.rxDropped++;
+      rxPool.Release(packet);
       break;
     }
     
@@ -730,7 +770,7 @@ void Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
     if (!(desc.status & RX_DESC_OWN)) {
       LOG_WARNING(ETH, "RX ring full, dropping packet and signaling interrupt to guest OS.");
       stats.rxDropped++;
-      pendingRxPackets.pop();
+      rxPool.Release(packet);
       // Re enable interrupts, since if we're here, it means that the OS ethernet interrupt handler didn't got triggered.
       enableInterrutps.store(true);
       // Raise interrupt siganling we're full
@@ -741,12 +781,11 @@ void Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
     // Get buffer size from descr[3] (bufferSizeWrap, lower 16 bits)
     u32 bufferSize = desc.bufferSizeWrap & 0xFFFF;
     
-    EthernetPacket& packet = pendingRxPackets.front();
-    u32 copyLen = packet.length;
+    u32 copyLen = packet->length;
     
     if (copyLen > bufferSize) {
       LOG_WARNING(ETH, "RX packet ({}) exceeds buffer size ({}), truncating", 
-        packet.length, bufferSize);
+        packet->length, bufferSize);
       copyLen = bufferSize;
       stats.rxOverruns++;
     }
@@ -768,14 +807,19 @@ void Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
       WriteRxDescriptor(index, desc);
       
       stats.rxErrors++;
-      pendingRxPackets.pop();
+      rxPool.Release(packet);
       
       // Check wrap bit in descr[3]
       rxHead = (desc.bufferSizeWrap & 0x80000000) ? 0 : ((rxHead + 1) % NUM_RX_DESCRIPTORS);
       continue;
     }
     
-    memcpy(bufferPtr, packet.data.data(), copyLen);
+    memcpy(bufferPtr, packet->data, copyLen);
+    ramPtr->MarkWritten(desc.bufferAddress, copyLen);
+    if (capture) {
+      capture->Capture(packet->data, copyLen, Network::CaptureDirection::Inbound);
+    }
+    rxPool.Release(packet);
     
     // Update descriptor:
     // descr[0] (receivedLength) = actual received length
@@ -798,23 +842,33 @@ void Xe::PCIDev::ETHERNET::ProcessRxDescriptors() {
     
     DEBUGP("RX: desc={}, len={}, buf={:#08x}", index, copyLen, desc.bufferAddress);
     
-    pendingRxPackets.pop();
-    
     // Check wrap bit in descr[3] (bit 31)
     rxHead = (desc.bufferSizeWrap & 0x80000000) ? 0 : ((rxHead + 1) % NUM_RX_DESCRIPTORS);
   }
   
   // Raise RX interrupt ONCE after batch processing
-  // TODO: Fixed batch sets?
   if (processedCount > 0) {
     RaiseInterrupt(INT_RX_DONE);
   }
+  return processedCount;
+}
+
+// Returns every queued RX frame to the pool
+void Xe::PCIDev::ETHERNET::DropPendingRxPackets() {
+  Network::PacketBuffer* packet = nullptr;
+  while (pendingRxPackets.TryPop(packet)) {
+    rxPool.Release(packet);
+  }
 }
 
 // Handle incomming TX packet from guest
 void Xe::PCIDev::ETHERNET::HandleTxPacket(const u8* data, u32 len) {
   if (!data || len == 0) { return; }
   
+  if (capture) {
+    capture->Capture(data, len, Network::CaptureDirection::Outbound);
+  }
+  
   // Try to send through network bridge first
   auto& bridge = Network::GetNetworkBridge();
   if (bridge.IsActive() && bridge.GetBackend()) {
@@ -839,35 +893,48 @@ void Xe::PCIDev::ETHERNET::HandleTxPacket(const u8* data, u32 len) {
 void Xe::PCIDev::ETHERNET::EnqueueRxPacket(const u8* data, u32 length) {
   if (!data || length == 0) { return; }
   
-  EthernetPacket packet;
-  packet.data.resize(length);
-  memcpy(packet.data.data(), data, length);
-  packet.length = length;
+  if (length > NET_PACKET_BUFFER_SIZE) {
+    stats.rxDropped++;
+    return;
+  }
   
-  {
-    std::lock_guard<std::mutex> lock(rxQueueMutex);
-    
-    // Limit queue size
-    if (pendingRxPackets.size() < 256) {
-      pendingRxPackets.push(std::move(packet));
-      
-      // Notify worker thread
-      workerCV.notify_one();
-    } else {
-      stats.rxDropped++;
-    }
+  // Counted as dropped by AcquireRxBuffer when the pool is empty
+  Network::PacketBuffer* packet = AcquireRxBuffer();
+  if (!packet) {
+    return;
   }
+  
+  memcpy(packet->data, data, length);
+  packet->length = length;
+  SubmitRxBuffer(packet);
+  CommitRx();
 }
 
-// Dequeues a pending RX packet
-bool Xe::PCIDev::ETHERNET::DequeueRxPacket(EthernetPacket& packet) {
-  std::lock_guard<std::mutex> lock(rxQueueMutex);
-  
-  if (pendingRxPackets.empty()) { return false; }
+// Takes a free RX buffer from the pool, nullptr if the guest has fallen behind and all of them are queued
+Xe::Network::PacketBuffer* Xe::PCIDev::ETHERNET::AcquireRxBuffer() {
+  Network::PacketBuffer* packet = rxPool.Acquire();
+  if (!packet) {
+    stats.rxDropped++;
+  }
+  return packet;
+}
 
-  packet = std::move(pendingRxPackets.front());
-  pendingRxPackets.pop();
-  return true;
+// Queues a received frame for the worker
+void Xe::PCIDev::ETHERNET::SubmitRxBuffer(Network::PacketBuffer* buffer) {
+  // The queue holds as many entries as there are buffers, so this can't fail
+  pendingRxPackets.TryPush(buffer);
+}
+
+// Returns an unused RX buffer
+void Xe::PCIDev::ETHERNET::ReleaseRxBuffer(Network::PacketBuffer* buffer) {
+  rxPool.Release(buffer);
+}
+
+// Wakes the worker once for a whole batch of frames
+void Xe::PCIDev::ETHERNET::CommitRx() {
+  if (!pendingRxPackets.Empty()) {
+    WakeWorker();
+  }
 }
 
 // Changes link state and update internal regs
@@ -947,19 +1014,38 @@ void Xe::PCIDev::ETHERNET::ConfigWrite(u64 writeAddress, const u8 *data, u64 siz
   memcpy(&pciConfigSpace.data[static_cast<u8>(writeAddress)], &tmp, size);
 }
 
+// Wakes the worker thread. Only the first wake before the worker runs takes the lock.
+void Xe::PCIDev::ETHERNET::WakeWorker() {
+  if (workerPending.exchange(true)) {
+    return;
+  }
+  // Taking the lock orders this with the worker checking its predicate and going to sleep
+  { std::lock_guard<std::mutex> lock(workerMutex); }
+  workerCV.notify_one();
+}
+
 // Worker Thread loop
 void Xe::PCIDev::ETHERNET::WorkerThreadLoop() {
   Base::SetCurrentThreadName("[Xe] Ethernet");
 
   DEBUGP("Ethernet worker thread started");
 
+  // Current TX rescan interval
+  u32 txPollInterval = ETH_TX_POLL_MIN_US;
+
   while (workerRunning && XeRunning) {
-    // Wait for work or timeout
+    // Wait for a doorbell, RX frames, or the next TX rescan
     {
       std::unique_lock<std::mutex> lock(workerMutex);
-      workerCV.wait_for(lock, std::chrono::milliseconds(1), [this] {
-        return !workerRunning || !XeRunning || ((txRing0Enabled || txRing1Enabled)) || (!pendingRxPackets.empty() && rxEnabled);
-        });
+      auto ready = [this] {
+        return !workerRunning || !XeRunning || workerPending.load();
+      };
+      if (txRing0Enabled || txRing1Enabled) {
+        workerCV.wait_for(lock, std::chrono::microseconds(txPollInterval), ready);
+      } else {
+        workerCV.wait(lock, ready);
+      }
+      workerPending = false;
     }
 
     // Check for shutdown
@@ -967,20 +1053,36 @@ void Xe::PCIDev::ETHERNET::WorkerThreadLoop() {
       break;
     }
 
+    // Held for a save state
+    std::unique_lock<std::mutex> pauseLock(workerPauseMutex);
+    if (workerPaused) {
+      continue;
+    }
+
+    // Drop frames queued before a reset
+    if (rxFlushPending.exchange(false)) {
+      DropPendingRxPackets();
+    }
+
+    u32 processedCount = 0;
+
     // Process TX queue
     if (txRing0Enabled) {
-      ProcessTxDescriptors(true);
+      processedCount += ProcessTxDescriptors(true);
     }
 
     if (txRing1Enabled) {
-      ProcessTxDescriptors(false);
+      processedCount += ProcessTxDescriptors(false);
     }
 
     // Process RX queue
     if (rxEnabled) {
-      ProcessRxDescriptors();
+      processedCount += ProcessRxDescriptors();
     }
+
+    // Poll quickly while traffic flows, back off while the rings stay idle
+    txPollInterval = processedCount ? ETH_TX_POLL_MIN_US : std::min<u32>(txPollInterval * 2, ETH_TX_POLL_MAX_US);
   }
 
   DEBUGP("Ethernet worker thread stopped");
-}
\ No newline at end of file
+}
@@ -11,8 +11,8 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 #include <array>
@@ -21,6 +21,9 @@
 #include "Core/PCI/Bridge/PCIBridge.h"
 #include "Core/PCI/PCIDevice.h"
 
+#include "Network/PacketPool.h"
+#include "Network/PcapFile.h"
+
 #define ETHERNET_DEV_SIZE 0x80
 
 // Maximum Ethernet frame size (including VLAN tag)
@@ -38,6 +41,11 @@
 #define NUM_RING1_TX_DESCRIPTORS 8
 #define NUM_RX_DESCRIPTORS 64 
 
+// The guest queues TX descriptors in memory, which we aren't told about, so while a TX ring is enabled
+// the worker also rescans it. The interval starts at the minimum after any activity and doubles while idle.
+#define ETH_TX_POLL_MIN_US 100
+#define ETH_TX_POLL_MAX_US 8000
+
 namespace Xe {
 namespace PCIDev {
 
@@ -223,12 +231,6 @@ struct XE_PCI_STATE {
   u8 macAddress2[6] = {0};
 };
 
-// Packet buffer structure for pending TX/RX
-struct EthernetPacket {
-  std::vector<u8> data; // Packet data buffer
-  u32 length = 0;       // Data lenght
-};
-
 // Ethernet device statistics
 struct EthernetStats {
   std::atomic<u64> txPackets{0};
@@ -244,7 +246,7 @@ struct EthernetStats {
   std::atomic<u64> rxOverruns{0};
 };
 
-class ETHERNET : public PCIDevice {
+class ETHERNET : public PCIDevice, public Network::IPacketSink {
 public:
   ETHERNET(const std::string &deviceName, u64 size, PCIBridge *parentPCIBridge, RAM *ram);
   ~ETHERNET();
@@ -255,9 +257,20 @@ public:
   void ConfigRead(u64 readAddress, u8* data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8* data, u64 size) override;
 
-  // External interface for future bridge support
+  // Save states. Frames the backend received, but the guest hasn't been handed yet, are dropped.
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+  // Holds the worker between passes over the rings until Resume()
+  void Quiesce() override;
+  void Resume() override;
+
+  // External interface for backends without pooled buffer support, copies the frame into the pool
   void EnqueueRxPacket(const u8* data, u32 length);
-  bool DequeueRxPacket(EthernetPacket& packet);
+
+  // Network::IPacketSink, backends receive straight into our pooled RX buffers
+  Network::PacketBuffer* AcquireRxBuffer() override;
+  void SubmitRxBuffer(Network::PacketBuffer* buffer) override;
+  void ReleaseRxBuffer(Network::PacketBuffer* buffer) override;
+  void CommitRx() override;
   
   // Get statistics
   const EthernetStats& GetStats() const { return stats; }
@@ -274,9 +287,11 @@ private:
   u32 MdioRead(u32 addr);
   void MdioWrite(u32 val);
   
-  // Descriptor ring processing
-  void ProcessRxDescriptors();
-  void ProcessTxDescriptors(bool ring0);
+  // Descriptor ring processing, returns the number of descriptors handled
+  u32 ProcessRxDescriptors();
+  u32 ProcessTxDescriptors(bool ring0);
+  // Returns every queued RX frame to the pool
+  void DropPendingRxPackets();
   
   // Packet handling
   void HandleTxPacket(const u8 *data, u32 len);
@@ -286,6 +301,8 @@ private:
   
   // Worker thread
   void WorkerThreadLoop();
+  // Tells the worker there's something to do (register doorbell, RX frames, reset)
+  void WakeWorker();
   
   // Descriptor operations
   bool ReadTxDescriptor(bool ring0, u32 index, XE_TX_DESCRIPTOR& desc);
@@ -328,18 +345,28 @@ private:
   u32 rxHead = 0;  // Next descriptor to process (hardware)
   u32 rxTail = 0;  // Next descriptor to be filled (software)
   
-  // Pending RX packets (received from bridge/external)
-  std::queue<EthernetPacket> pendingRxPackets;
-  std::mutex rxQueueMutex;  // RX Queue mutex
+  // RX buffers, filled by the network backend and queued until the worker copies them into guest memory
+  Network::PacketPool rxPool;
+  Network::PacketRing<Network::PacketBuffer*, NET_PACKET_POOL_SIZE> pendingRxPackets;
+  // Set on reset, the worker drops the queued frames (it's the only consumer of the queue)
+  std::atomic<bool> rxFlushPending{false};
   
   // Statistics
   EthernetStats stats;
+
+  // Traffic capture, when enabled
+  std::unique_ptr<Network::PcapWriter> capture;
   
   // Worker thread
   std::thread workerThread;
   std::atomic<bool> workerRunning{false};
   std::condition_variable workerCV;
   std::mutex workerMutex;
+  // Set by WakeWorker, cleared by the worker when it picks the work up
+  std::atomic<bool> workerPending{false};
+  // Held by the worker while it processes the rings, workerPaused keeps it from starting another pass
+  std::mutex workerPauseMutex;
+  bool workerPaused = false;
 };
 
 } // namespace PCIDev
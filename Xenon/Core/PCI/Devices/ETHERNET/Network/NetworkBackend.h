@@ -4,7 +4,7 @@
 
 //
 // Network Backend Interface
-// Abstract interface for different network backends (TAP, etc...)
+// Abstract interface for different network backends (TAP, virtual switch, etc...)
 //
 
 #pragma once
@@ -16,6 +16,8 @@
 
 #include "Base/Types.h"
 
+#include "PacketPool.h"
+
 namespace Xe {
 namespace Network {
 
@@ -23,6 +25,8 @@ namespace Network {
 enum class BackendType {
   None,       // No networking (packets dropped)
   TAP,        // TAP/TUN virtual network device
+  Switch,     // Shared memory virtual switch between emulator instances
+  Replay,     // Plays back the received frames of a capture
 };
 
 // Packet received callback
@@ -61,6 +65,10 @@ public:
   
   // Set the callback for received packets
   virtual void SetPacketCallback(PacketCallback callback) = 0;
+
+  // Set a sink to receive packets straight into its pooled buffers, nullptr to go back to the callback.
+  // Backends that can't read into caller provided buffers keep using the callback.
+  virtual bool SetPacketSink(IPacketSink* /*sink*/) { return false; }
   
   // Get the backend type
   virtual BackendType GetType() const = 0;
@@ -115,6 +123,10 @@ private:
   BackendStats stats;
 };
 
+// Guest time in ns, taken from the CPU time base (0 until the CPU exists and starts its time base).
+// Captures are stamped and replays are paced with it, so they follow the emulated machine, not the host.
+u64 GetGuestTimeNs();
+
 // Factory function to create backend based on type
 std::unique_ptr<INetworkBackend> CreateNetworkBackend(BackendType type, const std::string& config);
 
@@ -124,6 +136,8 @@ inline std::string BackendTypeToString(BackendType type) {
   switch (type) {
   case BackendType::None: return "none";
   case BackendType::TAP: return "tap";
+  case BackendType::Switch: return "switch";
+  case BackendType::Replay: return "replay";
   default: return "unknown";
   }
 }
@@ -132,6 +146,8 @@ inline std::string BackendTypeToString(BackendType type) {
 inline BackendType StringToBackendType(const std::string& str) {
   // TODO: Add future backends.
   if (str == "tap" || str == "TAP") return BackendType::TAP;
+  if (str == "switch" || str == "loopback") return BackendType::Switch;
+  if (str == "replay") return BackendType::Replay;
   return BackendType::None;
 }
 
@@ -8,9 +8,12 @@
 
 #include "NetworkBridge.h"
 #include "TAPBackend.h"
+#include "SwitchBackend.h"
+#include "ReplayBackend.h"
 #include "../Ethernet.h"
 
 #include "Base/Logging/Log.h"
+#include "Core/XeMain.h"
 
 namespace Xe {
 namespace Network {
@@ -22,12 +25,28 @@ std::unique_ptr<INetworkBackend> CreateNetworkBackend(BackendType type, const st
     TAPConfig tapConfig = ParseTAPConfig(config);
     return std::make_unique<TAPBackend>(tapConfig);
   }
+  case BackendType::Switch: {
+    SwitchConfig switchConfig = ParseSwitchConfig(config);
+    return std::make_unique<SwitchBackend>(switchConfig);
+  }
+  case BackendType::Replay: {
+    ReplayConfig replayConfig = ParseReplayConfig(config);
+    return std::make_unique<ReplayBackend>(replayConfig);
+  }
   case BackendType::None:
   default:
     return std::make_unique<NullBackend>();
   }
 }
 
+u64 GetGuestTimeNs() {
+  // The time base runs at 50MHz, 20ns a tick
+  if (XCPU::XenonCPU *cpu = XeMain::GetCPU()) {
+    return cpu->GetTimeBase() * 20;
+  }
+  return 0;
+}
+
 NetworkBridge::NetworkBridge() = default;
 
 NetworkBridge::~NetworkBridge() {
@@ -100,6 +119,12 @@ void NetworkBridge::Shutdown() {
 }
 
 void NetworkBridge::AttachEthernetDevice(PCIDev::ETHERNET* device) {
+  // Hand the device's RX pool to the backend, so frames are read straight into it.
+  // Done outside deviceMutex, the backend holds its own lock while delivering through OnPacketReceived.
+  if (backend) {
+    backend->SetPacketSink(device);
+  }
+  
   std::lock_guard<std::mutex> lock(deviceMutex);
   
   if (ethernetDevice) {
@@ -125,11 +150,18 @@ void NetworkBridge::AttachEthernetDevice(PCIDev::ETHERNET* device) {
 }
 
 void NetworkBridge::DetachEthernetDevice() {
-  std::lock_guard<std::mutex> lock(deviceMutex);
+  {
+    std::lock_guard<std::mutex> lock(deviceMutex);
+    
+    if (ethernetDevice) {
+      ethernetDevice = nullptr;
+      LOG_INFO(ETH, "Ethernet device detached from network bridge");
+    }
+  }
   
-  if (ethernetDevice) {
-    ethernetDevice = nullptr;
-    LOG_INFO(ETH, "Ethernet device detached from network bridge");
+  // Waits for the backend to let go of any pooled buffer
+  if (backend) {
+    backend->SetPacketSink(nullptr);
   }
 }
 
@@ -0,0 +1,147 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Pooled Packet Buffers
+// Fixed set of MTU sized buffers handed between network backends and the Ethernet device,
+// through lock-free rings, so received frames are never heap allocated or copied in between.
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "Base/Types.h"
+
+namespace Xe {
+namespace Network {
+
+// Large enough for any Ethernet frame (1522 with a VLAN tag)
+#define NET_PACKET_BUFFER_SIZE 2048
+// Buffers in the RX pool (power of 2)
+#define NET_PACKET_POOL_SIZE 256
+// Frames a backend reads in one go before waking the device
+#define NET_RX_BATCH_SIZE 32
+
+struct PacketBuffer {
+  u32 length = 0;
+  alignas(64) u8 data[NET_PACKET_BUFFER_SIZE];
+};
+
+// Bounded lock-free multi producer, multi consumer ring.
+// Each slot carries a sequence number telling producers and consumers whose turn it is.
+template <typename T, u32 Capacity>
+class PacketRing {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+public:
+  PacketRing() {
+    for (u32 i = 0; i != Capacity; ++i)
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bool TryPush(T value) {
+    u64 position = writePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[position & (Capacity - 1)];
+      const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+      const s64 difference = static_cast<s64>(sequence) - static_cast<s64>(position);
+      if (difference == 0) {
+        if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // Full
+        return false;
+      } else {
+        position = writePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(T &value) {
+    u64 position = readPosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots[position & (Capacity - 1)];
+      const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+      const s64 difference = static_cast<s64>(sequence) - static_cast<s64>(position + 1);
+      if (difference == 0) {
+        if (readPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = slot.value;
+          slot.sequence.store(position + Capacity, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // Empty
+        return false;
+      } else {
+        position = readPosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool Empty() const {
+    return readPosition.load(std::memory_order_acquire) == writePosition.load(std::memory_order_acquire);
+  }
+
+private:
+  struct Slot {
+    std::atomic<u64> sequence{ 0 };
+    T value{};
+  };
+
+  alignas(128) std::atomic<u64> writePosition{ 0 };
+  alignas(128) std::atomic<u64> readPosition{ 0 };
+  alignas(128) Slot slots[Capacity];
+};
+
+// Owner of a fixed set of buffers, free ones wait in a ring so any thread can take or return one
+template <typename T, u32 Count>
+class BufferPool {
+public:
+  BufferPool() : buffers(std::make_unique<T[]>(Count)) {
+    for (u32 i = 0; i != Count; ++i)
+      freeBuffers.TryPush(&buffers[i]);
+  }
+
+  // Free buffer, or nullptr when every buffer is in use
+  T *Acquire() {
+    T *buffer = nullptr;
+    freeBuffers.TryPop(buffer);
+    return buffer;
+  }
+
+  void Release(T *buffer) {
+    buffer->length = 0;
+    freeBuffers.TryPush(buffer);
+  }
+
+private:
+  std::unique_ptr<T[]> buffers{};
+  PacketRing<T *, Count> freeBuffers{};
+};
+
+using PacketPool = BufferPool<PacketBuffer, NET_PACKET_POOL_SIZE>;
+
+// Receiver of pooled frames, implemented by the Ethernet device.
+// Backends fill buffers taken from AcquireRxBuffer and hand them back through SubmitRxBuffer,
+// calling CommitRx once per batch so the device only wakes up once for all of them.
+class IPacketSink {
+public:
+  virtual ~IPacketSink() = default;
+
+  // Buffer to receive a frame into, nullptr when none are free (the frame should be dropped)
+  virtual PacketBuffer *AcquireRxBuffer() = 0;
+  // Queues a received frame, buffer->length must be set
+  virtual void SubmitRxBuffer(PacketBuffer *buffer) = 0;
+  // Returns a buffer that ended up unused
+  virtual void ReleaseRxBuffer(PacketBuffer *buffer) = 0;
+  // Wakes the device for everything submitted so far
+  virtual void CommitRx() = 0;
+};
+
+} // namespace Network
+} // namespace Xe
@@ -0,0 +1,387 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Packet Capture Files Implementation
+//
+
+#include "PcapFile.h"
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Xe {
+namespace Network {
+
+// pcapng option codes
+#define PCAPNG_OPT_END 0
+#define PCAPNG_OPT_SHB_USERAPPL 4
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_IF_TSRESOL 9
+#define PCAPNG_OPT_EPB_FLAGS 2
+
+template <typename T>
+static void Append(std::vector<u8> &buffer, T value) {
+  const u8 *bytes = reinterpret_cast<const u8 *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+static void AppendPadded(std::vector<u8> &buffer, const u8 *data, u32 length) {
+  buffer.insert(buffer.end(), data, data + length);
+  buffer.resize((buffer.size() + 3) & ~3ull, 0);
+}
+
+static void AppendOption(std::vector<u8> &buffer, u16 code, const void *value, u16 length) {
+  Append<u16>(buffer, code);
+  Append<u16>(buffer, length);
+  AppendPadded(buffer, static_cast<const u8 *>(value), length);
+}
+
+PcapWriter::PcapWriter(const std::string &path) {
+  file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR(ETH, "Capture: Unable to open '{}' for writing", path);
+    return;
+  }
+  wallStart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  guestStart = GetGuestTimeNs();
+  WriteHeader();
+
+  writerRunning = true;
+  writerThread = std::thread(&PcapWriter::WriterThreadLoop, this);
+  LOG_INFO(ETH, "Capture: Writing frames to '{}'", path);
+}
+
+PcapWriter::~PcapWriter() {
+  if (writerThread.joinable()) {
+    writerRunning = false;
+    { std::lock_guard<std::mutex> lock(writerMutex); }
+    writerCV.notify_one();
+    writerThread.join();
+  }
+  if (file.is_open()) {
+    LOG_INFO(ETH, "Capture: {} frame(s) written, {} dropped", GetCapturedCount(), GetDroppedCount());
+    file.close();
+  }
+}
+
+void PcapWriter::Capture(const u8 *data, u32 length, CaptureDirection direction) {
+  if (!writerRunning) {
+    return;
+  }
+  CaptureRecord *record = records.Acquire();
+  if (!record) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  record->length = std::min<u32>(length, NET_PACKET_BUFFER_SIZE);
+  record->direction = direction;
+  record->timestamp = GetGuestTimeNs();
+  memcpy(record->data, data, record->length);
+  queue.TryPush(record);
+
+  // Only the first frame of a batch takes the lock
+  if (!writerPending.exchange(true)) {
+    { std::lock_guard<std::mutex> lock(writerMutex); }
+    writerCV.notify_one();
+  }
+}
+
+void PcapWriter::WriterThreadLoop() {
+  Base::SetCurrentThreadName("[Xe] Ethernet Capture");
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(writerMutex);
+      writerCV.wait(lock, [this] { return writerPending.load() || !writerRunning; });
+      writerPending = false;
+    }
+
+    CaptureRecord *record = nullptr;
+    bool wrote = false;
+    while (queue.TryPop(record)) {
+      WriteRecord(*record);
+      records.Release(record);
+      wrote = true;
+    }
+    if (wrote) {
+      file.flush();
+    }
+
+    if (!writerRunning && queue.Empty()) {
+      break;
+    }
+  }
+}
+
+void PcapWriter::WriteHeader() {
+  // Section Header Block
+  std::vector<u8> body{};
+  Append<u32>(body, PCAPNG_BYTE_ORDER_MAGIC);
+  Append<u16>(body, 1); // Major version
+  Append<u16>(body, 0); // Minor version
+  Append<s64>(body, -1); // Section length, unknown
+  static constexpr char application[] = "Xenon";
+  AppendOption(body, PCAPNG_OPT_SHB_USERAPPL, application, sizeof(application) - 1);
+  AppendOption(body, PCAPNG_OPT_END, nullptr, 0);
+  WriteBlock(PCAPNG_SECTION_HEADER, body);
+
+  // Interface Description Block, the only interface is the guest NIC
+  body.clear();
+  Append<u16>(body, PCAP_LINKTYPE_ETHERNET);
+  Append<u16>(body, 0); // Reserved
+  Append<u32>(body, 0); // Snap length, unlimited
+  static constexpr char name[] = "xenon-eth";
+  AppendOption(body, PCAPNG_OPT_IF_NAME, name, sizeof(name) - 1);
+  const u8 resolution = 9; // Nanoseconds
+  AppendOption(body, PCAPNG_OPT_IF_TSRESOL, &resolution, sizeof(resolution));
+  AppendOption(body, PCAPNG_OPT_END, nullptr, 0);
+  WriteBlock(PCAPNG_INTERFACE_DESCRIPTION, body);
+}
+
+void PcapWriter::WriteRecord(const CaptureRecord &record) {
+  const u64 timestamp = wallStart + (record.timestamp - guestStart);
+
+  // Enhanced Packet Block
+  std::vector<u8> &body = block;
+  body.clear();
+  Append<u32>(body, 0); // Interface
+  Append<u32>(body, static_cast<u32>(timestamp >> 32));
+  Append<u32>(body, static_cast<u32>(timestamp));
+  Append<u32>(body, record.length); // Captured length
+  Append<u32>(body, record.length); // Original length
+  AppendPadded(body, record.data, record.length);
+  if (record.direction != CaptureDirection::Unknown) {
+    const u32 flags = static_cast<u32>(record.direction);
+    AppendOption(body, PCAPNG_OPT_EPB_FLAGS, &flags, sizeof(flags));
+    AppendOption(body, PCAPNG_OPT_END, nullptr, 0);
+  }
+  WriteBlock(PCAPNG_ENHANCED_PACKET, body);
+  captured.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PcapWriter::WriteBlock(u32 type, const std::vector<u8> &body) {
+  const u32 totalLength = static_cast<u32>(body.size()) + 12;
+  file.write(reinterpret_cast<const char *>(&type), sizeof(type));
+  file.write(reinterpret_cast<const char *>(&totalLength), sizeof(totalLength));
+  file.write(reinterpret_cast<const char *>(body.data()), body.size());
+  file.write(reinterpret_cast<const char *>(&totalLength), sizeof(totalLength));
+}
+
+//
+// Reader
+//
+
+template <typename T>
+static bool Extract(const std::vector<u8> &buffer, u64 offset, T &value) {
+  if (offset + sizeof(T) > buffer.size())
+    return false;
+  memcpy(&value, buffer.data() + offset, sizeof(T));
+  return true;
+}
+
+static bool ReadClassicPcap(const std::vector<u8> &file, u32 magic, PcapCapture &capture) {
+  u32 linkType = 0;
+  Extract(file, 20, linkType);
+  if (linkType != PCAP_LINKTYPE_ETHERNET) {
+    LOG_ERROR(ETH, "Capture: Link type {} isn't Ethernet", linkType);
+    return false;
+  }
+  const u64 fractionScale = magic == PCAP_MAGIC_NS ? 1 : 1000;
+  u64 offset = 24;
+  for (;;) {
+    u32 seconds = 0, fraction = 0, capturedLength = 0, originalLength = 0;
+    if (!Extract(file, offset, seconds) || !Extract(file, offset + 4, fraction) ||
+        !Extract(file, offset + 8, capturedLength) || !Extract(file, offset + 12, originalLength))
+      break;
+    offset += 16;
+    if (offset + capturedLength > file.size()) {
+      LOG_WARNING(ETH, "Capture: Truncated record at {:#x}", offset);
+      break;
+    }
+    PcapFrame frame{};
+    frame.timestamp = static_cast<u64>(seconds) * 1000000000 + fraction * fractionScale;
+    frame.offset = capture.data.size();
+    frame.length = capturedLength;
+    capture.data.insert(capture.data.end(), file.begin() + offset, file.begin() + offset + capturedLength);
+    capture.frames.push_back(frame);
+    offset += capturedLength;
+  }
+  return true;
+}
+
+static bool ReadPcapng(const std::vector<u8> &file, PcapCapture &capture) {
+  struct Interface {
+    u16 linkType = 0;
+    // Timestamp units per second
+    u64 unitsPerSecond = 1000000;
+  };
+  std::vector<Interface> interfaces{};
+  u64 lastTimestamp = 0;
+
+  u64 offset = 0;
+  for (;;) {
+    u32 type = 0, length = 0;
+    if (!Extract(file, offset, type) || !Extract(file, offset + 4, length))
+      break;
+    if (length < 12 || (length & 3) || offset + length > file.size()) {
+      LOG_WARNING(ETH, "Capture: Corrupt block at {:#x}", offset);
+      break;
+    }
+    const u64 body = offset + 8;
+    const u64 bodyEnd = offset + length - 4;
+    // Every field read below is checked against bodyEnd first, so nothing is read from the next block
+    // and no length is taken off a body that's shorter than it
+    const auto fits = [bodyEnd](u64 start, u64 size) { return start <= bodyEnd && size <= bodyEnd - start; };
+
+    switch (type) {
+    case PCAPNG_SECTION_HEADER: {
+      if (!fits(body, 4)) {
+        LOG_WARNING(ETH, "Capture: Corrupt section header at {:#x}", offset);
+        return false;
+      }
+      u32 byteOrder = 0;
+      Extract(file, body, byteOrder);
+      if (byteOrder != PCAPNG_BYTE_ORDER_MAGIC) {
+        LOG_ERROR(ETH, "Capture: Big endian pcapng sections aren't supported");
+        return false;
+      }
+      // Interface ids are per section
+      interfaces.clear();
+    } break;
+    case PCAPNG_INTERFACE_DESCRIPTION: {
+      Interface iface{};
+      if (!fits(body, 8)) {
+        // Still takes its id, so later packet blocks reference the right interface
+        LOG_WARNING(ETH, "Capture: Invalid interface block at {:#x}", offset);
+        interfaces.push_back(iface);
+        break;
+      }
+      Extract(file, body, iface.linkType);
+      // Options follow the fixed part
+      u64 option = body + 8;
+      while (fits(option, 4)) {
+        u16 code = 0, optionLength = 0;
+        Extract(file, option, code);
+        Extract(file, option + 2, optionLength);
+        if (code == PCAPNG_OPT_END || !fits(option + 4, optionLength))
+          break;
+        if (code == PCAPNG_OPT_IF_TSRESOL && optionLength >= 1) {
+          const u8 resolution = file[option + 4];
+          const u32 exponent = resolution & 0x7F;
+          iface.unitsPerSecond = 1;
+          for (u32 i = 0; i != exponent && i != 19; ++i)
+            iface.unitsPerSecond *= (resolution & 0x80) ? 2 : 10;
+        }
+        option += 4 + ((optionLength + 3) & ~3u);
+      }
+      interfaces.push_back(iface);
+    } break;
+    case PCAPNG_ENHANCED_PACKET: {
+      u32 interfaceId = 0, high = 0, low = 0, capturedLength = 0;
+      if (!fits(body, 20)) {
+        LOG_WARNING(ETH, "Capture: Invalid packet block at {:#x}", offset);
+        break;
+      }
+      Extract(file, body, interfaceId);
+      Extract(file, body + 4, high);
+      Extract(file, body + 8, low);
+      Extract(file, body + 12, capturedLength);
+      const u64 data = body + 20;
+      if (interfaceId >= interfaces.size() || !fits(data, capturedLength)) {
+        LOG_WARNING(ETH, "Capture: Invalid packet block at {:#x}", offset);
+        break;
+      }
+      if (interfaces[interfaceId].linkType != PCAP_LINKTYPE_ETHERNET)
+        break;
+      PcapFrame frame{};
+      const u64 units = (static_cast<u64>(high) << 32) | low;
+      const u64 unitsPerSecond = interfaces[interfaceId].unitsPerSecond;
+      frame.timestamp = units / unitsPerSecond * 1000000000 + (units % unitsPerSecond) * 1000000000 / unitsPerSecond;
+      // epb_flags carries the direction
+      u64 option = data + ((static_cast<u64>(capturedLength) + 3) & ~3ull);
+      while (fits(option, 4)) {
+        u16 code = 0, optionLength = 0;
+        Extract(file, option, code);
+        Extract(file, option + 2, optionLength);
+        if (code == PCAPNG_OPT_END || !fits(option + 4, optionLength))
+          break;
+        if (code == PCAPNG_OPT_EPB_FLAGS && optionLength == 4) {
+          u32 flags = 0;
+          Extract(file, option + 4, flags);
+          frame.direction = static_cast<CaptureDirection>(flags & 3);
+        }
+        option += 4 + ((optionLength + 3) & ~3u);
+      }
+      frame.offset = capture.data.size();
+      frame.length = capturedLength;
+      capture.data.insert(capture.data.end(), file.begin() + data, file.begin() + data + capturedLength);
+      capture.frames.push_back(frame);
+      lastTimestamp = frame.timestamp;
+    } break;
+    case PCAPNG_SIMPLE_PACKET: {
+      // No timestamp, take the previous one
+      if (!fits(body, 4)) {
+        LOG_WARNING(ETH, "Capture: Invalid simple packet block at {:#x}", offset);
+        break;
+      }
+      u32 originalLength = 0;
+      Extract(file, body, originalLength);
+      const u32 capturedLength = std::min<u32>(originalLength, static_cast<u32>(bodyEnd - body - 4));
+      if (interfaces.empty() || interfaces[0].linkType != PCAP_LINKTYPE_ETHERNET)
+        break;
+      PcapFrame frame{};
+      frame.timestamp = lastTimestamp;
+      frame.offset = capture.data.size();
+      frame.length = capturedLength;
+      capture.data.insert(capture.data.end(), file.begin() + body + 4, file.begin() + body + 4 + capturedLength);
+      capture.frames.push_back(frame);
+    } break;
+    default:
+      // Statistics, name resolution, custom blocks...
+      break;
+    }
+    offset += length;
+  }
+  return true;
+}
+
+bool ReadPcapFile(const std::string &path, PcapCapture &capture) {
+  std::ifstream input(path, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!input.is_open()) {
+    LOG_ERROR(ETH, "Capture: Unable to open '{}'", path);
+    return false;
+  }
+  std::vector<u8> file(static_cast<u64>(input.tellg()));
+  input.seekg(0);
+  input.read(reinterpret_cast<char *>(file.data()), file.size());
+  if (!input) {
+    LOG_ERROR(ETH, "Capture: Unable to read '{}'", path);
+    return false;
+  }
+
+  capture = {};
+  u32 magic = 0;
+  Extract(file, 0, magic);
+  bool success = false;
+  if (magic == PCAPNG_SECTION_HEADER) {
+    success = ReadPcapng(file, capture);
+  } else if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+    success = ReadClassicPcap(file, magic, capture);
+  } else {
+    LOG_ERROR(ETH, "Capture: '{}' isn't a (little endian) pcap or pcapng file", path);
+  }
+  if (success) {
+    LOG_INFO(ETH, "Capture: Loaded {} frame(s) from '{}'", capture.frames.size(), path);
+  }
+  return success;
+}
+
+} // namespace Network
+} // namespace Xe
@@ -0,0 +1,117 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Packet Capture Files
+// pcapng writer for the Ethernet device, and a pcap / pcapng reader for the replay backend.
+//
+// Frames are handed to the writer from the device threads with one copy into a pooled record, a
+// dedicated thread does the formatting and file I/O, so capturing doesn't slow the data path down.
+// Timestamps follow guest time (see GetGuestTimeNs), offset to the wall clock at the start of the capture
+// so Wireshark still shows sensible dates.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "NetworkBackend.h"
+
+namespace Xe {
+namespace Network {
+
+// pcapng block types
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION 0x00000001
+#define PCAPNG_SIMPLE_PACKET 0x00000003
+#define PCAPNG_ENHANCED_PACKET 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+// Classic pcap magics, microsecond and nanosecond timestamps
+#define PCAP_MAGIC_US 0xA1B2C3D4
+#define PCAP_MAGIC_NS 0xA1B23C4D
+// LINKTYPE_ETHERNET
+#define PCAP_LINKTYPE_ETHERNET 1
+
+// Frames queued for the writer thread before new ones get dropped (power of 2)
+#define PCAP_CAPTURE_QUEUE_SIZE 1024
+
+// Matches the pcapng epb_flags direction bits
+enum class CaptureDirection : u8 {
+  Unknown = 0,
+  Inbound = 1,  // Received by the guest
+  Outbound = 2, // Sent by the guest
+};
+
+class PcapWriter {
+public:
+  explicit PcapWriter(const std::string &path);
+  // Writes out everything still queued
+  ~PcapWriter();
+
+  bool IsOpen() const { return file.is_open(); }
+
+  // Queues a frame, never blocks. Dropped (and counted) when the writer falls behind.
+  void Capture(const u8 *data, u32 length, CaptureDirection direction);
+
+  u64 GetCapturedCount() const { return captured.load(std::memory_order_relaxed); }
+  u64 GetDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+private:
+  struct CaptureRecord {
+    u32 length = 0;
+    CaptureDirection direction = CaptureDirection::Unknown;
+    // Guest time when captured
+    u64 timestamp = 0;
+    u8 data[NET_PACKET_BUFFER_SIZE];
+  };
+
+  void WriterThreadLoop();
+  void WriteHeader();
+  void WriteRecord(const CaptureRecord &record);
+  // Appends a block, padding the body to 4 bytes and adding both length fields
+  void WriteBlock(u32 type, const std::vector<u8> &body);
+
+  std::ofstream file{};
+  std::vector<u8> block{};
+  // Wall clock and guest time the capture started at, in ns
+  u64 wallStart = 0;
+  u64 guestStart = 0;
+
+  BufferPool<CaptureRecord, PCAP_CAPTURE_QUEUE_SIZE> records{};
+  PacketRing<CaptureRecord *, PCAP_CAPTURE_QUEUE_SIZE> queue{};
+  std::atomic<u64> captured = 0;
+  std::atomic<u64> dropped = 0;
+
+  std::thread writerThread{};
+  std::atomic<bool> writerRunning = false;
+  std::atomic<bool> writerPending = false;
+  std::mutex writerMutex{};
+  std::condition_variable writerCV{};
+};
+
+// A frame read back from a capture
+struct PcapFrame {
+  // Capture time in ns, only meaningful relative to the other frames
+  u64 timestamp = 0;
+  CaptureDirection direction = CaptureDirection::Unknown;
+  // Offset of the data in PcapCapture::data
+  u64 offset = 0;
+  u32 length = 0;
+};
+
+struct PcapCapture {
+  std::vector<PcapFrame> frames{};
+  std::vector<u8> data{};
+};
+
+// Loads the Ethernet frames of a pcap or pcapng file (little endian, as written on x86 / ARM hosts)
+bool ReadPcapFile(const std::string &path, PcapCapture &capture);
+
+} // namespace Network
+} // namespace Xe
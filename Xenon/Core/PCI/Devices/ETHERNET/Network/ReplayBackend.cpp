@@ -0,0 +1,225 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Replay Network Backend Implementation
+//
+
+#include "ReplayBackend.h"
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+#include "Base/Global.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Xe {
+namespace Network {
+
+// Longest the replay thread sleeps before looking at the guest clock again
+#define REPLAY_MAX_SLEEP_NS 1000000
+
+ReplayBackend::ReplayBackend(const ReplayConfig& cfg) : config(cfg) {
+}
+
+ReplayBackend::~ReplayBackend() {
+  Shutdown();
+}
+
+bool ReplayBackend::Initialize() {
+  if (ready) {
+    return true;
+  }
+
+  LOG_INFO(ETH, "Replay Backend: Loading '{}'", config.capturePath);
+
+  if (!ReadPcapFile(config.capturePath, capture)) {
+    LOG_ERROR(ETH, "Replay Backend: Failed to load '{}'", config.capturePath);
+    return false;
+  }
+
+  // Only what the guest received goes back in
+  schedule.clear();
+  for (u32 i = 0; i != capture.frames.size(); ++i) {
+    if (capture.frames[i].direction != CaptureDirection::Outbound) {
+      schedule.push_back(i);
+    }
+  }
+  // Timestamps may be out of order across interfaces
+  std::stable_sort(schedule.begin(), schedule.end(), [this](u32 a, u32 b) {
+    return capture.frames[a].timestamp < capture.frames[b].timestamp;
+  });
+  if (schedule.empty()) {
+    LOG_WARNING(ETH, "Replay Backend: '{}' has no frames to replay", config.capturePath);
+  }
+
+  replayRunning = true;
+  replayThread = std::thread(&ReplayBackend::ReplayThreadLoop, this);
+
+  ready = true;
+
+  LOG_INFO(ETH, "Replay Backend: Replaying {} frame(s) (speed {}x{}{})", schedule.size(), config.speed,
+    config.loop ? ", looping" : "", config.startOnTx ? ", from the first guest frame" : "");
+  return true;
+}
+
+void ReplayBackend::Shutdown() {
+  if (!ready) {
+    return;
+  }
+
+  ready = false;
+  replayRunning = false;
+  if (replayThread.joinable()) {
+    replayThread.join();
+  }
+
+  LOG_INFO(ETH, "Replay Backend: Shutdown complete. TX: {} packets, RX: {} packets",
+    stats.txPackets, stats.rxPackets);
+}
+
+bool ReplayBackend::SendPacket(const u8* /*data*/, u32 length) {
+  // There's no peer, the guest's frames only mark the start of the timeline
+  if (!guestSent.load(std::memory_order_relaxed)) {
+    firstTxTime.store(GetGuestTimeNs(), std::memory_order_relaxed);
+    guestSent.store(true, std::memory_order_release);
+  }
+  stats.txPackets++;
+  stats.txBytes += length;
+  return true;
+}
+
+void ReplayBackend::SetPacketCallback(PacketCallback callback) {
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  packetCallback = callback;
+}
+
+bool ReplayBackend::SetPacketSink(IPacketSink* sink) {
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  packetSink = sink;
+  return true;
+}
+
+void ReplayBackend::ReplayThreadLoop() {
+  Base::SetCurrentThreadName("[Xe] Network Replay");
+
+  if (schedule.empty()) {
+    return;
+  }
+
+  // Wait for the timeline to start
+  if (config.startOnTx) {
+    while (replayRunning && XeRunning && !guestSent.load(std::memory_order_acquire)) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(REPLAY_MAX_SLEEP_NS));
+    }
+  }
+  u64 timelineStart = config.startOnTx ? firstTxTime.load(std::memory_order_relaxed) : GetGuestTimeNs();
+
+  const u64 firstTimestamp = capture.frames[schedule.front()].timestamp;
+  const u64 duration = capture.frames[schedule.back()].timestamp - firstTimestamp;
+  const double scale = config.speed > 0.0 ? 1.0 / config.speed : 1.0;
+  size_t next = 0;
+
+  while (replayRunning && XeRunning) {
+    const u64 now = GetGuestTimeNs();
+    u64 waitNs = 0;
+    u32 delivered = 0;
+
+    {
+      std::lock_guard<std::mutex> lock(callbackMutex);
+      while (next != schedule.size() && delivered != NET_RX_BATCH_SIZE) {
+        const PcapFrame& frame = capture.frames[schedule[next]];
+        const u64 due = timelineStart + static_cast<u64>((frame.timestamp - firstTimestamp) * scale);
+        if (due > now) {
+          waitNs = due - now;
+          break;
+        }
+
+        const u8* data = capture.data.data() + frame.offset;
+        stats.rxPackets++;
+        stats.rxBytes += frame.length;
+        if (packetSink) {
+          PacketBuffer* pooled = frame.length <= NET_PACKET_BUFFER_SIZE ? packetSink->AcquireRxBuffer() : nullptr;
+          if (pooled) {
+            memcpy(pooled->data, data, frame.length);
+            pooled->length = frame.length;
+            packetSink->SubmitRxBuffer(pooled);
+          } else {
+            stats.rxDropped++;
+          }
+        } else if (packetCallback) {
+          packetCallback(data, frame.length);
+        }
+        next++;
+        delivered++;
+      }
+      if (delivered && packetSink) {
+        packetSink->CommitRx();
+      }
+    }
+
+    if (next == schedule.size()) {
+      if (!config.loop) {
+        LOG_INFO(ETH, "Replay Backend: All {} frame(s) replayed", schedule.size());
+        break;
+      }
+      // Next pass starts where this one ended, with a small gap so an instant capture doesn't spin
+      timelineStart += static_cast<u64>(duration * scale) + REPLAY_MAX_SLEEP_NS;
+      next = 0;
+      continue;
+    }
+    if (delivered == NET_RX_BATCH_SIZE) {
+      continue;
+    }
+    // Guest time doesn't run in step with the host, so never sleep long before checking again
+    std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<u64>(waitNs, REPLAY_MAX_SLEEP_NS)));
+  }
+}
+
+ReplayConfig ParseReplayConfig(const std::string& configStr) {
+  ReplayConfig config;
+
+  size_t start = 0;
+  bool first = true;
+  while (start <= configStr.size()) {
+    size_t end = configStr.find(',', start);
+    if (end == std::string::npos) {
+      end = configStr.size();
+    }
+    const std::string token = configStr.substr(start, end - start);
+    start = end + 1;
+
+    if (first) {
+      first = false;
+      config.capturePath = token;
+      continue;
+    }
+
+    if (token == "loop") {
+      config.loop = true;
+      continue;
+    }
+    const size_t equals = token.find('=');
+    const std::string key = token.substr(0, equals);
+    const std::string value = equals == std::string::npos ? "" : token.substr(equals + 1);
+    try {
+      if (key == "speed") {
+        config.speed = std::stod(value);
+      } else if (key == "start") {
+        config.startOnTx = value == "tx";
+      } else {
+        LOG_WARNING(ETH, "Replay Backend: Unknown option '{}'", token);
+      }
+    } catch (const std::exception&) {
+      LOG_WARNING(ETH, "Replay Backend: Invalid value '{}' for '{}'", value, key);
+    }
+  }
+
+  return config;
+}
+
+} // namespace Network
+} // namespace Xe
@@ -0,0 +1,90 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Replay Network Backend
+// Feeds the frames of a pcap / pcapng capture to the guest, on the capture's own timeline measured
+// in guest time, so the same traffic arrives at the same point of guest execution on every run.
+// Frames the guest sends are counted and discarded.
+//
+// Captures written by the Ethernet device mark each frame's direction, only the ones the guest
+// received are replayed. Frames without a direction (classic pcap, other tools) are all replayed.
+//
+
+#pragma once
+
+#include "NetworkBackend.h"
+#include "PcapFile.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Xe {
+namespace Network {
+
+// Replay configuration
+struct ReplayConfig {
+  std::string capturePath;  // pcap or pcapng file
+  bool loop = false;        // Start over after the last frame
+  double speed = 1.0;       // Timeline scale, 2.0 plays twice as fast
+  bool startOnTx = false;   // Start the timeline at the guest's first sent frame instead of at power on
+};
+
+class ReplayBackend : public INetworkBackend {
+public:
+  explicit ReplayBackend(const ReplayConfig& config);
+  ~ReplayBackend() override;
+
+  // INetworkBackend interface
+  bool Initialize() override;
+  void Shutdown() override;
+  bool IsReady() const override { return ready; }
+  bool SendPacket(const u8* data, u32 length) override;
+  void SetPacketCallback(PacketCallback callback) override;
+  bool SetPacketSink(IPacketSink* sink) override;
+  BackendType GetType() const override { return BackendType::Replay; }
+  std::string GetName() const override { return "Replay:" + config.capturePath; }
+  bool GetMACAddress(u8* /*mac*/) const override { return false; }
+  bool SetMACAddress(const u8* /*mac*/) override { return false; }
+  const BackendStats& GetStats() const override { return stats; }
+  bool IsLinkUp() const override { return ready; }
+
+private:
+  // Replay thread, delivers frames as they come due
+  void ReplayThreadLoop();
+
+  // Configuration
+  ReplayConfig config;
+
+  // State
+  std::atomic<bool> ready{false};
+  PcapCapture capture;
+  // Indices of the frames to replay
+  std::vector<u32> schedule;
+  // Set once the guest sent something, when the timeline waits for it
+  std::atomic<bool> guestSent{false};
+  std::atomic<u64> firstTxTime{0};
+
+  // Callback, or the sink frames are copied into. Guarded by callbackMutex.
+  PacketCallback packetCallback;
+  IPacketSink* packetSink = nullptr;
+  std::mutex callbackMutex;
+
+  // Replay thread
+  std::thread replayThread;
+  std::atomic<bool> replayRunning{false};
+
+  // Statistics
+  BackendStats stats;
+};
+
+// Helper function to parse replay config from string
+// Format: "capturePath[,loop][,speed=<factor>][,start=boot|tx]"
+// Examples: "boot.pcapng", "traffic.pcap,loop,speed=2,start=tx"
+ReplayConfig ParseReplayConfig(const std::string& configStr);
+
+} // namespace Network
+} // namespace Xe
@@ -0,0 +1,634 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Virtual Switch Network Backend Implementation
+//
+
+#include "SwitchBackend.h"
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+#include "Base/Global.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace Xe {
+namespace Network {
+
+// MAC table probe window
+#define SWITCH_FDB_PROBES 16
+// Spins on a port's sender lock before checking whether its holder is still alive
+#define SWITCH_LOCK_SPINS 1024
+// Attempts at mapping a segment that is being removed while we join
+#define SWITCH_MAP_ATTEMPTS 100
+
+// steady_clock is system wide (CLOCK_MONOTONIC / QPC), so timestamps can be compared across processes
+static u64 SwitchNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static u64 CurrentProcessId() {
+#ifdef _WIN32
+  return GetCurrentProcessId();
+#else
+  return static_cast<u64>(getpid());
+#endif
+}
+
+// Whether the process owning a port is still around
+static bool OwnerAlive(u64 owner) {
+  const u64 pid = owner - 1;
+  if (pid == CurrentProcessId()) {
+    return true;
+  }
+#ifdef _WIN32
+  HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+  if (!process) {
+    return false;
+  }
+  const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+  CloseHandle(process);
+  return alive;
+#else
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+static u64 MacToKey(const u8* mac) {
+  u64 key = 0;
+  for (u32 i = 0; i != 6; ++i) {
+    key = (key << 8) | mac[i];
+  }
+  return key;
+}
+
+static u32 FdbHash(u64 key) {
+  return static_cast<u32>((key * 0x9E3779B97F4A7C15ull) >> 32) & (SWITCH_FDB_SIZE - 1);
+}
+
+SwitchBackend::SwitchBackend(const SwitchConfig& cfg) : config(cfg) {
+}
+
+SwitchBackend::~SwitchBackend() {
+  Shutdown();
+}
+
+bool SwitchBackend::Initialize() {
+  if (ready) {
+    return true;
+  }
+
+  LOG_INFO(ETH, "Switch Backend: Joining segment '{}'", config.segmentName);
+
+  if (!MapSegment()) {
+    LOG_ERROR(ETH, "Switch Backend: Failed to map segment '{}'", config.segmentName);
+    return false;
+  }
+
+  if (!JoinSwitch()) {
+    LOG_ERROR(ETH, "Switch Backend: All {} ports on segment '{}' are in use", SWITCH_MAX_PORTS, config.segmentName);
+    UnmapSegment();
+    return false;
+  }
+
+  // Start reader thread
+  readerRunning = true;
+  readerThread = std::thread(&SwitchBackend::ReaderThreadLoop, this);
+
+  ready = true;
+
+  LOG_INFO(ETH, "Switch Backend: Connected on port {} (latency {}us, loss {}%)",
+    portIndex, config.latencyUs, config.lossPercent);
+  return true;
+}
+
+void SwitchBackend::Shutdown() {
+  if (!ready) {
+    return;
+  }
+
+  LOG_INFO(ETH, "Switch Backend: Shutting down");
+
+  ready = false;
+  readerRunning = false;
+  if (readerThread.joinable()) {
+    readerThread.join();
+  }
+
+  LeaveSwitch();
+  UnmapSegment();
+
+  LOG_INFO(ETH, "Switch Backend: Shutdown complete. TX: {} packets, RX: {} packets",
+    stats.txPackets, stats.rxPackets);
+}
+
+void SwitchBackend::SetPacketCallback(PacketCallback callback) {
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  packetCallback = callback;
+}
+
+bool SwitchBackend::SetPacketSink(IPacketSink* sink) {
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  packetSink = sink;
+  return true;
+}
+
+bool SwitchBackend::MapSegment() {
+  for (u32 attempt = 0; attempt != SWITCH_MAP_ATTEMPTS; ++attempt) {
+    bool retry = false;
+    if (TryMapSegment(retry)) {
+      return true;
+    }
+    if (!retry) {
+      return false;
+    }
+    // The last user is removing the segment, a fresh one gets created once it's gone
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  LOG_ERROR(ETH, "Switch Backend: Segment '{}' kept going away while joining", config.segmentName);
+  return false;
+}
+
+bool SwitchBackend::TryMapSegment(bool& retry) {
+  bool creator = false;
+  void* mapping = nullptr;
+#ifdef _WIN32
+  const std::string mappingName = "Local\\XenonSwitch-" + config.segmentName;
+  mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+    0, static_cast<DWORD>(sizeof(SwitchSegment)), mappingName.c_str());
+  if (!mappingHandle) {
+    LOG_ERROR(ETH, "Switch Backend: CreateFileMapping failed ({})", GetLastError());
+    return false;
+  }
+  creator = GetLastError() != ERROR_ALREADY_EXISTS;
+  mapping = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SwitchSegment));
+  if (!mapping) {
+    LOG_ERROR(ETH, "Switch Backend: MapViewOfFile failed ({})", GetLastError());
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+    return false;
+  }
+#else
+  shmName = "/xenon-switch-" + config.segmentName;
+  int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  creator = fd >= 0;
+  if (!creator) {
+    if (errno != EEXIST) {
+      LOG_ERROR(ETH, "Switch Backend: shm_open '{}' failed ({})", shmName, strerror(errno));
+      return false;
+    }
+    fd = shm_open(shmName.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      LOG_ERROR(ETH, "Switch Backend: shm_open '{}' failed ({})", shmName, strerror(errno));
+      return false;
+    }
+  }
+  if (creator) {
+    if (ftruncate(fd, sizeof(SwitchSegment)) != 0) {
+      LOG_ERROR(ETH, "Switch Backend: Unable to size '{}' ({})", shmName, strerror(errno));
+      close(fd);
+      shm_unlink(shmName.c_str());
+      return false;
+    }
+  } else {
+    // The creator may not have sized it yet
+    struct stat info = {};
+    for (u32 attempt = 0; attempt != 1000; ++attempt) {
+      if (fstat(fd, &info) == 0 && static_cast<u64>(info.st_size) >= sizeof(SwitchSegment)) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (static_cast<u64>(info.st_size) != sizeof(SwitchSegment)) {
+      LOG_ERROR(ETH, "Switch Backend: '{}' has an unexpected size ({:#x}), remove it or use another segment name",
+        shmName, info.st_size);
+      close(fd);
+      return false;
+    }
+  }
+  mapping = mmap(nullptr, sizeof(SwitchSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOG_ERROR(ETH, "Switch Backend: mmap '{}' failed ({})", shmName, strerror(errno));
+    return false;
+  }
+#endif
+
+  if (creator) {
+    // Fresh mappings are zero filled, only the ring sequences need setting up
+    segment = new (mapping) SwitchSegment;
+    for (SwitchPort& port : segment->ports) {
+      for (u32 i = 0; i != SWITCH_RING_SLOTS; ++i) {
+        port.slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+    segment->magic = SWITCH_MAGIC;
+    segment->version = SWITCH_VERSION;
+    segment->size = sizeof(SwitchSegment);
+    segment->users.store(1, std::memory_order_relaxed);
+    segment->initialized.store(1, std::memory_order_release);
+    counted = true;
+  } else {
+    segment = static_cast<SwitchSegment*>(mapping);
+    for (u32 attempt = 0; attempt != 1000 && !segment->initialized.load(std::memory_order_acquire); ++attempt) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!segment->initialized.load(std::memory_order_acquire) || segment->magic != SWITCH_MAGIC ||
+        segment->version != SWITCH_VERSION || segment->size != sizeof(SwitchSegment)) {
+      LOG_ERROR(ETH, "Switch Backend: Segment '{}' is from an incompatible build", config.segmentName);
+      ReleaseMapping();
+      return false;
+    }
+    u32 users = segment->users.load(std::memory_order_relaxed);
+    do {
+      if (users & SWITCH_SEGMENT_CLOSED) {
+        ReleaseMapping();
+        retry = true;
+        return false;
+      }
+    } while (!segment->users.compare_exchange_weak(users, users + 1, std::memory_order_acq_rel));
+    counted = true;
+  }
+  return true;
+}
+
+void SwitchBackend::UnmapSegment() {
+  if (!segment) {
+    return;
+  }
+  // The last user out removes the name, so a stale segment doesn't outlive the consoles using it.
+  // Ports of processes that died are reclaimed on join instead, their use goes with them.
+  bool last = false;
+  if (counted) {
+    u32 users = segment->users.load(std::memory_order_relaxed);
+    do {
+      last = users == 1;
+    } while (!segment->users.compare_exchange_weak(users, last ? SWITCH_SEGMENT_CLOSED : users - 1,
+      std::memory_order_acq_rel));
+    counted = false;
+  }
+#ifndef _WIN32
+  if (last) {
+    shm_unlink(shmName.c_str());
+  }
+#endif
+  ReleaseMapping();
+}
+
+void SwitchBackend::ReleaseMapping() {
+#ifdef _WIN32
+  UnmapViewOfFile(segment);
+  CloseHandle(mappingHandle);
+  mappingHandle = nullptr;
+#else
+  munmap(segment, sizeof(SwitchSegment));
+#endif
+  segment = nullptr;
+}
+
+bool SwitchBackend::JoinSwitch() {
+  ownerId = CurrentProcessId() + 1;
+  // Free ports first, then ports left behind by processes that died
+  for (u32 pass = 0; pass != 2; ++pass) {
+    for (u32 port = 0; port != SWITCH_MAX_PORTS; ++port) {
+      u64 owner = segment->ports[port].owner.load(std::memory_order_acquire);
+      // One console per process, a port already carrying our pid was left by a dead process we reuse the pid of
+      if (pass == 0 ? owner != 0 : (owner == 0 || (owner != ownerId && OwnerAlive(owner)))) {
+        continue;
+      }
+      if (!segment->ports[port].owner.compare_exchange_strong(owner, ownerId, std::memory_order_acq_rel)) {
+        continue;
+      }
+      if (pass == 1) {
+        LOG_WARNING(ETH, "Switch Backend: Reclaimed port {} from process {}", port, owner - 1);
+        // Its use of the segment goes with it
+        segment->users.fetch_sub(1, std::memory_order_acq_rel);
+      }
+      portIndex = port;
+      // Drop whatever was left queued for the previous owner
+      SwitchPort& ours = segment->ports[port];
+      for (;;) {
+        const u64 position = ours.readPosition.load(std::memory_order_relaxed);
+        SwitchSlot& slot = ours.slots[position & (SWITCH_RING_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+          break;
+        }
+        slot.sequence.store(position + SWITCH_RING_SLOTS, std::memory_order_release);
+        ours.readPosition.store(position + 1, std::memory_order_relaxed);
+      }
+      ForgetPort(port);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SwitchBackend::LeaveSwitch() {
+  if (!segment) {
+    return;
+  }
+  ForgetPort(portIndex);
+  segment->ports[portIndex].owner.store(0, std::memory_order_release);
+}
+
+void SwitchBackend::Learn(const u8* mac, u32 port) {
+  // Multicast addresses never show up as a source
+  if (mac[0] & 1) {
+    return;
+  }
+  const u64 key = MacToKey(mac);
+  const u64 entry = (key << 16) | (port + 1);
+  const u32 hash = FdbHash(key);
+  // Existing entry, possibly moved to another port
+  for (u32 probe = 0; probe != SWITCH_FDB_PROBES; ++probe) {
+    std::atomic<u64>& slot = segment->fdb[(hash + probe) & (SWITCH_FDB_SIZE - 1)];
+    u64 current = slot.load(std::memory_order_relaxed);
+    if (current >> 16 == key) {
+      if (current != entry) {
+        slot.compare_exchange_strong(current, entry, std::memory_order_relaxed);
+      }
+      return;
+    }
+  }
+  // New entry
+  for (u32 probe = 0; probe != SWITCH_FDB_PROBES; ++probe) {
+    std::atomic<u64>& slot = segment->fdb[(hash + probe) & (SWITCH_FDB_SIZE - 1)];
+    u64 expected = 0;
+    if (slot.compare_exchange_strong(expected, entry, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  // Table is crowded here, evict the home slot
+  segment->fdb[hash].store(entry, std::memory_order_relaxed);
+}
+
+s32 SwitchBackend::Lookup(const u8* mac) const {
+  const u64 key = MacToKey(mac);
+  const u32 hash = FdbHash(key);
+  for (u32 probe = 0; probe != SWITCH_FDB_PROBES; ++probe) {
+    const u64 current = segment->fdb[(hash + probe) & (SWITCH_FDB_SIZE - 1)].load(std::memory_order_relaxed);
+    if (current && current >> 16 == key) {
+      return static_cast<s32>(current & 0xFFFF) - 1;
+    }
+  }
+  return -1;
+}
+
+void SwitchBackend::ForgetPort(u32 port) {
+  for (std::atomic<u64>& slot : segment->fdb) {
+    u64 current = slot.load(std::memory_order_relaxed);
+    if (current && (current & 0xFFFF) == port + 1) {
+      slot.compare_exchange_strong(current, 0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void SwitchBackend::LockSenders(SwitchPort& port) {
+  for (u32 spins = 0;; ++spins) {
+    u64 holder = 0;
+    if (port.senderLock.compare_exchange_weak(holder, ownerId, std::memory_order_acquire, std::memory_order_relaxed)) {
+      return;
+    }
+    if (spins < SWITCH_LOCK_SPINS) {
+      continue;
+    }
+    // Held for a while, a sender that died while queueing never lets go
+    if (holder != 0 && !OwnerAlive(holder) &&
+        port.senderLock.compare_exchange_strong(holder, ownerId, std::memory_order_acquire, std::memory_order_relaxed)) {
+      LOG_WARNING(ETH, "Switch Backend: Took over a sender lock from process {}", holder - 1);
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+bool SwitchBackend::Deliver(u32 port, const u8* data, u32 length, u64 timestamp) {
+  SwitchPort& destination = segment->ports[port];
+  // Frames are published before writePosition moves, so a sender dying at any point leaves at worst
+  // an unpublished slot (overwritten by the next sender) or a published one writePosition hasn't caught up to.
+  LockSenders(destination);
+  u64 position = destination.writePosition.load(std::memory_order_relaxed);
+  SwitchSlot* slot = &destination.slots[position & (SWITCH_RING_SLOTS - 1)];
+  if (slot->sequence.load(std::memory_order_acquire) == position + 1) {
+    destination.writePosition.store(++position, std::memory_order_relaxed);
+    slot = &destination.slots[position & (SWITCH_RING_SLOTS - 1)];
+  }
+  if (slot->sequence.load(std::memory_order_acquire) != position) {
+    // Ring full, the receiving console isn't keeping up
+    destination.senderLock.store(0, std::memory_order_release);
+    return false;
+  }
+  memcpy(slot->data, data, length);
+  slot->length = length;
+  slot->timestamp = timestamp;
+  slot->sequence.store(position + 1, std::memory_order_release);
+  destination.writePosition.store(position + 1, std::memory_order_relaxed);
+  destination.senderLock.store(0, std::memory_order_release);
+
+  destination.doorbell.fetch_add(1, std::memory_order_seq_cst);
+  if (destination.waiting.load(std::memory_order_seq_cst)) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<u32*>(&destination.doorbell), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+  }
+  return true;
+}
+
+bool SwitchBackend::SendPacket(const u8* data, u32 length) {
+  if (!ready || !data || length < 14) {
+    stats.txErrors++;
+    return false;
+  }
+  if (length > SWITCH_FRAME_SIZE) {
+    LOG_WARNING(ETH, "Switch Backend: Dropping oversized frame ({} bytes)", length);
+    stats.txErrors++;
+    return false;
+  }
+
+  Learn(data + 6, portIndex);
+
+  stats.txPackets++;
+  stats.txBytes += length;
+
+  if (config.lossPercent > 0.0 && lossDistribution(lossRandom) < config.lossPercent) {
+    stats.txDropped++;
+    return true;
+  }
+
+  const u64 timestamp = SwitchNow();
+  // Multicast/broadcast and unknown unicast go everywhere
+  const s32 destination = (data[0] & 1) ? -1 : Lookup(data);
+  if (destination >= 0 && segment->ports[destination].owner.load(std::memory_order_acquire) != 0) {
+    // Frames for ourselves don't go back out
+    if (static_cast<u32>(destination) != portIndex && !Deliver(destination, data, length, timestamp)) {
+      stats.txDropped++;
+    }
+    return true;
+  }
+  for (u32 port = 0; port != SWITCH_MAX_PORTS; ++port) {
+    if (port == portIndex || segment->ports[port].owner.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    if (!Deliver(port, data, length, timestamp)) {
+      stats.txDropped++;
+    }
+  }
+  return true;
+}
+
+void SwitchBackend::WaitDoorbell(u32 doorbellValue, u32 timeoutMs) {
+  SwitchPort& port = segment->ports[portIndex];
+  port.waiting.store(1, std::memory_order_seq_cst);
+  if (port.doorbell.load(std::memory_order_seq_cst) == doorbellValue) {
+#ifdef __linux__
+    // Shared futex, wakes across processes
+    struct timespec timeout = {};
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<u32*>(&port.doorbell), FUTEX_WAIT, doorbellValue, &timeout, nullptr, 0);
+#else
+    // No cross process wait on an address here, poll instead
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+  }
+  port.waiting.store(0, std::memory_order_relaxed);
+}
+
+void SwitchBackend::ReaderThreadLoop() {
+  Base::SetCurrentThreadName("[Xe] Switch Reader");
+
+  SwitchPort& port = segment->ports[portIndex];
+  const u64 latencyNs = static_cast<u64>(config.latencyUs) * 1000;
+
+  while (readerRunning && XeRunning) {
+    const u32 doorbell = port.doorbell.load(std::memory_order_acquire);
+    u32 delivered = 0;
+    u64 delayNs = 0;
+
+    {
+      std::lock_guard<std::mutex> lock(callbackMutex);
+      while (delivered != NET_RX_BATCH_SIZE) {
+        const u64 position = port.readPosition.load(std::memory_order_relaxed);
+        SwitchSlot& slot = port.slots[position & (SWITCH_RING_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+          break;
+        }
+        // Every frame gets the same delay, so the head of the ring is always due first
+        if (latencyNs) {
+          const u64 now = SwitchNow();
+          if (now < slot.timestamp + latencyNs) {
+            delayNs = slot.timestamp + latencyNs - now;
+            break;
+          }
+        }
+
+        stats.rxPackets++;
+        stats.rxBytes += slot.length;
+        if (packetSink) {
+          if (PacketBuffer* pooled = packetSink->AcquireRxBuffer()) {
+            memcpy(pooled->data, slot.data, slot.length);
+            pooled->length = slot.length;
+            packetSink->SubmitRxBuffer(pooled);
+          } else {
+            stats.rxDropped++;
+          }
+        } else if (packetCallback) {
+          packetCallback(slot.data, slot.length);
+        }
+
+        slot.sequence.store(position + SWITCH_RING_SLOTS, std::memory_order_release);
+        port.readPosition.store(position + 1, std::memory_order_relaxed);
+        delivered++;
+      }
+      if (delivered && packetSink) {
+        packetSink->CommitRx();
+      }
+    }
+
+    if (delivered == NET_RX_BATCH_SIZE) {
+      // There's likely more
+      continue;
+    }
+    if (delayNs) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<u64>(delayNs, 100000000)));
+      continue;
+    }
+    // Ring is empty, anything queued since we read the doorbell wakes us right away
+    WaitDoorbell(doorbell, 100);
+  }
+}
+
+SwitchConfig ParseSwitchConfig(const std::string& configStr) {
+  SwitchConfig config;
+
+  size_t start = 0;
+  bool first = true;
+  while (start <= configStr.size()) {
+    size_t end = configStr.find(',', start);
+    if (end == std::string::npos) {
+      end = configStr.size();
+    }
+    const std::string token = configStr.substr(start, end - start);
+    start = end + 1;
+
+    if (first) {
+      first = false;
+      if (!token.empty() && token != "auto") {
+        // Segment names end up in a shared memory object name, keep them simple
+        std::string name;
+        for (const char c : token) {
+          name.push_back(std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_');
+        }
+        config.segmentName = name;
+      }
+      continue;
+    }
+
+    const size_t equals = token.find('=');
+    if (equals == std::string::npos) {
+      LOG_WARNING(ETH, "Switch Backend: Ignoring option '{}'", token);
+      continue;
+    }
+    const std::string key = token.substr(0, equals);
+    const std::string value = token.substr(equals + 1);
+    try {
+      if (key == "latency") {
+        config.latencyUs = static_cast<u32>(std::stoul(value));
+      } else if (key == "loss") {
+        config.lossPercent = std::clamp(std::stod(value), 0.0, 100.0);
+      } else {
+        LOG_WARNING(ETH, "Switch Backend: Unknown option '{}'", key);
+      }
+    } catch (const std::exception&) {
+      LOG_WARNING(ETH, "Switch Backend: Invalid value '{}' for '{}'", value, key);
+    }
+  }
+
+  return config;
+}
+
+} // namespace Network
+} // namespace Xe
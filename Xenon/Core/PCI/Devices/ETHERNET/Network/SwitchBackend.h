@@ -0,0 +1,183 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// Virtual Switch Network Backend
+// Shared memory L2 switch, lets several emulated consoles talk to each other (system link)
+// without a host network device or admin privileges.
+//
+// Every console joins a named shared memory segment and takes a port on it. Each port has a frame ring,
+// senders copy frames straight into the destination's ring. The switch learns which port every source
+// MAC lives on, so unicast only goes to one port, unknown and broadcast frames are flooded.
+// The network bridge is a singleton, so there's one console per process, and every process using the
+// same segment name ends up on the same switch. Anything shared that a process holds (its port, a
+// ring's sender lock) is tagged with its pid, so a process that dies holding it can't wedge the switch.
+//
+
+#pragma once
+
+#include "NetworkBackend.h"
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace Xe {
+namespace Network {
+
+#define SWITCH_MAGIC 0x48435753 // 'SWCH'
+#define SWITCH_VERSION 2
+// Consoles per segment
+#define SWITCH_MAX_PORTS 16
+// Frames queued per port (power of 2)
+#define SWITCH_RING_SLOTS 256
+// Largest frame the switch carries (1522 with a VLAN tag)
+#define SWITCH_FRAME_SIZE 1536
+// MAC learning table entries (power of 2)
+#define SWITCH_FDB_SIZE 512
+// Set in SwitchSegment::users once the last user is leaving and the segment is being removed
+#define SWITCH_SEGMENT_CLOSED 0x80000000u
+
+// Shared memory layout. Everything in here is shared between processes, so it only holds
+// address free atomics and plain data.
+struct SwitchSlot {
+  std::atomic<u64> sequence;
+  // steady_clock time the frame was sent, in ns (for latency shaping)
+  u64 timestamp;
+  u32 length;
+  u8 data[SWITCH_FRAME_SIZE];
+};
+
+struct SwitchPort {
+  // Owner process id + 1, 0 when the port is free
+  std::atomic<u64> owner;
+  // Bumped on every frame queued, the owner sleeps on it
+  std::atomic<u32> doorbell;
+  std::atomic<u32> waiting;
+  // Sending process id + 1 while a frame is being queued, 0 otherwise. Taken over when its holder died.
+  alignas(64) std::atomic<u64> senderLock;
+  // Only moved by the sender lock holder
+  std::atomic<u64> writePosition;
+  // Only the owner pops
+  alignas(64) std::atomic<u64> readPosition;
+  alignas(64) SwitchSlot slots[SWITCH_RING_SLOTS];
+};
+
+struct SwitchSegment {
+  u32 magic;
+  u32 version;
+  u32 size;
+  // Set by whoever created the segment once the rings are set up
+  std::atomic<u32> initialized;
+  // Processes mapping the segment (a dead port's count goes when it's reclaimed), | SWITCH_SEGMENT_CLOSED
+  // once the last one left and the name is being removed
+  std::atomic<u32> users;
+  // MAC learning table, each entry is MAC << 16 | port + 1, 0 when empty
+  std::atomic<u64> fdb[SWITCH_FDB_SIZE];
+  SwitchPort ports[SWITCH_MAX_PORTS];
+};
+static_assert(std::atomic<u64>::is_always_lock_free && std::atomic<u32>::is_always_lock_free,
+  "The switch segment needs address free atomics.");
+
+// Switch configuration
+struct SwitchConfig {
+  std::string segmentName = "xenon"; // Consoles on the same segment name share the switch
+  u32 latencyUs = 0;                 // Delivery delay added to every received frame
+  double lossPercent = 0.0;          // Chance a sent frame is dropped
+};
+
+class SwitchBackend : public INetworkBackend {
+public:
+  explicit SwitchBackend(const SwitchConfig& config);
+  ~SwitchBackend() override;
+
+  // INetworkBackend interface
+  bool Initialize() override;
+  void Shutdown() override;
+  bool IsReady() const override { return ready; }
+  bool SendPacket(const u8* data, u32 length) override;
+  void SetPacketCallback(PacketCallback callback) override;
+  bool SetPacketSink(IPacketSink* sink) override;
+  BackendType GetType() const override { return BackendType::Switch; }
+  std::string GetName() const override { return "Switch:" + config.segmentName; }
+  bool GetMACAddress(u8* /*mac*/) const override { return false; }
+  bool SetMACAddress(const u8* /*mac*/) override { return false; }
+  const BackendStats& GetStats() const override { return stats; }
+  bool IsLinkUp() const override { return ready; }
+
+private:
+  // Maps (creating it if needed) the shared segment and counts us as a user
+  bool MapSegment();
+  // Tries once, returns false with retry set when the segment was being removed
+  bool TryMapSegment(bool& retry);
+  // Drops our use of the segment, the last user removes its name
+  void UnmapSegment();
+  void ReleaseMapping();
+
+  // Takes a free port, or one whose owner process died
+  bool JoinSwitch();
+  void LeaveSwitch();
+
+  // MAC learning
+  void Learn(const u8* mac, u32 port);
+  s32 Lookup(const u8* mac) const;
+  void ForgetPort(u32 port);
+
+  // Queues a frame on a port's ring and rings its doorbell
+  bool Deliver(u32 port, const u8* data, u32 length, u64 timestamp);
+  // Serializes senders on a port's ring
+  void LockSenders(SwitchPort& port);
+
+  // Receiver thread, moves frames from our ring to the device
+  void ReaderThreadLoop();
+  // Sleeps until our doorbell moves past doorbellValue, or timeoutMs passes
+  void WaitDoorbell(u32 doorbellValue, u32 timeoutMs);
+
+  // Configuration
+  SwitchConfig config;
+
+  // State
+  std::atomic<bool> ready{false};
+  SwitchSegment* segment = nullptr;
+  // We're counted in segment->users
+  bool counted = false;
+  u32 portIndex = 0;
+  u64 ownerId = 0;
+
+  // Callback, or the sink we read into directly when one is set. Guarded by callbackMutex.
+  PacketCallback packetCallback;
+  IPacketSink* packetSink = nullptr;
+  std::mutex callbackMutex;
+
+  // Reader thread
+  std::thread readerThread;
+  std::atomic<bool> readerRunning{false};
+
+  // Loss shaping, only used from the sending thread
+  std::mt19937 lossRandom{ std::random_device{}() };
+  std::uniform_real_distribution<double> lossDistribution{ 0.0, 100.0 };
+
+  // Statistics
+  BackendStats stats;
+
+#ifdef _WIN32
+  HANDLE mappingHandle = nullptr;
+#else
+  std::string shmName;
+#endif
+};
+
+// Helper function to parse switch config from string
+// Format: "segmentName[,latency=<us>][,loss=<percent>]"
+// Examples: "xenon", "lan0,latency=2000", "lan0,latency=500,loss=1.5"
+SwitchConfig ParseSwitchConfig(const std::string& configStr);
+
+} // namespace Network
+} // namespace Xe
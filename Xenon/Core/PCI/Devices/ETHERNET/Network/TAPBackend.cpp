@@ -181,6 +181,13 @@ void TAPBackend::SetPacketCallback(PacketCallback callback) {
   packetCallback = callback;
 }
 
+bool TAPBackend::SetPacketSink(IPacketSink* sink) {
+  // Waits out a batch in flight, no pooled buffer of the old sink is in use once this returns
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  packetSink = sink;
+  return true;
+}
+
 #ifdef _WIN32
 // Windows implementation
 
@@ -556,7 +563,7 @@ bool TAPBackend::SendPacket(const u8* data, u32 length) {
 void TAPBackend::ReaderThreadLoop() {
   Base::SetCurrentThreadName("[Xe] TAP Reader");
   
-  std::vector<u8> buffer(2048);
+  std::vector<u8> buffer(NET_PACKET_BUFFER_SIZE);
   
   while (readerRunning && XeRunning) {
     if (tapHandle == INVALID_HANDLE_VALUE) {
@@ -591,9 +598,18 @@ void TAPBackend::ReaderThreadLoop() {
       stats.rxPackets++;
       stats.rxBytes += bytesRead;
       
-      // Call the callback
       std::lock_guard<std::mutex> lock(callbackMutex);
-      if (packetCallback) {
+      if (packetSink) {
+        // The overlapped read may outlive a sink change, so it can't target a pooled buffer directly
+        if (PacketBuffer* pooled = packetSink->AcquireRxBuffer()) {
+          memcpy(pooled->data, buffer.data(), bytesRead);
+          pooled->length = bytesRead;
+          packetSink->SubmitRxBuffer(pooled);
+          packetSink->CommitRx();
+        } else {
+          stats.rxDropped++;
+        }
+      } else if (packetCallback) {
         packetCallback(buffer.data(), bytesRead);
       }
     }
@@ -760,7 +776,7 @@ bool TAPBackend::SendPacket(const u8* data, u32 length) {
 void TAPBackend::ReaderThreadLoop() {
   Base::SetCurrentThreadName("[Xe] TAP Reader");
   
-  std::vector<u8> buffer(2048);
+  std::vector<u8> buffer(NET_PACKET_BUFFER_SIZE);
   struct pollfd pfd = {};
   pfd.fd = tapFd;
   pfd.events = POLLIN;
@@ -787,19 +803,39 @@ void TAPBackend::ReaderThreadLoop() {
     }
     
     if (pfd.revents & POLLIN) {
-      ssize_t bytesRead = read(tapFd, buffer.data(), buffer.size());
-      
-      if (bytesRead > 0) {
+      // Drain what's queued on the device, up to a batch, reading straight into the sink's
+      // buffers when there is one. The sink is woken once for the whole batch.
+      std::lock_guard<std::mutex> lock(callbackMutex);
+      for (u32 frame = 0; frame != NET_RX_BATCH_SIZE; ++frame) {
+        PacketBuffer* pooled = packetSink ? packetSink->AcquireRxBuffer() : nullptr;
+        u8* destination = pooled ? pooled->data : buffer.data();
+        ssize_t bytesRead = read(tapFd, destination, NET_PACKET_BUFFER_SIZE);
+        
+        if (bytesRead <= 0) {
+          if (pooled) {
+            packetSink->ReleaseRxBuffer(pooled);
+          }
+          if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            stats.rxErrors++;
+          }
+          break;
+        }
+        
         stats.rxPackets++;
         stats.rxBytes += bytesRead;
         
-        // Call the callback
-        std::lock_guard<std::mutex> lock(callbackMutex);
-        if (packetCallback) {
+        if (pooled) {
+          pooled->length = static_cast<u32>(bytesRead);
+          packetSink->SubmitRxBuffer(pooled);
+        } else if (packetSink) {
+          // Every pooled buffer is queued, the guest isn't keeping up
+          stats.rxDropped++;
+        } else if (packetCallback) {
           packetCallback(buffer.data(), static_cast<u32>(bytesRead));
         }
-      } else if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-        stats.rxErrors++;
+      }
+      if (packetSink) {
+        packetSink->CommitRx();
       }
     }
     
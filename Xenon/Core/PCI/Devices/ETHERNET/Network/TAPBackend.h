@@ -43,6 +43,7 @@ public:
   bool IsReady() const override;
   bool SendPacket(const u8* data, u32 length) override;
   void SetPacketCallback(PacketCallback callback) override;
+  bool SetPacketSink(IPacketSink* sink) override;
   BackendType GetType() const override { return BackendType::TAP; }
   std::string GetName() const override;
   bool GetMACAddress(u8* mac) const override;
@@ -65,8 +66,10 @@ private:
   std::atomic<bool> ready{false};
   std::atomic<bool> linkUp{false};
   
-  // Callback
+  // Callback, or the sink we read into directly when one is set.
+  // Both are guarded by callbackMutex, held for a whole batch of reads.
   PacketCallback packetCallback;
+  IPacketSink* packetSink = nullptr;
   std::mutex callbackMutex;
   
   // Reader thread
@@ -4,6 +4,7 @@
 
 #include "HDD.h"
 
+#include "Base/Hash.h"
 #include "Base/Logging/Log.h"
 
 //#define HDD_DEBUG
@@ -123,9 +124,26 @@ Xe::PCIDev::HDD::HDD(const std::string &deviceName, u64 size, PCIBridge *parentP
   memcpy(&ataState.ataIdentifyData, &identifyDataBytes, sizeof(identifyDataBytes));
 
   // Mount our HDD image according to config.
-  ataState.mountedHDDImage = std::make_unique<STRIP_UNIQUE(ataState.mountedHDDImage)>(Config::filepaths.hddImage);
+  if (Config::filepaths.hddOverlay != "none") {
+    // Writes go to the overlay, the image itself is only read.
+    eOverlayExitAction exitAction = eOverlayExitAction::Keep;
+    switch (Base::JoaatStringHash(Config::filepaths.hddOverlayOnExit)) {
+    case "Commit"_jLower:
+      exitAction = eOverlayExitAction::Commit;
+      break;
+    case "Discard"_jLower:
+      exitAction = eOverlayExitAction::Discard;
+      break;
+    default:
+      break;
+    }
+    ataState.mountedHDDImage = std::make_unique<OverlayImage>(Config::filepaths.hddImage, Config::filepaths.hddOverlay,
+      exitAction, HDD_OVERLAY_CACHE_SIZE);
+  } else {
+    ataState.mountedHDDImage = std::make_unique<BlockDevice>(Config::filepaths.hddImage, true);
+  }
 
-  if (ataState.mountedHDDImage.get()->isHandleValid()) {
+  if (ataState.mountedHDDImage->IsOpen()) {
     if (fs::exists(Config::filepaths.hddImage)) {
       try {
         std::error_code fsError;
@@ -150,8 +168,6 @@ Xe::PCIDev::HDD::HDD(const std::string &deviceName, u64 size, PCIBridge *parentP
     LOG_INFO(HDD, "No HDD image found - disabling device.");
   }
 
-  hddThreadRunning = ataState.imageAttached;
-
   // Set the SCR's at offset 0xC0 (SiS-like).
   // SStatus
   data = ataState.imageAttached ? 0x00000113 : 0;
@@ -174,16 +190,11 @@ Xe::PCIDev::HDD::HDD(const std::string &deviceName, u64 size, PCIBridge *parentP
 
   // Device ready to receive commands.
   ataState.regs.status = ATA_STATUS_DRDY;
-
-  // Enter HDD Worker Thread
-  hddWorkerThread = std::thread(&Xe::PCIDev::HDD::hddThreadLoop, this);
 }
 
 Xe::PCIDev::HDD::~HDD() {
-  // Terminate thread.
-  hddThreadRunning = false;
-  if (hddWorkerThread.joinable())
-    hddWorkerThread.join();
+  // Wait for any in flight DMA before the state goes away.
+  dmaQueue.Stop();
 }
 
 // PCI Read
@@ -508,6 +519,9 @@ void Xe::PCIDev::HDD::Write(u64 writeAddress, const u8 *data, u64 size) {
       memcpy(&ataState.regs.dmaCommand, data, size);
       if (ataState.regs.dmaCommand & XE_ATAPI_DMA_ACTIVE) {
         ataState.regs.dmaStatus = XE_ATA_DMA_ACTIVE; // Signal DMA active status.
+        // Hand the transfer to the device worker, the guest polls DMA status/waits for the interrupt.
+        if (ataState.imageAttached)
+          dmaQueue.Post([this] { processDMARequest(); });
       }
       break;
     case ATA_REG_DMA_STATUS:
@@ -528,6 +542,71 @@ void Xe::PCIDev::HDD::MemSet(u64 writeAddress, s32 data, u64 size) {
   LOG_ERROR(HDD, "Unknown register! Attempted to MEMSET {:#x}", regOffset);
 }
 
+// Save states
+void Xe::PCIDev::HDD::SerializeState(Xe::SaveState::StateStream &stream) {
+  PCIDevice::SerializeState(stream);
+  stream.Do(ataState.regs, ataState.ataIdentifyData, ataState.pendingWriteOffset, ataState.pendingWriteSize,
+    ataState.dmaState, ataState.imageAttached);
+  ataState.dataInBuffer.SerializeState(stream);
+  ataState.dataOutBuffer.SerializeState(stream);
+  stream.DoMarker("HDDContents");
+
+  OverlayImage *overlay = dynamic_cast<OverlayImage*>(ataState.mountedHDDImage.get());
+  u8 hasContents = overlay != nullptr;
+  stream.Do(hasContents);
+  if (stream.IsSaving() && !overlay) {
+    LOG_WARNING(HDD, "Not running on an overlay, the disk contents aren't part of the state");
+  }
+  if (stream.Failed() || !hasContents) {
+    return;
+  }
+  if (!overlay) {
+    LOG_WARNING(HDD, "The state holds disk contents, but the image isn't mounted through an overlay. Skipping them");
+    return;
+  }
+
+  std::vector<u64> blocks{};
+  if (stream.IsSaving()) {
+    blocks = overlay->GetDeltaBlocks();
+  }
+  stream.DoVector(blocks);
+  if (stream.IsLoading()) {
+    if (stream.Failed()) {
+      return;
+    }
+    // Back to the clean image, then replay the blocks the state changed
+    overlay->Discard();
+  }
+  BlockBuffer block = AllocateBlockBuffer(OVERLAY_BLOCK_SIZE);
+  for (const u64 index : blocks) {
+    const u64 offset = index * OVERLAY_BLOCK_SIZE;
+    if (stream.IsSaving() && !overlay->Read(offset, block.get(), OVERLAY_BLOCK_SIZE)) {
+      LOG_ERROR(HDD, "Failed to read block {:#x} of the overlay", index);
+    }
+    stream.DoBytes(block.get(), OVERLAY_BLOCK_SIZE);
+    if (stream.Failed()) {
+      return;
+    }
+    if (stream.IsLoading() && !overlay->Write(offset, block.get(), OVERLAY_BLOCK_SIZE)) {
+      LOG_ERROR(HDD, "Failed to restore block {:#x} of the overlay", index);
+    }
+  }
+  if (stream.IsLoading()) {
+    ataState.pendingReadTicket = 0;
+    LOG_INFO(HDD, "Restored {} disk blocks", blocks.size());
+  }
+}
+
+void Xe::PCIDev::HDD::Quiesce() {
+  dmaQueue.WaitIdle();
+  // A READ DMA command was issued, but the guest hasn't started the transfer yet. Land the data in
+  // the buffer, so it gets saved with it.
+  waitForPendingRead();
+  if (!ataState.mountedHDDImage->WaitAll()) {
+    LOG_ERROR(HDD, "A write to the disk image failed");
+  }
+}
+
 // Config read.
 void Xe::PCIDev::HDD::ConfigRead(u64 readAddress, u8 *data, u64 size) {
   memcpy(data, &pciConfigSpace.data[static_cast<u8>(readAddress)], size);
@@ -564,6 +643,7 @@ void Xe::PCIDev::HDD::ConfigWrite(u64 writeAddress, const u8 *data, u64 size) {
 //
 
 void Xe::PCIDev::HDD::ataIdentifyDeviceCommand() {
+  waitForPendingRead();
   if (!ataState.dataOutBuffer.init(sizeof(ataState.ataIdentifyData), true)) {
     LOG_ERROR(HDD, "Failed to initialize data buffer for IDENTIFY_DEVICE command.");
   }
@@ -597,9 +677,12 @@ void Xe::PCIDev::HDD::ataReadDMACommand() {
   // Read count in bytes.
   sectorCount = sectorCount * ATA_SECTOR_SIZE;
 
+  // The buffer may be reallocated, the last read into it must land first
+  waitForPendingRead();
   ataState.dataOutBuffer.init(sectorCount, false);
   ataState.dataOutBuffer.reset();
-  ataState.mountedHDDImage->Read(offset, ataState.dataOutBuffer.get(), sectorCount);
+  // Runs while the guest sets up the PRD table, the DMA waits for it.
+  ataState.pendingReadTicket = ataState.mountedHDDImage->ReadAsync(offset, ataState.dataOutBuffer.get(), sectorCount);
 }
 
 // ATA READ NATIVE MAX ADDRESS EXT (LBA 48 Bit)
@@ -638,9 +721,12 @@ void Xe::PCIDev::HDD::ataReadDMAExtCommand() {
   // Read count in bytes.
   sectorCount = sectorCount * ATA_SECTOR_SIZE;
 
+  // The buffer may be reallocated, the last read into it must land first
+  waitForPendingRead();
   ataState.dataOutBuffer.init(sectorCount, false);
   ataState.dataOutBuffer.reset();
-  ataState.mountedHDDImage->Read(offset, ataState.dataOutBuffer.get(), sectorCount);
+  // Runs while the guest sets up the PRD table, the DMA waits for it.
+  ataState.pendingReadTicket = ataState.mountedHDDImage->ReadAsync(offset, ataState.dataOutBuffer.get(), sectorCount);
 }
 
 // ATA WRITE DMA (LBA 28 Bit)
@@ -657,10 +743,14 @@ void Xe::PCIDev::HDD::ataWriteDMACommand() {
 
   // Image offset.
   offset = offset * ATA_SECTOR_SIZE;
-  // Read count in bytes.
+  // Write count in bytes.
   sectorCount = sectorCount * ATA_SECTOR_SIZE;
 
-  ataState.mountedHDDImage->Write(offset, ataState.dataInBuffer.get(), sectorCount);
+  // The data comes in through DMA, it's written to the image once the transfer is done.
+  ataState.dataInBuffer.init(sectorCount, false);
+  ataState.dataInBuffer.reset();
+  ataState.pendingWriteOffset = offset;
+  ataState.pendingWriteSize = sectorCount;
 }
 
 //
@@ -705,28 +795,18 @@ const std::string Xe::PCIDev::HDD::getATACommandName(u32 commandID) {
   }
 }
 
-// Worker thread for DMA.
-void Xe::PCIDev::HDD::hddThreadLoop() {
-  // Check if we should be running
-  if (!hddThreadRunning)
+// Runs on the device worker, posted by a write to the DMA command register.
+void Xe::PCIDev::HDD::processDMARequest() {
+  // The guest may have cleared the active bit before we got here.
+  if (!XeRunning || !(ataState.regs.dmaCommand & XE_ATA_DMA_ACTIVE))
     return;
-  LOG_INFO(HDD, "Entered HDD worker thread.");
-  while (hddThreadRunning) {
-    // Check if we should exit early
-    hddThreadRunning = XeRunning;
-    if (!hddThreadRunning)
-      break;
-    // Check for the DMA active command.
-    if (ataState.regs.dmaCommand & XE_ATA_DMA_ACTIVE) {
-      // Start our DMA operation
-      doDMA();
-      // Change our DMA status after completion.
-      ataState.regs.dmaCommand &= ~1; // Clear active status.
-      ataState.regs.dmaStatus = XE_ATA_DMA_INTR; // Signal Interrupt.
-    }
-  }
-
-  LOG_INFO(HDD, "Exiting HDD worker thread.");
+  // Make sure the image read backing this transfer landed.
+  waitForPendingRead();
+  // Start our DMA operation
+  doDMA();
+  // Change our DMA status after completion.
+  ataState.regs.dmaCommand &= ~1; // Clear active status.
+  ataState.regs.dmaStatus = XE_ATA_DMA_INTR; // Signal Interrupt.
 }
 
 // Performs the DMA operation until it reaches the end of the PRDT.
@@ -757,6 +837,7 @@ void Xe::PCIDev::HDD::doDMA() {
       // Reading from us
       size = std::fmin(static_cast<u32>(size), ataState.dataOutBuffer.count());
       memcpy(bufferInMemory, ataState.dataOutBuffer.get(), size);
+      ramPtr->MarkWritten(bufferAddress, size);
       ataState.dataOutBuffer.resize(size);
     } else {
       // Writing to us
@@ -767,6 +848,19 @@ void Xe::PCIDev::HDD::doDMA() {
     if (lastEntry) {
       // Reset the current position
       ataState.dmaState.currentTableOffset = 0;
+      // Queue the image write. BlockDevice keeps later reads of these sectors behind it,
+      // so there's no need to hold the interrupt until it hits the disk.
+      if (!readOperation && ataState.pendingWriteSize != 0) {
+        const u32 written = ataState.dataInBuffer.size();
+        ataState.dataInBuffer.reset();
+        const u64 writeOffset = ataState.pendingWriteOffset;
+        ataState.mountedHDDImage->WriteAsync(writeOffset, ataState.dataInBuffer.get(), written, [writeOffset, written](bool success) {
+          if (!success) {
+            LOG_ERROR(HDD, "Write of {:#x} bytes at {:#x} to the disk image failed", written, writeOffset);
+          }
+        });
+        ataState.pendingWriteSize = 0;
+      }
       // After completion we must raise an interrupt
       ataIssueInterrupt();
       return;
@@ -774,6 +868,14 @@ void Xe::PCIDev::HDD::doDMA() {
   }
 }
 
+void Xe::PCIDev::HDD::waitForPendingRead() {
+  u64 ticket = ataState.pendingReadTicket.load(std::memory_order_acquire);
+  if (ticket == 0)
+    return;
+  ataState.mountedHDDImage->Wait(ticket);
+  ataState.pendingReadTicket.compare_exchange_strong(ticket, 0, std::memory_order_acq_rel);
+}
+
 // Issues an interrupt to the XCPU.
 void Xe::PCIDev::HDD::ataIssueInterrupt() {
   if ((ataState.regs.deviceControl & ATA_DEVICE_CONTROL_NIEN) == 0) {
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #endif
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -20,107 +21,18 @@
 #include "Core/RAM/RAM.h"
 #include "Core/XCPU/PPU/PPCInternal.h"
 #include "Core/PCI/SATA.h"
+#include "Core/PCI/BlockDevice.h"
+#include "Core/PCI/OverlayImage.h"
 #include "Core/PCI/Bridge/PCIBridge.h"
+#include "Core/PCI/DeviceWorker.h"
 
 #define HDD_DEV_SIZE 0x30
+// Write-back cache for hot sectors when running on an overlay
+#define HDD_OVERLAY_CACHE_SIZE 32_MiB
 
 namespace Xe {
 namespace PCIDev {
 
-//
-// Read/Write Storage.
-//
-#ifdef _WIN32
-class ReadWriteStorage {
-public:
-  ReadWriteStorage(const std::string Filename) {
-    hFile = CreateFileA(Filename.data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
-      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-  }
-
-  ~ReadWriteStorage(void) {
-    if (hFile != INVALID_HANDLE_VALUE)
-      CloseHandle(hFile);
-    hFile = INVALID_HANDLE_VALUE;
-  }
-
-  u32 Size() {
-    u32 cb;
-    cb = GetFileSize(hFile, nullptr);
-    return (cb == INVALID_FILE_SIZE) ? 0 : cb;
-  }
-
-  bool Read(u64 Offset, u8* Destination, u32 cu8s) {
-    DWORD cbRead;
-    OVERLAPPED Over;
-
-    memset(&Over, 0, sizeof Over);
-    Over.Offset = LODW(Offset);
-    Over.OffsetHigh = HIDW(Offset);
-    return (ReadFile(hFile, Destination, cu8s, &cbRead, &Over) &&
-      (cbRead == cu8s));
-  }
-
-  bool Write(u64 Offset, u8* Source, u32 cu8s) {
-    DWORD cbWritten;
-    OVERLAPPED Over;
-
-    memset(&Over, 0, sizeof Over);
-    Over.Offset = LODW(Offset);
-    Over.OffsetHigh = HIDW(Offset);
-    return (WriteFile(hFile, Source, cu8s, &cbWritten, &Over) &&
-      (cbWritten == cu8s));
-  }
-
-    bool isHandleValid() {
-      return (hFile != INVALID_HANDLE_VALUE);
-    }
-
-  private:
-    HANDLE hFile;
-  };
-#else
-class ReadWriteStorage {
-public:
-  ReadWriteStorage(const std::string Filename) {
-    fd = open(Filename.c_str(), O_RDWR);
-  }
-  ~ReadWriteStorage() {
-    if (fd != -1)
-      close(fd);
-    fd = -1;
-  }
-
-  u32 Size() {
-    struct stat st;
-    if (fstat(fd, &st) != 0)
-      return 0;
-    return static_cast<u32>(st.st_size);
-  }
-
-  bool Read(u64 Offset, u8* Destination, u32 cu8s) {
-    if (lseek(fd, Offset, SEEK_SET) == (off_t)-1)
-      return false;
-    ssize_t bytesRead = read(fd, Destination, cu8s);
-    return bytesRead == static_cast<ssize_t>(cu8s);
-  }
-
-  bool Write(u64 Offset, u8* Source, u32 cu8s) {
-    if (lseek(fd, Offset, SEEK_SET) == (off_t)-1)
-      return false;
-    ssize_t bytesWritten = write(fd, Source, cu8s);
-    return bytesWritten == static_cast<ssize_t>(cu8s);
-  }
-
-  bool isHandleValid() {
-    return (fd != -1);
-  }
-
-private:
-  int fd;
-};
-#endif // ifdef _WIN32
-
 //
 // Data Buffers
 //
@@ -140,7 +52,8 @@ private:
         reset();
       }
       if (!_data) {
-        _data = std::make_unique<STRIP_UNIQUE_ARR(_data)>(maxLength);
+        // Block aligned, so image transfers straight into it can bypass the page cache
+        _data = AllocateBlockBuffer(maxLength);
       }
       if (_data) {
         _size = std::max(_size, maxLength);
@@ -151,8 +64,25 @@ private:
       }
       return false;
     }
+    // Save states: the whole buffer and the transfer position
+    void SerializeState(Xe::SaveState::StateStream &stream) {
+      u32 size = _data ? _size : 0;
+      u32 pointer = _data ? _pointer : 0;
+      stream.Do(size, pointer);
+      if (stream.IsLoading()) {
+        if (stream.Failed() || pointer > size)
+          return stream.Fail();
+        _data.reset();
+        _size = 0;
+        if (size && !init(size, false))
+          return stream.Fail();
+        _pointer = pointer;
+      }
+      if (size)
+        stream.DoBytes(_data.get(), size);
+    }
   private:
-    std::unique_ptr<u8[]> _data;
+    BlockBuffer _data;
     u32 _size;
     u32 _pointer;
   };
@@ -379,8 +309,14 @@ struct ATA_DEV_STATE {
   ATA_REG_STATE regs = {0};
   // Identify Data for our Hard Drive.
   XE_ATA_IDENTIFY_DATA ataIdentifyData = {0};
-  // Mounted HDD Image.
-  std::unique_ptr<ReadWriteStorage> mountedHDDImage{};
+  // Mounted HDD Image (or a copy-on-write overlay on top of it).
+  std::unique_ptr<IBlockStorage> mountedHDDImage{};
+  // Image read backing the current READ DMA, waited on before the transfer to RAM and before the
+  // output buffer is touched again. Commands and DMA run on different threads.
+  std::atomic<u64> pendingReadTicket = 0;
+  // Target of the current WRITE DMA, written out once the guest data arrived.
+  u64 pendingWriteOffset = 0;
+  u32 pendingWriteSize = 0;
   // Input/Output buffers.
   HDDDataBuffer dataInBuffer;
   HDDDataBuffer dataOutBuffer;
@@ -400,6 +336,10 @@ public:
   void MemSet(u64 writeAddress, s32 data, u64 size) override;
   void ConfigRead(u64 readAddress, u8* data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8* data, u64 size) override;
+  // Disk contents are only captured when running on an overlay, as the blocks that differ from the image.
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+  // Waits for queued DMA and the image read behind the current command.
+  void Quiesce() override;
 
 private:
   // PCI Bridge pointer. Used for Interrupts.
@@ -411,14 +351,12 @@ private:
   // Device State
   ATA_DEV_STATE ataState = {};
 
-  // Worker Thread for DMA requests.
-  std::thread hddWorkerThread;
-
-  // Thread running
-  volatile bool hddThreadRunning = false;
+  // DMA requests, posted when the guest sets the DMA active bit.
+  // Kept after the state it touches, so it's torn down first.
+  DeviceWorkQueue dmaQueue{ "HDD" };
 
-  // Thread loop for processing DMA requests, etc...
-  void hddThreadLoop();
+  // Runs a DMA transfer posted to dmaQueue.
+  void processDMARequest();
 
   // ATA Commands.
   void ataReadDMACommand();
@@ -435,6 +373,8 @@ private:
   void doDMA();
   // Issues an interrupt if allowed.
   void ataIssueInterrupt();
+  // Waits for the image read landing in the output buffer, if any
+  void waitForPendingRead();
 };
 
 } // namespace PCIDev
@@ -0,0 +1,165 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "CSOImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Base/Logging/Log.h"
+
+namespace Xe::PCIDev {
+
+CSOImage::CSOImage(const std::string &imagePath) {
+  file = std::make_unique<BlockDevice>(imagePath, false);
+  if (!file->IsOpen() || !file->Read(0, reinterpret_cast<u8 *>(&header), sizeof(header))) {
+    LOG_ERROR(ODD, "CSO: Unable to read '{}'", imagePath);
+    return;
+  }
+  if (header.magic != CSO_MAGIC || header.version > CSO_VERSION) {
+    LOG_ERROR(ODD, "CSO: '{}' isn't a version {} CSO image", imagePath, CSO_VERSION);
+    return;
+  }
+  if (header.blockSize == 0 || (header.blockSize & (header.blockSize - 1)) != 0 ||
+      header.blockSize > CSO_MAX_BLOCK_SIZE || header.indexAlign > CSO_MAX_INDEX_ALIGN) {
+    LOG_ERROR(ODD, "CSO: '{}' has an invalid block size ({:#x}) or index alignment ({})", imagePath,
+      header.blockSize, header.indexAlign);
+    return;
+  }
+  // One entry per block, plus one marking the end of the last block. The index has to fit in the file,
+  // which bounds totalBytes before anything gets allocated for it.
+  const u64 fileSize = file->Size();
+  const u64 blockCount = header.totalBytes / header.blockSize + (header.totalBytes % header.blockSize != 0);
+  if (blockCount >= (fileSize - std::min<u64>(fileSize, sizeof(header))) / sizeof(u32)) {
+    LOG_ERROR(ODD, "CSO: '{}' claims {:#x} bytes, more than its block index can hold", imagePath, header.totalBytes);
+    return;
+  }
+  index.resize(blockCount + 1);
+  if (!file->Read(sizeof(header), reinterpret_cast<u8 *>(index.data()), index.size() * sizeof(u32))) {
+    LOG_ERROR(ODD, "CSO: Unable to read the block index of '{}'", imagePath);
+    return;
+  }
+  // Blocks are stored in order, every one of them inside the file
+  for (u64 block = 0; block != blockCount; ++block) {
+    if (BlockStart(block) > BlockStart(block + 1) || BlockStart(block + 1) > fileSize) {
+      LOG_ERROR(ODD, "CSO: Block {} of '{}' has a corrupt index entry", block, imagePath);
+      index.clear();
+      return;
+    }
+  }
+  LOG_INFO(ODD, "CSO: '{}', {:#x} bytes in {} block(s) of {:#x}", imagePath, header.totalBytes, blockCount, header.blockSize);
+#ifndef HAVE_ZLIB
+  LOG_WARNING(ODD, "CSO: Built without zlib, compressed blocks can't be read");
+#endif
+  valid = true;
+}
+
+bool CSOImage::IsCSO(const std::string &imagePath) {
+  std::ifstream image(imagePath, std::ios::in | std::ios::binary);
+  u32 magic = 0;
+  image.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  return image.good() && magic == CSO_MAGIC;
+}
+
+u64 CSOImage::Finish(bool success, const std::function<void(bool)> &callback) {
+  if (callback)
+    callback(success);
+  std::lock_guard lock(ticketMutex);
+  const u64 ticket = nextTicket++;
+  if (!success && !callback)
+    failedTickets.insert(ticket);
+  return ticket;
+}
+
+u64 CSOImage::ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback) {
+  return Finish(valid && DoRead(offset, destination, size), callback);
+}
+
+u64 CSOImage::WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback) {
+  LOG_ERROR(ODD, "CSO: Write of {:#x} bytes at {:#x} to a read-only image", size, offset);
+  return Finish(false, callback);
+}
+
+bool CSOImage::Wait(u64 ticket) {
+  std::lock_guard lock(ticketMutex);
+  return failedTickets.erase(ticket) == 0;
+}
+
+bool CSOImage::WaitAll() {
+  std::lock_guard lock(ticketMutex);
+  const bool success = failedTickets.empty();
+  failedTickets.clear();
+  return success;
+}
+
+bool CSOImage::DoRead(u64 offset, u8 *destination, u64 size) {
+  if (offset + size > header.totalBytes) {
+    LOG_ERROR(ODD, "CSO: Read of {:#x} bytes at {:#x} is past the end of the image", size, offset);
+    return false;
+  }
+  const u64 blockSize = header.blockSize;
+  std::vector<u8> partial{};
+  while (size) {
+    const u64 block = offset / blockSize;
+    const u64 blockOffset = offset % blockSize;
+    const u64 length = std::min(size, blockSize - blockOffset);
+    // Whole blocks go straight into the destination
+    if (blockOffset == 0 && length == blockSize) {
+      if (!ReadBlock(block, destination))
+        return false;
+    } else {
+      partial.resize(blockSize);
+      if (!ReadBlock(block, partial.data()))
+        return false;
+      memcpy(destination, partial.data() + blockOffset, length);
+    }
+    offset += length;
+    destination += length;
+    size -= length;
+  }
+  return true;
+}
+
+bool CSOImage::ReadBlock(u64 block, u8 *destination) {
+  const u64 blockSize = header.blockSize;
+  const bool plain = (index[block] & CSO_INDEX_PLAIN) != 0;
+  const u64 start = BlockStart(block);
+  const u64 end = BlockStart(block + 1);
+  // The last block may be short
+  const u64 outputSize = std::min(blockSize, header.totalBytes - block * blockSize);
+  if (plain) {
+    return file->Read(start, destination, outputSize);
+  }
+#ifdef HAVE_ZLIB
+  thread_local std::vector<u8> compressed{};
+  compressed.resize(end - start);
+  if (!file->Read(start, compressed.data(), compressed.size()))
+    return false;
+  // Raw deflate stream, no zlib header
+  z_stream stream = {};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    return false;
+  stream.next_in = compressed.data();
+  stream.avail_in = static_cast<uInt>(compressed.size());
+  stream.next_out = destination;
+  stream.avail_out = static_cast<uInt>(outputSize);
+  const s32 result = inflate(&stream, Z_FINISH);
+  inflateEnd(&stream);
+  if (result != Z_STREAM_END || stream.avail_out != 0) {
+    LOG_ERROR(ODD, "CSO: Unable to decompress block {} ({})", block, result);
+    return false;
+  }
+  return true;
+#else
+  LOG_ERROR(ODD, "CSO: Block {} is compressed, and zlib support isn't built in", block);
+  return false;
+#endif
+}
+
+} // namespace Xe::PCIDev
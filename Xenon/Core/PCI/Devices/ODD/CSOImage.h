@@ -0,0 +1,86 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Core/PCI/BlockDevice.h"
+
+/*
+ *	CSOImage.h Compressed (CSO / CISO v1) disc images.
+ *
+ *	The image is split into fixed size blocks, each deflated on its own, with a table of block offsets
+ *	after the header. Reads are decompressed on the calling thread and complete before ReadAsync returns,
+ *	so this is meant to sit under a DiscCache, which does its reads on the device workers.
+ *
+ *	Decompression needs zlib (HAVE_ZLIB), without it only blocks stored uncompressed can be read.
+ */
+
+namespace Xe::PCIDev {
+
+#define CSO_MAGIC 0x4F534943 // 'CISO'
+#define CSO_VERSION 1
+
+struct CSO_HEADER {
+  u32 magic;
+  u32 headerSize;
+  // Uncompressed image size
+  u64 totalBytes;
+  u32 blockSize;
+  u8 version;
+  // Block offsets are stored shifted right by this
+  u8 indexAlign;
+  u8 reserved[2];
+};
+static_assert(sizeof(CSO_HEADER) == 0x18);
+
+// Set on an index entry when the block is stored uncompressed
+#define CSO_INDEX_PLAIN 0x80000000
+// Largest block size accepted, images in the wild use 2KiB
+#define CSO_MAX_BLOCK_SIZE 1_MiB
+// Index entries are 31 bits, shifted further than this they'd overflow 64 bits
+#define CSO_MAX_INDEX_ALIGN 31
+
+class CSOImage : public IBlockStorage {
+public:
+  explicit CSOImage(const std::string &imagePath);
+
+  // Whether a file looks like a CSO image
+  static bool IsCSO(const std::string &imagePath);
+
+  bool IsOpen() const override { return valid; }
+  u64 Size() const override { return header.totalBytes; }
+
+  u64 ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback = {}) override;
+  // Compressed images are read-only
+  u64 WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback = {}) override;
+  bool Wait(u64 ticket) override;
+  bool WaitAll() override;
+private:
+  // Completes a ticket that already ran
+  u64 Finish(bool success, const std::function<void(bool)> &callback);
+  bool DoRead(u64 offset, u8 *destination, u64 size);
+  // Decompresses block into destination (blockSize bytes)
+  bool ReadBlock(u64 block, u8 *destination);
+  // File offset of a block, index entries are validated when the image is opened
+  u64 BlockStart(u64 block) const {
+    return static_cast<u64>(index[block] & ~CSO_INDEX_PLAIN) << header.indexAlign;
+  }
+
+  std::unique_ptr<BlockDevice> file{};
+  bool valid = false;
+  CSO_HEADER header{};
+  std::vector<u32> index{};
+
+  std::mutex ticketMutex{};
+  u64 nextTicket = 1;
+  std::unordered_set<u64> failedTickets{};
+};
+
+} // namespace Xe::PCIDev
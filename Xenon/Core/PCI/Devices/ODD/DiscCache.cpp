@@ -0,0 +1,210 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "DiscCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Base/Logging/Log.h"
+
+namespace Xe::PCIDev {
+
+DiscCache::DiscCache(std::unique_ptr<IBlockStorage> source, u64 cacheSize) :
+  source(std::move(source))
+{
+  extentCount = (Size() + DISC_CACHE_EXTENT_SIZE - 1) / DISC_CACHE_EXTENT_SIZE;
+  // Always leave room for a full read-ahead window plus the extents being read
+  capacity = std::max<u64>(cacheSize / DISC_CACHE_EXTENT_SIZE, DISC_CACHE_READ_AHEAD_MAX * 2);
+}
+
+DiscCache::~DiscCache() {
+  readAheadQueue.Stop();
+  WaitAll();
+  readQueue.Stop();
+}
+
+u64 DiscCache::ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback) {
+  std::unique_lock lock(mutex);
+  const u64 ticket = nextTicket++;
+  if (offset + size > Size()) {
+    LOG_ERROR(ODD, "Read of {:#x} bytes at {:#x} is past the end of the image", size, offset);
+    if (!callback)
+      failedTickets.insert(ticket);
+    lock.unlock();
+    if (callback)
+      callback(false);
+    return ticket;
+  }
+
+  UpdateStream(offset, size);
+  if (CopyCached(offset, destination, size)) {
+    hits.fetch_add(1, std::memory_order_relaxed);
+    lock.unlock();
+    if (callback)
+      callback(true);
+    return ticket;
+  }
+  misses.fetch_add(1, std::memory_order_relaxed);
+  pendingTickets.insert(ticket);
+  lock.unlock();
+
+  readQueue.Post([this, ticket, offset, destination, size, callback = std::move(callback)] {
+    bool success = true;
+    u64 position = offset;
+    while (success && position != offset + size) {
+      const u64 extent = position / DISC_CACHE_EXTENT_SIZE;
+      const u64 extentOffset = position % DISC_CACHE_EXTENT_SIZE;
+      const u64 length = std::min(offset + size - position, DISC_CACHE_EXTENT_SIZE - extentOffset);
+      // Read-ahead can evict it again before we get the lock, just load it again then
+      for (;;) {
+        if (!LoadExtent(extent)) {
+          success = false;
+          break;
+        }
+        std::lock_guard extentLock(mutex);
+        auto it = extents.find(extent);
+        if (it == extents.end())
+          continue;
+        memcpy(destination + (position - offset), it->second.data.get() + extentOffset, length);
+        lru.splice(lru.begin(), lru, it->second.lruPosition);
+        break;
+      }
+      position += length;
+    }
+    if (callback)
+      callback(success);
+    Complete(ticket, success, static_cast<bool>(callback));
+  });
+  return ticket;
+}
+
+u64 DiscCache::WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback) {
+  LOG_ERROR(ODD, "Write of {:#x} bytes at {:#x} to a disc image", size, offset);
+  std::unique_lock lock(mutex);
+  const u64 ticket = nextTicket++;
+  if (!callback)
+    failedTickets.insert(ticket);
+  lock.unlock();
+  if (callback)
+    callback(false);
+  return ticket;
+}
+
+bool DiscCache::Wait(u64 ticket) {
+  std::unique_lock lock(mutex);
+  ticketCV.wait(lock, [&] { return !pendingTickets.contains(ticket); });
+  return failedTickets.erase(ticket) == 0;
+}
+
+bool DiscCache::WaitAll() {
+  std::unique_lock lock(mutex);
+  ticketCV.wait(lock, [this] { return pendingTickets.empty(); });
+  const bool success = failedTickets.empty();
+  failedTickets.clear();
+  return success;
+}
+
+void DiscCache::Complete(u64 ticket, bool success, bool reported) {
+  {
+    std::lock_guard lock(mutex);
+    pendingTickets.erase(ticket);
+    if (!success && !reported)
+      failedTickets.insert(ticket);
+  }
+  ticketCV.notify_all();
+}
+
+bool DiscCache::CopyCached(u64 offset, u8 *destination, u64 size) {
+  if (size == 0)
+    return true;
+  const u64 first = offset / DISC_CACHE_EXTENT_SIZE;
+  const u64 last = (offset + size - 1) / DISC_CACHE_EXTENT_SIZE;
+  for (u64 extent = first; extent <= last; ++extent) {
+    if (!extents.contains(extent))
+      return false;
+  }
+  u64 position = offset;
+  for (u64 extent = first; extent <= last; ++extent) {
+    Extent &cached = extents[extent];
+    const u64 extentOffset = position % DISC_CACHE_EXTENT_SIZE;
+    const u64 length = std::min(offset + size - position, DISC_CACHE_EXTENT_SIZE - extentOffset);
+    memcpy(destination + (position - offset), cached.data.get() + extentOffset, length);
+    lru.splice(lru.begin(), lru, cached.lruPosition);
+    position += length;
+  }
+  return true;
+}
+
+bool DiscCache::LoadExtent(u64 extent) {
+  std::unique_lock lock(mutex);
+  for (;;) {
+    if (extents.contains(extent))
+      return true;
+    if (!loading.contains(extent))
+      break;
+    extentCV.wait(lock);
+  }
+  loading.insert(extent);
+  lock.unlock();
+
+  Extent loaded{};
+  loaded.size = std::min<u64>(DISC_CACHE_EXTENT_SIZE, Size() - extent * DISC_CACHE_EXTENT_SIZE);
+  loaded.data = AllocateBlockBuffer(DISC_CACHE_EXTENT_SIZE);
+  const bool success = source->Read(extent * DISC_CACHE_EXTENT_SIZE, loaded.data.get(), loaded.size);
+
+  lock.lock();
+  loading.erase(extent);
+  if (success) {
+    lru.push_front(extent);
+    loaded.lruPosition = lru.begin();
+    extents.emplace(extent, std::move(loaded));
+    Evict();
+  } else {
+    LOG_ERROR(ODD, "Unable to read extent at {:#x}", extent * DISC_CACHE_EXTENT_SIZE);
+  }
+  lock.unlock();
+  extentCV.notify_all();
+  return success;
+}
+
+void DiscCache::Evict() {
+  while (extents.size() > capacity) {
+    extents.erase(lru.back());
+    lru.pop_back();
+  }
+}
+
+void DiscCache::UpdateStream(u64 offset, u64 size) {
+  if (offset == streamEnd && size != 0) {
+    readAheadWindow = readAheadWindow ? std::min<u64>(readAheadWindow * 2, DISC_CACHE_READ_AHEAD_MAX) :
+      DISC_CACHE_READ_AHEAD_MIN;
+  } else {
+    // New stream, anything still queued for the old one is stale
+    readAheadWindow = 0;
+    readAheadNext = 0;
+    ++streamGeneration;
+  }
+  streamEnd = offset + size;
+  if (!readAheadWindow)
+    return;
+
+  const u64 first = std::max(streamEnd / DISC_CACHE_EXTENT_SIZE, readAheadNext);
+  const u64 last = std::min(streamEnd / DISC_CACHE_EXTENT_SIZE + readAheadWindow, extentCount);
+  for (u64 extent = first; extent < last; ++extent) {
+    if (extents.contains(extent) || loading.contains(extent))
+      continue;
+    readAheadQueue.Post([this, extent, generation = streamGeneration] {
+      {
+        std::lock_guard lock(mutex);
+        if (generation != streamGeneration)
+          return;
+      }
+      LoadExtent(extent);
+    });
+  }
+  readAheadNext = std::max(readAheadNext, last);
+}
+
+} // namespace Xe::PCIDev
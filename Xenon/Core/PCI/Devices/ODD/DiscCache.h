@@ -0,0 +1,110 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Core/PCI/BlockDevice.h"
+#include "Core/PCI/DeviceWorker.h"
+
+/*
+ *	DiscCache.h Read cache with read-ahead for disc images.
+ *
+ *	The image is cached in fixed size extents, kept in an LRU bounded by the cache size. Discs are mostly
+ *	read in long sequential runs, so once a run is spotted the extents past it are fetched in the
+ *	background, and the next READ is usually served straight from memory. A compressed source is only
+ *	decompressed once per extent, the hot extents stay decompressed in the cache.
+ *
+ *	Demand reads and read-ahead run on separate device work queues, so a read never queues up behind
+ *	prefetches.
+ */
+
+namespace Xe::PCIDev {
+
+// Cache granularity
+#define DISC_CACHE_EXTENT_SIZE 0x10000
+// Read-ahead window, in extents. It starts at the minimum and doubles for every sequential read.
+#define DISC_CACHE_READ_AHEAD_MIN 2
+#define DISC_CACHE_READ_AHEAD_MAX 32
+
+class DiscCache : public IBlockStorage {
+public:
+  // Takes over source, cacheSize is the budget for cached extents
+  DiscCache(std::unique_ptr<IBlockStorage> source, u64 cacheSize);
+  // Cancels outstanding read-ahead and waits for outstanding reads
+  ~DiscCache() override;
+
+  bool IsOpen() const override { return source && source->IsOpen(); }
+  u64 Size() const override { return source->Size(); }
+
+  u64 ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback = {}) override;
+  // Discs are read-only
+  u64 WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback = {}) override;
+  bool Wait(u64 ticket) override;
+  bool WaitAll() override;
+
+  // Reads served entirely from the cache, and reads that had to wait on the image
+  u64 GetHitCount() const { return hits.load(std::memory_order_relaxed); }
+  u64 GetMissCount() const { return misses.load(std::memory_order_relaxed); }
+private:
+  struct Extent {
+    BlockBuffer data{};
+    // Bytes of the image in this extent, only the last one is short
+    u64 size = 0;
+    std::list<u64>::iterator lruPosition{};
+  };
+
+  // Copies the cached part of a read, returns whether all of it was cached. Called with the lock held.
+  bool CopyCached(u64 offset, u8 *destination, u64 size);
+  // Makes sure an extent is cached, loading it or waiting for whoever is. Returns false if the load failed.
+  bool LoadExtent(u64 extent);
+  // Drops the least recently used extents until the cache fits its budget. Called with the lock held.
+  void Evict();
+  // Tracks sequential runs and queues read-ahead past [offset, offset + size). Called with the lock held.
+  void UpdateStream(u64 offset, u64 size);
+  // Marks a ticket done, its failure is only kept when there's no callback to report it to
+  void Complete(u64 ticket, bool success, bool reported);
+
+  std::unique_ptr<IBlockStorage> source{};
+  u64 extentCount = 0;
+  u64 capacity = 0;
+
+  std::mutex mutex{};
+  std::condition_variable extentCV{};
+  std::unordered_map<u64, Extent> extents{};
+  // Most recently used first
+  std::list<u64> lru{};
+  // Extents being loaded right now
+  std::unordered_set<u64> loading{};
+
+  // Sequential stream detection
+  u64 streamEnd = 0;
+  u64 readAheadWindow = 0;
+  // First extent not yet queued for read-ahead
+  u64 readAheadNext = 0;
+  // Bumped when a stream ends, queued read-ahead for an older one is skipped
+  u64 streamGeneration = 0;
+
+  std::condition_variable ticketCV{};
+  u64 nextTicket = 1;
+  std::unordered_set<u64> pendingTickets{};
+  std::unordered_set<u64> failedTickets{};
+
+  std::atomic<u64> hits = 0;
+  std::atomic<u64> misses = 0;
+
+  // Declared last, so the queues are stopped before the state they use goes away
+  // On the storage pool, the ODD's commands wait on them from the device pool
+  DeviceWorkQueue readQueue{ "ODD Read", DeviceWorkerPool::GetStorage() };
+  DeviceWorkQueue readAheadQueue{ "ODD Read-ahead", DeviceWorkerPool::GetStorage() };
+};
+
+} // namespace Xe::PCIDev
@@ -123,9 +123,15 @@ Xe::PCIDev::ODD::ODD(const char* deviceName, u64 size, PCIBridge *parentPCIBridg
   // Set our inquiry data.
   memcpy(&atapiState.atapiInquiryData, atapiInquiryDataBytes, sizeof(atapiState.atapiInquiryData));
 
-  atapiState.mountedODDImage = std::make_unique<STRIP_UNIQUE(atapiState.mountedODDImage)>(Config::filepaths.oddImage);
-
-  if (atapiState.mountedODDImage.get()->isHandleValid()) {
+  // Compressed images are decompressed a cache extent at a time, plain ones are read as is
+  std::unique_ptr<IBlockStorage> discImage{};
+  if (CSOImage::IsCSO(Config::filepaths.oddImage))
+    discImage = std::make_unique<CSOImage>(Config::filepaths.oddImage);
+  else
+    discImage = std::make_unique<BlockDevice>(Config::filepaths.oddImage, false);
+  atapiState.mountedODDImage = std::make_unique<DiscCache>(std::move(discImage), ODD_CACHE_SIZE);
+
+  if (atapiState.mountedODDImage->IsOpen()) {
     if (fs::exists(Config::filepaths.oddImage)) {
       try {
         std::error_code fsError;
@@ -152,8 +158,6 @@ Xe::PCIDev::ODD::ODD(const char* deviceName, u64 size, PCIBridge *parentPCIBridg
     LOG_INFO(ODD, "No ODD image found - disabling device.");
   }
 
-  oddThreadRunning = atapiState.imageAttached;
-
   // Set the SCR's at offset 0xC0 (SiS-like)
   // SStatus
   data = atapiState.imageAttached ? 0x00000113 : 0;
@@ -198,9 +202,11 @@ Xe::PCIDev::ODD::ODD(const char* deviceName, u64 size, PCIBridge *parentPCIBridg
           LOG_ERROR(ODD, "DVD Key found is not 16 bytes long.");
       }
   }
+}
 
-  // Enter ODD Worker Thread
-  oddWorkerThread = std::thread(&Xe::PCIDev::ODD::oddThreadLoop, this);
+Xe::PCIDev::ODD::~ODD() {
+  // Wait for any in flight command/DMA before the state goes away.
+  workQueue.Stop();
 }
 
 // PCI Read
@@ -223,6 +229,8 @@ void Xe::PCIDev::ODD::Read(u64 readAddress, u8 *data, u64 size) {
 
     switch (atapiCommandReg) {
     case ATA_REG_DATA:
+      // PIO reads straight out of the buffer, so the image read must be done.
+      waitForPendingRead();
       if (!atapiState.dataOutBuffer.empty()) {
         size = std::fmin(size, atapiState.dataOutBuffer.count());
         memcpy(&atapiState.regs.data, atapiState.dataOutBuffer.get(), size);
@@ -343,6 +351,8 @@ void Xe::PCIDev::ODD::Write(u64 writeAddress, const u8 *data, u64 size) {
         atapiState.scsiCommandPending = true;
         // Reset our buffer ptr.
         atapiState.dataInBuffer.reset();
+        if (atapiState.imageAttached)
+          workQueue.Post([this] { processSCSIRequest(); });
       }
       return;
     } break;
@@ -494,6 +504,9 @@ void Xe::PCIDev::ODD::Write(u64 writeAddress, const u8 *data, u64 size) {
       memcpy(&atapiState.regs.dmaCommand, data, size);
       if (atapiState.regs.dmaCommand & XE_ATAPI_DMA_ACTIVE) {
         atapiState.regs.dmaStatus = XE_ATA_DMA_ACTIVE; // Signal DMA active status.
+        // Queued behind any pending SCSI command, so the transfer sees its results.
+        if (atapiState.imageAttached)
+          workQueue.Post([this] { processDMARequest(); });
       }
       break;
     case ATAPI_DMA_REG_STATUS:
@@ -578,6 +591,7 @@ void Xe::PCIDev::ODD::MemSet(u64 writeAddress, s32 data, u64 size) {
         return;
       } break;
       case ATA_COMMAND_IDENTIFY_PACKET_DEVICE: {
+        waitForPendingRead();
         memset(atapiState.dataOutBuffer.get(), data, size);
         // Set the transfer size:
         // bytecount = LBA High << 8 | LBA Mid
@@ -637,6 +651,24 @@ void Xe::PCIDev::ODD::MemSet(u64 writeAddress, s32 data, u64 size) {
   }
 }
 
+// Save states
+void Xe::PCIDev::ODD::SerializeState(Xe::SaveState::StateStream &stream) {
+  PCIDevice::SerializeState(stream);
+  stream.Do(atapiState.regs, atapiState.atapiIdentifyData, atapiState.atapiInquiryData, atapiState.scsiCBD,
+    atapiState.dmaState, atapiState.imageAttached, atapiState.scsiCommandPending);
+  atapiState.dataInBuffer.SerializeState(stream);
+  atapiState.dataOutBuffer.SerializeState(stream);
+  stream.Do(dvdKey, pageData, copyDataIntoPageData);
+  if (stream.IsLoading()) {
+    atapiState.pendingReadTicket = 0;
+  }
+}
+
+void Xe::PCIDev::ODD::Quiesce() {
+  workQueue.WaitIdle();
+  waitForPendingRead();
+}
+
 // Config read.
 void Xe::PCIDev::ODD::ConfigRead(u64 readAddress, u8 *data, u64 size) {
   const u8 readReg = static_cast<u8>(readAddress);
@@ -755,6 +787,7 @@ void Xe::PCIDev::ODD::atapiIdentifyCommand() {
 }
 
 void Xe::PCIDev::ODD::atapiIdentifyPacketDeviceCommand() {
+  waitForPendingRead();
   if (!atapiState.dataOutBuffer.init(sizeof(XE_ATAPI_IDENTIFY_DATA), true)) {
     LOG_ERROR(ODD, "Failed to initialize data buffer for atapiIdentifyPacketDeviceCommand");
   }
@@ -817,28 +850,60 @@ void Xe::PCIDev::ODD::scsiInquiryCommand() {
 }
 
 void Xe::PCIDev::ODD::scsiRead10Command() {
-  // Reset output buffer
-  atapiState.dataOutBuffer.reset();
-
   u32 sectorCount = ((u32)atapiState.scsiCBD.AsByte[7] << 8) | (atapiState.scsiCBD.AsByte[8]);
-  u32 readOffset = ((u32)atapiState.scsiCBD.AsByte[2] << 24) | ((u32)atapiState.scsiCBD.AsByte[3] << 16)
+  u32 lba = ((u32)atapiState.scsiCBD.AsByte[2] << 24) | ((u32)atapiState.scsiCBD.AsByte[3] << 16)
     | ((u32)atapiState.scsiCBD.AsByte[4] << 8) | atapiState.scsiCBD.AsByte[5];
+  scsiReadSectors(lba, sectorCount);
+}
+
+void Xe::PCIDev::ODD::scsiRead12Command() {
+  u32 sectorCount = ((u32)atapiState.scsiCBD.AsByte[6] << 24) | ((u32)atapiState.scsiCBD.AsByte[7] << 16)
+    | ((u32)atapiState.scsiCBD.AsByte[8] << 8) | atapiState.scsiCBD.AsByte[9];
+  u32 lba = ((u32)atapiState.scsiCBD.AsByte[2] << 24) | ((u32)atapiState.scsiCBD.AsByte[3] << 16)
+    | ((u32)atapiState.scsiCBD.AsByte[4] << 8) | atapiState.scsiCBD.AsByte[5];
+  scsiReadSectors(lba, sectorCount);
+}
+
+void Xe::PCIDev::ODD::scsiReadSectors(u64 lba, u32 sectorCount) {
+  // Reset output buffer
+  atapiState.dataOutBuffer.reset();
 
-  sectorCount *= ATAPI_CDROM_SECTOR_SIZE;
-  readOffset *= ATAPI_CDROM_SECTOR_SIZE;
+  // 64 bit, dual layer images are well past 4GB.
+  u64 readOffset = lba * ATAPI_CDROM_SECTOR_SIZE;
+  u64 readSize = static_cast<u64>(sectorCount) * ATAPI_CDROM_SECTOR_SIZE;
 
 #ifdef ODD_DEBUG
-  LOG_DEBUG(ODD, "Read10: Read Offset: {:#x}, Size: {:#x}", readOffset, sectorCount);
+  LOG_DEBUG(ODD, "Read: Read Offset: {:#x}, Size: {:#x}", readOffset, readSize);
 #endif // ODD_DEBUG
 
-  atapiState.dataOutBuffer.init(sectorCount, true);
+  if (readSize > ODD_MAX_READ_SIZE) {
+    LOG_ERROR(ODD, "Read of {:#x} bytes at {:#x} is too large, rejecting it", readSize, readOffset);
+    scsiIllegalRequest();
+    return;
+  }
+  const u32 transferSize = static_cast<u32>(readSize);
+  if (!atapiState.dataOutBuffer.init(transferSize, false)) {
+    LOG_ERROR(ODD, "Failed to initialize data buffer for a {:#x} byte read", transferSize);
+    scsiIllegalRequest();
+    return;
+  }
   atapiState.dataOutBuffer.reset();
-  atapiState.mountedODDImage->Read(readOffset, atapiState.dataOutBuffer.get(), sectorCount);
+  // The interrupt goes out right away, the transfer waits for the data.
+  // Sequential reads are usually already in the cache by now, thanks to read-ahead.
+  atapiState.pendingReadTicket = atapiState.mountedODDImage->ReadAsync(readOffset, atapiState.dataOutBuffer.get(), transferSize);
   atapiState.regs.interruptReason |= ATA_INTERRUPT_REASON_IO;
   atapiState.regs.interruptReason &= ~ATA_INTERRUPT_REASON_CD;
   atapiState.regs.status = ATA_STATUS_DRDY | ATA_STATUS_DF | ATA_STATUS_DRQ;
 }
 
+void Xe::PCIDev::ODD::scsiIllegalRequest() {
+  // ATAPI reports the sense key in the upper nibble of the error register
+  atapiState.regs.error = (0x5 << 4) | ATA_ERROR_ABRT;
+  atapiState.regs.status = ATA_STATUS_DRDY | ATA_STATUS_ERR_CHK;
+  atapiState.regs.interruptReason &= ~7;
+  atapiState.regs.interruptReason |= ATA_INTERRUPT_REASON_CD | ATA_INTERRUPT_REASON_IO;
+}
+
 void Xe::PCIDev::ODD::scsiReadTocCommand() {
   // Reset output buffer
   atapiState.dataOutBuffer.reset();
@@ -1048,57 +1113,51 @@ std::string Xe::PCIDev::ODD::getATAPIRegisterName(u32 regID) {
   }
 }
 
-// Worker thread for DMA.
-void Xe::PCIDev::ODD::oddThreadLoop() {
-  // Check if we should be running
-  if (!oddThreadRunning)
+// Runs on the device worker, posted once a full CDB was written with ATA_COMMAND_PACKET.
+void Xe::PCIDev::ODD::processSCSIRequest() {
+  if (!XeRunning || !atapiState.scsiCommandPending)
+    return;
+  processSCSICommand();
+  atapiState.scsiCommandPending = false;
+  // Request an Interrupt.
+  atapiIssueInterrupt();
+}
+
+// Runs on the device worker, posted by a write to the DMA command register.
+void Xe::PCIDev::ODD::processDMARequest() {
+  // The guest may have cleared the active bit before we got here.
+  if (!XeRunning || !(atapiState.regs.dmaCommand & XE_ATA_DMA_ACTIVE))
     return;
-  LOG_INFO(ODD, "Entered ODD worker thread.");
-  while (oddThreadRunning) {
-    // Check if we should exit early
-    oddThreadRunning = XeRunning;
-    if (!oddThreadRunning)
-      break;
-    // Check for the DMA active command, and only start the DMA engine if there's not any 
-    // pending SCSI command for processing. (Avoids race conditions)
-    if (atapiState.regs.dmaCommand & XE_ATA_DMA_ACTIVE
-      && atapiState.scsiCommandPending == false) {
 #ifdef ODD_DEBUG
-      LOG_INFO(ODD, "Started DMA Operation. Direction : {}",(atapiState.regs.dmaCommand & XE_ATAPI_DMA_WR ? "Out" : "In"));
+  LOG_INFO(ODD, "Started DMA Operation. Direction : {}",(atapiState.regs.dmaCommand & XE_ATAPI_DMA_WR ? "Out" : "In"));
 #endif // ODD_DEBUG
-      // Start our DMA operation
-      doDMA();
-      // Change our DMA status after completion.
-      atapiState.regs.dmaCommand &= ~1; // Clear active status.
-      atapiState.regs.dmaStatus = XE_ATA_DMA_INTR; // Signal Interrupt.
-      atapiState.regs.SActive = 0x40;
-      atapiState.regs.status = ATA_STATUS_DRDY;
-      // Reset I/O data buffers
-      atapiState.dataInBuffer.reset();
-      atapiState.dataOutBuffer.reset();
-      // After completion we must raise an interrupt.
-      atapiIssueInterrupt();
-
-      // Check if we should copy the input buffer onto our page data.
-      if (copyDataIntoPageData) {
-        memcpy(pageData, atapiState.dataInBuffer.get(), sizeof(pageData));
-        copyDataIntoPageData = false;
-      }
-    }
-    
-    // Check for pending SCSI commands.
-    if (atapiState.scsiCommandPending) {
-      processSCSICommand();
-      atapiState.scsiCommandPending = false;
-      // Request an Interrupt.
-      atapiIssueInterrupt();
-    }
+  waitForPendingRead();
+  // Start our DMA operation
+  doDMA();
+  // Change our DMA status after completion.
+  atapiState.regs.dmaCommand &= ~1; // Clear active status.
+  atapiState.regs.dmaStatus = XE_ATA_DMA_INTR; // Signal Interrupt.
+  atapiState.regs.SActive = 0x40;
+  atapiState.regs.status = ATA_STATUS_DRDY;
+  // Reset I/O data buffers
+  atapiState.dataInBuffer.reset();
+  atapiState.dataOutBuffer.reset();
+  // After completion we must raise an interrupt.
+  atapiIssueInterrupt();
 
-    // Sleep for some time.
-    std::this_thread::sleep_for(50ns);
+  // Check if we should copy the input buffer onto our page data.
+  if (copyDataIntoPageData) {
+    memcpy(pageData, atapiState.dataInBuffer.get(), sizeof(pageData));
+    copyDataIntoPageData = false;
   }
+}
 
-  LOG_INFO(ODD, "Exiting ODD worker thread.");
+void Xe::PCIDev::ODD::waitForPendingRead() {
+  u64 ticket = atapiState.pendingReadTicket.load(std::memory_order_acquire);
+  if (ticket == 0)
+    return;
+  atapiState.mountedODDImage->Wait(ticket);
+  atapiState.pendingReadTicket.compare_exchange_strong(ticket, 0, std::memory_order_acq_rel);
 }
 
 // Performs the DMA operation until it reaches the end of the PRDT.
@@ -1130,6 +1189,7 @@ void Xe::PCIDev::ODD::doDMA() {
       // Reading from us
       size = std::fmin(static_cast<u32>(size), atapiState.dataOutBuffer.count());
       memcpy(bufferInMemory, atapiState.dataOutBuffer.get(), size);
+      ramPtr->MarkWritten(bufferAddress, size);
       atapiState.dataOutBuffer.resize(size);
     } else {
       // Writing to us
@@ -1157,6 +1217,8 @@ void Xe::PCIDev::ODD::atapiIssueInterrupt() {
 
 // Processes SCSI commands.
 void Xe::PCIDev::ODD::processSCSICommand() {
+  // A previous READ (10) may still be landing in the output buffer
+  waitForPendingRead();
   // Reset input buffer pointer
   atapiState.dataInBuffer.reset();
   // Copy our CDB data.
@@ -1206,6 +1268,9 @@ void Xe::PCIDev::ODD::processSCSICommand() {
   case SCSIOP_READ10:
     scsiRead10Command();
     break;
+  case SCSIOP_READ12:
+    scsiRead12Command();
+    break;
   case SCSIOP_READ_TOC:
     scsiReadTocCommand();
     break;
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #endif
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -19,12 +20,22 @@
 
 #include "Core/RAM/RAM.h"
 #include "Core/PCI/SATA.h"
+#include "Core/PCI/BlockDevice.h"
 #include "Core/PCI/Bridge/PCIBridge.h"
 #include "Core/PCI/PCIDevice.h"
+#include "Core/PCI/DeviceWorker.h"
+#include "Core/PCI/Devices/ODD/CSOImage.h"
+#include "Core/PCI/Devices/ODD/DiscCache.h"
 #include "Core/XCPU/PPU/PPCInternal.h"
 
 #define ODD_DEV_SIZE 0x30
 
+// Memory budget for cached (and decompressed) disc extents
+#define ODD_CACHE_SIZE 64_MiB
+
+// Largest READ (10)/(12) transfer we accept, READ (12) can ask for up to 2^32 sectors
+#define ODD_MAX_READ_SIZE 16_MiB
+
 namespace Xe {
 namespace PCIDev {
 
@@ -53,7 +64,8 @@ public:
       reset();
     }
     if (!_data) {
-      _data = std::make_unique<STRIP_UNIQUE_ARR(_data)>(maxLength);
+      // Block aligned, so image transfers straight into it can bypass the page cache
+      _data = AllocateBlockBuffer(maxLength);
     }
     if (_data) {
       _size = std::max(_size, maxLength);
@@ -64,88 +76,29 @@ public:
     }
     return false;
   }
+  // Save states: the whole buffer and the transfer position
+  void SerializeState(Xe::SaveState::StateStream &stream) {
+    u32 size = _data ? _size : 0;
+    u32 pointer = _data ? _pointer : 0;
+    stream.Do(size, pointer);
+    if (stream.IsLoading()) {
+      if (stream.Failed() || pointer > size)
+        return stream.Fail();
+      _data.reset();
+      _size = 0;
+      if (size && !init(size, false))
+        return stream.Fail();
+      _pointer = pointer;
+    }
+    if (size)
+      stream.DoBytes(_data.get(), size);
+  }
 private:
-  std::unique_ptr<u8[]> _data;
+  BlockBuffer _data;
   u32 _size;
   u32 _pointer;
 };
 
-//
-// Read Only Storage.
-//
-#ifdef _WIN32
-class ReadOnlyStorage {
-public:
-  ReadOnlyStorage(const std::string Filename) {
-    hFile = CreateFileA(Filename.data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
-      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-  }
-
-  ~ReadOnlyStorage(void) {
-    if (hFile != INVALID_HANDLE_VALUE)
-      CloseHandle(hFile);
-    hFile = INVALID_HANDLE_VALUE;
-  }
-
-  u32 Size() {
-    u32 cb;
-    cb = GetFileSize(hFile, nullptr);
-    return (cb == INVALID_FILE_SIZE) ? 0 : cb;
-  }
-
-  bool Read(u64 Offset, u8 *Destination, u32 cu8s) {
-    DWORD cbRead;
-    OVERLAPPED Over;
-
-    memset(&Over, 0, sizeof Over);
-    Over.Offset = LODW(Offset);
-    Over.OffsetHigh = HIDW(Offset);
-    return (ReadFile(hFile, Destination, cu8s, &cbRead, &Over) &&
-      (cbRead == cu8s));
-  }
-
-  bool isHandleValid() {
-    return (hFile != INVALID_HANDLE_VALUE);
-  }
-
-private:
-  HANDLE hFile;
-};
-#else
-class ReadOnlyStorage {
-public:
-  ReadOnlyStorage(const std::string Filename) {
-    fd = open(Filename.c_str(), O_RDWR);
-  }
-  ~ReadOnlyStorage() {
-    if (fd != -1)
-      close(fd);
-    fd = -1;
-  }
-
-  u32 Size() {
-    struct stat st;
-    if (fstat(fd, &st) != 0)
-      return 0;
-    return static_cast<u32>(st.st_size);
-  }
-
-  bool Read(u64 Offset, u8 *Destination, u32 cu8s) {
-    if (lseek(fd, Offset, SEEK_SET) == (off_t)-1)
-      return false;
-    ssize_t bytesRead = read(fd, Destination, cu8s);
-    return bytesRead == static_cast<ssize_t>(cu8s);
-  }
-
-  bool isHandleValid() {
-    return (fd != -1);
-  }
-
-private:
-  int fd;
-};
-#endif // ifdef _WIN32
-
 //
 // SCSI Inquiry Data Structure
 //
@@ -620,8 +573,11 @@ struct ATAPI_DEV_STATE {
   XE_ATAPI_IDENTIFY_DATA atapiIdentifyData = {};
   // Inquiry data for our ODD Drive.
   XE_ATAPI_INQUIRY_DATA atapiInquiryData = {};
-  // Mounted ISO Image.
-  std::unique_ptr<ReadOnlyStorage> mountedODDImage{};
+  // Mounted ISO Image, behind the read-ahead cache.
+  std::unique_ptr<IBlockStorage> mountedODDImage{};
+  // Image read backing the last READ (10/12), waited on before the data leaves the drive and before
+  // the output buffer is touched again. ATA commands and SCSI/DMA work run on different threads.
+  std::atomic<u64> pendingReadTicket = 0;
   // Input/Output buffers.
   ODDDataBuffer dataInBuffer;
   ODDDataBuffer dataOutBuffer;
@@ -639,12 +595,17 @@ class ODD : public PCIDevice {
 public:
   ODD(const char* deviceName, u64 size,
     PCIBridge *parentPCIBridge, RAM *ram);
+  ~ODD();
 
   void Read(u64 readAddress, u8 *data, u64 size) override;
   void Write(u64 writeAddress, const u8 *data, u64 size) override;
   void MemSet(u64 writeAddress, s32 data, u64 size) override;
   void ConfigRead(u64 readAddress, u8* data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8* data, u64 size) override;
+  // The disc itself isn't part of the state, only the drive.
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+  // Waits for queued commands/DMA and the image read behind the current command.
+  void Quiesce() override;
 
 private:
   // PCI Bridge pointer. Used for Interrupts.
@@ -656,14 +617,13 @@ private:
   // ATAPI Device State.
   ATAPI_DEV_STATE atapiState = {};
 
-  // Worker Thread for DMA requests.
-  std::thread oddWorkerThread;
-
-  // Thread running
-  volatile bool oddThreadRunning = false;
+  // SCSI packets and DMA requests, in the order the guest issued them.
+  DeviceWorkQueue workQueue{ "ODD" };
 
-  // Thread loop for processing DMA requests, etc...
-  void oddThreadLoop();
+  // Runs a SCSI command posted to workQueue.
+  void processSCSIRequest();
+  // Runs a DMA transfer posted to workQueue.
+  void processDMARequest();
 
   // ATA Commands
   void atapiIdentifyPacketDeviceCommand();
@@ -673,6 +633,7 @@ private:
   void scsiReadCapacityCommand();
   void scsiInquiryCommand();
   void scsiRead10Command();
+  void scsiRead12Command();
   void scsiReadTocCommand();
 
   // Utilities
@@ -689,6 +650,12 @@ private:
   void atapiIssueInterrupt();
   // Processes a SCSI Command.
   void processSCSICommand();
+  // Queues an image read of sectorCount sectors at lba into dataOutBuffer.
+  void scsiReadSectors(u64 lba, u32 sectorCount);
+  // Ends the current packet command with CHECK CONDITION, ILLEGAL REQUEST.
+  void scsiIllegalRequest();
+  // Waits for the image read backing dataOutBuffer, if any.
+  void waitForPendingRead();
 
   // Basic no-op command
   void atapiNopCommand();
@@ -153,6 +153,13 @@ void Xe::PCIDev::OHCI::Write(u64 writeAddress, const u8 *data, u64 size) {
 void Xe::PCIDev::OHCI::MemSet(u64 writeAddress, s32 data, u64 size)
 {}
 
+void Xe::PCIDev::OHCI::SerializeState(Xe::SaveState::StateStream &stream) {
+  PCIDevice::SerializeState(stream);
+  stream.Do(HcRevision, HcControl, HcCommandStatus, HcInterruptStatus, HcInterruptEnable, HcHCCA, HcPeriodCurrentED,
+    HcControlHeadED, HcBulkHeadED, HcFmInterval, HcPeriodicStart, HcRhDescriptorA, HcRhDescriptorB, HcRhStatus,
+    HcRhPortStatus);
+}
+
 
 void Xe::PCIDev::OHCI::ConfigRead(u64 readAddress, u8 *data, u64 size) {
   memcpy(data, &pciConfigSpace.data[static_cast<u8>(readAddress)], size);
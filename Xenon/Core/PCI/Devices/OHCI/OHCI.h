@@ -19,6 +19,8 @@ public:
   void MemSet(u64 writeAddress, s32 data, u64 size) override;
   void ConfigRead(u64 readAddress, u8 *data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8 *data, u64 size) override;
+
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
 private:
   s32 instance;
   u32 ports;
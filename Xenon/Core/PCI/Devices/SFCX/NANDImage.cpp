@@ -0,0 +1,219 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "NANDImage.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Base/Logging/Log.h"
+
+// Blocks the NAND overlay caches before writing them back. Flush writes everything at once anyway.
+#define NAND_OVERLAY_CACHE_SIZE 0x100000
+
+namespace Xe::PCIDev {
+
+NANDImage::NANDImage(const std::string &imagePath, eNANDMapping mapping, const std::string &overlayPath) :
+  mapping(mapping)
+{
+  const bool useOverlay = !overlayPath.empty() && overlayPath != "none";
+  if (useOverlay && mapping == eNANDMapping::Shared) {
+    LOG_WARNING(SFCX, "NAND overlay '{}' ignored, a shared mapping writes to the image directly", overlayPath);
+  }
+  if (!Map(imagePath))
+    return;
+  LOG_INFO(SFCX, "Mapped NAND image '{}' ({:#x} bytes, {} mapping)", imagePath, size,
+    mapping == eNANDMapping::Shared ? "shared" : "private");
+
+  if (useOverlay && mapping == eNANDMapping::Private) {
+    overlay = std::make_unique<OverlayImage>(imagePath, overlayPath, eOverlayExitAction::Keep, NAND_OVERLAY_CACHE_SIZE);
+    if (!overlay->IsOpen() || !ApplyOverlay()) {
+      LOG_ERROR(SFCX, "Unable to use NAND overlay '{}', NAND writes will be lost on exit", overlayPath);
+      overlay.reset();
+      return;
+    }
+    dirtyWords = ((size + OVERLAY_BLOCK_SIZE - 1) / OVERLAY_BLOCK_SIZE + 63) / 64;
+    dirtyPages = std::make_unique<std::atomic<u64>[]>(dirtyWords);
+  }
+}
+
+NANDImage::~NANDImage() {
+  Flush();
+  overlay.reset();
+  Unmap();
+}
+
+u64 NANDImage::Clip(u64 offset, u64 length, const char *operation) const {
+  if (offset >= size) {
+    LOG_ERROR(SFCX, "NAND {} of {:#x} bytes at {:#x} is past the end of the image", operation, length, offset);
+    return 0;
+  }
+  if (length > size - offset) {
+    LOG_ERROR(SFCX, "NAND {} of {:#x} bytes at {:#x} runs past the end of the image", operation, length, offset);
+    return size - offset;
+  }
+  return length;
+}
+
+void NANDImage::Read(u64 offset, u8 *destination, u64 length) const {
+  const u64 valid = Clip(offset, length, "read");
+  memcpy(destination, data + offset, valid);
+  // Behave like erased flash past the end
+  memset(destination + valid, 0xFF, length - valid);
+}
+
+void NANDImage::Write(u64 offset, const u8 *source, u64 length) {
+  length = Clip(offset, length, "write");
+  memcpy(data + offset, source, length);
+  MarkDirty(offset, length);
+}
+
+void NANDImage::Set(u64 offset, s32 value, u64 length) {
+  length = Clip(offset, length, "write");
+  memset(data + offset, value, length);
+  MarkDirty(offset, length);
+}
+
+void NANDImage::MarkDirty(u64 offset, u64 length) {
+  if (!dirtyPages || !length)
+    return;
+  const u64 last = (offset + length - 1) / OVERLAY_BLOCK_SIZE;
+  for (u64 page = offset / OVERLAY_BLOCK_SIZE; page <= last; ++page) {
+    dirtyPages[page / 64].fetch_or(1ULL << (page % 64), std::memory_order_relaxed);
+  }
+}
+
+bool NANDImage::ApplyOverlay() {
+  // Only pages that were ever written are read, everything else stays a lazily faulted page of the image
+  const std::vector<u64> blocks = overlay->GetDeltaBlocks();
+  for (u64 block : blocks) {
+    const u64 offset = block * OVERLAY_BLOCK_SIZE;
+    if (offset >= size || !overlay->Read(offset, data + offset, std::min<u64>(OVERLAY_BLOCK_SIZE, size - offset)))
+      return false;
+  }
+  if (!blocks.empty()) {
+    LOG_INFO(SFCX, "Applied {} page(s) from the NAND overlay", blocks.size());
+  }
+  return true;
+}
+
+bool NANDImage::Flush() {
+  if (!data)
+    return false;
+  if (mapping == eNANDMapping::Shared) {
+#ifdef _WIN32
+    return FlushViewOfFile(data, 0) && FlushFileBuffers(static_cast<HANDLE>(fileHandle));
+#else
+    return msync(data, size, MS_SYNC) == 0;
+#endif
+  }
+  if (!overlay)
+    return true;
+
+  std::vector<u64> tickets{};
+  for (u64 word = 0; word != dirtyWords; ++word) {
+    // Pages dirtied again while we're copying just get picked up by the next Flush
+    u64 bits = dirtyPages[word].exchange(0, std::memory_order_relaxed);
+    while (bits) {
+      const u64 page = word * 64 + std::countr_zero(bits);
+      bits &= bits - 1;
+      const u64 offset = page * OVERLAY_BLOCK_SIZE;
+      tickets.push_back(overlay->WriteAsync(offset, data + offset, std::min<u64>(OVERLAY_BLOCK_SIZE, size - offset)));
+    }
+  }
+  if (tickets.empty())
+    return true;
+  bool success = true;
+  for (u64 ticket : tickets)
+    success &= overlay->Wait(ticket);
+  overlay->Flush();
+  LOG_DEBUG(SFCX, "Stored {} dirty NAND page(s) in the overlay", tickets.size());
+  return success;
+}
+
+bool NANDImage::Map(const std::string &imagePath) {
+  const bool shared = mapping == eNANDMapping::Shared;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(imagePath.c_str(), shared ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+    FILE_SHARE_READ | (shared ? 0 : FILE_SHARE_WRITE), nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    LOG_ERROR(SFCX, "Unable to open NAND image '{}'", imagePath);
+    return false;
+  }
+  fileHandle = file;
+  LARGE_INTEGER fileSize = {};
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    LOG_ERROR(SFCX, "Unable to get the size of NAND image '{}'", imagePath);
+    return false;
+  }
+  // PAGE_WRITECOPY + FILE_MAP_COPY is the private (copy-on-write) view
+  mappingHandle = CreateFileMappingA(file, nullptr, shared ? PAGE_READWRITE : PAGE_WRITECOPY, 0, 0, nullptr);
+  if (!mappingHandle) {
+    LOG_ERROR(SFCX, "Unable to create a mapping of NAND image '{}'", imagePath);
+    return false;
+  }
+  void *view = MapViewOfFile(mappingHandle, shared ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, 0);
+  if (!view) {
+    LOG_ERROR(SFCX, "Unable to map NAND image '{}'", imagePath);
+    return false;
+  }
+  size = static_cast<u64>(fileSize.QuadPart);
+  data = static_cast<u8 *>(view);
+#else
+  const s32 fd = open(imagePath.c_str(), (shared ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR(SFCX, "Unable to open NAND image '{}': {}", imagePath, strerror(errno));
+    return false;
+  }
+  struct stat fileStat = {};
+  if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+    LOG_ERROR(SFCX, "Unable to get the size of NAND image '{}'", imagePath);
+    close(fd);
+    return false;
+  }
+  const u64 fileSize = static_cast<u64>(fileStat.st_size);
+  void *view = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  close(fd);
+  if (view == MAP_FAILED) {
+    LOG_ERROR(SFCX, "Unable to map NAND image '{}': {}", imagePath, strerror(errno));
+    return false;
+  }
+  size = fileSize;
+  data = static_cast<u8 *>(view);
+#endif
+  return true;
+}
+
+void NANDImage::Unmap() {
+#ifdef _WIN32
+  if (data)
+    UnmapViewOfFile(data);
+  if (mappingHandle)
+    CloseHandle(mappingHandle);
+  if (fileHandle)
+    CloseHandle(fileHandle);
+  mappingHandle = nullptr;
+  fileHandle = nullptr;
+#else
+  if (data)
+    munmap(data, size);
+#endif
+  data = nullptr;
+  size = 0;
+}
+
+} // namespace Xe::PCIDev
@@ -0,0 +1,72 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "Base/Types.h"
+#include "Core/PCI/OverlayImage.h"
+
+/*
+ *	NANDImage.h Memory mapped NAND image backing the SFCX.
+ *
+ *	The image is mapped instead of read up front, so pages are only faulted in once the console touches
+ *	them. A shared mapping writes straight through to the image, a private one keeps writes in memory.
+ *	A private mapping can be paired with a copy-on-write overlay (same format as the HDD overlay), dirty
+ *	pages then get stored in it on Flush and are applied on top of the image on the next run.
+ */
+
+namespace Xe::PCIDev {
+
+enum class eNANDMapping : u8 {
+  Private, // Copy-on-write, changes are lost on exit unless an overlay is used
+  Shared   // Changes are written back to the image
+};
+
+class NANDImage {
+public:
+  // overlayPath is only used with a private mapping, "none" (or empty) to disable
+  NANDImage(const std::string &imagePath, eNANDMapping mapping, const std::string &overlayPath);
+  // Flushes, then unmaps
+  ~NANDImage();
+
+  bool IsOpen() const { return data != nullptr; }
+  u64 Size() const { return size; }
+  // Base of the mapping
+  const u8 *Data() const { return data; }
+
+  // Accessors. Out of range accesses are clipped to the image, rather than faulting on the mapping.
+  void Read(u64 offset, u8 *destination, u64 length) const;
+  void Write(u64 offset, const u8 *source, u64 length);
+  void Set(u64 offset, s32 value, u64 length);
+
+  // Makes writes durable: msync for a shared mapping, dirty pages into the overlay for a private one
+  bool Flush();
+private:
+  // Clips [offset, offset + length) to the image, returns the usable length
+  u64 Clip(u64 offset, u64 length, const char *operation) const;
+  // Records written pages for the overlay
+  void MarkDirty(u64 offset, u64 length);
+  // Applies the overlay's blocks on top of the private mapping
+  bool ApplyOverlay();
+  bool Map(const std::string &imagePath);
+  void Unmap();
+
+  eNANDMapping mapping = eNANDMapping::Private;
+  u8 *data = nullptr;
+  u64 size = 0;
+#ifdef _WIN32
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#endif
+  std::unique_ptr<OverlayImage> overlay{};
+  // One bit per OVERLAY_BLOCK_SIZE page written since the last Flush, only with an overlay
+  std::unique_ptr<std::atomic<u64>[]> dirtyPages{};
+  u64 dirtyWords = 0;
+};
+
+} // namespace Xe::PCIDev
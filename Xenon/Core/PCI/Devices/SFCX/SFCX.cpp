@@ -5,7 +5,7 @@
 #include "Base/Logging/Log.h"
 #include "Base/Global.h"
 #include "Base/Config.h"
-#include "Base/Thread.h"
+#include "Base/Hash.h"
 #include "Core/XCPU/XenonCPU.h"
 
 #include "SFCX.h"
@@ -57,26 +57,13 @@ Xe::PCIDev::SFCX::SFCX(const std::string &deviceName, u64 size, const std::strin
   // Load the NAND dump
   LOG_INFO(SFCX, "Loading NAND from path: {}", nandLoadPath);
 
-  // Check Image size
-  u64 imageSize = 0;
+  // Map the image, pages are only read in once they're touched
+  eNANDMapping mapping = eNANDMapping::Private;
+  if (Base::JoaatStringHash(Config::filepaths.nandMapping) == "Shared"_jLower)
+    mapping = eNANDMapping::Shared;
+  nandImage = std::make_unique<NANDImage>(nandLoadPath, mapping, Config::filepaths.nandOverlay);
 
-  // fs::file_size can cause a exception if it is not a valid file
-  try {
-    std::error_code ec;
-    imageSize = std::filesystem::file_size(nandLoadPath, ec);
-    if (imageSize == -1 || !imageSize) {
-      imageSize = 0;
-      LOG_ERROR(Base_Filesystem, "Failed to retrieve the file size of {} (Error: {})", nandLoadPath, ec.message());
-    }
-  } catch (const std::exception& ex) {
-    LOG_ERROR(Base_Filesystem, "Exception trying to get file size. Exception: {}",
-      ex.what());
-    return;
-  }
-
-  nandFile.open(nandLoadPath, std::ios_base::in | std::ios_base::binary);
-
-  if (!nandFile.is_open()) {
+  if (!nandImage->IsOpen()) {
     LOG_CRITICAL(SFCX, "Fatal error! Please make sure your NAND (or NAND path) is valid!");
     return;
   }
@@ -87,24 +74,14 @@ Xe::PCIDev::SFCX::SFCX(const std::string &deviceName, u64 size, const std::strin
     return;
   }
 
-  // Read NAND Image data
-  nandFile.seekg(0, std::ios::beg);
-  rawImageData.resize(imageSize);
-  for (s32 b = 0; b < imageSize;  b += sfcxState.blockSize) {
-    nandFile.read(reinterpret_cast<char*>(rawImageData.data() + b), sfcxState.blockSize);
-  }
-  // Close the file
-  nandFile.close();
-
   // Get the block size based on the blockSize / pageSize * pageSizePhys
   sfcxState.blockSizePhys = (sfcxState.blockSize / sfcxState.pageSize) * sfcxState.pageSizePhys;
 
   // Set our device BAR register based on the image size
-  pciDevSizes[1] = imageSize; // BAR1
+  pciDevSizes[1] = nandImage->Size(); // BAR1
 
   // Read NAND header.
-  memcpy(&sfcxState.nandHeader, reinterpret_cast<char*>(rawImageData.data()),
-    sizeof(sfcxState.nandHeader));
+  nandImage->Read(0, reinterpret_cast<u8*>(&sfcxState.nandHeader), sizeof(sfcxState.nandHeader));
 
   // Display info about the loaded image header
   sfcxState.nandHeader.nandMagic = byteswap_be<u16>(sfcxState.nandHeader.nandMagic);
@@ -161,8 +138,7 @@ Xe::PCIDev::SFCX::SFCX(const std::string &deviceName, u64 size, const std::strin
   // Get CB_A header data from image data.
   u32 cbaOffset = sfcxState.nandHeader.entry;
   cbaOffset = 1 ? ((cbaOffset / 0x200) * 0x210) + cbaOffset % 0x200 : cbaOffset;
-  memcpy(&cbaHeader, reinterpret_cast<char*>(rawImageData.data() + cbaOffset),
-    sizeof(cbaHeader));
+  nandImage->Read(cbaOffset, reinterpret_cast<u8*>(&cbaHeader), sizeof(cbaHeader));
 
   // Byteswap CB_A info from header
   cbaHeader.buildNumber = byteswap_be<u16>(cbaHeader.buildNumber);
@@ -172,8 +148,7 @@ Xe::PCIDev::SFCX::SFCX(const std::string &deviceName, u64 size, const std::strin
   // Get CB_B header data from image data
   u32 cbbOffset = sfcxState.nandHeader.entry + cbaHeader.length;
   cbbOffset = 1 ? ((cbbOffset / 0x200) * 0x210) + cbbOffset % 0x200 : cbbOffset;
-  memcpy(&cbbHeader, reinterpret_cast<char*>(rawImageData.data() + cbbOffset),
-    sizeof(cbbHeader));
+  nandImage->Read(cbbOffset, reinterpret_cast<u8*>(&cbbHeader), sizeof(cbbHeader));
 
   // Byteswap CB_B info from header
   cbbHeader.buildNumber = byteswap_be<u16>(cbbHeader.buildNumber);
@@ -245,17 +220,23 @@ Xe::PCIDev::SFCX::SFCX(const std::string &deviceName, u64 size, const std::strin
 }
 
 Xe::PCIDev::SFCX::~SFCX() {
-  // Clear NAND image data
-  rawImageData.clear();
-  // Terminate thread
-  sfcxThreadRunning = false;
-  if (sfcxThread.joinable())
-    sfcxThread.join();
+  // Wait for any in flight command
+  commandQueue.Stop();
+  // Write back and unmap the NAND image
+  nandImage.reset();
 }
 
 void Xe::PCIDev::SFCX::Start() {
-  // Enter SFCX Thread
-  sfcxThread = std::thread(&Xe::PCIDev::SFCX::sfcxMainLoop, this);
+  std::lock_guard lck(mutex);
+  started = true;
+  // Config register should be initialized by now, run anything issued early
+  sfcxPostCommand();
+}
+
+void Xe::PCIDev::SFCX::sfcxPostCommand() {
+  if (!started || sfcxState.commandReg == NO_CMD)
+    return;
+  commandQueue.Post([this] { sfcxProcessCommand(); });
 }
 
 void Xe::PCIDev::SFCX::Read(u64 readAddress, u8 *data, u64 size) {
@@ -351,6 +332,7 @@ void Xe::PCIDev::SFCX::Write(u64 writeAddress, const u8 *data, u64 size) {
 
     // Set command register
     sfcxState.commandReg = command;
+    sfcxPostCommand();
     break;
   case SFCX_ADDRESS_REG:
     memcpy(&sfcxState.addressReg, data, size);
@@ -393,6 +375,7 @@ void Xe::PCIDev::SFCX::MemSet(u64 writeAddress, s32 data, u64 size) {
     break;
   case SFCX_COMMAND_REG:
     memset(&sfcxState.commandReg, data, size);
+    sfcxPostCommand();
     break;
   case SFCX_ADDRESS_REG:
     memset(&sfcxState.addressReg, data, size);
@@ -427,7 +410,7 @@ void Xe::PCIDev::SFCX::ReadRaw(u64 readAddress, u8 *data, u64 size) {
 #ifdef NAND_DEBUG
   LOG_DEBUG(SFCX, "Reading RAW data at 0x{:X} (offset 0x{:X}) for 0x{:X} bytes", readAddress, offset, size);
 #endif // NAND_DEBUG
-  memcpy(data, rawImageData.data() + offset, size);
+  nandImage->Read(offset, data, size);
 }
 
 void Xe::PCIDev::SFCX::WriteRaw(u64 writeAddress, const u8 *data, u64 size) {
@@ -436,7 +419,7 @@ void Xe::PCIDev::SFCX::WriteRaw(u64 writeAddress, const u8 *data, u64 size) {
 #ifdef NAND_DEBUG
   LOG_DEBUG(SFCX, "Writing RAW data at 0x{:X} (offset 0x{:X}) for 0x{:X} bytes", writeAddress, offset, size);
 #endif // NAND_DEBUG
-  memcpy(rawImageData.data() + offset, data, size);
+  nandImage->Write(offset, data, size);
 }
 
 void Xe::PCIDev::SFCX::MemSetRaw(u64 writeAddress, s32 data, u64 size) {
@@ -445,7 +428,7 @@ void Xe::PCIDev::SFCX::MemSetRaw(u64 writeAddress, s32 data, u64 size) {
 #ifdef NAND_DEBUG
   LOG_DEBUG(SFCX, "Setting RAW data at 0x{:X} to 0x{:X} (offset 0x{:X}) for 0x{:X} bytes", writeAddress, data, offset, size);
 #endif // NAND_DEBUG
-  memset(rawImageData.data() + offset, data, size);
+  nandImage->Set(offset, data, size);
 }
 
 void Xe::PCIDev::SFCX::ConfigWrite(u64 writeAddress, const u8 *data, u64 size) {
@@ -477,66 +460,70 @@ void Xe::PCIDev::SFCX::ConfigWrite(u64 writeAddress, const u8 *data, u64 size) {
   memcpy(&pciConfigSpace.data[offset], &tmp, size);
 }
 
-void Xe::PCIDev::SFCX::sfcxMainLoop() {
-  Base::SetCurrentThreadName("[Xe] SFCX");
-  sfcxThreadRunning = XeRunning;
-  // Config register should be initialized by now
-  while (sfcxThreadRunning) {
-    // Ensure we haven't shutdown elsewhere.
-    sfcxThreadRunning = XeRunning;
-    if (!sfcxThreadRunning)
-      break;
+void Xe::PCIDev::SFCX::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lck(mutex);
+  PCIDevice::SerializeState(stream);
+  stream.Do(sfcxState, hasInitialised, initSkip1, initSkip2);
+  // A command issued before the state was saved still has to run
+  if (stream.IsLoading() && !stream.Failed())
+    sfcxPostCommand();
+}
 
-    // Did we got a command?
-    if (sfcxState.commandReg != NO_CMD) {
-      // Check the command reg to see what command was issued
-      std::lock_guard lck(mutex);
-      switch (sfcxState.commandReg) {
-      case PHY_PAGE_TO_BUF:
-        sfcxReadPageFromNAND(true);
-        break;
-      case LOG_PAGE_TO_BUF:
-        sfcxReadPageFromNAND(false);
-        break;
-      case DMA_LOG_TO_RAM:
-        sfcxDoDMAfromNAND(false);
-        break;
-      case DMA_PHY_TO_RAM:
-        sfcxDoDMAfromNAND(true);
-        break;
-      case DMA_RAM_TO_PHY:
-        sfcxDoDMAtoNAND();
-        break;
-      case BLOCK_ERASE:
-        sfcxEraseBlock();
-        break;
-      case UNLOCK_CMD_0:
-        LOG_DEBUG(SFCX, "Performing unlock sequence for NAND write.");
-        break;
-      case UNLOCK_CMD_1:
-        break;
-      default:
-        LOG_ERROR(SFCX, "Unrecognized command was issued. 0x{:X}. Issuing interrupt if enabled.", sfcxState.commandReg);
-        break;
-      }
-      if (sfcxState.configReg & CONFIG_INT_EN) {
-        parentBus->RouteInterrupt(PRIO_SFCX);
-        sfcxState.statusReg |= STATUS_INT_CP;
-      }
+void Xe::PCIDev::SFCX::Quiesce() {
+  commandQueue.WaitIdle();
+}
 
-      // Clear Command Register
-      sfcxState.commandReg = NO_CMD;
+void Xe::PCIDev::SFCX::sfcxProcessCommand() {
+  std::lock_guard lck(mutex);
+  // Ensure we haven't shutdown elsewhere, and that a later write didn't already consume it.
+  if (!XeRunning || sfcxState.commandReg == NO_CMD)
+    return;
 
-      // Set Status to Ready again
-      sfcxState.statusReg &= ~STATUS_BUSY;
-    }
+  // Check the command reg to see what command was issued
+  switch (sfcxState.commandReg) {
+  case PHY_PAGE_TO_BUF:
+    sfcxReadPageFromNAND(true);
+    break;
+  case LOG_PAGE_TO_BUF:
+    sfcxReadPageFromNAND(false);
+    break;
+  case DMA_LOG_TO_RAM:
+    sfcxDoDMAfromNAND(false);
+    break;
+  case DMA_PHY_TO_RAM:
+    sfcxDoDMAfromNAND(true);
+    break;
+  case DMA_RAM_TO_PHY:
+    sfcxDoDMAtoNAND();
+    break;
+  case BLOCK_ERASE:
+    sfcxEraseBlock();
+    break;
+  case UNLOCK_CMD_0:
+    LOG_DEBUG(SFCX, "Performing unlock sequence for NAND write.");
+    break;
+  case UNLOCK_CMD_1:
+    break;
+  default:
+    LOG_ERROR(SFCX, "Unrecognized command was issued. 0x{:X}. Issuing interrupt if enabled.", sfcxState.commandReg);
+    break;
+  }
+  if (sfcxState.configReg & CONFIG_INT_EN) {
+    parentBus->RouteInterrupt(PRIO_SFCX);
+    sfcxState.statusReg |= STATUS_INT_CP;
   }
+
+  // Clear Command Register
+  sfcxState.commandReg = NO_CMD;
+
+  // Set Status to Ready again
+  sfcxState.statusReg &= ~STATUS_BUSY;
 }
 
 bool Xe::PCIDev::SFCX::checkMagic() {
   char magic[2];
 
-  nandFile.read(reinterpret_cast<char*>(magic), sizeof(magic));
+  nandImage->Read(0, reinterpret_cast<u8*>(magic), sizeof(magic));
 
   // Retail Nand Magic is 0xFF4F
   // Devkit Nand Magic is 0x0F4F
@@ -571,7 +558,7 @@ void Xe::PCIDev::SFCX::sfcxReadPageFromNAND(bool physical) {
   memset(sfcxState.pageBuffer, 0, sizeof(sfcxState.pageBuffer));
 
   // Perform the read
-  memcpy(sfcxState.pageBuffer, &rawImageData[nandOffset], physical ? sfcxState.pageSizePhys : sfcxState.pageSize);
+  nandImage->Read(nandOffset, sfcxState.pageBuffer, physical ? sfcxState.pageSizePhys : sfcxState.pageSize);
 }
 
 void Xe::PCIDev::SFCX::sfcxEraseBlock() {
@@ -588,7 +575,7 @@ void Xe::PCIDev::SFCX::sfcxEraseBlock() {
   memset(sfcxState.pageBuffer, 0, sizeof(sfcxState.pageBuffer));
 
   // Perform the erase
-  memset(&rawImageData[nandOffset], 0, sfcxState.blockSizePhys);
+  nandImage->Set(nandOffset, 0, sfcxState.blockSizePhys);
 }
 
 void Xe::PCIDev::SFCX::sfcxDoDMAfromNAND(bool physical) {
@@ -622,7 +609,7 @@ void Xe::PCIDev::SFCX::sfcxDoDMAfromNAND(bool physical) {
     memset(sfcxState.pageBuffer, 0, sizeof(sfcxState.pageBuffer));
 
     // Get page data
-    memcpy(sfcxState.pageBuffer, &rawImageData[physAddr], sfcxState.pageSizePhys);
+    nandImage->Read(physAddr, sfcxState.pageBuffer, sfcxState.pageSizePhys);
 
     // Write page and spare to RAM
     // On DMA, physical pages are split into Page data and Spare Data, and stored at different locations in memory
@@ -640,6 +627,12 @@ void Xe::PCIDev::SFCX::sfcxDoDMAfromNAND(bool physical) {
     // Increase read address
     physAddr += sfcxState.pageSizePhys;
   }
+
+  // Let any host side copies of this memory know it changed
+  mainMemory->MarkWritten(sfcxState.dataPhysAddrReg, static_cast<u64>(dmaPagesNum) * sfcxState.pageSize);
+  if (physical) {
+    mainMemory->MarkWritten(sfcxState.sparePhysAddrReg, static_cast<u64>(dmaPagesNum) * sfcxState.spareSize);
+  }
 }
 
 void Xe::PCIDev::SFCX::sfcxDoDMAtoNAND() {
@@ -671,8 +664,8 @@ void Xe::PCIDev::SFCX::sfcxDoDMAtoNAND() {
 
     // Write page and spare to NAND
     // On DMA, physical pages are split into Page data and Spare Data, and stored at different locations in memory
-    memcpy(&rawImageData[physAddr], dataPhysAddrPtr, sfcxState.pageSize);
-    memcpy(&rawImageData[physAddr + sfcxState.pageSize], sparePhysAddrPtr, sfcxState.spareSize);
+    nandImage->Write(physAddr, dataPhysAddrPtr, sfcxState.pageSize);
+    nandImage->Write(physAddr + sfcxState.pageSize, sparePhysAddrPtr, sfcxState.spareSize);
 
     // Increase buffer pointers
     dataPhysAddrPtr += sfcxState.pageSize;   // Logical page size
@@ -4,13 +4,14 @@
 
 #pragma once
 
+#include <memory>
 #include <thread>
-#include <fstream>
-#include <filesystem>
 
 #include "Core/RAM/RAM.h"
 #include "Core/PCI/Bridge/PCIBridge.h"
 #include "Core/PCI/PCIDevice.h"
+#include "Core/PCI/DeviceWorker.h"
+#include "Core/PCI/Devices/SFCX/NANDImage.h"
 
 // Device Size (at address 0xEA00C000)
 #define SFCX_DEV_SIZE 0x400
@@ -179,7 +180,7 @@ public:
     PCIBridge *parentPCIBridge, RAM *ram);
   ~SFCX();
 
-  // Starts the thread
+  // Starts accepting commands, anything issued before this runs now
   void Start();
 
   // PCI Read/Write methods to the SFCX device.
@@ -196,22 +197,26 @@ public:
   void ConfigRead(u64 readAddress, u8* data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8* data, u64 size) override;
 
+  // Save states. The NAND contents are saved on their own (see SaveState.h), through GetNANDImage().
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+  // Waits for the command in flight.
+  void Quiesce() override;
+  NANDImage *GetNANDImage() { return nandImage.get(); }
+
   bool hasInitialised = false;
   // Init skips
   u64 initSkip1 = 0, initSkip2 = 0;
 private:
-  // Secure Flash Controller for Xbox main loop.
-  void sfcxMainLoop();
+  // Runs the command in the command register, posted to commandQueue.
+  void sfcxProcessCommand();
+  // Posts the pending command to the device worker. Called with the lock held.
+  void sfcxPostCommand();
   // Magic check
   bool checkMagic();
-  // Thread object
-  std::thread sfcxThread;
-  // Thread running
-  volatile bool sfcxThreadRunning = false;
+  // Set by Start(), commands are only posted after this
+  bool started = false;
   // SFCX State
   SFCX_STATE sfcxState{};
-  // I/O File stream.
-  std::ifstream nandFile;
   // PCI Bridge pointer. Used for Interrupts.
   PCIBridge *parentBus = nullptr;
   // Mutex for thread-safe behavior.
@@ -226,8 +231,10 @@ private:
   void sfcxDoDMAfromNAND(bool physical);
   // Does a DMA operation from physical memory to NAND.
   void sfcxDoDMAtoNAND();
-  // RAW NAND Data from loaded image.
-  std::vector<u8> rawImageData{};
+  // RAW NAND Data, mapped from the loaded image.
+  std::unique_ptr<NANDImage> nandImage{};
+  // NAND commands, posted on a write to the command register
+  DeviceWorkQueue commandQueue{ "SFCX" };
 };
 
 } // namespace PCIDev
@@ -100,7 +100,8 @@ Xe::PCIDev::SMC::SMC(const std::string &deviceName, u64 size, PCIBridge *parentP
     smcCoreState.uartHandle = std::make_unique<HW_UART_SOCK>();
     break;
   }
-  case "socket"_j: {
+  case "socket"_j:
+  case "file"_j: {
     smcCoreState.uartHandle = std::make_unique<HW_UART_SOCK>();
     break;
   }
@@ -117,6 +118,50 @@ Xe::PCIDev::SMC::SMC(const std::string &deviceName, u64 size, PCIBridge *parentP
   }
   smcCoreState.uartHandle->uartPresent = true;
 
+  // Fat consoles vs Slims have different initial values for the HANA/ANA
+  hanaState = HANA_State;
+  switch (Config::highlyExperimental.consoleRevison) {
+  case Config::eConsoleRevision::Xenon:
+  case Config::eConsoleRevision::Zephyr:
+  case Config::eConsoleRevision::Falcon:
+  case Config::eConsoleRevision::Jasper:
+    hanaState = FAT_HANA_State;
+    break;
+  case Config::eConsoleRevision::Trinity:
+  case Config::eConsoleRevision::Corona:
+  case Config::eConsoleRevision::Corona4GB:
+  case Config::eConsoleRevision::Winchester:
+    hanaState = HANA_State;
+    break;
+  }
+  switch (Config::highlyExperimental.consoleRevison) {
+  case Config::eConsoleRevision::Xenon:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x01;
+    break;
+  case Config::eConsoleRevision::Zephyr:
+    // reinterpret_cast<u8*>(hanaState)[0xFE] = ... ;
+    break;
+  case Config::eConsoleRevision::Falcon:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x21;
+    break;
+  case Config::eConsoleRevision::Jasper:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x21;
+    break;
+  case Config::eConsoleRevision::Trinity:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
+    break;
+  case Config::eConsoleRevision::Corona4GB:
+  case Config::eConsoleRevision::Corona:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
+    break;
+  case Config::eConsoleRevision::Winchester:
+    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
+    break;
+  }
+  // Set FIFO_IN_STATUS_REG to FIFO_STATUS_READY to indicate we are ready to
+  // receive a message.
+  smcPCIState.fifoInStatusReg = FIFO_STATUS_READY;
+
   // Enter main execution thread.
   smcThread = std::thread(&SMC::smcMainThread, this);
 }
@@ -125,6 +170,10 @@ Xe::PCIDev::SMC::SMC(const std::string &deviceName, u64 size, PCIBridge *parentP
 Xe::PCIDev::SMC::~SMC() {
   LOG_INFO(SMC, "Shutting SMC down...");
   smcThreadRunning = false;
+  {
+    std::lock_guard<std::mutex> lock(smcWakeMutex);
+  }
+  smcWakeCV.notify_one();
   if (smcThread.joinable())
     smcThread.join();
   smcCoreState.uartHandle->Shutdown();
@@ -186,6 +235,35 @@ void Xe::PCIDev::SMC::Read(u64 readAddress, u8 *data, u64 size) {
   mutex.unlock();
 }
 
+// Save states
+void Xe::PCIDev::SMC::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lck(mutex);
+  PCIDevice::SerializeState(stream);
+  stream.Do(smcPCIState, smcCoreState.currTrayState, smcCoreState.currPowerOnReason, smcCoreState.currAVPackType,
+    smcCoreState.fifoDataBuffer, smcCoreState.fifoBufferPos);
+  // HANA/ANA registers are indexed by a byte
+  stream.DoBytes(hanaState, 0x100 * sizeof(u32));
+}
+
+void Xe::PCIDev::SMC::Quiesce() {
+  std::lock_guard lck(mutex);
+  clockPaused = true;
+  // Save states don't carry the queued interrupt, deliver it before the state is taken
+  if (smmInterruptPending) {
+    smmInterruptPending = false;
+    pciBridge->RouteInterrupt(PRIO_SMM);
+  }
+}
+
+void Xe::PCIDev::SMC::Resume() {
+  {
+    std::lock_guard lck(mutex);
+    clockPaused = false;
+  }
+  // The interrupt may have been armed while held
+  wakeSMCThread();
+}
+
 // PCI Config Read
 void Xe::PCIDev::SMC::ConfigRead(u64 readAddress, u8 *data, u64 size) {
   LOG_INFO(SMC, "ConfigRead: Address = 0x{:X}, size = 0x{:X}.", readAddress, size);
@@ -223,17 +301,15 @@ void Xe::PCIDev::SMC::Write(u64 writeAddress, const u8 *data, u64 size) {
     break;
   case CLCK_INT_ENABLED_REG: // Clock INT Enabled Register
     memcpy(&smcPCIState.clockIntEnabledReg, data, size);
+    wakeSMCThread();
     break;
   case CLCK_INT_STATUS_REG: // Clock INT Status Register
     memcpy(&smcPCIState.clockIntStatusReg, data, size);
+    wakeSMCThread();
     break;
   case FIFO_IN_STATUS_REG: // FIFO In Status Register
     memcpy(&smcPCIState.fifoInStatusReg, data, size);
-    if (smcPCIState.fifoInStatusReg == FIFO_STATUS_READY) { // We're about to receive a message.
-      // Reset our input buffer and buffer pointer.
-      memset(smcCoreState.fifoDataBuffer, 0, sizeof(smcCoreState.fifoDataBuffer));
-      smcCoreState.fifoBufferPos = 0;
-    }
+    fifoInStatusWritten();
     break;
   case FIFO_OUT_STATUS_REG: // FIFO Out Status Register
     memcpy(&smcPCIState.fifoOutStatusReg, data, size);
@@ -282,17 +358,15 @@ void Xe::PCIDev::SMC::MemSet(u64 writeAddress, s32 data, u64 size) {
     break;
   case CLCK_INT_ENABLED_REG: // Clock INT Enabled Register
     memset(&smcPCIState.clockIntEnabledReg, data, size);
+    wakeSMCThread();
     break;
   case CLCK_INT_STATUS_REG: // Clock INT Status Register
     memset(&smcPCIState.clockIntStatusReg, data, size);
+    wakeSMCThread();
     break;
   case FIFO_IN_STATUS_REG: // FIFO In Status Register
     memset(&smcPCIState.fifoInStatusReg, data, size);
-    if (smcPCIState.fifoInStatusReg == FIFO_STATUS_READY) { // We're about to receive a message.
-      // Reset our input buffer and buffer pointer.
-      memset(&smcCoreState.fifoDataBuffer, 0, 16);
-      smcCoreState.fifoBufferPos = 0;
-    }
+    fifoInStatusWritten();
     break;
   case FIFO_OUT_STATUS_REG: // FIFO Out Status Register
     memset(&smcPCIState.fifoOutStatusReg, data, size);
@@ -356,27 +430,33 @@ void Xe::PCIDev::SMC::setupUART(u32 uartConfig) {
     break;
   }
   case "print"_j: {
-    HW_UART_SOCK_CONFIG *config = new HW_UART_SOCK_CONFIG();
-    strncpy(config->ip, smcCoreState.socketIp.c_str(), sizeof(config->ip));
-    config->port = smcCoreState.socketPort;
-    config->usePrint = true;
-    smcCoreState.uartHandle->Init(config);
+    HW_UART_SOCK_CONFIG config = {};
+    strncpy(config.ip, smcCoreState.socketIp.c_str(), sizeof(config.ip) - 1);
+    config.port = smcCoreState.socketPort;
+    config.usePrint = true;
+    smcCoreState.uartHandle->Init(&config);
     break;
   }
   case "socket"_j: {
-    HW_UART_SOCK_CONFIG *config = new HW_UART_SOCK_CONFIG();
-    strncpy(config->ip, smcCoreState.socketIp.c_str(), sizeof(config->ip));
-    config->port = smcCoreState.socketPort;
-    config->usePrint = false;
-    smcCoreState.uartHandle->Init(config);
+    HW_UART_SOCK_CONFIG config = {};
+    strncpy(config.ip, smcCoreState.socketIp.c_str(), sizeof(config.ip) - 1);
+    config.port = smcCoreState.socketPort;
+    config.usePrint = false;
+    smcCoreState.uartHandle->Init(&config);
+    break;
+  }
+  case "file"_j: {
+    HW_UART_SOCK_CONFIG config = {};
+    strncpy(config.filePath, Config::smc.uartFile.c_str(), sizeof(config.filePath) - 1);
+    smcCoreState.uartHandle->Init(&config);
     break;
   }
 #ifdef _WIN32
   case "vcom"_j: {
-    HW_UART_VCOM_CONFIG *config = new HW_UART_VCOM_CONFIG();
-    strncpy(config->selectedComPort, smcCoreState.currentCOMPort.c_str(), sizeof(config->selectedComPort));
-    config->config = uartConfig;
-    smcCoreState.uartHandle->Init(config);
+    HW_UART_VCOM_CONFIG config = {};
+    strncpy(config.selectedComPort, smcCoreState.currentCOMPort.c_str(), sizeof(config.selectedComPort) - 1);
+    config.config = uartConfig;
+    smcCoreState.uartHandle->Init(&config);
     break;
   }
 #endif // _WIN32
@@ -391,67 +471,86 @@ void Xe::PCIDev::SMC::setupUART(u32 uartConfig) {
 // SMC Main Thread
 void Xe::PCIDev::SMC::smcMainThread() {
   Base::SetCurrentThreadName("[Xe] SMC");
-  // Set FIFO_IN_STATUS_REG to FIFO_STATUS_READY to indicate we are ready to
-  // receive a message.
-  smcPCIState.fifoInStatusReg = FIFO_STATUS_READY;
 
   // Timer for measuring elapsed time since last Clock Interrupt.
   std::chrono::steady_clock::time_point timerStart =
       std::chrono::steady_clock::now();
-  
-  // Fat consoles vs Slims have different initial values for the HANA/ANA
-  u32 *hanaState = HANA_State;
-  switch (Config::highlyExperimental.consoleRevison) {
-  case Config::eConsoleRevision::Xenon:
-  case Config::eConsoleRevision::Zephyr:
-  case Config::eConsoleRevision::Falcon:
-  case Config::eConsoleRevision::Jasper:
-    hanaState = FAT_HANA_State;
-    break;
-  case Config::eConsoleRevision::Trinity:
-  case Config::eConsoleRevision::Corona:
-  case Config::eConsoleRevision::Corona4GB:
-  case Config::eConsoleRevision::Winchester:
-    hanaState = HANA_State;
-    break;
-  }
-  switch (Config::highlyExperimental.consoleRevison) {
-  case Config::eConsoleRevision::Xenon:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x01;
-    break;
-  case Config::eConsoleRevision::Zephyr:
-    // reinterpret_cast<u8*>(hanaState)[0xFE] = ... ;
-    break;
-  case Config::eConsoleRevision::Falcon:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x21;
-    break;
-  case Config::eConsoleRevision::Jasper:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x21;
-    break;
-  case Config::eConsoleRevision::Trinity:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
-    break;
-  case Config::eConsoleRevision::Corona4GB:
-  case Config::eConsoleRevision::Corona:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
-    break;
-  case Config::eConsoleRevision::Winchester:
-    reinterpret_cast<u8*>(hanaState)[0xFE] = 0x23;
-    break;
-  }
+  // Clock interrupt enabled, and the last one was taken
+  bool clockArmed = false;
+
   while (smcThreadRunning) {
-    MICROPROFILE_SCOPEI("[Xe::PCI]", "SMC::Loop", MP_AUTO);
     // The System Management Controller (SMC) does the following:
     // * Communicates over a FIFO Queue with the kernel to execute commands and
-    // provide system info.
+    // provide system info. Done on the register writes, see fifoInStatusWritten.
     // * Does the UART/Serial communication between the console and remote
-    // Serial Device/PC.
+    // Serial Device/PC. Done by the UART handle.
     // * Ticks the clock and sends an interrupt (PRIO_CLOCK) every x
-    // milliseconds.
+    // milliseconds. Done here.
+    {
+      std::unique_lock<std::mutex> lock(smcWakeMutex);
+      const auto woken = [this] { return smcWakePending.load() || !smcThreadRunning; };
+      if (clockArmed) {
+        // According to sources online, this timer runs at a 1ms frequency.
+        // TODO: Verify on hardware.
+        // Leaving this on 5ms for now, we're not fast enough for a 1ms timer, and crashes the emulator.
+        smcWakeCV.wait_until(lock, timerStart + 5ms, woken);
+      } else {
+        // Nothing to do until the registers change
+        smcWakeCV.wait(lock, woken);
+      }
+      smcWakePending = false;
+    }
+    if (!smcThreadRunning) {
+      break;
+    }
+
+    if (rebootPending.exchange(false)) {
+      XeMain::Reboot(rebootReason);
+      continue;
+    }
+
+    MICROPROFILE_SCOPEI("[Xe::PCI]", "SMC::Clock", MP_AUTO);
+    mutex.lock();
+    // FIFO reply ready, held while quiesced like the clock
+    if (smmInterruptPending && !clockPaused) {
+      smmInterruptPending = false;
+      pciBridge->RouteInterrupt(PRIO_SMM);
+    }
+    // Check for SMC Clock interrupt register.
+    // 
+    // Clock Int Enabled, and Clock Interrupt Not Taken.
+    clockArmed = !clockPaused && smcPCIState.clockIntEnabledReg == CLCK_INT_ENABLED &&
+      smcPCIState.clockIntStatusReg == CLCK_INT_READY;
+    if (clockArmed && std::chrono::steady_clock::now() >= timerStart + 5ms) {
+      // Update internal timer.
+      timerStart = std::chrono::steady_clock::now();
+      smcPCIState.clockIntStatusReg = CLCK_INT_TAKEN;
+      pciBridge->RouteInterrupt(PRIO_CLOCK);
+      // Armed again once the guest acknowledges it
+      clockArmed = false;
+    }
+    mutex.unlock();
+  }
+}
 
-    // Core State (PowerOn Cause, SMC Ver, FAN Speed, Temps, etc...) should be
-    // already set.
+// Wakes the SMC thread, to look at the clock registers again, raise a FIFO reply interrupt or run a reboot
+void Xe::PCIDev::SMC::wakeSMCThread() {
+  if (smcWakePending.load(std::memory_order_relaxed) || smcWakePending.exchange(true)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(smcWakeMutex);
+  }
+  smcWakeCV.notify_one();
+}
 
+// FIFO In Status written by the system
+void Xe::PCIDev::SMC::fifoInStatusWritten() {
+  if (smcPCIState.fifoInStatusReg == FIFO_STATUS_READY) { // We're about to receive a message.
+    // Reset our input buffer and buffer pointer.
+    memset(smcCoreState.fifoDataBuffer, 0, sizeof(smcCoreState.fifoDataBuffer));
+    smcCoreState.fifoBufferPos = 0;
+  } else {
     /*
             1. FIFO communication.
     */
@@ -517,7 +616,6 @@ void Xe::PCIDev::SMC::smcMainThread() {
       // Note that the first byte in the response is always Command ID.
       //
       // Data Buffer[0] is our message ID.
-      mutex.lock();
       if (false) {
         std::stringstream ss{};
         ss << std::endl;
@@ -684,9 +782,10 @@ void Xe::PCIDev::SMC::smcMainThread() {
         else if (smcCoreState.fifoDataBuffer[1] == 0x04) {
           LOG_INFO(SMC, "[Standby] Requested reboot");
           // Note: Real hardware only respects 0x30, but for automated testing, we will allow anything
-          mutex.unlock();
-          XeMain::Reboot(static_cast<Xe::PCIDev::SMC_PWR_REASON>(smcCoreState.fifoDataBuffer[2]));
-          mutex.lock();
+          // This runs on the CPU thread that sent the command, which the reboot is about to stop. Let the SMC thread do it.
+          rebootReason = static_cast<Xe::PCIDev::SMC_PWR_REASON>(smcCoreState.fifoDataBuffer[2]);
+          rebootPending = true;
+          wakeSMCThread();
         } else {
           LOG_WARNING(SMC, "Unimplemented SMC_FIFO_CMD Subtype in SMC_SET_STANDBY: 0x{:02X}",
             static_cast<u16>(smcCoreState.fifoDataBuffer[1]));
@@ -746,45 +845,18 @@ void Xe::PCIDev::SMC::smcMainThread() {
             static_cast<u16>(smcCoreState.fifoDataBuffer[0]));
         break;
       }
-      mutex.unlock();
 
       // Set FIFO_OUT_STATUS_REG to FIFO_STATUS_READY, signaling we're ready to
       // transmit a response.
       smcPCIState.fifoOutStatusReg = FIFO_STATUS_READY;
 
       // If interrupts are active set Int status and issue one.
+      // The SMC thread raises it, as it used to when it polled the FIFO: routing an interrupt from inside the
+      // MMIO write would deliver it to the CPU before the store that submitted the command has completed.
       if (smcPCIState.smiIntEnabledReg & SMI_INT_ENABLED && noResponse == false) {
-        // Wait a small delay to mimic hardware. This allows code in xboxkrnl.exe such as
-        // KeWaitForSingleObject to correctly setup waiting code.
-        // This is no longer needed due to mutexes
-        mutex.lock();
         smcPCIState.smiIntPendingReg = SMI_INT_PENDING;
-        pciBridge->RouteInterrupt(PRIO_SMM);
-        mutex.unlock();
-      }
-    }
-
-    // Measure elapsed time.
-    std::chrono::steady_clock::time_point timerNow =
-      std::chrono::steady_clock::now();
-
-    // Check for SMC Clock interrupt register.
-    // 
-    // Clock Int Enabled.
-    if (smcPCIState.clockIntEnabledReg == CLCK_INT_ENABLED) {
-      // Clock Interrupt Not Taken.
-      if (smcPCIState.clockIntStatusReg == CLCK_INT_READY) {
-        // According to sources online, this timer runs at a 1ms frequency.
-        // TODO: Verify on hardware.
-        // Leaving this on 10ms for now, we're not fast enough for a 1ms timer, and crashes the emulator.
-        if (timerNow >= timerStart + 5ms) {
-          // Update internal timer.
-          timerStart = std::chrono::steady_clock::now();
-          mutex.lock();
-          smcPCIState.clockIntStatusReg = CLCK_INT_TAKEN;
-          pciBridge->RouteInterrupt(PRIO_CLOCK);
-          mutex.unlock();
-        }
+        smmInterruptPending = true;
+        wakeSMCThread();
       }
     }
   }
@@ -7,6 +7,7 @@
 #ifdef _WIN32
 #include <Windows.h>
 #endif
+#include <atomic>
 #include <condition_variable>
 #include <thread>
 
@@ -249,6 +250,12 @@ public:
   void ConfigRead(u64 readAddress, u8* data, u64 size) override;
   void ConfigWrite(u64 writeAddress, const u8* data, u64 size) override;
 
+  // Save states. The UART setup comes from the config, and isn't part of the state.
+  void SerializeState(Xe::SaveState::StateStream &stream) override;
+  // Holds the clock interrupt until Resume()
+  void Quiesce() override;
+  void Resume() override;
+
   void SetPowerOnReason(const SMC_PWR_REASON &reason) {
     smcCoreState.currPowerOnReason = reason;
   }
@@ -268,21 +275,41 @@ private:
   // SMC Core State, tracking all general system status
   SMC_CORE_STATE smcCoreState;
 
-  // SMC Thread object
+  // HANA/ANA register state for the current console revision
+  u32 *hanaState = nullptr;
+
+  // SMC Thread object. Only ticks the clock interrupt, raises FIFO reply interrupts and runs requested
+  // reboots, FIFO commands are handled on the guest's write that submits them.
   std::thread smcThread;
 
   // SMC Thread running state
-  volatile bool smcThreadRunning = true;
+  std::atomic<bool> smcThreadRunning = true;
+
+  // Clock interrupt held for a save state. Guarded by mutex.
+  bool clockPaused = false;
 
-  // UART Thread object
-  std::thread uartThread;
+  // Wakes the SMC thread when the clock interrupt registers change, a reply is ready or a reboot is requested
+  std::atomic<bool> smcWakePending = false;
+  std::mutex smcWakeMutex;
+  std::condition_variable smcWakeCV;
 
-  // UART Receive Thread object
-  std::thread uartSecondaryThread;
+  // FIFO reply interrupt, raised from the SMC thread rather than inside the guest's MMIO write. Guarded by mutex.
+  bool smmInterruptPending = false;
+
+  // Reboot requested by SMC_SET_STANDBY. Run from the SMC thread, as it stops the CPU that requested it.
+  std::atomic<bool> rebootPending = false;
+  SMC_PWR_REASON rebootReason = {};
 
   // SMC Main Thread
   void smcMainThread();
 
+  // Wakes the SMC thread
+  void wakeSMCThread();
+
+  // FIFO_IN_STATUS_REG was written, processes the command and queues up the reply when it's being
+  // submitted. Called with mutex held.
+  void fifoInStatusWritten();
+
   // UART/COM Port Setup
   void setupUART(u32 uartConfig);
 };
@@ -0,0 +1,77 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "Base/Types.h"
+
+//
+// Single producer / single consumer byte ring
+// Used between the guest side of the UART (MMIO, serialized by the SMC) and the UART I/O thread.
+// Neither side ever blocks or takes a lock, the consumer can hand contiguous spans straight to
+// send() / fwrite() / WriteFile() and consume whatever was actually written.
+//
+template <u32 Capacity>
+class ByteRing {
+  static_assert((Capacity & (Capacity - 1)) == 0, "ByteRing capacity must be a power of 2");
+public:
+  // Producer
+  bool Push(u8 value) {
+    const u32 head = writePos.load(std::memory_order_relaxed);
+    if (head - readPos.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    data[head & (Capacity - 1)] = value;
+    writePos.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  // Producer, stores as much of src as fits and returns how much that was
+  u32 Write(const u8 *src, u32 length) {
+    const u32 head = writePos.load(std::memory_order_relaxed);
+    length = std::min(length, Capacity - (head - readPos.load(std::memory_order_acquire)));
+    const u32 offset = head & (Capacity - 1);
+    const u32 first = std::min(length, Capacity - offset);
+    memcpy(data + offset, src, first);
+    memcpy(data, src + first, length - first);
+    writePos.store(head + length, std::memory_order_release);
+    return length;
+  }
+
+  // Consumer
+  bool Pop(u8 &value) {
+    const u32 tail = readPos.load(std::memory_order_relaxed);
+    if (writePos.load(std::memory_order_acquire) == tail) {
+      return false;
+    }
+    value = data[tail & (Capacity - 1)];
+    readPos.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  // Consumer, returns the longest contiguous readable span. Follow with Consume().
+  u32 Peek(const u8 **span) const {
+    const u32 tail = readPos.load(std::memory_order_relaxed);
+    const u32 offset = tail & (Capacity - 1);
+    *span = data + offset;
+    return std::min(writePos.load(std::memory_order_acquire) - tail, Capacity - offset);
+  }
+  void Consume(u32 length) {
+    readPos.store(readPos.load(std::memory_order_relaxed) + length, std::memory_order_release);
+  }
+
+  // Either side, only a snapshot
+  u32 Size() const {
+    return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire);
+  }
+  u32 Free() const { return Capacity - Size(); }
+  bool Empty() const { return Size() == 0; }
+private:
+  // Free running positions, wrap at 2^32
+  alignas(64) std::atomic<u32> writePos = 0;
+  alignas(64) std::atomic<u32> readPos = 0;
+  alignas(64) u8 data[Capacity] = {};
+};
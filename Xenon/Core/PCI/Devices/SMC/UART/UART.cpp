@@ -4,75 +4,194 @@
 
 #include "UART.h"
 
+#include <chrono>
+
 #include "Base/Error.h"
 #include "Base/Global.h"
 #include "Base/Thread.h"
 #ifndef _WIN32
+#include <fcntl.h>
 #include <signal.h>
 #endif //ifndef _WIN32
 
 #define COM_TEST 0
 
-// UART Thread
-void HW_UART_SOCK::uartMainThread() {
-  Base::SetCurrentThreadName("[Xe::SMC::UART] Transfer");
+void HW_UART::TxPushed(bool accepted) {
+  if (accepted) {
+    txOverrun = false;
+    return;
+  }
+  txDropped++;
+  if (!txOverrun) {
+    txOverrun = true;
+    LOG_WARNING(UART, "TX ring full, dropping output the guest wrote without checking TX status ({} bytes so far)",
+      txDropped);
+  }
+}
+
+// UART I/O Thread
+void HW_UART_SOCK::uartIOThread() {
+  Base::SetCurrentThreadName("[Xe::SMC::UART] I/O");
   if (uartInitialized) {
     LOG_INFO(SMC, "UART Initialized Successfully!");
   }
+#ifdef _WIN32
   while (uartThreadRunning) {
-    std::unique_lock<std::mutex> lock(uartMutex);
-    if (!uartTxBuffer.empty()) {
-      char c = uartTxBuffer.front();
+    {
+      std::unique_lock<std::mutex> lock(uartMutex);
+      const auto woken = [this] { return uartWakePending.load() || !uartThreadRunning; };
       if (socketCreated) {
-        s32 flags = 0;
+        // No way to wait on the socket and the CV together, check it every so often
+        uartCV.wait_for(lock, std::chrono::milliseconds(UART_POLL_INTERVAL_MS), woken);
+      } else {
+        uartCV.wait(lock, woken);
+      }
+    }
+    if (uartWakePending) {
+      std::this_thread::sleep_for(std::chrono::microseconds(UART_BATCH_DELAY_US));
+    }
+    uartWakePending = false;
+    if (socketCreated) {
+      ReceiveRx();
+    }
+    FlushTx();
+  }
+#else
+  pollfd fds[2] = {};
+  fds[0].fd = wakePipe[0];
+  fds[0].events = POLLIN;
+  while (uartThreadRunning) {
+    fds[1].fd = socketCreated ? sockHandle : -1;
+    fds[1].events = POLLIN;
+    // Only ask for POLLOUT while the socket is what is holding output back
+    if (socketCreated && !uartTxBuffer.Empty() && !uartWakePending) {
+      fds[1].events |= POLLOUT;
+    }
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+      LOG_WARNING(UART, "UART poll failed: {}", strerror(errno));
+      break;
+    }
+    if (fds[0].revents & POLLIN) {
+      u8 drain[64];
+      while (read(wakePipe[0], drain, sizeof(drain)) == sizeof(drain)) {}
+      std::this_thread::sleep_for(std::chrono::microseconds(UART_BATCH_DELAY_US));
+    }
+    if (socketCreated && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+      ReceiveRx();
+    }
+    uartWakePending = false;
+    FlushTx();
+  }
+#endif // _WIN32
+  // Whatever is left when shutting down
+  FlushTx();
+}
+
+void HW_UART_SOCK::WakeIO() {
+  if (uartWakePending.load(std::memory_order_relaxed) || uartWakePending.exchange(true)) {
+    return;
+  }
+#ifdef _WIN32
+  {
+    std::lock_guard<std::mutex> lock(uartMutex);
+  }
+  uartCV.notify_one();
+#else
+  const u8 wake = 1;
+  if (write(wakePipe[1], &wake, 1) < 0) {
+    // Pipe full, the thread is going to wake up anyways
+  }
+#endif // _WIN32
+}
+
+void HW_UART_SOCK::FlushTx() {
+  const u8 *span = nullptr;
+  u32 length = 0;
+  bool wroteFile = false;
+  while ((length = uartTxBuffer.Peek(&span)) != 0) {
+    if (socketCreated) {
+      s32 flags = 0;
 #ifndef _WIN32
-        flags = MSG_NOSIGNAL;
+      flags = MSG_NOSIGNAL | MSG_DONTWAIT;
 #endif // ifndef _WIN32
-        if (send(sockHandle, &c, 1, flags) <= 0) {
-          LOG_WARNING(UART, "Socket send failed: {}", strerror(errno));
-          socketCreated = false;
-          socketclose(sockHandle);
+      const auto sent = send(sockHandle, reinterpret_cast<const char*>(span), static_cast<s32>(length), flags);
+      if (sent > 0) {
+        uartTxBuffer.Consume(static_cast<u32>(sent));
+        continue;
+      }
+#ifdef _WIN32
+      if (WSAGetLastError() == WSAEWOULDBLOCK) {
+        break;
+      }
+#else
+      if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR) {
+        // Try again once poll says there's room
+        break;
+      }
+#endif // _WIN32
+      LOG_WARNING(UART, "Socket send failed: {}", Base::GetLastErrorMsg());
+      CloseSocket();
+      continue;
+    }
+    if (ownsOutputFile) {
+      fwrite(span, 1, length, outputFile);
+    } else {
+      // Same as the terminal output before, skip the padding the kernel sends
+      u32 runStart = 0;
+      for (u32 i = 0; i != length; ++i) {
+        if (span[i] == 0xFF || span[i] == '\0') {
+          fwrite(span + runStart, 1, i - runStart, outputFile);
+          runStart = i + 1;
         }
-      } else {
-        if (c != -1 && c != '\0')
-          printf("%c", c);
       }
-      uartTxBuffer.pop();
+      fwrite(span + runStart, 1, length - runStart, outputFile);
     }
-    lock.unlock();
+    uartTxBuffer.Consume(length);
+    wroteFile = true;
+  }
+  if (wroteFile) {
+    fflush(outputFile);
   }
 }
 
-// UART Receive Thread
-void HW_UART_SOCK::uartReceiveThread() {
-  Base::SetCurrentThreadName("[Xe::SMC::UART] Receive");
-  while (uartThreadRunning) {
-    std::unique_lock<std::mutex> lock(uartMutex);
-    char c = -1;
-    u64 bytesReceived = 0;
+void HW_UART_SOCK::ReceiveRx() {
+  u8 chunk[UART_RECV_CHUNK];
+  while (socketCreated) {
+    // Never take more than the ring has room for, the rest waits in the socket
+    const u32 room = std::min<u32>(uartRxBuffer.Free(), sizeof(chunk));
+    if (room == 0) {
+      break;
+    }
 #ifdef _WIN32
-    u_long mode = 1;
-    ioctlsocket(sockHandle, FIONBIO, &mode);
-    bytesReceived = recv(sockHandle, &c, 1, 0);
+    const auto bytesReceived = recv(sockHandle, reinterpret_cast<char*>(chunk), static_cast<s32>(room), 0);
+    if (bytesReceived < 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
+      break;
+    }
 #else
-    bytesReceived = recv(sockHandle, &c, 1, MSG_DONTWAIT);
+    const auto bytesReceived = recv(sockHandle, chunk, room, MSG_DONTWAIT);
+    if (bytesReceived < 0 && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR)) {
+      break;
+    }
+#endif // _WIN32
     if (bytesReceived == 0) {
       // Peer closed connection
       LOG_INFO(UART, "UART socket closed by peer.");
-      socketCreated = false;
-      socketclose(sockHandle);
+      CloseSocket();
       break;
-    } else if (bytesReceived < 0 && errno != EWOULDBLOCK && errno != EAGAIN) {
-      LOG_WARNING(UART, "UART recv error: {}", strerror(errno));
-      socketCreated = false;
-      socketclose(sockHandle);
+    } else if (bytesReceived < 0) {
+      LOG_WARNING(UART, "UART recv error: {}", Base::GetLastErrorMsg());
+      CloseSocket();
       break;
     }
-#endif //ifndef _WIN32
-    if (c != -1 && bytesReceived != 0) {
-      uartRxBuffer.push(c);
-    }
-    lock.unlock();
+    uartRxBuffer.Write(chunk, static_cast<u32>(bytesReceived));
+  }
+}
+
+void HW_UART_SOCK::CloseSocket() {
+  socketCreated = false;
+  socketclose(sockHandle);
+  if (!outputFile) {
+    outputFile = stdout;
   }
 }
 
@@ -83,8 +202,21 @@ void HW_UART_SOCK::Init(void *uartConfig) {
 #endif // ifndef _WIN32
 
   HW_UART_SOCK_CONFIG *sock = reinterpret_cast<decltype(sock)>(uartConfig);
-  printMode = sock->usePrint;
-  socketCreated = true;
+  printMode = sock->usePrint || sock->filePath[0] != '\0';
+  socketCreated = false;
+
+  if (sock->filePath[0] != '\0') {
+    outputFile = fopen(sock->filePath, "wb");
+    if (outputFile) {
+      ownsOutputFile = true;
+      LOG_INFO(UART, "Writing UART output to '{}'", sock->filePath);
+    } else {
+      LOG_ERROR(UART, "Failed to open '{}' for UART output, printing instead. {}", sock->filePath, Base::GetLastErrorMsg());
+      outputFile = stdout;
+    }
+  } else if (printMode) {
+    outputFile = stdout;
+  }
 
   if (!printMode) {
     sockAddr.sin_family = AF_INET;
@@ -116,63 +248,90 @@ void HW_UART_SOCK::Init(void *uartConfig) {
         socketCreated = true;
       }
     }
-  }
-  if (printMode) {
-    socketCreated = false;
-    uartThreadRunning = true;
-    uartInitialized = true;
-    uartPresent = true;
-    uartThread = std::thread(&HW_UART_SOCK::uartMainThread, this);
-    uartThread.detach();
-  } else {
-    uartThreadRunning = socketCreated;
-    uartInitialized = socketCreated;
-    uartPresent = true;
-    uartThread = std::thread(&HW_UART_SOCK::uartMainThread, this);
-    uartThread.detach();
     if (socketCreated) {
-      uartSecondaryThread = std::thread(&HW_UART_SOCK::uartReceiveThread, this);
+      // The I/O thread never blocks on the socket
+#ifdef _WIN32
+      u_long mode = 1;
+      ioctlsocket(sockHandle, FIONBIO, &mode);
+#else
+      fcntl(sockHandle, F_SETFL, fcntl(sockHandle, F_GETFL, 0) | O_NONBLOCK);
+#endif // _WIN32
+    } else {
+      LOG_WARNING(UART, "No UART socket, printing output instead");
+      outputFile = stdout;
     }
   }
+
+#ifndef _WIN32
+  if (pipe(wakePipe) != 0) {
+    LOG_CRITICAL(UART, "Failed to create the UART wake pipe! {}", Base::GetLastErrorMsg());
+    return;
+  }
+  fcntl(wakePipe[0], F_SETFL, fcntl(wakePipe[0], F_GETFL, 0) | O_NONBLOCK);
+  fcntl(wakePipe[1], F_SETFL, fcntl(wakePipe[1], F_GETFL, 0) | O_NONBLOCK);
+#endif // ifndef _WIN32
+  uartThreadRunning = true;
+  uartInitialized = true;
+  uartPresent = true;
+  uartThread = std::thread(&HW_UART_SOCK::uartIOThread, this);
 }
 
 void HW_UART_SOCK::Shutdown() {
   uartThreadRunning = false;
-  // Shutdown receive thread
-  if (uartSecondaryThread.joinable())
-    uartSecondaryThread.join();
+  // Shutdown the I/O thread, it writes out what's left first
+#ifdef _WIN32
+  {
+    std::lock_guard<std::mutex> lock(uartMutex);
+  }
+  uartCV.notify_one();
+#else
+  if (wakePipe[1] != -1) {
+    const u8 wake = 1;
+    if (write(wakePipe[1], &wake, 1) < 0) {}
+  }
+#endif // _WIN32
+  if (uartThread.joinable())
+    uartThread.join();
+#ifndef _WIN32
+  for (int &fd : wakePipe) {
+    if (fd != -1) {
+      close(fd);
+      fd = -1;
+    }
+  }
+#endif // ifndef _WIN32
   // Shutdown socket
   if (socketCreated) {
 #ifdef _WIN32
     shutdown(sockHandle, SD_BOTH);
 #endif // _WIN32
     socketclose(sockHandle);
+    socketCreated = false;
+  }
+  if (ownsOutputFile) {
+    fclose(outputFile);
+    ownsOutputFile = false;
   }
+  outputFile = nullptr;
 }
 
 void HW_UART_SOCK::Write(const u8 data) {
-  std::lock_guard<std::mutex> lock(uartMutex);
-  uartTxBuffer.push(data);
-  retVal = true;
+  // Only the guest writes, and the SMC serializes it, so this is the ring's single producer
+  retVal = uartTxBuffer.Push(data);
+  TxPushed(retVal);
+  WakeIO();
 }
 
 u8 HW_UART_SOCK::Read() {
   u8 data = 0;
-  std::lock_guard<std::mutex> lock(uartMutex);
-  if (!uartRxBuffer.empty()) {
-    data = uartRxBuffer.front();
-    uartRxBuffer.pop();
-    retVal = true;
-  } else {
-    retVal = false;
-  }
+  retVal = uartRxBuffer.Pop(data);
   return data;
 }
 
 u32 HW_UART_SOCK::ReadStatus() {
   u32 status = 0;
-  status |= uartTxBuffer.size() <= 16 ? UART_STATUS_EMPTY : 0;
-  status |= uartRxBuffer.empty() ? 0 : UART_STATUS_DATA_PRES;
+  status |= uartTxBuffer.Free() != 0 ? UART_STATUS_EMPTY : 0;
+  status |= uartRxBuffer.Empty() ? 0 : UART_STATUS_DATA_PRES;
   return status;
 }
 
@@ -234,9 +393,42 @@ void HW_UART_VCOM::Init(void *uartConfig) {
 
   // Everything initialized
   uartInitialized = true;
+  writerRunning = true;
+  writerThread = std::thread(&HW_UART_VCOM::comWriterThread, this);
+}
+
+void HW_UART_VCOM::comWriterThread() {
+  Base::SetCurrentThreadName("[Xe::SMC::UART] vCOM Writer");
+  while (writerRunning) {
+    {
+      std::unique_lock<std::mutex> lock(writerMutex);
+      writerCV.wait(lock, [this] { return writerPending.load() || !writerRunning; });
+    }
+    // Let a burst of guest writes pile up, and write it in one go
+    std::this_thread::sleep_for(std::chrono::microseconds(UART_BATCH_DELAY_US));
+    writerPending = false;
+    const u8 *span = nullptr;
+    u32 length = 0;
+    while ((length = txBuffer.Peek(&span)) != 0) {
+      currentBytesWrittenCount = 0;
+      if (!WriteFile(comPortHandle, span, length, &currentBytesWrittenCount, nullptr) || currentBytesWrittenCount == 0) {
+        // Port went away, nothing else is getting out
+        txBuffer.Consume(length);
+        continue;
+      }
+      txBuffer.Consume(currentBytesWrittenCount);
+    }
+  }
 }
 
 void HW_UART_VCOM::Shutdown() {
+  writerRunning = false;
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+  }
+  writerCV.notify_one();
+  if (writerThread.joinable())
+    writerThread.join();
 #if defined(DEBUG_BUILD) && COM_TEST
   f.close();
 #endif
@@ -255,8 +447,19 @@ void HW_UART_VCOM::Write(const u8 data) {
   reading = false;
   uartBuffer.push_back(data);
 #endif
-  if (comPortHandle)
-    retVal = WriteFile(comPortHandle, &data, 1, &currentBytesWrittenCount, nullptr);
+  if (!comPortHandle || comPortHandle == INVALID_HANDLE_VALUE) {
+    retVal = false;
+    return;
+  }
+  // Written out by the writer thread
+  retVal = txBuffer.Push(data);
+  TxPushed(retVal);
+  if (!writerPending.load(std::memory_order_relaxed) && !writerPending.exchange(true)) {
+    {
+      std::lock_guard<std::mutex> lock(writerMutex);
+    }
+    writerCV.notify_one();
+  }
 }
 
 u8 HW_UART_VCOM::Read() {
@@ -10,6 +10,7 @@
 #define socketclose closesocket
 #else
 #include <arpa/inet.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
@@ -17,18 +18,32 @@
 #define socketclose close
 #endif // _WIN32
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdio>
+#include <mutex>
 #include <thread>
-#include <queue>
 
 #include "Base/Assert.h"
 
+#include "ByteRing.h"
+
 //
 // UART Definitions
 //
 #define UART_STATUS_EMPTY 0x2
 #define UART_STATUS_DATA_PRES 0x1
 
+// Size of the TX and RX rings, power of 2
+#define UART_RING_SIZE 0x10000
+// Bytes moved per recv() call
+#define UART_RECV_CHUNK 0x1000
+// How long the I/O thread lets output pile up after being woken, so a burst of guest writes
+// goes out in one syscall instead of one per byte
+#define UART_BATCH_DELAY_US 250
+// How often the socket is checked for input where it can't be waited on together with the TX ring (Windows)
+#define UART_POLL_INTERVAL_MS 5
+
 // HW UART base class
 class HW_UART {
 public:
@@ -51,14 +66,22 @@ public:
   bool uartPresent = false;
   // Read/Write Return Status Values
   bool retVal = false;
+  // TX bytes dropped because the guest wrote with the TX ring full (UART_STATUS_EMPTY clear)
+  u64 txDropped = 0;
+protected:
+  // Counts a TX byte the ring didn't take, logs the first one of every run of drops
+  void TxPushed(bool accepted);
+  bool txOverrun = false;
 };
 
-// HW UART, used in Socket and printf
+// HW UART, used in Socket, printf and file output
 struct HW_UART_SOCK_CONFIG {
   //255.255.255.255 = 16 + 1 (nul-term)
   char ip[17] = {};
   u16 port = 0;
   bool usePrint = false;
+  // Output file, used instead of a socket when set
+  char filePath[260] = {};
 };
 class HW_UART_SOCK : public HW_UART {
 public:
@@ -67,26 +90,41 @@ public:
   void Write(const u8 data) override;
   u8 Read() override;
   u32 ReadStatus() override;
-  // UART Thread
-  void uartMainThread();
-  // UART Receive Thread
-  void uartReceiveThread();
+  // UART I/O Thread. Moves the TX ring out to the socket / stdout / file, and the socket into the RX ring
+  void uartIOThread();
+  // Wakes the I/O thread, only the first write after it went idle pays for this
+  void WakeIO();
+  // Sends / writes out everything in the TX ring that the destination accepts right away
+  void FlushTx();
+  // Moves what the socket has into the RX ring
+  void ReceiveRx();
+  // Drops the connection, further output goes to stdout
+  void CloseSocket();
   // Print mode
   bool printMode = false;
   // Socket created
   bool socketCreated = false;
-  // UART Thread object
+  // Destination when not using a socket, stdout or the output file
+  FILE *outputFile = nullptr;
+  bool ownsOutputFile = false;
+  // UART I/O Thread object
   std::thread uartThread;
-  // UART Receive Thread object
-  std::thread uartSecondaryThread;
   // Thread status
-  volatile bool uartThreadRunning = false;
-  // Receive buffer (inverse, as we're hardware)
-  std::queue<u8> uartTxBuffer = {};
-  // Transfer buffer (inverse, as we're hardware)
-  std::queue<u8> uartRxBuffer = {};
-  // Mutex, to avoid race conitions
+  std::atomic<bool> uartThreadRunning = false;
+  // Set when the I/O thread has been woken and hasn't drained the TX ring yet
+  std::atomic<bool> uartWakePending = false;
+  // Receive buffer (inverse, as we're hardware). Guest -> I/O thread
+  ByteRing<UART_RING_SIZE> uartTxBuffer = {};
+  // Transfer buffer (inverse, as we're hardware). I/O thread -> Guest
+  ByteRing<UART_RING_SIZE> uartRxBuffer = {};
+#ifdef _WIN32
+  // Wakes the I/O thread
   std::mutex uartMutex = {};
+  std::condition_variable uartCV = {};
+#else
+  // Self pipe, lets poll() wait on the socket and the TX ring at once
+  int wakePipe[2] = { -1, -1 };
+#endif // _WIN32
   // Socket Address
   struct sockaddr_in sockAddr = {};
   // Socket Handles
@@ -121,6 +159,14 @@ public:
   std::vector<u8> uartBuffer = {};
 #endif
 #ifdef _WIN32
+  // COM Port writer thread, writes the TX ring out in batches
+  void comWriterThread();
+  ByteRing<UART_RING_SIZE> txBuffer = {};
+  std::thread writerThread = {};
+  std::atomic<bool> writerRunning = false;
+  std::atomic<bool> writerPending = false;
+  std::mutex writerMutex = {};
+  std::condition_variable writerCV = {};
   // Current COM Port Device Control Block
   // See
   // https://learn.microsoft.com/en-us/windows/win32/api/winbase/ns-winbase-dcb
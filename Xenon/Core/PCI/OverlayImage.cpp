@@ -0,0 +1,462 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "OverlayImage.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "Base/Logging/Log.h"
+
+namespace Xe::PCIDev {
+
+static constexpr u64 ChunkSize = static_cast<u64>(OVERLAY_BLOCK_SIZE) * OVERLAY_CHUNK_BLOCKS;
+// Bitmap page + chunk data
+static constexpr u64 SlotSize = OVERLAY_BLOCK_SIZE + ChunkSize;
+
+static inline u64 AlignBlock(u64 value) {
+  return (value + OVERLAY_BLOCK_SIZE - 1) & ~static_cast<u64>(OVERLAY_BLOCK_SIZE - 1);
+}
+
+OverlayImage::OverlayImage(const std::string &baseImagePath, const std::string &deltaImagePath,
+  eOverlayExitAction action, u64 cacheSize) :
+  basePath(baseImagePath), deltaPath(deltaImagePath), exitAction(action),
+  cacheCapacity(std::max<u64>(cacheSize / OVERLAY_BLOCK_SIZE, 1)) {
+  base = std::make_unique<BlockDevice>(basePath, false);
+  if (!base->IsOpen()) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to open base image '{}'", basePath);
+    return;
+  }
+  baseSize = base->Size();
+  valid = OpenDelta();
+  if (valid) {
+    LOG_INFO(PCIBridge, "Overlay: '{}' on top of '{}', {} block(s) in the delta", deltaPath, basePath, deltaBlocks);
+  }
+}
+
+OverlayImage::~OverlayImage() {
+  if (valid) {
+    switch (exitAction) {
+    case eOverlayExitAction::Keep:
+      Flush();
+      break;
+    case eOverlayExitAction::Commit:
+      Commit();
+      break;
+    case eOverlayExitAction::Discard:
+      Discard();
+      break;
+    }
+  }
+  workQueue.Stop();
+}
+
+u64 OverlayImage::Post(std::function<bool()> &&work, std::function<void(bool)> &&callback) {
+  // Tickets are handed out in queue order, so completedTicket only ever moves forward
+  std::lock_guard postLock(ticketMutex);
+  const u64 ticket = nextTicket++;
+  workQueue.Post([this, ticket, work = std::move(work), callback = std::move(callback)] {
+    const bool success = valid && work();
+    if (callback)
+      callback(success);
+    {
+      std::lock_guard lock(ticketMutex);
+      if (!success && !callback)
+        failedTickets.insert(ticket);
+      completedTicket = ticket;
+    }
+    ticketCV.notify_all();
+  });
+  return ticket;
+}
+
+u64 OverlayImage::ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback) {
+  return Post([this, offset, destination, size] { return DoRead(offset, destination, size); }, std::move(callback));
+}
+
+u64 OverlayImage::WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback) {
+  std::vector<u8> data(source, source + size);
+  return Post([this, offset, data = std::move(data)] { return DoWrite(offset, data.data(), data.size()); }, std::move(callback));
+}
+
+bool OverlayImage::Wait(u64 ticket) {
+  std::unique_lock lock(ticketMutex);
+  ticketCV.wait(lock, [&] { return completedTicket >= ticket; });
+  return failedTickets.erase(ticket) == 0;
+}
+
+bool OverlayImage::WaitAll() {
+  std::unique_lock lock(ticketMutex);
+  const u64 lastTicket = nextTicket - 1;
+  ticketCV.wait(lock, [&] { return completedTicket >= lastTicket; });
+  const bool success = failedTickets.empty();
+  failedTickets.clear();
+  return success;
+}
+
+void OverlayImage::Flush() {
+  Wait(Post([this] { return DoFlush(); }, {}));
+}
+
+bool OverlayImage::Commit() {
+  return Wait(Post([this] { return DoCommit(); }, {}));
+}
+
+void OverlayImage::Discard() {
+  Wait(Post([this] { return DoDiscard(); }, {}));
+}
+
+std::vector<u64> OverlayImage::GetDeltaBlocks() {
+  std::vector<u64> blocks{};
+  Wait(Post([this, &blocks] {
+    for (u64 chunk = 0; chunk != chunkIndex.size(); ++chunk) {
+      const u32 slot = chunkIndex[chunk];
+      if (slot == 0)
+        continue;
+      for (u64 bit = 0; bit != OVERLAY_CHUNK_BLOCKS; ++bit) {
+        if ((slotBitmaps[slot][bit / 64] >> (bit % 64)) & 1)
+          blocks.push_back(chunk * OVERLAY_CHUNK_BLOCKS + bit);
+      }
+    }
+    // Written, but still only in the cache
+    for (const auto &[block, cached] : cache) {
+      if (cached.dirty && !InDelta(block))
+        blocks.push_back(block);
+    }
+    std::sort(blocks.begin(), blocks.end());
+    return true;
+  }, {}));
+  return blocks;
+}
+
+bool OverlayImage::OpenDelta() {
+  if (!std::filesystem::exists(deltaPath) && !CreateDelta())
+    return false;
+  delta = std::make_unique<BlockDevice>(deltaPath, true);
+  if (!delta->IsOpen() || !delta->Read(0, reinterpret_cast<u8 *>(&header), sizeof(header))) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to read delta '{}'", deltaPath);
+    return false;
+  }
+  if (header.magic != OVERLAY_MAGIC || header.version != OVERLAY_VERSION ||
+      header.blockSize != OVERLAY_BLOCK_SIZE || header.chunkBlocks != OVERLAY_CHUNK_BLOCKS) {
+    LOG_ERROR(PCIBridge, "Overlay: '{}' isn't a version {} overlay", deltaPath, OVERLAY_VERSION);
+    return false;
+  }
+  if (header.baseSize != baseSize) {
+    LOG_ERROR(PCIBridge, "Overlay: '{}' was made for a {:#x} byte image, '{}' is {:#x} bytes",
+      deltaPath, header.baseSize, basePath, baseSize);
+    return false;
+  }
+
+  // Index, then every allocated slot's bitmap
+  chunkIndex.resize(header.chunkCount);
+  if (!delta->Read(header.indexOffset, reinterpret_cast<u8 *>(chunkIndex.data()), chunkIndex.size() * sizeof(u32)))
+    return false;
+  slotBitmaps.assign(header.slotCount + 1, {});
+  std::vector<u64> tickets{};
+  for (u64 slot = 1; slot <= header.slotCount; ++slot) {
+    const u64 slotOffset = header.slotsOffset + (slot - 1) * SlotSize;
+    tickets.push_back(delta->ReadAsync(slotOffset, reinterpret_cast<u8 *>(slotBitmaps[slot].data()), sizeof(ChunkBitmap)));
+  }
+  bool success = true;
+  for (u64 ticket : tickets)
+    success &= delta->Wait(ticket);
+  deltaBlocks = 0;
+  for (const ChunkBitmap &bitmap : slotBitmaps) {
+    for (u64 word : bitmap)
+      deltaBlocks += std::popcount(word);
+  }
+  return success;
+}
+
+bool OverlayImage::CreateDelta() {
+  header = {};
+  header.magic = OVERLAY_MAGIC;
+  header.version = OVERLAY_VERSION;
+  header.blockSize = OVERLAY_BLOCK_SIZE;
+  header.chunkBlocks = OVERLAY_CHUNK_BLOCKS;
+  header.baseSize = baseSize;
+  header.chunkCount = (baseSize + ChunkSize - 1) / ChunkSize;
+  header.slotCount = 0;
+  header.indexOffset = OVERLAY_BLOCK_SIZE;
+  header.slotsOffset = AlignBlock(header.indexOffset + header.chunkCount * sizeof(u32));
+
+  std::ofstream file(deltaPath, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to create delta '{}'", deltaPath);
+    return false;
+  }
+  std::vector<u8> metadata(header.slotsOffset, 0);
+  memcpy(metadata.data(), &header, sizeof(header));
+  file.write(reinterpret_cast<const char *>(metadata.data()), metadata.size());
+  LOG_INFO(PCIBridge, "Overlay: Created delta '{}' for '{}'", deltaPath, basePath);
+  return file.good();
+}
+
+bool OverlayImage::InDelta(u64 block) const {
+  const u32 slot = chunkIndex[block / OVERLAY_CHUNK_BLOCKS];
+  if (slot == 0)
+    return false;
+  const u64 bit = block % OVERLAY_CHUNK_BLOCKS;
+  return (slotBitmaps[slot][bit / 64] >> (bit % 64)) & 1;
+}
+
+u64 OverlayImage::DeltaBlockOffset(u64 block) const {
+  const u32 slot = chunkIndex[block / OVERLAY_CHUNK_BLOCKS];
+  return header.slotsOffset + (slot - 1) * SlotSize + OVERLAY_BLOCK_SIZE +
+    (block % OVERLAY_CHUNK_BLOCKS) * OVERLAY_BLOCK_SIZE;
+}
+
+bool OverlayImage::DoRead(u64 offset, u8 *destination, u64 size) {
+  if (offset + size > baseSize) {
+    LOG_ERROR(PCIBridge, "Overlay: Read of {:#x} bytes at {:#x} is past the end of the image", size, offset);
+    return false;
+  }
+  // Contiguous runs from the same file go out as one request
+  struct Run {
+    BlockDevice *device = nullptr;
+    u64 offset = 0;
+    u8 *destination = nullptr;
+    u64 size = 0;
+  };
+  std::vector<Run> runs{};
+  const auto addRun = [&runs](BlockDevice *device, u64 runOffset, u8 *runDestination, u64 runSize) {
+    if (!runs.empty()) {
+      Run &last = runs.back();
+      if (last.device == device && last.offset + last.size == runOffset && last.destination + last.size == runDestination) {
+        last.size += runSize;
+        return;
+      }
+    }
+    runs.push_back({ device, runOffset, runDestination, runSize });
+  };
+
+  u64 position = offset;
+  const u64 end = offset + size;
+  while (position < end) {
+    const u64 block = position / OVERLAY_BLOCK_SIZE;
+    const u64 inner = position % OVERLAY_BLOCK_SIZE;
+    const u64 length = std::min<u64>(OVERLAY_BLOCK_SIZE - inner, end - position);
+    u8 *target = destination + (position - offset);
+    if (auto it = cache.find(block); it != cache.end()) {
+      memcpy(target, it->second.data.get() + inner, length);
+      lru.splice(lru.begin(), lru, it->second.lruPosition);
+    } else if (InDelta(block)) {
+      addRun(delta.get(), DeltaBlockOffset(block) + inner, target, length);
+    } else {
+      addRun(base.get(), position, target, length);
+    }
+    position += length;
+  }
+
+  std::vector<std::pair<BlockDevice *, u64>> tickets{};
+  for (const Run &run : runs)
+    tickets.emplace_back(run.device, run.device->ReadAsync(run.offset, run.destination, run.size));
+  bool success = true;
+  for (const auto &[device, ticket] : tickets)
+    success &= device->Wait(ticket);
+  return success;
+}
+
+bool OverlayImage::DoWrite(u64 offset, const u8 *source, u64 size) {
+  if (offset + size > baseSize) {
+    LOG_ERROR(PCIBridge, "Overlay: Write of {:#x} bytes at {:#x} is past the end of the image", size, offset);
+    return false;
+  }
+  u64 position = offset;
+  const u64 end = offset + size;
+  while (position < end) {
+    const u64 block = position / OVERLAY_BLOCK_SIZE;
+    const u64 inner = position % OVERLAY_BLOCK_SIZE;
+    const u64 length = std::min<u64>(OVERLAY_BLOCK_SIZE - inner, end - position);
+    // Partial writes need the rest of the block first
+    CachedBlock *entry = GetCachedBlock(block, length != OVERLAY_BLOCK_SIZE);
+    if (!entry)
+      return false;
+    memcpy(entry->data.get() + inner, source + (position - offset), length);
+    entry->dirty = true;
+    position += length;
+  }
+  return Evict();
+}
+
+bool OverlayImage::LoadBlock(u64 block, u8 *destination) {
+  const u64 blockOffset = block * OVERLAY_BLOCK_SIZE;
+  // The last block may hang past the end of the base image
+  const u64 length = std::min<u64>(OVERLAY_BLOCK_SIZE, baseSize - blockOffset);
+  if (length != OVERLAY_BLOCK_SIZE)
+    memset(destination, 0, OVERLAY_BLOCK_SIZE);
+  if (InDelta(block))
+    return delta->Read(DeltaBlockOffset(block), destination, length);
+  return base->Read(blockOffset, destination, length);
+}
+
+OverlayImage::CachedBlock *OverlayImage::GetCachedBlock(u64 block, bool load) {
+  if (auto it = cache.find(block); it != cache.end()) {
+    lru.splice(lru.begin(), lru, it->second.lruPosition);
+    return &it->second;
+  }
+  CachedBlock entry{};
+  entry.data = AllocateBlockBuffer(OVERLAY_BLOCK_SIZE);
+  if (load && !LoadBlock(block, entry.data.get()))
+    return nullptr;
+  lru.push_front(block);
+  entry.lruPosition = lru.begin();
+  return &cache.emplace(block, std::move(entry)).first->second;
+}
+
+bool OverlayImage::StoreBlocks(const std::vector<std::pair<u64, const u8 *>> &blocks) {
+  if (blocks.empty())
+    return true;
+  bool success = true;
+  // First write to a chunk gives it a slot at the end of the delta. An index entry pointing at a slot
+  // with an empty bitmap is harmless, so it may go out before the data.
+  std::vector<u64> tickets{};
+  bool newSlot = false;
+  for (const auto &[block, data] : blocks) {
+    const u64 chunk = block / OVERLAY_CHUNK_BLOCKS;
+    u32 &slot = chunkIndex[chunk];
+    if (slot != 0)
+      continue;
+    slot = static_cast<u32>(++header.slotCount);
+    slotBitmaps.emplace_back();
+    tickets.push_back(delta->WriteAsync(header.indexOffset + chunk * sizeof(u32), reinterpret_cast<const u8 *>(&slot), sizeof(u32)));
+    newSlot = true;
+  }
+  if (newSlot)
+    tickets.push_back(delta->WriteAsync(0, reinterpret_cast<const u8 *>(&header), sizeof(header)));
+
+  // Data, it has to be on disk before the bitmap marks it
+  for (const auto &[block, data] : blocks)
+    tickets.push_back(delta->WriteAsync(DeltaBlockOffset(block), data, OVERLAY_BLOCK_SIZE));
+  for (u64 ticket : tickets)
+    success &= delta->Wait(ticket);
+  tickets.clear();
+  if (!success || !delta->Flush()) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to write {} block(s) to '{}'", blocks.size(), deltaPath);
+    return false;
+  }
+
+  // Then the bitmap words of the newly stored blocks
+  for (const auto &[block, data] : blocks) {
+    const u32 slot = chunkIndex[block / OVERLAY_CHUNK_BLOCKS];
+    const u64 bit = block % OVERLAY_CHUNK_BLOCKS;
+    ChunkBitmap &bitmap = slotBitmaps[slot];
+    if ((bitmap[bit / 64] >> (bit % 64)) & 1)
+      continue;
+    bitmap[bit / 64] |= 1ull << (bit % 64);
+    ++deltaBlocks;
+    const u64 slotOffset = header.slotsOffset + (slot - 1) * SlotSize;
+    tickets.push_back(delta->WriteAsync(slotOffset + (bit / 64) * sizeof(u64), reinterpret_cast<const u8 *>(&bitmap[bit / 64]), sizeof(u64)));
+  }
+  for (u64 ticket : tickets)
+    success &= delta->Wait(ticket);
+  if (!success) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to update the block bitmap of '{}'", deltaPath);
+  }
+  return success;
+}
+
+bool OverlayImage::Evict() {
+  if (cache.size() <= cacheCapacity)
+    return true;
+  // Dirty victims are written out together, so they share one flush
+  std::vector<BlockBuffer> victims{};
+  std::vector<std::pair<u64, const u8 *>> dirty{};
+  while (cache.size() > cacheCapacity) {
+    const u64 block = lru.back();
+    auto it = cache.find(block);
+    if (it->second.dirty) {
+      dirty.emplace_back(block, it->second.data.get());
+      victims.push_back(std::move(it->second.data));
+    }
+    lru.pop_back();
+    cache.erase(it);
+  }
+  return StoreBlocks(dirty);
+}
+
+bool OverlayImage::DoFlush() {
+  std::vector<std::pair<u64, const u8 *>> dirty{};
+  for (auto &[block, entry] : cache) {
+    if (entry.dirty)
+      dirty.emplace_back(block, entry.data.get());
+  }
+  bool success = StoreBlocks(dirty);
+  if (success) {
+    for (auto &[block, entry] : cache)
+      entry.dirty = false;
+  }
+  success &= delta->WaitAll();
+  return success && delta->Flush();
+}
+
+bool OverlayImage::DoCommit() {
+  if (!DoFlush())
+    return false;
+  if (deltaBlocks == 0)
+    return true;
+  LOG_INFO(PCIBridge, "Overlay: Committing {} block(s) to '{}'", deltaBlocks, basePath);
+  // The only time the base gets opened for writing
+  BlockDevice writableBase(basePath, true);
+  if (!writableBase.IsOpen()) {
+    LOG_ERROR(PCIBridge, "Overlay: Unable to open '{}' for writing, delta kept", basePath);
+    return false;
+  }
+  BlockBuffer buffer = AllocateBlockBuffer(OVERLAY_BLOCK_SIZE);
+  bool success = true;
+  for (u64 chunk = 0; chunk != chunkIndex.size(); ++chunk) {
+    const u32 slot = chunkIndex[chunk];
+    if (slot == 0)
+      continue;
+    for (u64 bit = 0; bit != OVERLAY_CHUNK_BLOCKS; ++bit) {
+      if (!((slotBitmaps[slot][bit / 64] >> (bit % 64)) & 1))
+        continue;
+      const u64 block = chunk * OVERLAY_CHUNK_BLOCKS + bit;
+      const u64 blockOffset = block * OVERLAY_BLOCK_SIZE;
+      const u64 length = std::min<u64>(OVERLAY_BLOCK_SIZE, baseSize - blockOffset);
+      success &= delta->Read(DeltaBlockOffset(block), buffer.get(), length);
+      writableBase.WriteAsync(blockOffset, buffer.get(), length);
+    }
+  }
+  success &= writableBase.WaitAll();
+  // The committed blocks have to be durable before the delta holding them goes away
+  success = success && writableBase.Flush();
+  if (!success) {
+    LOG_ERROR(PCIBridge, "Overlay: Commit to '{}' failed, delta kept", basePath);
+    return false;
+  }
+  return DoDiscard();
+}
+
+bool OverlayImage::DoDiscard() {
+  cache.clear();
+  lru.clear();
+  delta->WaitAll();
+  // Reset the metadata, then cut the slots off the file
+  std::fill(chunkIndex.begin(), chunkIndex.end(), 0);
+  slotBitmaps.assign(1, {});
+  header.slotCount = 0;
+  deltaBlocks = 0;
+  bool success = delta->Write(header.indexOffset, reinterpret_cast<const u8 *>(chunkIndex.data()), chunkIndex.size() * sizeof(u32));
+  success &= WriteHeader();
+  delta.reset();
+  std::error_code ec;
+  std::filesystem::resize_file(deltaPath, header.slotsOffset, ec);
+  if (ec) {
+    LOG_WARNING(PCIBridge, "Overlay: Unable to shrink '{}': {}", deltaPath, ec.message());
+  }
+  delta = std::make_unique<BlockDevice>(deltaPath, true);
+  LOG_INFO(PCIBridge, "Overlay: Discarded all changes in '{}'", deltaPath);
+  return success && delta->IsOpen();
+}
+
+bool OverlayImage::WriteHeader() {
+  return delta->Write(0, reinterpret_cast<const u8 *>(&header), sizeof(header));
+}
+
+} // namespace Xe::PCIDev
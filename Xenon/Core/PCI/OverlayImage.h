@@ -0,0 +1,155 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Core/PCI/BlockDevice.h"
+#include "Core/PCI/DeviceWorker.h"
+
+/*
+ *	OverlayImage.h Copy-on-write overlay for drive images.
+ *
+ *	The base image is only ever opened read-only. Writes land in a sparse delta file, so any number of
+ *	instances can share one golden image and a clean disk is just a missing delta.
+ *
+ *	Delta layout (all offsets 4KB aligned, so the delta can use direct I/O too):
+ *	  [Header][Chunk index: u32 slot per chunk, 0 = untouched][Slot 1][Slot 2]...
+ *	Each slot holds one chunk (OVERLAY_CHUNK_BLOCKS blocks): a 4KB page with the chunk's block bitmap,
+ *	followed by the chunk data. Slots are allocated on the first write to a chunk, and only written
+ *	blocks are ever touched, so unwritten parts of a slot stay holes in the file.
+ *	Block data is written and flushed before the bitmap bits marking it, a block is never marked before
+ *	it has its contents.
+ */
+
+namespace Xe::PCIDev {
+
+#define OVERLAY_MAGIC 0x56524F58 // 'XORV'
+#define OVERLAY_VERSION 1
+// Copy-on-write granularity
+#define OVERLAY_BLOCK_SIZE 0x1000
+// Blocks per index chunk (1MB chunks)
+#define OVERLAY_CHUNK_BLOCKS 256
+
+struct OVERLAY_HEADER {
+  u32 magic;
+  u32 version;
+  u32 blockSize;
+  u32 chunkBlocks;
+  // Size of the base image this delta belongs to
+  u64 baseSize;
+  u64 chunkCount;
+  // Allocated slots
+  u64 slotCount;
+  u64 indexOffset;
+  u64 slotsOffset;
+};
+
+// What happens to the delta when the overlay is closed
+enum class eOverlayExitAction : u8 {
+  Keep,    // Leave it for the next run
+  Commit,  // Merge it into the base image
+  Discard  // Throw it away
+};
+
+class OverlayImage : public IBlockStorage {
+public:
+  // cacheSize is the budget for the in memory write-back cache of hot blocks
+  OverlayImage(const std::string &basePath, const std::string &deltaPath, eOverlayExitAction exitAction, u64 cacheSize);
+  // Flushes the cache, then applies the exit action
+  ~OverlayImage() override;
+
+  bool IsOpen() const override { return valid; }
+  u64 Size() const override { return baseSize; }
+
+  u64 ReadAsync(u64 offset, u8 *destination, u64 size, std::function<void(bool)> callback = {}) override;
+  u64 WriteAsync(u64 offset, const u8 *source, u64 size, std::function<void(bool)> callback = {}) override;
+  bool Wait(u64 ticket) override;
+  bool WaitAll() override;
+
+  // Writes every dirty cached block to the delta
+  void Flush();
+  // Merges the delta into the base image and empties it
+  bool Commit();
+  // Drops every change since the delta was created
+  void Discard();
+
+  // Blocks currently stored in the delta
+  u64 GetDeltaBlockCount() const { return deltaBlocks; }
+  // Indices (in OVERLAY_BLOCK_SIZE units) of every block that differs from the base, ascending
+  std::vector<u64> GetDeltaBlocks();
+private:
+  struct CachedBlock {
+    BlockBuffer data{};
+    bool dirty = false;
+    std::list<u64>::iterator lruPosition{};
+  };
+  using ChunkBitmap = std::array<u64, OVERLAY_CHUNK_BLOCKS / 64>;
+
+  // Queues work, returning its ticket
+  u64 Post(std::function<bool()> &&work, std::function<void(bool)> &&callback);
+
+  // Everything below runs on the overlay's work queue
+  bool OpenDelta();
+  bool CreateDelta();
+  bool DoRead(u64 offset, u8 *destination, u64 size);
+  bool DoWrite(u64 offset, const u8 *source, u64 size);
+  bool DoFlush();
+  bool DoCommit();
+  bool DoDiscard();
+  // Whether the delta holds this block
+  bool InDelta(u64 block) const;
+  // Offset of a block's data inside the delta
+  u64 DeltaBlockOffset(u64 block) const;
+  // Reads a whole block from wherever its current contents live
+  bool LoadBlock(u64 block, u8 *destination);
+  // Cache entry for a block, loading it if asked to
+  CachedBlock *GetCachedBlock(u64 block, bool load);
+  // Writes blocks out to the delta, allocating their slots if needed. The data is on disk before any
+  // bitmap bit marking it is written, so a crash never leaves a marked block with stale contents.
+  bool StoreBlocks(const std::vector<std::pair<u64, const u8 *>> &blocks);
+  // Keeps the cache inside its budget
+  bool Evict();
+  bool WriteHeader();
+
+  std::string basePath{};
+  std::string deltaPath{};
+  eOverlayExitAction exitAction = eOverlayExitAction::Keep;
+  std::unique_ptr<BlockDevice> base{};
+  std::unique_ptr<BlockDevice> delta{};
+  bool valid = false;
+  u64 baseSize = 0;
+
+  OVERLAY_HEADER header{};
+  // Slot per chunk, 0 if the chunk was never written
+  std::vector<u32> chunkIndex{};
+  // Block bitmap per allocated slot (index 0 unused)
+  std::vector<ChunkBitmap> slotBitmaps{};
+  u64 deltaBlocks = 0;
+
+  // Write-back cache of recently written blocks
+  u64 cacheCapacity = 0;
+  std::unordered_map<u64, CachedBlock> cache{};
+  // Most recently used first
+  std::list<u64> lru{};
+
+  // Requests run one at a time, in order, so they never overlap each other
+  std::mutex ticketMutex{};
+  std::condition_variable ticketCV{};
+  u64 nextTicket = 1;
+  u64 completedTicket = 0;
+  std::unordered_set<u64> failedTickets{};
+  // On the storage pool, the drives wait on it from the device pool
+  DeviceWorkQueue workQueue{ "Overlay", DeviceWorkerPool::GetStorage() };
+};
+
+} // namespace Xe::PCIDev
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "Core/PCI/PCIe.h"
+#include "Core/SaveState/StateStream.h"
 
 struct PCIDeviceInfo {
   std::string deviceName{};
@@ -29,6 +30,16 @@ public:
 
   std::string GetDeviceName() { return deviceInfo.deviceName; }
 
+  // Save states. Devices with registers or memory of their own extend this, after calling it.
+  // Only called while the system is quiesced.
+  virtual void SerializeState(Xe::SaveState::StateStream &stream) {
+    stream.Do(pciConfigSpace, pciDevSizes);
+  }
+  // Stops the device's own threads and lets its posted work finish, so its state stops changing.
+  // Called after the CPU was quiesced, Resume() is called from the same thread.
+  virtual void Quiesce() {}
+  virtual void Resume() {}
+
   // Checks wether a given address is mapped in the device's BAR's
   bool IsAddressMappedInBAR(u32 address) {
     u32 bar0 = pciConfigSpace.configSpaceHeader.BAR0;
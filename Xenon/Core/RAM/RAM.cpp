@@ -92,6 +92,7 @@ RAM::RAM(const std::string &deviceName, u64 startAddress, std::string size, bool
   } else {
     memset(ramData.get(), 0xCD, ramSize);
   }
+  AllocateTracking();
 }
 RAM::~RAM() {
   ramData.reset();
@@ -104,6 +105,8 @@ void RAM::Reset() {
   } else {
     memset(ramData.get(), 0xCD, ramSize);
   }
+  // Everything changed under the watchers
+  MarkWritten(RAM_START_ADDR, ramSize);
 }
 
 void RAM::Resize(u64 size) {
@@ -111,6 +114,7 @@ void RAM::Resize(u64 size) {
   if (!ramData.get()) {
     ramData = std::make_unique<STRIP_UNIQUE_ARR(ramData)>(ramSize);
   }
+  AllocateTracking();
 }
 
 void RAM::Read(u64 readAddress, u8 *data, u64 size) {
@@ -123,6 +127,7 @@ void RAM::Read(u64 readAddress, u8 *data, u64 size) {
 void RAM::Write(u64 writeAddress, const u8 *data, u64 size) {
   const u32 offset = static_cast<u32>(writeAddress - RAM_START_ADDR);
   memcpy(ramData.get() + offset, data, size);
+  MarkWritten(writeAddress, size);
   if (false)
     LOG_TRACE(Xenon, "Writing {:#08x} bytes to {:#08x}", size, writeAddress);
 }
@@ -130,6 +135,7 @@ void RAM::Write(u64 writeAddress, const u8 *data, u64 size) {
 void RAM::MemSet(u64 writeAddress, s32 data, u64 size) {
   const u32 offset = static_cast<u32>(writeAddress - RAM_START_ADDR);
   memset(ramData.get() + offset, data, size);
+  MarkWritten(writeAddress, size);
   if (false)
     LOG_TRACE(Xenon, "Setting {:#08x} to {:#02x} for {:#08x} bytes", writeAddress, data, size);
 }
@@ -139,3 +145,26 @@ u8 *RAM::GetPointerToAddress(u32 address) {
   if (offset > ramSize) { return nullptr; }
   return ramData.get() + offset;
 }
+
+
+void RAM::WatchRange(u64 address, u64 size) {
+  if (size == 0 || trackPageCount == 0)
+    return;
+  const u64 offset = address - RAM_START_ADDR;
+  const u64 firstPage = offset >> RAM_TRACK_PAGE_SHIFT;
+  const u64 lastPage = std::min((offset + size - 1) >> RAM_TRACK_PAGE_SHIFT, trackPageCount - 1);
+  for (u64 page = firstPage; page <= lastPage; ++page) {
+    watchedPages[page >> 6].fetch_or(1ull << (page & 63), std::memory_order_relaxed);
+  }
+  // Orders the watch stores before the caller reads guest memory, pairs with the fence in MarkWritten
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void RAM::AllocateTracking() {
+  // Round up to whole 64 page blocks
+  const u64 pageSize = 1ull << RAM_TRACK_PAGE_SHIFT;
+  trackPageCount = (((ramSize + pageSize - 1) >> RAM_TRACK_PAGE_SHIFT) + 63) & ~63ull;
+  watchedPages = std::make_unique<std::atomic<u64>[]>(trackPageCount / 64);
+  writtenPages = std::make_unique<std::atomic<u64>[]>(trackPageCount / 64);
+  writeGeneration.fetch_add(1, std::memory_order_release);
+}
@@ -4,11 +4,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 #include "Base/SystemDevice.h"
+#include "Base/WaitTable.h"
 
 #define RAM_START_ADDR 0
+// Granularity of the write tracking (4KiB pages)
+#define RAM_TRACK_PAGE_SHIFT 12
 
 class RAM : public SystemDevice {
 public:
@@ -25,7 +30,67 @@ public:
   u64 GetSize() {
     return ramSize;
   }
+
+  // Write tracking, used by host side copies of guest memory (GPU buffer cache).
+  // Watches are one-shot: the first write to a watched page flags it as written and disarms the watch,
+  // so pages nobody cares about (or that are already dirty) only cost a fence and a relaxed load per write.
+  // Writers store guest data then load the watch, watchers arm the watch then read guest data. Both sides
+  // fence in between, otherwise each could miss the other's store and a stale copy would never be invalidated.
+
+  // Arms the watch on every page overlapping [address, address + size)
+  void WatchRange(u64 address, u64 size);
+
+  // Must be called by anything writing guest memory through GetPointerToAddress (DMA, CP writes).
+  // Also wakes anyone waiting on the range.
+  void MarkWritten(u64 address, u64 size) {
+    if (size == 0 || trackPageCount == 0)
+      return;
+    writeWaiters.Notify(address, size);
+    // Orders the guest data stores before the watch loads, pairs with the fence in WatchRange
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const u64 offset = address - RAM_START_ADDR;
+    const u64 firstPage = offset >> RAM_TRACK_PAGE_SHIFT;
+    const u64 lastPage = std::min((offset + size - 1) >> RAM_TRACK_PAGE_SHIFT, trackPageCount - 1);
+    for (u64 page = firstPage; page <= lastPage; ++page) {
+      const u64 bit = 1ull << (page & 63);
+      std::atomic<u64> &watched = watchedPages[page >> 6];
+      if (watched.load(std::memory_order_relaxed) & bit) [[unlikely]] {
+        watched.fetch_and(~bit, std::memory_order_relaxed);
+        writtenPages[page >> 6].fetch_or(bit, std::memory_order_release);
+        writeGeneration.fetch_add(1, std::memory_order_release);
+      }
+    }
+  }
+
+  // Bumped every time a watched page gets written, lets consumers skip the bitmap scan
+  u64 GetWriteGeneration() const {
+    return writeGeneration.load(std::memory_order_acquire);
+  }
+
+  // Number of 64 page blocks in the written bitmap
+  u64 GetTrackBlockCount() const {
+    return trackPageCount / 64;
+  }
+
+  // Returns the written bits of a 64 page block and clears them
+  u64 ConsumeWrittenPages(u64 blockIndex) {
+    return writtenPages[blockIndex].exchange(0, std::memory_order_acq_rel);
+  }
+
+  // Threads waiting on guest memory to be written (CP WAIT_REG_MEM), notified from MarkWritten
+  Base::WaitTable &GetWriteWaiters() {
+    return writeWaiters;
+  }
 private:
+  void AllocateTracking();
+
   u64 ramSize = 0;
   std::unique_ptr<u8[]> ramData{};
+
+  // Write tracking state, one bit per page
+  u64 trackPageCount = 0;
+  std::unique_ptr<std::atomic<u64>[]> watchedPages{};
+  std::unique_ptr<std::atomic<u64>[]> writtenPages{};
+  std::atomic<u64> writeGeneration = 0;
+  Base::WaitTable writeWaiters{};
 };
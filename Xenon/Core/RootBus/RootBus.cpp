@@ -69,6 +69,7 @@ bool RootBus::Read(u64 readAddress, u8 *data, u64 size, bool soc) {
     ramDevice->Read(readAddress, data, size);
     return true;
   }
+  mmioReads.fetch_add(1, std::memory_order_relaxed);
 
   // SFCX
   if (readAddress >= sfcxDevice->GetStartAddress() &&
@@ -130,6 +131,7 @@ bool RootBus::Write(u64 writeAddress, const u8 *data, u64 size, bool soc) {
     ramDevice->Write(writeAddress, data, size);
     return true;
   }
+  mmioWrites.fetch_add(1, std::memory_order_relaxed);
 
   // SFCX
   if (writeAddress >= sfcxDevice->GetStartAddress() &&
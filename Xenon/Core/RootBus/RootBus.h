@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <unordered_map>
 
 #include "Base/SystemDevice.h"
@@ -36,6 +37,10 @@ public:
   bool ConfigRead(u64 readAddress, u8 *data, u64 size);
   bool ConfigWrite(u64 writeAddress, const u8 *data, u64 size);
 
+  // Statistics, accesses that didn't take the RAM fast path
+  u64 GetMMIOReads() const { return mmioReads.load(std::memory_order_relaxed); }
+  u64 GetMMIOWrites() const { return mmioWrites.load(std::memory_order_relaxed); }
+
 private:
   std::shared_ptr<HostBridge> hostBridge{};
   u32 deviceCount;
@@ -44,4 +49,7 @@ private:
   SystemDevice* ramDevice{ nullptr };
   SystemDevice* sfcxDevice{ nullptr };
   std::unique_ptr<u8> biuData{ std::make_unique<STRIP_UNIQUE(biuData)>(0x10000) };
+  // MMIO access counters
+  std::atomic<u64> mmioReads = 0;
+  std::atomic<u64> mmioWrites = 0;
 };
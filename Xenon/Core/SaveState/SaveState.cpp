@@ -0,0 +1,541 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "SaveState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#elif defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "Base/Logging/Log.h"
+#include "Core/XeMain.h"
+
+namespace Xe::SaveState {
+
+namespace {
+
+// Bases of bases of... give up past this, it's a loop
+constexpr u32 maxBaseDepth = 16;
+
+u64 hashPage(const u8 *page) {
+  u64 hash = 0xCBF29CE484222325ULL;
+  for (u64 i = 0; i != STATE_PAGE_SIZE; i += sizeof(u64)) {
+    u64 word = 0;
+    std::memcpy(&word, page + i, sizeof(word));
+    hash = (hash ^ word) * 0x100000001B3ULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+bool isZeroPage(const u8 *page) {
+  for (u64 i = 0; i != STATE_PAGE_SIZE; i += sizeof(u64)) {
+    u64 word = 0;
+    std::memcpy(&word, page + i, sizeof(word));
+    if (word)
+      return false;
+  }
+  return true;
+}
+
+u32 workerCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Data that doesn't shrink is stored as is
+eStateCodec compressData(const u8 *data, u64 size, std::vector<u8> &stored) {
+#ifdef HAVE_ZSTD
+  stored.resize(ZSTD_compressBound(size));
+  const size_t result = ZSTD_compress(stored.data(), stored.size(), data, size, 1);
+  if (!ZSTD_isError(result) && result < size) {
+    stored.resize(result);
+    return eStateCodec::Zstd;
+  }
+#elif defined(HAVE_ZLIB)
+  uLongf compressedSize = compressBound(static_cast<uLong>(size));
+  stored.resize(compressedSize);
+  if (compress2(stored.data(), &compressedSize, data, static_cast<uLong>(size), Z_BEST_SPEED) == Z_OK &&
+    compressedSize < size) {
+    stored.resize(compressedSize);
+    return eStateCodec::Zlib;
+  }
+#endif
+  stored.assign(data, data + size);
+  return eStateCodec::None;
+}
+
+bool decompressData(eStateCodec codec, const u8 *stored, u64 storedSize, u8 *data, u64 size) {
+  switch (codec) {
+  case eStateCodec::None:
+    if (storedSize != size)
+      return false;
+    std::memcpy(data, stored, size);
+    return true;
+#ifdef HAVE_ZSTD
+  case eStateCodec::Zstd: {
+    const size_t result = ZSTD_decompress(data, size, stored, storedSize);
+    return !ZSTD_isError(result) && result == size;
+  }
+#elif defined(HAVE_ZLIB)
+  case eStateCodec::Zlib: {
+    uLongf result = static_cast<uLongf>(size);
+    return uncompress(data, &result, stored, static_cast<uLong>(storedSize)) == Z_OK && result == size;
+  }
+#endif
+  default:
+    LOG_ERROR(Xenon, "[SaveState]: Codec {} isn't supported by this build.", static_cast<u8>(codec));
+    return false;
+  }
+}
+
+template <typename T>
+void appendValue(std::vector<u8> &out, const T &value) {
+  const u8 *bytes = reinterpret_cast<const u8 *>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// A state file, section payloads decompressed (memory regions keep their compressed blocks)
+struct sStateFile {
+  std::filesystem::path path{};
+  sStateHeader header{};
+  std::unordered_map<u32, std::vector<u8>> sections{};
+
+  const std::vector<u8> *Find(eStateSection tag) const {
+    const auto it = sections.find(static_cast<u32>(tag));
+    return it != sections.end() ? &it->second : nullptr;
+  }
+};
+
+bool readStateFile(const std::filesystem::path &path, sStateFile &state) {
+  std::ifstream file{ path, std::ios::binary };
+  state.path = path;
+  if (!file || !file.read(reinterpret_cast<char *>(&state.header), sizeof(state.header)) ||
+    state.header.magic != XE_SAVE_STATE_MAGIC) {
+    LOG_ERROR(Xenon, "[SaveState]: '{}' isn't a save state.", path.string());
+    return false;
+  }
+  if (state.header.version != XE_SAVE_STATE_VERSION) {
+    LOG_ERROR(Xenon, "[SaveState]: '{}' is a version {} save state, expected version {}.", path.string(),
+      state.header.version, XE_SAVE_STATE_VERSION);
+    return false;
+  }
+  std::error_code error{};
+  const u64 fileSize = std::filesystem::file_size(path, error);
+  // Every section takes at least its header
+  if (error || state.header.sectionCount > (fileSize - sizeof(state.header)) / sizeof(sStateSectionHeader)) {
+    LOG_ERROR(Xenon, "[SaveState]: '{}' is truncated.", path.string());
+    return false;
+  }
+  std::vector<u8> stored{};
+  for (u32 i = 0; i != state.header.sectionCount; ++i) {
+    sStateSectionHeader section{};
+    if (!file.read(reinterpret_cast<char *>(&section), sizeof(section))) {
+      LOG_ERROR(Xenon, "[SaveState]: '{}' is truncated.", path.string());
+      return false;
+    }
+    // Sizes come from the file, check them before allocating anything. Compressed sections always shrank.
+    const bool sizesValid = section.storedSize <= fileSize - static_cast<u64>(file.tellg()) &&
+      (section.codec == eStateCodec::None ? section.rawSize == section.storedSize :
+        section.rawSize > section.storedSize && section.rawSize <= STATE_MAX_SECTION_SIZE);
+    if (!sizesValid) {
+      LOG_ERROR(Xenon, "[SaveState]: Section {:08X} of '{}' is broken.", static_cast<u32>(section.tag), path.string());
+      return false;
+    }
+    stored.resize(section.storedSize);
+    std::vector<u8> &raw = state.sections[static_cast<u32>(section.tag)];
+    raw.resize(section.rawSize);
+    if (!file.read(reinterpret_cast<char *>(stored.data()), section.storedSize) ||
+      !decompressData(section.codec, stored.data(), stored.size(), raw.data(), raw.size())) {
+      LOG_ERROR(Xenon, "[SaveState]: Section {:08X} of '{}' is broken.", static_cast<u32>(section.tag), path.string());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parsed memory region section
+struct sRegion {
+  u64 size = 0;
+  u64 pageCount = 0;
+  const u8 *sources = nullptr;
+  const u8 *hashes = nullptr;
+  // Header and stored data of every block
+  std::vector<std::pair<sStateBlockHeader, const u8 *>> blocks{};
+
+  eStatePageSource Source(u64 page) const { return static_cast<eStatePageSource>(sources[page]); }
+  u64 Hash(u64 page) const {
+    u64 hash = 0;
+    std::memcpy(&hash, hashes + page * sizeof(u64), sizeof(hash));
+    return hash;
+  }
+};
+
+bool parseRegion(const std::vector<u8> &payload, sRegion &region) {
+  u64 pos = 0;
+  auto read = [&](void *value, u64 size) {
+    if (size > payload.size() - pos)
+      return false;
+    std::memcpy(value, payload.data() + pos, size);
+    pos += size;
+    return true;
+  };
+  if (!read(&region.size, sizeof(region.size)) || !read(&region.pageCount, sizeof(region.pageCount)) ||
+    region.pageCount != (region.size + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE ||
+    region.pageCount * (1 + sizeof(u64)) > payload.size() - pos) {
+    return false;
+  }
+  region.sources = payload.data() + pos;
+  pos += region.pageCount;
+  region.hashes = payload.data() + pos;
+  pos += region.pageCount * sizeof(u64);
+  const u64 blockCount = (region.pageCount + STATE_PAGES_PER_BLOCK - 1) / STATE_PAGES_PER_BLOCK;
+  region.blocks.resize(blockCount);
+  for (auto &[header, data] : region.blocks) {
+    if (!read(&header, sizeof(header)) || header.storedSize > payload.size() - pos)
+      return false;
+    data = payload.data() + pos;
+    pos += header.storedSize;
+  }
+  return true;
+}
+
+// Builds a memory region section over data, pages matching base (when given) are left to it
+std::vector<u8> buildRegion(const u8 *data, u64 size, const sRegion *base) {
+  const u64 pageCount = (size + STATE_PAGE_SIZE - 1) / STATE_PAGE_SIZE;
+  const u64 blockCount = (pageCount + STATE_PAGES_PER_BLOCK - 1) / STATE_PAGES_PER_BLOCK;
+  if (base && base->size != size)
+    base = nullptr;
+  std::vector<u8> sources(pageCount);
+  std::vector<u64> hashes(pageCount);
+  std::vector<std::pair<sStateBlockHeader, std::vector<u8>>> blocks(blockCount);
+  {
+    Xe::PCIDev::DeviceWorkerPool pool{ workerCount() };
+    for (u64 block = 0; block != blockCount; ++block) {
+      pool.Submit([&, block] {
+        const u64 first = block * STATE_PAGES_PER_BLOCK;
+        const u64 last = std::min(first + STATE_PAGES_PER_BLOCK, pageCount);
+        std::vector<u8> raw{};
+        u8 tail[STATE_PAGE_SIZE] = {};
+        for (u64 page = first; page != last; ++page) {
+          // The last page may be partial, it's hashed and stored zero padded
+          const u8 *pageData = data + page * STATE_PAGE_SIZE;
+          if (size - page * STATE_PAGE_SIZE < STATE_PAGE_SIZE) {
+            std::memcpy(tail, pageData, size - page * STATE_PAGE_SIZE);
+            pageData = tail;
+          }
+          hashes[page] = hashPage(pageData);
+          eStatePageSource source = eStatePageSource::Stored;
+          if (base && base->Hash(page) == hashes[page])
+            source = eStatePageSource::Base;
+          else if (isZeroPage(pageData))
+            source = eStatePageSource::Zero;
+          else
+            raw.insert(raw.end(), pageData, pageData + STATE_PAGE_SIZE);
+          sources[page] = static_cast<u8>(source);
+        }
+        auto &[header, stored] = blocks[block];
+        header.rawSize = static_cast<u32>(raw.size());
+        header.codec = compressData(raw.data(), raw.size(), stored);
+        header.storedSize = static_cast<u32>(stored.size());
+      });
+    }
+    // Runs everything submitted before joining
+  }
+
+  std::vector<u8> payload{};
+  appendValue(payload, size);
+  appendValue(payload, pageCount);
+  payload.insert(payload.end(), sources.begin(), sources.end());
+  const u8 *hashBytes = reinterpret_cast<const u8 *>(hashes.data());
+  payload.insert(payload.end(), hashBytes, hashBytes + hashes.size() * sizeof(u64));
+  for (const auto &[header, stored] : blocks) {
+    appendValue(payload, header);
+    payload.insert(payload.end(), stored.begin(), stored.end());
+  }
+  return payload;
+}
+
+// Resolves a memory region of state (and its bases) into data
+bool loadRegion(const sStateFile &state, eStateSection tag, u8 *data, u64 size, u32 depth = 0) {
+  const std::vector<u8> *payload = state.Find(tag);
+  sRegion region{};
+  if (!payload || !parseRegion(*payload, region) || region.size != size) {
+    LOG_ERROR(Xenon, "[SaveState]: Memory region {:08X} of '{}' is missing or doesn't match this machine.",
+      static_cast<u32>(tag), state.path.string());
+    return false;
+  }
+
+  const bool needsBase = std::any_of(region.sources, region.sources + region.pageCount,
+    [](u8 source) { return static_cast<eStatePageSource>(source) == eStatePageSource::Base; });
+  if (needsBase) {
+    const std::vector<u8> *baseSection = state.Find(eStateSection::Base);
+    if (!baseSection || depth == maxBaseDepth) {
+      LOG_ERROR(Xenon, "[SaveState]: '{}' is a delta with no usable base.", state.path.string());
+      return false;
+    }
+    std::filesystem::path basePath{ std::string(baseSection->begin(), baseSection->end()) };
+    if (basePath.is_relative())
+      basePath = state.path.parent_path() / basePath;
+    sStateFile base{};
+    if (!readStateFile(basePath, base))
+      return false;
+    if (base.header.stateId != state.header.baseId) {
+      LOG_ERROR(Xenon, "[SaveState]: '{}' isn't the base '{}' was made against.", basePath.string(),
+        state.path.string());
+      return false;
+    }
+    if (!loadRegion(base, tag, data, size, depth + 1))
+      return false;
+  }
+
+  std::atomic<bool> failed = false;
+  {
+    Xe::PCIDev::DeviceWorkerPool pool{ workerCount() };
+    for (u64 block = 0; block != region.blocks.size(); ++block) {
+      pool.Submit([&, block] {
+        const auto &[header, stored] = region.blocks[block];
+        std::vector<u8> raw(header.rawSize);
+        if (!decompressData(header.codec, stored, header.storedSize, raw.data(), raw.size())) {
+          failed = true;
+          return;
+        }
+        const u64 first = block * STATE_PAGES_PER_BLOCK;
+        const u64 last = std::min<u64>(first + STATE_PAGES_PER_BLOCK, region.pageCount);
+        u64 rawPos = 0;
+        for (u64 page = first; page != last; ++page) {
+          const u64 offset = page * STATE_PAGE_SIZE;
+          const u64 length = std::min<u64>(STATE_PAGE_SIZE, size - offset);
+          switch (region.Source(page)) {
+          case eStatePageSource::Zero:
+            std::memset(data + offset, 0, length);
+            break;
+          case eStatePageSource::Stored:
+            if (rawPos + STATE_PAGE_SIZE > raw.size()) {
+              failed = true;
+              return;
+            }
+            std::memcpy(data + offset, raw.data() + rawPos, length);
+            rawPos += STATE_PAGE_SIZE;
+            break;
+          default:
+            break;
+          }
+        }
+      });
+    }
+  }
+  if (failed) {
+    LOG_ERROR(Xenon, "[SaveState]: Memory region {:08X} of '{}' is broken.", static_cast<u32>(tag),
+      state.path.string());
+    return false;
+  }
+  return true;
+}
+
+void writeSection(std::ofstream &file, eStateSection tag, const std::vector<u8> &raw, bool compress,
+  u32 &sectionCount) {
+  sStateSectionHeader header{};
+  header.tag = tag;
+  header.rawSize = raw.size();
+  std::vector<u8> stored{};
+  const std::vector<u8> *data = &raw;
+  if (compress) {
+    header.codec = compressData(raw.data(), raw.size(), stored);
+    if (header.codec != eStateCodec::None)
+      data = &stored;
+  }
+  header.storedSize = data->size();
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(data->data()), data->size());
+  sectionCount++;
+}
+
+// Only writes the pages that changed, so an overlay doesn't fill up with identical ones
+void writeNAND(Xe::PCIDev::NANDImage *nandImage, const std::vector<u8> &nandData) {
+  for (u64 offset = 0; offset < nandData.size(); offset += STATE_PAGE_SIZE) {
+    const u64 length = std::min<u64>(STATE_PAGE_SIZE, nandData.size() - offset);
+    if (std::memcmp(nandImage->Data() + offset, nandData.data() + offset, length) != 0)
+      nandImage->Write(offset, nandData.data() + offset, length);
+  }
+}
+
+std::vector<u8> machineSection() {
+  std::vector<u8> machine{};
+  appendValue(machine, XeMain::ram->GetSize());
+  appendValue(machine, Config::highlyExperimental.consoleRevison);
+  const Xe::PCIDev::NANDImage *nandImage = XeMain::sfcx ? XeMain::sfcx->GetNANDImage() : nullptr;
+  appendValue(machine, nandImage && nandImage->IsOpen() ? nandImage->Size() : 0);
+  return machine;
+}
+
+} // anonymous namespace
+
+void CaptureMachine(sMachineState &state, bool captureNAND) {
+  StateStream cpu{};
+  XeMain::xenonCPU->SerializeState(cpu);
+  state.cpu = cpu.TakeData();
+  StateStream gpu{};
+  if (XeMain::xenos)
+    XeMain::xenos->SerializeState(gpu);
+  state.gpu = gpu.TakeData();
+  StateStream pci{};
+  XeMain::hostBridge->SerializeState(pci);
+  XeMain::pciBridge->SerializeState(pci);
+  state.pci = pci.TakeData();
+  const Xe::PCIDev::NANDImage *nandImage = XeMain::sfcx ? XeMain::sfcx->GetNANDImage() : nullptr;
+  if (captureNAND && nandImage && nandImage->IsOpen())
+    state.nand.assign(nandImage->Data(), nandImage->Data() + nandImage->Size());
+  else
+    state.nand.clear();
+}
+
+bool RestoreMachine(const sMachineState &state) {
+  auto restore = [](const char *name, const std::vector<u8> &data, const auto &serialize) {
+    StateStream stream{ data.data(), data.size() };
+    serialize(stream);
+    if (stream.Failed()) {
+      LOG_ERROR(Xenon, "[SaveState]: {} state doesn't match this machine or build.", name);
+      return false;
+    }
+    return true;
+  };
+  if (!state.nand.empty()) {
+    Xe::PCIDev::NANDImage *nandImage = XeMain::sfcx ? XeMain::sfcx->GetNANDImage() : nullptr;
+    if (!nandImage || !nandImage->IsOpen() || nandImage->Size() != state.nand.size()) {
+      LOG_ERROR(Xenon, "[SaveState]: NAND doesn't match the captured one.");
+      return false;
+    }
+    writeNAND(nandImage, state.nand);
+  }
+  return restore("CPU", state.cpu, [](StateStream &stream) { XeMain::xenonCPU->SerializeState(stream); }) &&
+    restore("GPU", state.gpu, [](StateStream &stream) { if (XeMain::xenos) XeMain::xenos->SerializeState(stream); }) &&
+    restore("PCI", state.pci, [](StateStream &stream) {
+      XeMain::hostBridge->SerializeState(stream);
+      XeMain::pciBridge->SerializeState(stream);
+    });
+}
+
+bool Save(const std::filesystem::path &path, const std::filesystem::path &basePath) {
+  const auto start = std::chrono::steady_clock::now();
+  sStateHeader header{};
+  header.stateId = (static_cast<u64>(std::random_device{}()) << 32) ^ std::random_device{}() ^
+    static_cast<u64>(std::chrono::system_clock::now().time_since_epoch().count());
+
+  const std::vector<u8> machine = machineSection();
+  sStateFile base{};
+  if (!basePath.empty()) {
+    if (!readStateFile(basePath, base))
+      return false;
+    if (base.Find(eStateSection::Machine) == nullptr || *base.Find(eStateSection::Machine) != machine) {
+      LOG_ERROR(Xenon, "[SaveState]: '{}' was saved on a different machine, it can't be a base.", basePath.string());
+      return false;
+    }
+    header.baseId = base.header.stateId;
+  }
+
+  std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+  if (!file) {
+    LOG_ERROR(Xenon, "[SaveState]: Unable to open '{}' for writing.", path.string());
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  writeSection(file, eStateSection::Machine, machine, false, header.sectionCount);
+  if (!basePath.empty()) {
+    // Relative to the delta, so both can be moved together
+    std::error_code error{};
+    std::filesystem::path stored = std::filesystem::relative(std::filesystem::absolute(basePath),
+      std::filesystem::absolute(path).parent_path(), error);
+    if (error || stored.empty())
+      stored = std::filesystem::absolute(basePath);
+    const std::string storedPath = stored.string();
+    writeSection(file, eStateSection::Base, std::vector<u8>(storedPath.begin(), storedPath.end()), false,
+      header.sectionCount);
+  }
+
+  sMachineState components{};
+  CaptureMachine(components);
+  writeSection(file, eStateSection::CPU, components.cpu, true, header.sectionCount);
+  writeSection(file, eStateSection::GPU, components.gpu, true, header.sectionCount);
+  writeSection(file, eStateSection::PCI, components.pci, true, header.sectionCount);
+
+  auto regionBase = [&](eStateSection tag, sRegion &region) -> const sRegion * {
+    const std::vector<u8> *payload = base.Find(tag);
+    return payload && parseRegion(*payload, region) ? &region : nullptr;
+  };
+  sRegion ramBase{};
+  writeSection(file, eStateSection::RAM, buildRegion(XeMain::ram->GetPointerToAddress(RAM_START_ADDR),
+    XeMain::ram->GetSize(), regionBase(eStateSection::RAM, ramBase)), false, header.sectionCount);
+  const Xe::PCIDev::NANDImage *nandImage = XeMain::sfcx ? XeMain::sfcx->GetNANDImage() : nullptr;
+  if (nandImage && nandImage->IsOpen()) {
+    sRegion nandBase{};
+    writeSection(file, eStateSection::NAND, buildRegion(nandImage->Data(), nandImage->Size(),
+      regionBase(eStateSection::NAND, nandBase)), false, header.sectionCount);
+  }
+
+  // Section count is only known now
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+  if (!file) {
+    LOG_ERROR(Xenon, "[SaveState]: Failed writing '{}'.", path.string());
+    return false;
+  }
+  LOG_INFO(Xenon, "[SaveState]: Saved '{}' in {}ms.", path.string(),
+    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+  return true;
+}
+
+bool Load(const std::filesystem::path &path) {
+  const auto start = std::chrono::steady_clock::now();
+  sStateFile state{};
+  if (!readStateFile(path, state))
+    return false;
+  const std::vector<u8> *machine = state.Find(eStateSection::Machine);
+  if (!machine || *machine != machineSection()) {
+    LOG_ERROR(Xenon, "[SaveState]: '{}' was saved with a different RAM size, revision or NAND.", path.string());
+    return false;
+  }
+
+  sMachineState components{};
+  for (auto [tag, target] : { std::pair{ eStateSection::CPU, &components.cpu },
+    std::pair{ eStateSection::GPU, &components.gpu }, std::pair{ eStateSection::PCI, &components.pci } }) {
+    const std::vector<u8> *section = state.Find(tag);
+    if (!section) {
+      LOG_ERROR(Xenon, "[SaveState]: '{}' is missing section {:08X}.", path.string(), static_cast<u32>(tag));
+      return false;
+    }
+    *target = *section;
+  }
+
+  if (!loadRegion(state, eStateSection::RAM, XeMain::ram->GetPointerToAddress(RAM_START_ADDR), XeMain::ram->GetSize()))
+    return false;
+  // Everything changed under the watchers (GPU buffer cache)
+  XeMain::ram->MarkWritten(RAM_START_ADDR, XeMain::ram->GetSize());
+
+  Xe::PCIDev::NANDImage *nandImage = XeMain::sfcx ? XeMain::sfcx->GetNANDImage() : nullptr;
+  if (nandImage && nandImage->IsOpen()) {
+    std::vector<u8> nandData(nandImage->Size());
+    if (!loadRegion(state, eStateSection::NAND, nandData.data(), nandData.size()))
+      return false;
+    writeNAND(nandImage, nandData);
+  }
+
+  if (!RestoreMachine(components))
+    return false;
+  LOG_INFO(Xenon, "[SaveState]: Loaded '{}' in {}ms.", path.string(),
+    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+  return true;
+}
+
+} // namespace Xe::SaveState
@@ -0,0 +1,111 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Base/Types.h"
+
+//
+// Save state (.xstate) layout. Everything is little endian.
+//
+// File: sStateHeader, then sections. Every section is an sStateSectionHeader followed by storedSize bytes.
+//   Machine  u64 RAM size, u8 console revision, u64 NAND size, a state only loads on the same machine
+//   Base     path of the state this one is a delta against (relative to this one), absent for full states
+//   CPU      XenonCPU::SerializeState (context, IIC, SoC blocks, every PPU with its TLB/ERATs/SPRs)
+//   GPU      XGPU::SerializeState (Xenos registers, EDRAM, CP ring pointers and microcode)
+//   PCI      HostBridge and PCIBridge::SerializeState (every PCI device, by name)
+//   RAM      memory region, see below
+//   NAND     memory region, only when the NAND is backed by an image
+// Component sections are compressed as a whole (see eStateCodec).
+//
+// Memory regions are split in STATE_PAGE_SIZE pages, every page has a source and a hash of its contents:
+//   u64 size, u64 page count, u8 source per page (eStatePageSource), u64 hash per page,
+//   then one sStateBlockHeader + data per STATE_PAGES_PER_BLOCK pages, holding the block's Stored pages in order.
+// A delta state stores only the pages whose hash differs from its base, the rest point at the base (which
+// may itself be a delta). Blocks are compressed and decompressed in parallel.
+//
+
+#define XE_SAVE_STATE_MAGIC 0x54534158 // 'XAST'
+#define XE_SAVE_STATE_VERSION 1
+
+#define STATE_PAGE_SIZE 0x1000
+#define STATE_PAGES_PER_BLOCK 256
+// Largest decompressed section loaded, well above the biggest RAM configuration
+#define STATE_MAX_SECTION_SIZE 4_GiB
+
+namespace Xe::SaveState {
+
+enum class eStateCodec : u8 {
+  None,
+  Zstd,
+  Zlib
+};
+
+enum class eStateSection : u32 {
+  Machine = 0x4843414D, // 'MACH'
+  Base = 0x45534142, // 'BASE'
+  CPU = 0x20555043, // 'CPU '
+  GPU = 0x20555047, // 'GPU '
+  PCI = 0x20494350, // 'PCI '
+  RAM = 0x204D4152, // 'RAM '
+  NAND = 0x444E414E // 'NAND'
+};
+
+enum class eStatePageSource : u8 {
+  Zero, // All zeroes, nothing stored
+  Stored, // Stored in this state
+  Base // Same as the base state's page
+};
+
+#pragma pack(push, 1)
+struct sStateHeader {
+  u32 magic = XE_SAVE_STATE_MAGIC;
+  u32 version = XE_SAVE_STATE_VERSION;
+  // Random, identifies this state to the deltas made against it
+  u64 stateId = 0;
+  // stateId of the base state, 0 for a full state
+  u64 baseId = 0;
+  u32 sectionCount = 0;
+};
+
+struct sStateSectionHeader {
+  eStateSection tag = eStateSection::Machine;
+  eStateCodec codec = eStateCodec::None;
+  u64 rawSize = 0;
+  u64 storedSize = 0;
+};
+
+struct sStateBlockHeader {
+  eStateCodec codec = eStateCodec::None;
+  u32 rawSize = 0;
+  u32 storedSize = 0;
+};
+#pragma pack(pop)
+
+// Component state of a quiesced machine, held in memory (RAM excluded)
+struct sMachineState {
+  std::vector<u8> cpu{};
+  std::vector<u8> gpu{};
+  std::vector<u8> pci{};
+  // NAND image contents, only when asked for (the fork launcher recreates the SFCX, which maps the image again)
+  std::vector<u8> nand{};
+};
+
+/// Captures the CPU, GPU and PCI state, and the NAND with captureNAND. The machine must be quiesced
+/// (see XeMain::Quiesce).
+void CaptureMachine(sMachineState &state, bool captureNAND = false);
+/// Restores what CaptureMachine captured, into a quiesced machine. Returns false if a component rejects its state,
+/// the machine is then left half restored and shouldn't be resumed.
+bool RestoreMachine(const sMachineState &state);
+
+/// Writes the state of a quiesced machine to path. With a base path, only RAM/NAND pages that differ from it are
+/// stored. Returns false if the file can't be written or the base isn't a state of this machine.
+bool Save(const std::filesystem::path &path, const std::filesystem::path &basePath = {});
+/// Loads a state (and every base it depends on) into a quiesced machine.
+bool Load(const std::filesystem::path &path);
+
+} // namespace Xe::SaveState
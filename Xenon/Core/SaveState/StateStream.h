@@ -0,0 +1,154 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Base/Hash.h"
+#include "Base/Types.h"
+
+namespace Xe::SaveState {
+
+// Serializes component state for save states (see SaveState.h).
+// Components describe their state once, through Do() and friends, and the same code saves it (the stream copies
+// from the members) and loads it (the stream copies into them). A load never reads past the end of the data: once
+// it runs out, or a marker doesn't match, the stream fails and every following read leaves its target untouched.
+class StateStream {
+public:
+  // Saving stream, starts empty
+  StateStream() = default;
+  // Loading stream over data, which must outlive it
+  StateStream(const u8 *data, u64 size) :
+    loading(true), readData(data), readSize(size)
+  {}
+
+  bool IsLoading() const { return loading; }
+  bool IsSaving() const { return !loading; }
+  // A load ran out of data or hit a mismatched marker, or the component failed it
+  bool Failed() const { return failed; }
+  void Fail() { failed = true; }
+
+  // Saved data
+  const std::vector<u8> &GetData() const { return data; }
+  std::vector<u8> TakeData() { return std::move(data); }
+
+  void DoBytes(void *bytes, u64 size) {
+    if (!loading) {
+      const u8 *source = static_cast<const u8 *>(bytes);
+      data.insert(data.end(), source, source + size);
+      return;
+    }
+    if (failed || size > readSize - readPos) {
+      failed = true;
+      return;
+    }
+    std::memcpy(bytes, readData + readPos, size);
+    readPos += size;
+  }
+
+  // Values stored as is, trivially copyable types only
+  template <typename... T>
+  void Do(T &...values) {
+    (doValue(values), ...);
+  }
+
+  template <typename T>
+  void DoAtomic(std::atomic<T> &value) {
+    T plain = value.load(std::memory_order_acquire);
+    doValue(plain);
+    if (loading && !failed)
+      value.store(plain, std::memory_order_release);
+  }
+
+  void DoString(std::string &string) {
+    u32 size = static_cast<u32>(string.size());
+    doValue(size);
+    if (loading) {
+      if (failed || size > readSize - readPos) {
+        failed = true;
+        return;
+      }
+      string.resize(size);
+    }
+    DoBytes(string.data(), size);
+  }
+
+  template <typename T>
+  void DoVector(std::vector<T> &vector) {
+    static_assert(std::is_trivially_copyable_v<T>, "Only vectors of trivially copyable types can be stored as is");
+    u64 count = vector.size();
+    doValue(count);
+    if (loading) {
+      if (failed || count > (readSize - readPos) / sizeof(T)) {
+        failed = true;
+        return;
+      }
+      vector.resize(count);
+    }
+    DoBytes(vector.data(), count * sizeof(T));
+  }
+
+  // Maps are stored sorted by key, so saving the same state twice gives the same bytes
+  template <typename K, typename V>
+  void DoMap(std::unordered_map<K, V> &map) {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+      "Only maps of trivially copyable types can be stored as is");
+    std::vector<std::pair<K, V>> entries{};
+    if (!loading) {
+      entries.assign(map.begin(), map.end());
+      std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    }
+    u64 count = entries.size();
+    doValue(count);
+    if (loading) {
+      if (failed || count > (readSize - readPos) / (sizeof(K) + sizeof(V))) {
+        failed = true;
+        return;
+      }
+      entries.resize(count);
+    }
+    for (auto &[key, value] : entries) {
+      doValue(key);
+      doValue(value);
+    }
+    if (loading && !failed) {
+      map.clear();
+      map.insert(entries.begin(), entries.end());
+    }
+  }
+
+  // Checks a load is still in step with the save, fails the stream otherwise
+  void DoMarker(std::string_view name) {
+    const u32 expected = Base::JoaatStringHash(name, false);
+    u32 marker = expected;
+    doValue(marker);
+    if (marker != expected)
+      failed = true;
+  }
+private:
+  template <typename T>
+  void doValue(T &value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be stored as is");
+    DoBytes(&value, sizeof(T));
+  }
+
+  bool loading = false;
+  bool failed = false;
+  // Saving
+  std::vector<u8> data{};
+  // Loading
+  const u8 *readData = nullptr;
+  u64 readSize = 0;
+  u64 readPos = 0;
+};
+
+} // namespace Xe::SaveState
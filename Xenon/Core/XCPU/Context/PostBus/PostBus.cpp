@@ -6,7 +6,18 @@
 
 #include "PostBus.h"
 
+namespace {
+  std::atomic<Xe::XCPU::POSTBUS::POSTObserver> postObserver = nullptr;
+} // anonymous namespace
+
+void Xe::XCPU::POSTBUS::SetObserver(POSTObserver observer) {
+  postObserver.store(observer, std::memory_order_release);
+}
+
 void Xe::XCPU::POSTBUS::POST(u64 postCode) {
+  if (const POSTObserver observer = postObserver.load(std::memory_order_acquire)) {
+    observer(postCode);
+  }
   /* 1BL */
   if (postCode >= 0x10 && postCode <= 0x1E) {
     switch (postCode) {
@@ -15,6 +15,10 @@ namespace XCPU {
 namespace POSTBUS {
 void POST(u64 postCode);
 std::string GET_POST(u64 postCode);
+// Observer called from the writing PPU thread for every POST code, before it's logged. Used by tools like
+// xenon-bench to time boot progress. Set it before the CPU starts, nullptr removes it.
+using POSTObserver = void (*)(u64 postCode);
+void SetObserver(POSTObserver observer);
 }
 } // namespace XCPU
 } // namespace Xe
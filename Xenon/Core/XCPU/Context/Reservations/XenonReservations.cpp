@@ -4,20 +4,33 @@
 
 #include "XenonReservations.h"
 
+#include <algorithm>
+
 XenonReservations::XenonReservations() {
   std::lock_guard lock(reservationLock);
   numReservations = 0;
-  processors = 0;
-  reservations[0] = nullptr;
+  // Six hardware threads
+  reservations.reserve(6);
 }
 
 bool XenonReservations::Register(PPU_RES *Res) {
   std::lock_guard lock(reservationLock);
-  reservations[processors] = Res;
-  processors++;
+  reservations.push_back(Res);
   return true;
 }
 
+void XenonReservations::Unregister(PPU_RES *Res) {
+  std::lock_guard lock(reservationLock);
+  auto it = std::find(reservations.begin(), reservations.end(), Res);
+  if (it == reservations.end()) {
+    return;
+  }
+  if ((*it)->valid) {
+    numReservations--;
+  }
+  reservations.erase(it);
+}
+
 void XenonReservations::Scan(u64 PhysAddress) {
   std::lock_guard lock(reservationLock);
   // CBE processor's reservation granule is 128 bytes (PPE cache line size).
@@ -25,10 +38,10 @@ void XenonReservations::Scan(u64 PhysAddress) {
   constexpr u64 RESERVATION_GRANULE_MASK = ~u64(127);
   PhysAddress &= RESERVATION_GRANULE_MASK;
 
-  for (int i = 0; i < processors; i++) {
+  for (PPU_RES *res : reservations) {
     // NB: order of checks matters!
-    if (reservations[i]->valid && PhysAddress == (reservations[i]->reservedAddr & RESERVATION_GRANULE_MASK)) {
-      reservations[i]->valid = false;
+    if (res->valid && PhysAddress == (res->reservedAddr & RESERVATION_GRANULE_MASK)) {
+      res->valid = false;
       numReservations--;
     }
   }
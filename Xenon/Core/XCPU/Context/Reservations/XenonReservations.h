@@ -18,6 +18,8 @@ class XenonReservations {
 public:
   XenonReservations();
   virtual bool Register(PPU_RES *Res);
+  // Drops a reservation block, for PPUs that go away before the context does (instruction test workers)
+  void Unregister(PPU_RES *Res);
   void Increment(void) {
     std::lock_guard lock(reservationLock);
     numReservations++;
@@ -40,6 +42,5 @@ public:
 private:
   s32 numReservations;
   std::recursive_mutex reservationLock;
-  s32 processors;
-  struct PPU_RES *reservations[6];
+  std::vector<PPU_RES*> reservations;
 };
@@ -65,6 +65,15 @@ bool XenonContext::HandleSOCWrite(u64 writeAddr, const u8 *data, size_t byteCoun
 }
 
 // Security Engine Read
+void XenonContext::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lock(mutex);
+  stream.DoBytes(SRAM.get(), XE_SECRAM_BLOCK_SIZE);
+  stream.Do(fuseSet, timeBaseActive);
+  stream.DoAtomic(timeBaseGlobalCounter);
+  iic.SerializeState(stream);
+  stream.Do(*socSecOTPBlock, *socSecEngBlock, *socSecRNGBlock, *socCBIBlock, *socPMWBlock, *socPRVBlock);
+}
+
 bool XenonContext::HandleSecEngRead(u64 readAddr, u8 *data, size_t byteCount) {
   std::lock_guard lock(mutex);
 
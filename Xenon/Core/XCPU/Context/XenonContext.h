@@ -50,6 +50,8 @@ namespace Xe::XCPU {
     RAM *GetRAM() { return ram; }
     bool HandleSOCRead(u64 readAddr, u8 *data, size_t byteCount);
     bool HandleSOCWrite(u64 writeAddr, const u8 *data, size_t byteCount);
+    // Save states: SRAM, fuses, the IIC, the time base and the SOC blocks. Reservations are the PPUs'.
+    void SerializeState(Xe::SaveState::StateStream &stream);
 
     // Xenon SecureROM
     // Contains the CPU's main startup code known as 1BL.
@@ -82,6 +84,13 @@ namespace Xe::XCPU {
     // The timer thread inside XenonCPU will increase this; each PPU reads the counter and applies the delta.
     std::atomic<u64> timeBaseGlobalCounter{ 0 };
 
+    // Execution milestone, used by tools like xenon-bench. While non-zero, the first PPU thread to reach this
+    // address clears it and stores the host steady_clock time (ns) in pcWatchHitTime.
+    // The interpreter reads it once per time slice and checks every instruction against that, the JIT checks
+    // it on every block entry.
+    std::atomic<u64> pcWatch{ 0 };
+    std::atomic<u64> pcWatchHitTime{ 0 };
+
     //
     // SOC Blocks
     //
@@ -4,6 +4,9 @@
 
 #include "Core/XCPU/Context/XenonIIC/XenonIIC.h"
 
+#include <algorithm>
+#include <bit>
+
   // Debug output enable.
   //#define IIC_DEBUG
 
@@ -52,8 +55,13 @@ void Xe::XCPU::XenonIIC::Write(u64 writeAddress, const u8* data, u64 size) {
     const u32 blockOffset = offset % ProcessorBlockSize;  // 0..0xFFF
 
     switch (blockOffset) {
-    case 0x0000: break; // LogicalIdentification
-    case 0x0008: break; // InterruptTaskPriority
+    case 0x0000: // LogicalIdentification
+      interruptState[threadID].logicalId.store(static_cast<u8>(
+        socINTBlock->ProcessorBlock[threadID].LogicalIdentification.AsBITS.LogicalId), std::memory_order_release);
+      break;
+    case 0x0008: // InterruptTaskPriority
+      setTaskPriority(threadID, dataIn);
+      break;
     case 0x0010: // IpiGeneration
       // Interrupt packet received, generate appropriate interrupt to target threads.
       {
@@ -79,7 +87,7 @@ void Xe::XCPU::XenonIIC::Write(u64 writeAddress, const u8* data, u64 size) {
       {
         removeFirstACKdInterrupt(threadID);
         // Update task priority.
-        socINTBlock->ProcessorBlock[threadID].InterruptTaskPriority.AsULONGLONG = dataIn & 0xFF;
+        setTaskPriority(threadID, dataIn & 0xFF);
       }
       break; 
     case 0x0070: break; // SpuriousVector
@@ -183,6 +191,17 @@ void Xe::XCPU::XenonIIC::Read(u64 readAddress, u8* data, u64 size) {
   memcpy(data, &dataOut, size);
 }
 
+// Save states
+void Xe::XCPU::XenonIIC::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lock(iicMutex);
+  stream.DoBytes(socINTBlock.get(), sizeof(SOCINTS_BLOCK));
+  for (sInterruptState &thread : interruptState) {
+    stream.DoAtomic(thread.state);
+    stream.DoAtomic(thread.logicalId);
+    stream.Do(thread.inService);
+  }
+}
+
 
 //
 // Helper Routines
@@ -191,21 +210,18 @@ void Xe::XCPU::XenonIIC::Read(u64 readAddress, u8* data, u64 size) {
 // Generates an interrupt of the specified type to the specified CPUs.
 void Xe::XCPU::XenonIIC::generateInterrupt(u8 interruptType, u8 cpusToInterrupt) {
   MICROPROFILE_SCOPEI("[Xe::IIC]", "GenInterrupt", MP_AUTO);
-  
-  // Set a lock
-  std::lock_guard lock(iicMutex);
 
   DEBUGP("[IIC]: Generating interrupt {} for threads with mask {:#x}", 
     getIntName(static_cast<eXeIntVectors>(interruptType)).c_str(), cpusToInterrupt);
 
-  // Create our interrupt packet
-  sInterruptPacket intPacket = { interruptType, false};
+  interruptsGenerated.fetch_add(1, std::memory_order_relaxed);
 
+  // Latch the vector, a vector that's already pending stays pending once (same as the hardware IRR)
+  const u64 vectorBit = iicVectorBit(interruptType);
   for (u8 threadID = 0; threadID < 6; threadID++) {
-    u8 cpuMask = socINTBlock->ProcessorBlock[threadID].LogicalIdentification.AsBITS.LogicalId;
+    const u8 cpuMask = interruptState[threadID].logicalId.load(std::memory_order_acquire);
     if ((cpusToInterrupt & cpuMask)) {
-      // Store the interrupt in the interrupt queue
-      interruptState[threadID].pendingInterrupts.push(intPacket);
+      interruptState[threadID].state.fetch_or(vectorBit, std::memory_order_release);
     }
   }
 }
@@ -215,189 +231,81 @@ void Xe::XCPU::XenonIIC::cancelInterrupt(u8 interruptType, u8 cpusToInterrupt) {
   return;
 }
 
-// Returns true if there are pending interrupts for the given thread that match the specified priority.
-bool Xe::XCPU::XenonIIC::hasPendingInterrupts(u8 threadID, bool ignorePendingACKd) {
-  // Check for valid thread ID
-  if (threadID >= 6) {
-    return false;
-  }
-
-  // Set a lock
-  std::lock_guard lock(iicMutex);
-
-  auto& pq = interruptState[threadID].pendingInterrupts;
-
-  if (pq.empty()) {
-    // No pending interrupts
-    return false;
-  }
-
-  // Check for priority
-  const u8 priority = static_cast<u8>(socINTBlock->ProcessorBlock[threadID].InterruptTaskPriority.AsULONGLONG & 0xFF);
-
-  // Ignore ACK packages if any and lower priority interrupts
-  bool foundAcked = false;
-  bool foundMatch = false;
-  u8 type = 0;
-  std::vector<sInterruptPacket> buffer;
-  buffer.reserve(pq.size());
-
-  while (!pq.empty()) {
-    const auto pkt = pq.top();
-    pq.pop();
-    buffer.emplace_back(pkt);
-
-    if (pkt.acknowledged) { foundAcked = true; } 
-    else if (pkt.interruptType > priority) { foundMatch = true; type = pkt.interruptType; }
-  }
-
-  for (const auto& pkt : buffer) { pq.push(pkt); }
-
-  // There are ACK'd packets, cant signal an interupt.
-  if (foundAcked && !ignorePendingACKd) {
-    return false;
-  }
-
-  return foundMatch;
+// Sets the task priority for a given thread, and what it gets signaled for.
+void Xe::XCPU::XenonIIC::setTaskPriority(u8 threadID, u64 priority) {
+  socINTBlock->ProcessorBlock[threadID].InterruptTaskPriority.AsULONGLONG = priority;
+  // Anything at or past prioNONE masks everything
+  const u64 priorityVector = std::min<u64>((priority & 0xFF) >> 2, 31);
+  auto &state = interruptState[threadID].state;
+  u64 current = state.load(std::memory_order_relaxed);
+  while (!state.compare_exchange_weak(current,
+    (current & ~IIC_STATE_PRIORITY_MASK) | (priorityVector << IIC_STATE_PRIORITY_SHIFT),
+    std::memory_order_acq_rel, std::memory_order_relaxed)) {}
 }
 
-// Removes the first ACK'd interrupt from the pending queue for a given thread.
+// Removes the first ACK'd interrupt for a given thread.
 void Xe::XCPU::XenonIIC::removeFirstACKdInterrupt(u8 threadID) {
   // Bounds check
   if (threadID >= 6) {
     return;
   }
 
-  // Set a lock
-  std::lock_guard lock(iicMutex);
-
-  auto& pq = interruptState[threadID].pendingInterrupts;
-  if (pq.empty()) {
-    DEBUGP("[IIC]: EOI on thread {} with empty queue", threadID);
+  auto &intState = interruptState[threadID];
+  if (intState.inService == 0) {
+    DEBUGP("[IIC]: EOI on thread {} found no ACK'd interrupts to remove", threadID);
     return;
   }
 
-  // Rebuild the priority queue excluding the first acknowledged packet encountered in order.
-  bool removed = false;
-  std::vector<sInterruptPacket> buffer;
-  buffer.reserve(pq.size());
-
-  // Pop all elements; the top is highest priority due to operator < inversion.
-  while (!pq.empty()) {
-    const auto pkt = pq.top();
-    pq.pop();
-    if (!removed && pkt.acknowledged) {
-      removed = true;
-      DEBUGP("[IIC]: Removed ACK'd interrupt {} from thread {}",
-          getIntName(static_cast<eXeIntVectors>(pkt.interruptType)).c_str(), threadID);
-      continue; // skip this packet
-    }
-    buffer.emplace_back(pkt);
-  }
+  // Same order acknowledge hands them out in, lowest vector first
+  const u32 vector = std::countr_zero(intState.inService);
+  intState.inService &= ~(1u << vector);
+  DEBUGP("[IIC]: Removed ACK'd interrupt {} from thread {}",
+    getIntName(static_cast<eXeIntVectors>(vector << 2)).c_str(), threadID);
 
-  // Restore the remaining packets back into the priority queue.
-  for (const auto& pkt : buffer) {
-    pq.push(pkt);
+  if (intState.inService == 0) {
+    intState.state.fetch_and(~IIC_STATE_IN_SERVICE, std::memory_order_acq_rel);
   }
-
-  if (!removed) { DEBUGP("[IIC]: EOI on thread {} found no ACK'd interrupts to remove", threadID); }
 }
 
-// Acknowledges and returns the highest priority pending interrupt for a given thread.
-// NOTE: If the highest priority interrupt is the same priority as the current task priority, we return and ACK the next
-// higher priority interrupt instead.
+// Acknowledges and returns the first pending interrupt for a given thread, lowest vector first.
+// Only interrupts strictly above the current task priority are eligible, acknowledged ones stay
+// in service until their EOI.
+// NOTE: Interrupts are taken in queue order, lowest vector at the head. A head below the task priority
+// holds back everything behind it (nothing is returned), unless an interrupt in service is ahead of it.
 u8 Xe::XCPU::XenonIIC::acknowledgeInterrupt(u8 threadID) {
   // Bounds check
   if (threadID >= 6) {
     return prioNONE;
   }
 
-  // Set a lock
-  std::lock_guard lock(iicMutex);
-
-  u8 outInterrupt = prioNONE;
-
-  auto& pq = interruptState[threadID].pendingInterrupts;
-
-  if (!pq.empty()) {
-    // Current task priority for this thread
-    const u8 currentPriority = static_cast<u8>(socINTBlock->ProcessorBlock[threadID].InterruptTaskPriority.AsULONGLONG & 0xFF);
-
-    // Get the highest priority interrupt
-    const auto topPacket = pq.top();
-    u8 targetInterrupt = prioNONE;
-
-    if (!topPacket.acknowledged) {
-      if (topPacket.interruptType > currentPriority) {
-        // Top is higher than current priority -> acknowledge it
-        targetInterrupt = topPacket.interruptType;
-      } else if (topPacket.interruptType == currentPriority) {
-        // Special case, top equals current priority -> find next strictly higher than currentPriority
-        // We scan the queue and pick the first matching.
-        std::vector<sInterruptPacket> buffer;
-        buffer.reserve(pq.size());
-
-        u8 nextHigher = prioNONE;
-        while (!pq.empty()) {
-          const auto pkt = pq.top();
-          pq.pop();
-          buffer.emplace_back(pkt);
-          if (nextHigher == prioNONE && !pkt.acknowledged && pkt.interruptType > currentPriority) {
-            nextHigher = pkt.interruptType;
-            // Continue draining to preserve all packets
-          }
-        }
-        // Restore all queue contents
-        for (const auto& pkt : buffer) { pq.push(pkt); }
-
-        targetInterrupt = nextHigher; // may remain prioNONE if none found
-      } else {
-        // Top is lower than currentPriority -> no eligible interrupt
-        targetInterrupt = prioNONE;
-      }
-    } else {
-      // Top already acknowledged; try to find a non-acknowledged packet strictly higher than currentPriority
-      std::vector<sInterruptPacket> buffer;
-      buffer.reserve(pq.size());
-
-      u8 nextHigher = prioNONE;
-      while (!pq.empty()) {
-        const auto pkt = pq.top();
-        pq.pop();
-        buffer.emplace_back(pkt);
-        if (nextHigher == prioNONE && !pkt.acknowledged && pkt.interruptType > currentPriority) {
-          nextHigher = pkt.interruptType;
-          // Continue draining to preserve all packets
-        }
-      }
-      for (const auto& pkt : buffer) { pq.push(pkt); }
-
-      targetInterrupt = nextHigher;
+  auto &intState = interruptState[threadID];
+  // Both only change with iicMutex held
+  const u8 priority = static_cast<u8>(socINTBlock->ProcessorBlock[threadID].InterruptTaskPriority.AsULONGLONG & 0xFF);
+  const u32 firstInService = intState.inService ? std::countr_zero(intState.inService) : 32;
+  u64 current = intState.state.load(std::memory_order_acquire);
+  u32 vector = 0;
+  do {
+    const u32 pending = static_cast<u32>(current);
+    if (pending == 0) {
+      return prioNONE;
     }
-
-    // If we found an interrupt to acknowledge, mark exactly one matching packet as acknowledged.
-    if (targetInterrupt != prioNONE) {
-      outInterrupt = targetInterrupt;
-
-      bool marked = false;
-      std::vector<sInterruptPacket> buffer;
-      buffer.reserve(pq.size());
-      // Pop all elements; the top is highest priority due to operator < inversion.
-      while (!pq.empty()) {
-        auto pkt = pq.top();
-        pq.pop();
-        if (!marked && !pkt.acknowledged && pkt.interruptType == targetInterrupt) {
-          pkt.acknowledged = true;
-          marked = true;
-        }
-        buffer.emplace_back(pkt);
-      }
-      // Restore the packets back into the priority queue.
-      for (const auto& pkt : buffer) { pq.push(pkt); }
+    const u32 firstPending = std::countr_zero(pending);
+    if (firstPending < firstInService && (firstPending << 2) < priority) {
+      return prioNONE;
     }
-  }
-
-  return outInterrupt;
+    const u8 priorityVector = static_cast<u8>((current & IIC_STATE_PRIORITY_MASK) >> IIC_STATE_PRIORITY_SHIFT);
+    const u32 eligible = static_cast<u32>(current) & iicVectorsAbove(priorityVector);
+    if (eligible == 0) {
+      return prioNONE;
+    }
+    vector = std::countr_zero(eligible);
+    // Moves from pending to in service in one step, other threads can keep raising interrupts meanwhile
+  } while (!intState.state.compare_exchange_weak(current, (current & ~static_cast<u64>(1u << vector)) | IIC_STATE_IN_SERVICE,
+    std::memory_order_acq_rel, std::memory_order_acquire));
+
+  intState.inService |= 1u << vector;
+  interruptsAcknowledged.store(interruptsAcknowledged.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  return static_cast<u8>(vector << 2);
 }
 
 // Returns the name of the register being accessed based on the offset and what block it belongs to.
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
-#include <queue>
+
+#include "Core/SaveState/StateStream.h"
 
 namespace Xe::XCPU {
 
@@ -220,20 +222,41 @@ namespace Xe::XCPU {
     u64 Reserved12[495]; // 28808
   } SOCINTS_BLOCK, * PSOCINTS_BLOCK;
 
-  // Structure represnting an Interrupt Packet
-    struct sInterruptPacket {
-    u8 interruptType = prioNONE;
-    bool acknowledged = false;
+  //
+  // Per thread interrupt state
+  //
+  // Interrupts are tracked as bitmasks of vectors (type >> 2, same as the VectorNumber fields above),
+  // like the hardware's IRR / ISR. Everything a PPU thread needs to know on every loop iteration is packed
+  // in one atomic word, so checking for interrupts is a single load and raising one is a single fetch_or.
+  // Only acknowledge / EOI / task priority changes take the IIC mutex.
+  //
 
-    // Highest priority comes first
-    friend constexpr bool operator<(const sInterruptPacket& lhs, const sInterruptPacket& rhs) noexcept {
-      return lhs.interruptType > rhs.interruptType;
-    }
-  };
+  // Bits 0-31: vectors pending acknowledgement
+  static constexpr u64 IIC_STATE_PENDING_MASK = 0xFFFFFFFFull;
+  // Bits 32-36: task priority vector, only vectors above it are signaled
+  static constexpr u64 IIC_STATE_PRIORITY_SHIFT = 32;
+  static constexpr u64 IIC_STATE_PRIORITY_MASK = 0x1Full << IIC_STATE_PRIORITY_SHIFT;
+  // Bit 37: an acknowledged interrupt is waiting for its EOI
+  static constexpr u64 IIC_STATE_IN_SERVICE = 1ull << 37;
+
+  // Converts an interrupt type to its bit in the masks
+  static constexpr u32 iicVectorBit(u8 interruptType) {
+    return 1u << ((interruptType >> 2) & 0x1F);
+  }
+  // Mask of the vectors strictly above a task priority
+  static constexpr u32 iicVectorsAbove(u8 priorityVector) {
+    return priorityVector >= 31 ? 0 : ~((2u << priorityVector) - 1);
+  }
 
   // Structure tracking the state of interrupts for each PPU Thread.
-  struct sInterruptState {
-    std::priority_queue<sInterruptPacket> pendingInterrupts;
+  // Aligned so threads polling their own state don't share cache lines.
+  struct alignas(64) sInterruptState {
+    // Pending vectors, task priority and the in service flag, see above
+    std::atomic<u64> state = 0;
+    // Logical ID, what IPIs and device interrupts are matched against
+    std::atomic<u8> logicalId = 0;
+    // Acknowledged vectors waiting for an EOI. Guarded by iicMutex.
+    u32 inService = 0;
   };
 
   class XenonIIC {
@@ -249,8 +272,27 @@ namespace Xe::XCPU {
     void generateInterrupt(u8 interruptType, u8 cpusToInterrupt);
     // Cancels a previously generated pending interrupt.
     void cancelInterrupt(u8 interruptType, u8 cpusToInterrupt);
-    // Returns true if there are pending interrupts for the given thread.
-    bool hasPendingInterrupts(u8 threadID, bool ignorePendingACKd = false);
+    // Returns true if there are pending interrupts above the task priority for the given thread.
+    // While an acknowledged interrupt waits for its EOI nothing is signaled, unless ignorePendingACKd is set.
+    bool hasPendingInterrupts(u8 threadID, bool ignorePendingACKd = false) {
+      // Check for valid thread ID
+      if (threadID >= 6) {
+        return false;
+      }
+      const u64 state = interruptState[threadID].state.load(std::memory_order_acquire);
+      if ((state & IIC_STATE_IN_SERVICE) && !ignorePendingACKd) {
+        return false;
+      }
+      const u8 priorityVector = static_cast<u8>((state & IIC_STATE_PRIORITY_MASK) >> IIC_STATE_PRIORITY_SHIFT);
+      return (static_cast<u32>(state) & iicVectorsAbove(priorityVector)) != 0;
+    }
+
+    // Save states: the register block and every thread's interrupt state
+    void SerializeState(Xe::SaveState::StateStream &stream);
+
+    // Statistics, interrupts raised by devices/IPIs and interrupts taken by the PPU threads.
+    u64 GetInterruptsGenerated() const { return interruptsGenerated.load(std::memory_order_relaxed); }
+    u64 GetInterruptsAcknowledged() const { return interruptsAcknowledged.load(std::memory_order_relaxed); }
 
   private:
     // Our Interrupt Block
@@ -259,13 +301,21 @@ namespace Xe::XCPU {
     // Interrupt States for each PPU Thread
     sInterruptState interruptState[6] = {};
 
-    // Mutex for thread safety
-    std::recursive_mutex iicMutex;
+    // Mutex for the register block and the acknowledge / EOI paths
+    std::mutex iicMutex;
+
+    // Statistics, see above. Acknowledges are counted with iicMutex held.
+    std::atomic<u64> interruptsGenerated = 0;
+    std::atomic<u64> interruptsAcknowledged = 0;
+
+    // Sets the task priority of a thread. Called with iicMutex held.
+    void setTaskPriority(u8 threadID, u64 priority);
 
-    // Erases the first element in the queue that has been ack'd.
+    // Ends the first acknowledged interrupt. Called with iicMutex held.
     void removeFirstACKdInterrupt(u8 threadID);
 
-    // Reads out the first element that has not been ACk'd and marks it as ack'd.
+    // Acknowledges the first pending interrupt above the task priority, unless a lower one below it heads the
+    // queue. Called with iicMutex held.
     u8 acknowledgeInterrupt(u8 threadID);
 
     // Processes an access offset and returns a string from where it belongs to.
@@ -5,10 +5,13 @@
 #include "InstructionProfiler.h"
 
 #include "Base/Logging/Log.h"
+#include "Base/PathUtil.h"
+
+#include "PPCInterpreter.h"
 
 #include <algorithm>
-#include <vector>
-#include <mutex>
+#include <fstream>
+#include <unordered_set>
 
 namespace PPCInterpreter {
 
@@ -82,232 +85,253 @@ namespace PPCInterpreter {
       "mftb", "slbmte", "slbie", "mtspr", "slbia", "tlbsync", 
     };
 
-    static inline bool comparePairDesc(const std::pair<std::string, u64> &a,
-      const std::pair<std::string, u64> &b) {
-      return a.second > b.second;
+    static inline bool typeMatches(const std::string &name, eInstrProfileDumpType type) {
+      switch (type) {
+      case ALU: return aluNames.contains(name);
+      case FPU: return fpuNames.contains(name);
+      case VXU: return vxuNames.contains(name);
+      case LS: return lsNames.contains(name);
+      case SYS: return sysNames.contains(name);
+      default: return true;
+      }
     }
   } // anonymous namespace
 
+  const char *InstrCategory(const std::string &name) {
+    if (aluNames.contains(name)) return "ALU";
+    if (fpuNames.contains(name)) return "FPU";
+    if (vxuNames.contains(name)) return "VXU";
+    if (lsNames.contains(name)) return "LS";
+    if (sysNames.contains(name)) return "SYS";
+    return "Other";
+  }
+
   InstructionProfiler &InstructionProfiler::Get() noexcept {
     static InstructionProfiler instance;
     return instance;
   }
 
   InstructionProfiler::InstructionProfiler() noexcept {
-    // No initialization required para el mapa dinmico.
+    // Allocated up front, so neither the interpreter nor JIT code ever sees a missing core
+    for (auto &core : cores) {
+      core = std::make_unique<sCoreCounters>();
+    }
   }
 
   InstructionProfiler::~InstructionProfiler() = default;
 
-  void InstructionProfiler::Increment(const std::string &instrName) noexcept {
-    {
-      std::shared_lock lock(countersMutex_);
-      auto it = counters_.find(instrName);
-      if (it != counters_.end()) {
-        it->second->fetch_add(1, std::memory_order_relaxed);
+  u64 *InstructionProfiler::GetCounterAddress(u8 coreID, u32 slot) noexcept {
+    if (coreID >= INSTR_PROFILER_MAX_CORES) {
+      return nullptr;
+    }
+    return reinterpret_cast<u64 *>(&cores[coreID]->slots[slot & (INSTR_PROFILER_SLOTS - 1)]);
+  }
+
+  void InstructionProfiler::SamplePC(sCoreCounters &core, u64 pc) noexcept {
+    const u64 key = pc | 1;
+    u32 index = static_cast<u32>(((pc >> 2) * 0x9E3779B97F4A7C15ULL) >> 32) & (INSTR_PROFILER_PC_TABLE_SIZE - 1);
+    for (u32 probe = 0; probe != INSTR_PROFILER_PC_MAX_PROBES; ++probe) {
+      sPCSample &entry = core.pcSamples[index];
+      const u64 current = entry.key.load(std::memory_order_relaxed);
+      if (current == key || current == 0) {
+        // Only the owning core inserts, so claiming an empty entry needs no CAS
+        if (current == 0) {
+          entry.key.store(key, std::memory_order_relaxed);
+        }
+        entry.count.store(entry.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
         return;
       }
+      index = (index + 1) & (INSTR_PROFILER_PC_TABLE_SIZE - 1);
     }
+    core.droppedSamples.fetch_add(1, std::memory_order_relaxed);
+  }
 
-    {
-      std::unique_lock lock(countersMutex_);
-      auto it = counters_.find(instrName);
-      if (it == counters_.end()) {
-        auto ptr = std::make_shared<std::atomic<u64>>(0);
-        auto res = counters_.emplace(instrName, ptr);
-        res.first->second->fetch_add(1, std::memory_order_relaxed);
+  void InstructionProfiler::Reset() noexcept {
+    // Cores keep running while this happens, a few counts in flight may survive
+    for (auto &core : cores) {
+      for (auto &counter : core->slots) {
+        counter.store(0, std::memory_order_relaxed);
       }
-      else {
-        it->second->fetch_add(1, std::memory_order_relaxed);
+      for (auto &entry : core->pcSamples) {
+        entry.count.store(0, std::memory_order_relaxed);
+        entry.key.store(0, std::memory_order_relaxed);
       }
+      core->droppedSamples.store(0, std::memory_order_relaxed);
     }
   }
 
-  void InstructionProfiler::Reset() noexcept {
-    std::unique_lock lock(countersMutex_);
-    for (auto &p : counters_) {
-      p.second->store(0, std::memory_order_relaxed);
+  std::vector<InstructionProfiler::sInstrCount> InstructionProfiler::MergeCounts() const {
+    std::vector<sInstrCount> counts;
+    for (u32 slot = 0; slot != INSTR_PROFILER_SLOTS; ++slot) {
+      sInstrCount count{ slot };
+      for (u32 i = 0; i != INSTR_PROFILER_MAX_CORES; ++i) {
+        count.perCore[i] = cores[i]->slots[slot].load(std::memory_order_relaxed);
+        count.total += count.perCore[i];
+      }
+      if (count.total) {
+        counts.push_back(count);
+      }
     }
+    std::sort(counts.begin(), counts.end(), [](const sInstrCount &a, const sInstrCount &b) {
+      return a.total > b.total;
+    });
+    return counts;
   }
 
-  void InstructionProfiler::DumpTopAll(size_t topN) const noexcept {
-    std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (v) vec.emplace_back(p.first, v);
+  std::vector<InstructionProfiler::sPCCount> InstructionProfiler::MergePCs() const {
+    std::vector<sPCCount> samples;
+    for (const auto &core : cores) {
+      for (const auto &entry : core->pcSamples) {
+        const u64 key = entry.key.load(std::memory_order_relaxed);
+        const u64 count = entry.count.load(std::memory_order_relaxed);
+        if (key && count) {
+          samples.push_back({ key & ~1ULL, count });
+        }
       }
     }
-
-    if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no counts recorded.");
-      return;
+    // Cores running the same code sample the same addresses
+    std::sort(samples.begin(), samples.end(), [](const sPCCount &a, const sPCCount &b) { return a.pc < b.pc; });
+    std::vector<sPCCount> merged;
+    for (const auto &sample : samples) {
+      if (!merged.empty() && merged.back().pc == sample.pc) {
+        merged.back().count += sample.count;
+      } else {
+        merged.push_back(sample);
+      }
     }
+    std::sort(merged.begin(), merged.end(), [](const sPCCount &a, const sPCCount &b) { return a.count > b.count; });
+    return merged;
+  }
 
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
-
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} instructions (all):", limit);
-
-    for (size_t i = 0; i < limit; ++i) {
-      const auto &p = vec[i];
-      LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
-    }
+  void InstructionProfiler::DumpTopAll(size_t topN) const noexcept {
+    DumpTop("", ALL, topN);
   }
 
-  void InstructionProfiler::DumpTopALU(size_t topN) const noexcept {
+  void InstructionProfiler::DumpTop(const char *category, eInstrProfileDumpType type, size_t topN) const noexcept {
+    const std::vector<sInstrCount> counts = MergeCounts();
+
     std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        if (aluNames.find(p.first) == aluNames.end()) continue;
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (!v) continue;
-        vec.emplace_back(p.first, v);
+    for (const auto &count : counts) {
+      std::string name = ppcDecoder.decodeName(InstrSlotOpcode(count.slot));
+      if (typeMatches(name, type)) {
+        vec.emplace_back(std::move(name), count.total);
+        if (vec.size() == topN) {
+          break;
+        }
       }
     }
 
     if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no ALU instruction counts recorded.");
+      LOG_INFO(Xenon, "[InstructionProfiler]: no {}instruction counts recorded.", category);
       return;
     }
 
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
+    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} {}instructions:", vec.size(), category);
 
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} ALU instructions (exact list):", limit);
-
-    for (size_t i = 0; i < limit; ++i) {
+    for (size_t i = 0; i < vec.size(); ++i) {
       const auto &p = vec[i];
       LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
     }
   }
 
-  void InstructionProfiler::DumpTopFPU(size_t topN) const noexcept {
-    std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        if (fpuNames.find(p.first) == fpuNames.end()) continue;
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (!v) continue;
-        vec.emplace_back(p.first, v);
-      }
-    }
+  void InstructionProfiler::DumpInstrCounts(eInstrProfileDumpType dumpType, size_t topN) {
+    if (dumpType & ALU) { DumpTop("ALU ", ALU, topN); }
+    if (dumpType & VXU) { DumpTop("VXU ", VXU, topN); }
+    if (dumpType & FPU) { DumpTop("FPU ", FPU, topN); }
+    if (dumpType & LS) { DumpTop("Load/Store ", LS, topN); }
+    if (dumpType & SYS) { DumpTop("System ", SYS, topN); }
+  }
 
-    if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no FPU instruction counts recorded.");
+  void InstructionProfiler::DumpTopPCs(size_t topN) const noexcept {
+    const std::vector<sPCCount> samples = MergePCs();
+    if (samples.empty()) {
+      LOG_INFO(Xenon, "[InstructionProfiler]: no address samples recorded.");
       return;
     }
 
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
+    u64 totalSamples = 0;
+    for (const auto &sample : samples) {
+      totalSamples += sample.count;
+    }
+    const size_t limit = std::min(topN, samples.size());
 
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} FPU instructions (exact list):", limit);
+    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} sampled addresses ({} samples, 1 every {} instructions):",
+      limit, totalSamples, INSTR_PROFILER_PC_SAMPLE_RATE);
 
     for (size_t i = 0; i < limit; ++i) {
-      const auto &p = vec[i];
-      LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
+      const auto &s = samples[i];
+      LOG_INFO(Xenon, "  {:3} : {:>12} hits - 0x{:016X} ({:.2f}%)", i + 1, s.count, s.pc,
+        100.0 * s.count / totalSamples);
     }
   }
 
-  void InstructionProfiler::DumpTopVXU(size_t topN) const noexcept {
-    std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        if (vxuNames.find(p.first) == vxuNames.end()) continue;
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (!v) continue;
-        vec.emplace_back(p.first, v);
-      }
+  bool InstructionProfiler::ExportCSV(const std::filesystem::path &path) const noexcept {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[InstructionProfiler]: Unable to open '{}' for writing.", path.string());
+      return false;
     }
 
-    if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no VXU instruction counts recorded.");
-      return;
+    file << "slot,name,category";
+    for (u32 i = 0; i != INSTR_PROFILER_MAX_CORES; ++i) {
+      file << fmt::format(",ppu{}", i);
     }
-
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
-
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} VXU instructions (exact list):", limit);
-
-    for (size_t i = 0; i < limit; ++i) {
-      const auto &p = vec[i];
-      LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
-    }
-  }
-
-  void InstructionProfiler::DumpTopLS(size_t topN) const noexcept {
-    std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        if (lsNames.find(p.first) == lsNames.end()) continue;
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (!v) continue;
-        vec.emplace_back(p.first, v);
+    file << ",total\n";
+    for (const auto &count : MergeCounts()) {
+      const std::string name = ppcDecoder.decodeName(InstrSlotOpcode(count.slot));
+      file << fmt::format("0x{:05X},{},{}", count.slot, name, InstrCategory(name));
+      for (u64 coreCount : count.perCore) {
+        file << fmt::format(",{}", coreCount);
       }
+      file << fmt::format(",{}\n", count.total);
     }
 
-    if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no Load/Store instruction counts recorded.");
-      return;
+    // Sampled addresses follow as a second table
+    file << "\npc,samples\n";
+    for (const auto &sample : MergePCs()) {
+      file << fmt::format("0x{:016X},{}\n", sample.pc, sample.count);
     }
 
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
-
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} Load/Store instructions (exact list):", limit);
-
-    for (size_t i = 0; i < limit; ++i) {
-      const auto &p = vec[i];
-      LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
-    }
+    LOG_INFO(Xenon, "[InstructionProfiler]: Counts written to '{}'.", path.string());
+    return file.good();
   }
 
-  void InstructionProfiler::DumpTopSYS(size_t topN) const noexcept {
-    std::vector<std::pair<std::string, u64>> vec;
-    {
-      std::shared_lock lock(countersMutex_);
-      vec.reserve(counters_.size());
-      for (const auto &p : counters_) {
-        if (sysNames.find(p.first) == sysNames.end()) continue;
-        u64 v = p.second->load(std::memory_order_relaxed);
-        if (!v) continue;
-        vec.emplace_back(p.first, v);
-      }
+  bool InstructionProfiler::ExportJSON(const std::filesystem::path &path) const noexcept {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[InstructionProfiler]: Unable to open '{}' for writing.", path.string());
+      return false;
     }
 
-    if (vec.empty()) {
-      LOG_INFO(Xenon, "[InstructionProfiler]: no System instruction counts recorded.");
-      return;
+    u64 droppedSamples = 0;
+    for (const auto &core : cores) {
+      droppedSamples += core->droppedSamples.load(std::memory_order_relaxed);
     }
 
-    std::sort(vec.begin(), vec.end(), comparePairDesc);
-    size_t limit = std::min(topN, vec.size());
-
-    LOG_INFO(Xenon, "[InstructionProfiler]: Top {} System instructions (exact list):", limit);
-
-    for (size_t i = 0; i < limit; ++i) {
-      const auto &p = vec[i];
-      LOG_INFO(Xenon, "  {:3} : {:>12} hits - {}", i + 1, p.second, p.first);
+    // Instruction names are plain mnemonics, nothing needs escaping
+    file << "{\n  \"instructions\": [";
+    bool first = true;
+    for (const auto &count : MergeCounts()) {
+      const std::string name = ppcDecoder.decodeName(InstrSlotOpcode(count.slot));
+      file << fmt::format("{}\n    {{ \"slot\": {}, \"name\": \"{}\", \"category\": \"{}\", \"perCore\": [",
+        first ? "" : ",", count.slot, name, InstrCategory(name));
+      for (u32 i = 0; i != INSTR_PROFILER_MAX_CORES; ++i) {
+        file << fmt::format("{}{}", i ? ", " : "", count.perCore[i]);
+      }
+      file << fmt::format("], \"total\": {} }}", count.total);
+      first = false;
     }
-  }
+    file << fmt::format("\n  ],\n  \"pcSampleRate\": {},\n  \"droppedSamples\": {},\n  \"pcSamples\": [",
+      INSTR_PROFILER_PC_SAMPLE_RATE, droppedSamples);
+    first = true;
+    for (const auto &sample : MergePCs()) {
+      file << fmt::format("{}\n    {{ \"pc\": \"0x{:016X}\", \"samples\": {} }}", first ? "" : ",", sample.pc, sample.count);
+      first = false;
+    }
+    file << "\n  ]\n}\n";
 
-  void InstructionProfiler::DumpInstrCounts(eInstrProfileDumpType dumpType, size_t topN) {
-    if (dumpType & ALU) { DumpTopALU(topN); }
-    if (dumpType & VXU) { DumpTopVXU(topN); }
-    if (dumpType & FPU) { DumpTopFPU(topN); }
-    if (dumpType & LS) { DumpTopLS(topN); }
-    if (dumpType & SYS) { DumpTopSYS(topN); }
+    LOG_INFO(Xenon, "[InstructionProfiler]: Counts written to '{}'.", path.string());
+    return file.good();
   }
 
-} // namespace PPCInterpreter
\ No newline at end of file
+} // namespace PPCInterpreter
@@ -5,14 +5,24 @@
 #pragma once
 
 #include <atomic>
+#include <filesystem>
 #include <memory>
-#include <shared_mutex>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include <cstddef>
 
+// Counters per core, one per PPCDecode table slot
+#define INSTR_PROFILER_SLOTS 0x20000
+// One set of counters per PPU core. Each core runs on its own host thread, so every counter has a single writer
+// and counting is a plain load / add / store, no locked instructions.
+#define INSTR_PROFILER_MAX_CORES 3
+// Every Nth instruction a core interprets gets its address sampled. Prime, so loops don't alias with it.
+#define INSTR_PROFILER_PC_SAMPLE_RATE 997
+// Distinct sampled addresses tracked per core (power of 2)
+#define INSTR_PROFILER_PC_TABLE_SIZE 0x4000
+// Entries looked at before a sample is dropped
+#define INSTR_PROFILER_PC_MAX_PROBES 16
+
 namespace PPCInterpreter {
 
   enum eInstrProfileDumpType : unsigned int {
@@ -24,13 +34,36 @@ namespace PPCInterpreter {
     ALL = ALU | VXU | FPU | LS | SYS
   };
 
-  // Quick instruction profiler for PPC Interpreter.
+  // Any opcode sharing the slot's primary opcode and extended bits decodes the same, builds one for a decoder slot
+  inline u32 InstrSlotOpcode(u32 slot) {
+    return ((slot & 0x3F) << 26) | (slot >> 6);
+  }
+
+  // Category an instruction name belongs to: ALU, FPU, VXU, LS, SYS or Other
+  const char *InstrCategory(const std::string &name);
+
+  // Quick instruction profiler for the PPC Interpreter and JIT.
+  // Counts are kept per decoder table slot, names and categories are only looked up when dumping.
   class InstructionProfiler {
   public:
     static InstructionProfiler &Get() noexcept;
 
-    // Ahora acepta el nombre de la instruccin (string) en lugar de un ndice de tabla.
-    void Increment(const std::string &instrName) noexcept;
+    // Counts one execution of the instruction in decoder slot `slot` on a core, and samples the address every so often.
+    void Increment(u8 coreID, u32 slot, u64 pc) noexcept {
+      if (coreID >= INSTR_PROFILER_MAX_CORES) {
+        return;
+      }
+      sCoreCounters &core = *cores[coreID];
+      std::atomic<u64> &counter = core.slots[slot & (INSTR_PROFILER_SLOTS - 1)];
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (--core.sampleCountdown == 0) {
+        core.sampleCountdown = INSTR_PROFILER_PC_SAMPLE_RATE;
+        SamplePC(core, pc);
+      }
+    }
+
+    // Address of a slot counter. JIT blocks built on that core increment it directly.
+    u64 *GetCounterAddress(u8 coreID, u32 slot) noexcept;
 
     // Reset all counters.
     void Reset() noexcept;
@@ -41,17 +74,51 @@ namespace PPCInterpreter {
     // Dumps instruction counts based on the dumpType flags.
     void DumpInstrCounts(eInstrProfileDumpType dumpType, size_t topN = 20);
 
+    // Dumps the most sampled instruction addresses.
+    void DumpTopPCs(size_t topN = 20) const noexcept;
+
+    // Writes every executed instruction with its per core and total counts, and the sampled addresses.
+    bool ExportCSV(const std::filesystem::path &path) const noexcept;
+    bool ExportJSON(const std::filesystem::path &path) const noexcept;
+
     InstructionProfiler() noexcept;
     ~InstructionProfiler();
 
   private:
-    void DumpTopALU(size_t topN = 20) const noexcept;
-    void DumpTopFPU(size_t topN = 20) const noexcept;
-    void DumpTopVXU(size_t topN = 20) const noexcept;
-    void DumpTopLS(size_t topN = 20) const noexcept;
-    void DumpTopSYS(size_t topN = 20) const noexcept;
-    std::unordered_map<std::string, std::shared_ptr<std::atomic<u64>>> counters_;
-    mutable std::shared_mutex countersMutex_;
+    struct sPCSample {
+      // Sampled address | 1, 0 when unused. Instruction addresses are word aligned, so the low bit is free.
+      std::atomic<u64> key = 0;
+      std::atomic<u64> count = 0;
+    };
+
+    struct alignas(64) sCoreCounters {
+      std::atomic<u64> slots[INSTR_PROFILER_SLOTS] = {};
+      sPCSample pcSamples[INSTR_PROFILER_PC_TABLE_SIZE] = {};
+      std::atomic<u64> droppedSamples = 0;
+      // Only touched by the owning core
+      u32 sampleCountdown = INSTR_PROFILER_PC_SAMPLE_RATE;
+    };
+    static_assert(sizeof(std::atomic<u64>) == sizeof(u64), "JIT blocks increment counters as plain u64s");
+
+    struct sInstrCount {
+      u32 slot = 0;
+      u64 total = 0;
+      u64 perCore[INSTR_PROFILER_MAX_CORES] = {};
+    };
+    struct sPCCount {
+      u64 pc = 0;
+      u64 count = 0;
+    };
+
+    void SamplePC(sCoreCounters &core, u64 pc) noexcept;
+
+    // Merges all cores, sorted by total count. Slots never executed are left out.
+    std::vector<sInstrCount> MergeCounts() const;
+    std::vector<sPCCount> MergePCs() const;
+
+    void DumpTop(const char *category, eInstrProfileDumpType type, size_t topN) const noexcept;
+
+    std::unique_ptr<sCoreCounters> cores[INSTR_PROFILER_MAX_CORES];
   };
 
-} // namespace PPCInterpreter
\ No newline at end of file
+} // namespace PPCInterpreter
@@ -16,6 +16,7 @@ Xe::XCPU::XenonContext* PPCInterpreter::xenonContext = nullptr;
 PPCInterpreter::PPCDecoder PPCInterpreter::ppcDecoder{};
 
 #ifdef ENABLE_INSTRUCTION_PROFILER
+#include "Base/PathUtil.h"
 #include "Core/XCPU/Interpreter/InstructionProfiler.h"
 
 // Flags for instruction counters
@@ -128,11 +129,16 @@ void PPCInterpreter::ppcExecuteSingleInstruction(sPPEState *ppeState) {
   // Instruction Profiling
 #ifdef ENABLE_INSTRUCTION_PROFILER
   // Increase ref counts for current instruction
-  InstructionProfiler::Get().Increment(ppcDecoder.decodeName(thread.CI.opcode));
+  InstructionProfiler::Get().Increment(ppeState->ppuID, PPCDecode(thread.CI.opcode), thread.CIA);
 
-  // If enabled dumps the ALU instr counts.
+  // If enabled dumps the instr counts and hot addresses, and writes them to the log directory.
   if (dumpInstrCount && ppeState->ppuName == "PPU0") {
-    InstructionProfiler::Get().DumpInstrCounts(eInstrProfileDumpType::ALL);
+    InstructionProfiler &profiler = InstructionProfiler::Get();
+    profiler.DumpInstrCounts(eInstrProfileDumpType::ALL);
+    profiler.DumpTopPCs();
+    const auto &logDir = Base::FS::GetUserPath(Base::FS::PathType::LogDir);
+    profiler.ExportCSV(logDir / "instr_profile.csv");
+    profiler.ExportJSON(logDir / "instr_profile.json");
     dumpInstrCount = false;
   }
 
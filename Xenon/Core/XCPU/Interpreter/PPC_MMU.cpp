@@ -198,6 +198,20 @@ inline bool mmuComparePTE(u64 VA, u64 VPN, u64 pte0, u64 pte1, u8 p, bool L, boo
   return true;
 }
 
+// Trace writer an access gets recorded into. Only the core's own PPU thread records, the writer is single threaded
+// and the debugger reads guest memory through here too.
+inline Xe::XCPU::TraceWriter *mmuTraceWriter(sPPEState *ppeState) {
+  Xe::XCPU::TraceWriter *writer = ppeState->traceWriter;
+  return writer && Xe::XCPU::tracingPPE == ppeState ? writer : nullptr;
+}
+
+// Records a SoC block or bus device access in the binary trace, if one is being written
+inline void mmuTraceMMIO(sPPEState *ppeState, ePPUThreadID thr, u64 RA, const u8 *data, u64 byteCount, bool write) {
+  if (Xe::XCPU::TraceWriter *trace = mmuTraceWriter(ppeState)) [[unlikely]] {
+    trace->MMIO(thr != ePPUThread_None ? thr : curThreadId, RA, data, static_cast<u8>(byteCount), write);
+  }
+}
+
 // SLB Invalidate All
 void PPCInterpreter::PPCInterpreter_slbia(sPPEState *ppeState) {
   for (auto &slbEntry : curThread.SLB) {
@@ -230,7 +244,7 @@ void PPCInterpreter::PPCInterpreter_tlbiel(sPPEState *ppeState) {
 #ifdef MMU_DEBUG
         LOG_DEBUG(Xenon_MMU, "[TLBIEL]: Congruence-class invalidation (class {:#x})", classIndex);
 #endif
-        ppu->GetPPUJIT()->InvalidateAllBlocks();
+        ppu->GetPPUJIT()->InvalidateAllBlocks(eJITInvalidation::TLB);
       }
     }
   } else {
@@ -265,7 +279,7 @@ void PPCInterpreter::PPCInterpreter_tlbiel(sPPEState *ppeState) {
 #ifdef MMU_DEBUG
         LOG_DEBUG(Xenon_MMU, "[TLBIEL]: Invalidating JIT blocks for page {:#x} (size {:#x})", start, pageSize);
 #endif
-        ppu->GetPPUJIT()->InvalidateBlocksForRange(start, end);
+        ppu->GetPPUJIT()->InvalidateBlocksForRange(start, end, eJITInvalidation::TLB);
       }
     }
   }
@@ -308,7 +322,7 @@ void PPCInterpreter::PPCInterpreter_tlbie(sPPEState *ppeState) {
 #ifdef MMU_DEBUG
       LOG_DEBUG(Xenon_MMU, "[TLBIE]: Invalidating JIT blocks for page {:#x} (size {:#x})", start, pageSize);
 #endif
-      ppu->GetPPUJIT()->InvalidateBlocksForRange(start, end);
+      ppu->GetPPUJIT()->InvalidateBlocksForRange(start, end, eJITInvalidation::TLB);
     }
   }
 }
@@ -378,14 +392,9 @@ void PPCInterpreter::mmuAddTlbEntry(sPPEState *ppeState) {
   // Pre-calculate RPN for fast lookup
   const u64 RPN = L ? (tlbRpn & PPC_HPTE64_RPN_LP) : (tlbRpn & PPC_HPTE64_RPN_NO_LP);
 
-#ifdef DEBUG_BUILD
-  if (XeMain::GetCPU()) {
-    PPU *ppu = XeMain::GetCPU()->GetPPU(ppeState->ppuID);
-    if (ppu && ppu->traceFile) {
-      fprintf(ppu->traceFile, "TLB[%d:%d] map 0x%llx -> 0x%llx\n", TS, TI, tlbVpn, tlbRpn);
-    }
+  if (Xe::XCPU::TraceWriter *trace = mmuTraceWriter(ppeState)) [[unlikely]] {
+    trace->TLBFill(ppeState->currentThread, Xe::XCPU::eTraceTLBSource::Software, TS, TI, VPN, RPN);
   }
-#endif
 
 #ifdef MMU_DEBUG
   LOG_DEBUG(Xenon_MMU, "[TLB]: Adding entry: Class: {:#x}, Set: {:#b}, VPN: {:#x}, RPN: {:#x}",
@@ -981,6 +990,11 @@ bool PPCInterpreter::MMUTranslateAddress(u64 *EA, sPPEState *ppeState,
     QSET(RA, 0, 21, 0);
   }
 
+  if (Xe::XCPU::TraceWriter *trace = mmuTraceWriter(ppeState)) [[unlikely]] {
+    trace->TLBFill(thr != ePPUThread_None ? thr : curThreadId, Xe::XCPU::eTraceTLBSource::ERAT,
+      thread.instrFetch, 0, *EA & ~0xFFF, RA & ~0xFFF);
+  }
+
   // Save in ERAT's
   if (thread.instrFetch) {
     // iERAT
@@ -1005,6 +1019,10 @@ void PPCInterpreter::MMURead(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppeS
     memset(outData, 0, byteCount);
     return;
   }
+  if (Xe::XCPU::TraceWriter *trace = mmuTraceWriter(ppeState); trace && trace->TracesMemory() && !thread.instrFetch) [[unlikely]] {
+    trace->MemAccess(thr != ePPUThread_None ? thr : curThreadId, oldEA, EA,
+      static_cast<u8>(byteCount), false);
+  }
   bool socRead = false;
 
   EA = mmuContructEndAddressFromSecEngAddr(EA, &socRead);
@@ -1049,10 +1067,12 @@ void PPCInterpreter::MMURead(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppeS
     else if (EA >= XE_SOCINTS_BLOCK_START && EA <= XE_SOCINTS_BLOCK_START + XE_SOCINTS_BLOCK_SIZE) {
       // Pass it onto our context INT struct.
       cpuContext->HandleSOCRead(EA, outData, byteCount);
+      mmuTraceMMIO(ppeState, thr, EA, outData, byteCount, false);
       return;
     }
     // Try to handle the SoC read, may belong to one of the CPU SoC blocks.
     else if (cpuContext->HandleSOCRead(EA, outData, byteCount)) {
+      mmuTraceMMIO(ppeState, thr, EA, outData, byteCount, false);
       return;
     }
   }
@@ -1062,6 +1082,9 @@ void PPCInterpreter::MMURead(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppeS
     if (Config::log.advanced)
       LOG_WARNING(Xenon_MMU, "Invalid SoC Read from 0x{:X}", EA);
   }
+  if (socRead || EA >= PHYS_MEMORY_END) {
+    mmuTraceMMIO(ppeState, thr, EA, outData, byteCount, false);
+  }
 }
 
 // MMU Write Routine, used by the CPU
@@ -1073,6 +1096,11 @@ void PPCInterpreter::MMUWrite(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppe
   if (!MMUTranslateAddress(&EA, ppeState, true, thr))
     return;
 
+  if (Xe::XCPU::TraceWriter *trace = mmuTraceWriter(ppeState); trace && trace->TracesMemory()) [[unlikely]] {
+    trace->MemAccess(thr != ePPUThread_None ? thr : curThreadId, oldEA, EA,
+      static_cast<u8>(byteCount), true);
+  }
+
   // Check if it's reserved
   cpuContext->xenonRes.Check(EA);
 
@@ -1092,16 +1120,9 @@ void PPCInterpreter::MMUWrite(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppe
   }
 
   if (socWrite) {
-#ifdef DEBUG_BUILD
-    if (EA == 0x61010ULL) {
-      u64 postCode = *reinterpret_cast<const u64 *>(data);
-      std::string poseCodeStr = Xe::XCPU::POSTBUS::GET_POST(postCode);
-      PPU *PPU = XeMain::GetCPU()->GetPPU(ppeState->ppuID);
-      if (PPU->traceFile) {
-        fprintf(PPU->traceFile, "POST,0x%llx,%s\n", postCode, poseCodeStr.c_str());
-      }
+    if (Xe::XCPU::TraceWriter *trace = EA == 0x61010ULL ? mmuTraceWriter(ppeState) : nullptr) [[unlikely]] {
+      trace->Post(thr != ePPUThread_None ? thr : curThreadId, *reinterpret_cast<const u64 *>(data));
     }
-#endif
     // Check if writing to SROM region.
     if (EA >= XE_SROM_ADDR && EA < XE_SROM_ADDR + XE_SROM_SIZE) {
       LOG_ERROR(Xenon_MMU, "Tried to write to XCPU SROM!");
@@ -1116,15 +1137,21 @@ void PPCInterpreter::MMUWrite(Xe::XCPU::XenonContext *cpuContext, sPPEState *ppe
     // Integrated Interrupt Controller in real mode, used when the HV wants to
     // start a CPUs IC.
     else if (EA >= XE_SOCINTS_BLOCK_START && EA <= XE_SOCINTS_BLOCK_START + XE_SOCINTS_BLOCK_SIZE) {
+      mmuTraceMMIO(ppeState, thr, EA, data, byteCount, true);
       cpuContext->HandleSOCWrite(EA, data, byteCount);
       return;
     }
     // Try to handle the SoC write, may belong to one of the CPU SoC blocks.
     else if (cpuContext->HandleSOCWrite(EA, data, byteCount)) {
+      mmuTraceMMIO(ppeState, thr, EA, data, byteCount, true);
       return;
     }
   }
 
+  if (socWrite || EA >= PHYS_MEMORY_END) {
+    mmuTraceMMIO(ppeState, thr, EA, data, byteCount, true);
+  }
+
   // External write
   if (!xenonContext->GetRootBus()->Write(EA, data, byteCount, socWrite) && socWrite) {
     u64 tmp = 0;
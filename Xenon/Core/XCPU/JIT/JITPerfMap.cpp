@@ -0,0 +1,147 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "JITPerfMap.h"
+
+#include "Base/Arch.h"
+#include "Base/Logging/Log.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+  // jitdump format, see tools/perf/Documentation/jitdump-specification.txt in the Linux tree
+  constexpr u32 JITDUMP_MAGIC = 0x4A695444;
+  constexpr u32 JITDUMP_VERSION = 1;
+  constexpr u32 JITDUMP_CODE_LOAD = 0;
+  constexpr u32 JITDUMP_CODE_CLOSE = 3;
+#if defined(ARCH_X86_64)
+  constexpr u32 JITDUMP_ELF_MACHINE = 62;  // EM_X86_64
+#elif defined(ARCH_X86)
+  constexpr u32 JITDUMP_ELF_MACHINE = 3;   // EM_386
+#else
+  constexpr u32 JITDUMP_ELF_MACHINE = 183; // EM_AARCH64
+#endif
+
+  struct sJITDumpHeader {
+    u32 magic;
+    u32 version;
+    u32 totalSize;
+    u32 elfMachine;
+    u32 pad;
+    u32 pid;
+    u64 timestamp;
+    u64 flags;
+  };
+
+  struct sJITDumpRecord {
+    u32 id;
+    u32 totalSize;
+    u64 timestamp;
+  };
+
+  struct sJITDumpCodeLoad {
+    sJITDumpRecord record;
+    u32 pid;
+    u32 tid;
+    u64 vma;
+    u64 codeAddress;
+    u64 codeSize;
+    u64 codeIndex;
+    // Followed by the name and the code bytes
+  };
+
+  // perf record -k mono timestamps samples with CLOCK_MONOTONIC
+  u64 monotonicNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+} // anonymous namespace
+#endif // __linux__
+
+JITPerfMap &JITPerfMap::Get() {
+  static JITPerfMap instance;
+  return instance;
+}
+
+JITPerfMap::~JITPerfMap() {
+#ifdef __linux__
+  if (dumpFile) {
+    const sJITDumpRecord close{ JITDUMP_CODE_CLOSE, sizeof(sJITDumpRecord), monotonicNs() };
+    fwrite(&close, sizeof(close), 1, dumpFile);
+    fclose(dumpFile);
+  }
+  if (dumpMarker) {
+    munmap(dumpMarker, sysconf(_SC_PAGESIZE));
+  }
+  if (mapFile) {
+    fclose(mapFile);
+  }
+#endif
+}
+
+bool JITPerfMap::Open() {
+#ifdef __linux__
+  const pid_t pid = getpid();
+
+  const std::string mapPath = fmt::format("/tmp/perf-{}.map", pid);
+  mapFile = fopen(mapPath.c_str(), "w");
+  if (!mapFile) {
+    LOG_ERROR(Xenon, "[JIT]: Unable to create '{}'.", mapPath);
+    return false;
+  }
+
+  const std::string dumpPath = fmt::format("/tmp/jit-{}.dump", pid);
+  dumpFile = fopen(dumpPath.c_str(), "w+");
+  if (!dumpFile) {
+    LOG_ERROR(Xenon, "[JIT]: Unable to create '{}', only writing '{}'.", dumpPath, mapPath);
+    return true;
+  }
+  // The mmap event of an executable mapping of the file is how perf record notices the dump
+  dumpMarker = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(dumpFile), 0);
+  if (dumpMarker == MAP_FAILED) {
+    dumpMarker = nullptr;
+    LOG_WARNING(Xenon, "[JIT]: Unable to map '{}', perf inject won't find it.", dumpPath);
+  }
+  const sJITDumpHeader header{ JITDUMP_MAGIC, JITDUMP_VERSION, sizeof(sJITDumpHeader), JITDUMP_ELF_MACHINE, 0,
+    static_cast<u32>(pid), monotonicNs(), 0 };
+  fwrite(&header, sizeof(header), 1, dumpFile);
+
+  LOG_INFO(Xenon, "[JIT]: Describing JIT code in '{}' and '{}'.", mapPath, dumpPath);
+  return true;
+#else
+  LOG_WARNING(Xenon, "[JIT]: perf maps are only available on Linux.");
+  return false;
+#endif
+}
+
+void JITPerfMap::RegisterCode(const void *code, u64 codeSize, const std::string &name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!opened) {
+    opened = true;
+    failed = !Open();
+  }
+  if (failed || !code || !codeSize) {
+    return;
+  }
+#ifdef __linux__
+  fmt::print(mapFile, "{:x} {:x} {}\n", reinterpret_cast<u64>(code), codeSize, name);
+  fflush(mapFile);
+
+  if (dumpFile) {
+    const sJITDumpCodeLoad load{
+      { JITDUMP_CODE_LOAD, static_cast<u32>(sizeof(sJITDumpCodeLoad) + name.size() + 1 + codeSize), monotonicNs() },
+      static_cast<u32>(getpid()), static_cast<u32>(syscall(SYS_gettid)),
+      reinterpret_cast<u64>(code), reinterpret_cast<u64>(code), codeSize, codeIndex++ };
+    fwrite(&load, sizeof(load), 1, dumpFile);
+    fwrite(name.c_str(), name.size() + 1, 1, dumpFile);
+    fwrite(code, codeSize, 1, dumpFile);
+    fflush(dumpFile);
+  }
+#endif
+}
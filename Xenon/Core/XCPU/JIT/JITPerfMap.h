@@ -0,0 +1,40 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <string>
+
+//
+// Describes JIT code to host profilers, so their samples land on guest blocks instead of anonymous memory.
+// Writes both formats Linux perf understands:
+// - /tmp/perf-<pid>.map, read by perf report directly.
+// - /tmp/jit-<pid>.dump (jitdump), which also carries the code bytes for annotation:
+//   perf record -k mono ...; perf inject --jit -i perf.data -o perf.jit.data; perf report -i perf.jit.data
+// Enabled with Config::debug.jitPerfMap. Only available on Linux.
+//
+class JITPerfMap {
+public:
+  static JITPerfMap &Get();
+
+  // Describes a newly emitted block. Thread safe, the PPUs compile concurrently.
+  void RegisterCode(const void *code, u64 codeSize, const std::string &name);
+
+private:
+  JITPerfMap() = default;
+  ~JITPerfMap();
+
+  // Opens both files on first use.
+  bool Open();
+
+  std::mutex mutex;
+  bool opened = false;
+  bool failed = false;
+  FILE *mapFile = nullptr;
+  FILE *dumpFile = nullptr;
+  // perf finds the jitdump through this mapping of it
+  void *dumpMarker = nullptr;
+  u64 codeIndex = 0;
+};
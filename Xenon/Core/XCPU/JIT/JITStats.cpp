@@ -0,0 +1,53 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "JITStats.h"
+
+#include "Base/Logging/Log.h"
+
+void sJITStats::Log(const std::string &owner) const {
+  const u64 compiled = blocksCompiled.Get();
+  if (!compiled) {
+    return;
+  }
+
+  const u64 hits = cacheHits.Get();
+  const u64 misses = cacheMisses.Get();
+  const u64 dispatched = dispatchedBlocks.Get();
+  const u64 linked = linkedBlocks.Get();
+  auto percent = [](u64 part, u64 total) { return total ? 100.0 * part / total : 0.0; };
+
+  LOG_INFO(Xenon, "[JIT]: {}: {} blocks compiled ({} failed), {} guest instrs, {:.2f} ms compiling ({:.1f} us per block)",
+    owner, compiled, blockBuildFailures.Get(), guestInstrsCompiled.Get(), compileTimeNs.Get() / 1e6,
+    compileTimeNs.Get() / 1e3 / compiled);
+  LOG_INFO(Xenon, "[JIT]: {}: {} KiB host code emitted, {} KiB live",
+    owner, hostCodeBytes.Get() / 1024, liveHostCodeBytes.Get() / 1024);
+  LOG_INFO(Xenon, "[JIT]: {}: Block cache {} hits / {} misses ({:.2f}% hits)",
+    owner, hits, misses, percent(hits, hits + misses));
+  LOG_INFO(Xenon, "[JIT]: {}: Block transitions {} dispatched / {} linked ({:.2f}% linked)",
+    owner, dispatched, linked, percent(linked, dispatched + linked));
+  LOG_INFO(Xenon, "[JIT]: {}: Blocks invalidated: {} TLB, {} hash mismatch, {} range, {} flush",
+    owner, Invalidations(eJITInvalidation::TLB), Invalidations(eJITInvalidation::HashMismatch),
+    Invalidations(eJITInvalidation::Range), Invalidations(eJITInvalidation::Flush));
+  if (hybridFallbacksCompiled.Get()) {
+    LOG_INFO(Xenon, "[JIT]: {}: Hybrid interpreter fallbacks: {} compiled, {} executed",
+      owner, hybridFallbacksCompiled.Get(), hybridFallbacksExecuted.Get());
+  }
+
+  std::string histogram;
+  for (u32 i = 0; i != JIT_COMPILE_HISTOGRAM_BUCKETS; ++i) {
+    const u64 count = compileTimeHistogram[i].Get();
+    if (!count) {
+      continue;
+    }
+    if (i == 0) {
+      histogram += fmt::format(" <1us:{}", count);
+    } else if (i == JIT_COMPILE_HISTOGRAM_BUCKETS - 1) {
+      histogram += fmt::format(" >={}us:{}", 1ULL << (i - 1), count);
+    } else {
+      histogram += fmt::format(" <{}us:{}", 1ULL << i, count);
+    }
+  }
+  LOG_INFO(Xenon, "[JIT]: {}: Compile times:{}", owner, histogram);
+}
@@ -0,0 +1,77 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <string>
+
+// Compile time histogram buckets. Bucket 0 is under 1us, bucket n is [2^(n-1), 2^n) us, the last one is everything above.
+#define JIT_COMPILE_HISTOGRAM_BUCKETS 16
+
+// Why JIT blocks were thrown away
+enum class eJITInvalidation : u8 {
+  TLB,          // tlbie / tlbiel of a page the block covers
+  HashMismatch, // Guest code changed under the block (real mode check)
+  Range,        // Explicit range invalidation
+  Flush,        // Whole cache flush
+  Count
+};
+
+// A counter with a single writer (the PPU thread owning the JIT) and any number of readers.
+// Counting is a plain load / add / store, no locked instructions.
+class JITCounter {
+public:
+  void operator++() { Add(1); }
+  void Add(u64 amount) { value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+  void Sub(u64 amount) { value.store(value.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed); }
+  void Set(u64 newValue) { value.store(newValue, std::memory_order_relaxed); }
+  u64 Get() const { return value.load(std::memory_order_relaxed); }
+  // JIT code increments it in place
+  u64 *Address() { return reinterpret_cast<u64 *>(&value); }
+private:
+  std::atomic<u64> value = 0;
+};
+static_assert(sizeof(JITCounter) == sizeof(u64), "JIT code increments counters as plain u64s");
+
+// PPU_JIT statistics, always collected.
+struct sJITStats {
+  // Compilation
+  JITCounter blocksCompiled;
+  JITCounter blockBuildFailures;
+  JITCounter guestInstrsCompiled;
+  JITCounter compileTimeNs;
+  JITCounter compileTimeHistogram[JIT_COMPILE_HISTOGRAM_BUCKETS];
+  // Host code, emitted in total and still in the cache
+  JITCounter hostCodeBytes;
+  JITCounter liveHostCodeBytes;
+
+  // Block cache lookups by the dispatcher
+  JITCounter cacheHits;
+  JITCounter cacheMisses;
+  // Block transitions, through the dispatcher or straight through a block link
+  JITCounter dispatchedBlocks;
+  JITCounter linkedBlocks;
+
+  // Blocks invalidated, by cause
+  JITCounter invalidations[static_cast<u8>(eJITInvalidation::Count)];
+
+  // Hybrid mode, instructions compiled as interpreter calls and how often those ran
+  JITCounter hybridFallbacksCompiled;
+  JITCounter hybridFallbacksExecuted;
+
+  void RecordCompileTime(u64 ns) {
+    compileTimeNs.Add(ns);
+    const u64 us = ns / 1000;
+    const u32 bucket = us ? std::bit_width(us) : 0;
+    ++compileTimeHistogram[bucket < JIT_COMPILE_HISTOGRAM_BUCKETS ? bucket : JIT_COMPILE_HISTOGRAM_BUCKETS - 1];
+  }
+
+  JITCounter &Invalidations(eJITInvalidation cause) { return invalidations[static_cast<u8>(cause)]; }
+  u64 Invalidations(eJITInvalidation cause) const { return invalidations[static_cast<u8>(cause)].Get(); }
+
+  // Logs everything, prefixed with the owner's name.
+  void Log(const std::string &owner) const;
+};
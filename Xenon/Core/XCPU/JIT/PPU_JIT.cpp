@@ -9,9 +9,13 @@
 #include "Core/XCPU/JIT/x86_64/JITEmitter_Helpers.h"
 #endif
 #include "Core/XCPU/Interpreter/PPCInterpreter.h"
+#ifdef ENABLE_INSTRUCTION_PROFILER
+#include "Core/XCPU/Interpreter/InstructionProfiler.h"
+#endif
 #include "Core/XCPU/PPU/PPCInternal.h"
 #include "Core/XCPU/XenonCPU.h"
 #include "Core/XCPU/PPU/PPU.h"
+#include "JITPerfMap.h"
 #include "PPU_JIT.h"
 
 //
@@ -28,6 +32,7 @@ PPU_JIT::PPU_JIT(PPU *ppu) :
 
 // Destructor
 PPU_JIT::~PPU_JIT() {
+  stats.Log(ppeState->ppuName);
   std::lock_guard<std::mutex> lock(jitCacheMutex);
   for (auto &[hash, block] : jitBlocksCache)
     block.reset();
@@ -107,7 +112,7 @@ void PPU_JIT::UnlinkBlocksTo(u64 targetAddr) {
   }
 }
 
-void PPU_JIT::InvalidateBlocksForRange(u64 startAddr, u64 endAddr) {
+void PPU_JIT::InvalidateBlocksForRange(u64 startAddr, u64 endAddr, eJITInvalidation cause) {
   constexpr u64 pageSize = 4096ULL; // 4k is the minimum page size, can be easily increased to match p bit of tlbie/l.
   if (startAddr >= endAddr) return;
 
@@ -143,6 +148,10 @@ void PPU_JIT::InvalidateBlocksForRange(u64 startAddr, u64 endAddr) {
 #ifdef JIT_DEBUG
       LOG_DEBUG(Xenon, "[JIT]: Invalidating block at {:#x} due to page invalidation range {:#x}-{:#x}", blkAddr, startAddr, endAddr);
 #endif
+      if (it->second) {
+        stats.Invalidations(cause).Add(1);
+        stats.liveHostCodeBytes.Sub(it->second->codeSize);
+      }
       // Release resources
       it->second.reset();
       jitBlocksCache.erase(it);
@@ -152,15 +161,17 @@ void PPU_JIT::InvalidateBlocksForRange(u64 startAddr, u64 endAddr) {
   }
 }
 
-void PPU_JIT::InvalidateBlockAt(u64 blockAddr) {
-  InvalidateBlocksForRange(blockAddr, blockAddr + 1);
+void PPU_JIT::InvalidateBlockAt(u64 blockAddr, eJITInvalidation cause) {
+  InvalidateBlocksForRange(blockAddr, blockAddr + 1, cause);
 }
 
-void PPU_JIT::InvalidateAllBlocks() {
+void PPU_JIT::InvalidateAllBlocks(eJITInvalidation cause) {
   std::lock_guard<std::mutex> lock(jitCacheMutex);
 #ifdef JIT_DEBUG
   LOG_DEBUG(Xenon, "[JIT]: Invalidating ALL JIT blocks");
 #endif
+  stats.Invalidations(cause).Add(jitBlocksCache.size());
+  stats.liveHostCodeBytes.Set(0);
   for (auto &p : jitBlocksCache) {
     p.second.reset();
   }
@@ -222,6 +233,7 @@ namespace JITOpcodeHashes {
 using namespace asmjit;
 // Builds a JIT block starting at the given address.
 std::shared_ptr<JITBlock> PPU_JIT::BuildJITBlock(u64 blockStartAddress, u64 maxBlockSize) {
+  const auto compileStart = std::chrono::steady_clock::now();
   std::unique_ptr<JITBlockBuilder> jitBuilder = std::make_unique<STRIP_UNIQUE(jitBuilder)>(blockStartAddress, &jitRuntime);
 
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
@@ -317,6 +329,17 @@ std::shared_ptr<JITBlock> PPU_JIT::BuildJITBlock(u64 blockStartAddress, u64 maxB
     // Setup our instruction prologue.
     InstrPrologue(jitBuilder.get(), opcode);
 
+#if defined(ENABLE_INSTRUCTION_PROFILER) && (defined(ARCH_X86) || defined(ARCH_X86_64))
+    // Count the instruction every time the block runs, in the same counters the interpreter uses.
+    // Blocks are built and run on one core, so a plain increment is enough.
+    {
+      x86::Gp counter = compiler.newGpq();
+      compiler.mov(counter, reinterpret_cast<u64>(
+        PPCInterpreter::InstructionProfiler::Get().GetCounterAddress(ppeState->ppuID, decodedInstr)));
+      compiler.inc(x86::qword_ptr(counter));
+    }
+#endif
+
     // Check for ocurred Instruction access exceptions.
     if (opcode == 0xFFFFFFFF || opcode == 0xCDCDCDCD || opcode == 0x00000000) {
       instrDataValid = false;
@@ -373,8 +396,13 @@ std::shared_ptr<JITBlock> PPU_JIT::BuildJITBlock(u64 blockStartAddress, u64 maxB
       // If the instruction is invalid and we're in hybrid mode, call the interpreter decoder and function lookup.
       if (ppu->currentExecMode == eExecutorMode::Hybrid && invalidInstr) {
         auto function = PPCInterpreter::ppcDecoder.decode(opcode);
+        ++stats.hybridFallbacksCompiled;
 
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
+        x86::Gp fallbackCounter = compiler.newGpq();
+        compiler.mov(fallbackCounter, reinterpret_cast<u64>(stats.hybridFallbacksExecuted.Address()));
+        compiler.inc(x86::qword_ptr(fallbackCounter));
+
         InvokeNode *out = nullptr;
         compiler.invoke(&out, imm((void *)function), FuncSignature::build<void, void *>());
         out->setArg(0, jitBuilder->ppeState->Base());
@@ -456,10 +484,24 @@ std::shared_ptr<JITBlock> PPU_JIT::BuildJITBlock(u64 blockStartAddress, u64 maxB
   // Create the final JITBlock
   std::shared_ptr<JITBlock> block = std::make_shared<STRIP_UNIQUE(block)>(&jitRuntime, blockStartAddress, jitBuilder.get());
   if (!block->Build()) {
+    ++stats.blockBuildFailures;
     block.reset();
     return nullptr; // Block build failed.
   }
 
+  ++stats.blocksCompiled;
+  stats.guestInstrsCompiled.Add(instrCount);
+  stats.hostCodeBytes.Add(block->codeSize);
+  stats.liveHostCodeBytes.Add(block->codeSize);
+  stats.RecordCompileTime(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - compileStart).count());
+
+  // Tell host profilers what this code is.
+  if (Config::debug.jitPerfMap) {
+    JITPerfMap::Get().RegisterCode(reinterpret_cast<const void *>(block->codePtr), block->codeSize,
+      fmt::format("{}_0x{:08X}_{}instrs", ppeState->ppuName, blockStartAddress, instrCount));
+  }
+
   // Create block hash
   u64 hash = 0;
   for (const auto &instr : instrsTemp) { hash += instr; }
@@ -507,9 +549,16 @@ u64 PPU_JIT::ExecuteJITBlock(u64 blockStartAddress, bool enableHalt) {
   return block->size / 4;
 }
 
+// Records a block entry in the binary trace, if one is being written
+static inline void traceJITBlock(sPPEState *ppeState, const JITBlock *block) {
+  if (ppeState->traceWriter) [[unlikely]] {
+    ppeState->traceWriter->JITBlock(ppeState->currentThread, block->ppuAddress, static_cast<u32>(block->size / 4));
+  }
+}
+
 // Execute a given number of instructions using JIT.
-void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool singleBlock) {
-  u32 instrsExecuted = 0;
+u64 PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool singleBlock) {
+  u64 instrsExecuted = 0;
   while (instrsExecuted < numInstrs && active && (XeRunning && !XePaused)) {
     auto &thread = curThread;
 
@@ -537,14 +586,18 @@ void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool
 
     // Get next block start address.
     u64 blockStartAddress = thread.NIA;
+    ppu->CheckPCWatch(blockStartAddress);
     // Attempt to find such block in the block cache.
     auto it = jitBlocksCache.find(blockStartAddress);
     if (it == jitBlocksCache.end()) {
+      ++stats.cacheMisses;
       // Block was not found. Attempt to create a new one.
       auto block = BuildJITBlock(blockStartAddress, numInstrs - instrsExecuted);
       if (!block) { continue; } // Block build attempt failed.
 
       // Execute our block and increse executed instructions.
+      ++stats.dispatchedBlocks;
+      traceJITBlock(ppeState, block.get());
       block->codePtr(ppu, ppeState, enableHalt);
       instrsExecuted += block->size / 4;
 
@@ -584,6 +637,8 @@ void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool
           LOG_DEBUG(Xenon, "[JIT]: Block hash mismatch for block at address {:#x}", blockStartAddress);
 #endif // JIT_DEBUG
           // Blocks do not match. Erase it and retry.
+          stats.Invalidations(eJITInvalidation::HashMismatch).Add(1);
+          stats.liveHostCodeBytes.Sub(block->codeSize);
           block.reset();
           // Clean up page index mapping
           UnregisterBlock(blockStartAddress);
@@ -594,6 +649,9 @@ void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool
 
       // Run block as usual.
       JITBlock *currentBlock = it->second.get();
+      ++stats.cacheHits;
+      ++stats.dispatchedBlocks;
+      traceJITBlock(ppeState, currentBlock);
       currentBlock->codePtr(ppu, ppeState, enableHalt);
       instrsExecuted += currentBlock->size / 4;
 
@@ -617,7 +675,10 @@ void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool
         }
 
         // Execute linked block
+        ++stats.linkedBlocks;
         currentBlock = currentBlock->linkedBlock;
+        ppu->CheckPCWatch(currentBlock->ppuAddress);
+        traceJITBlock(ppeState, currentBlock);
         currentBlock->codePtr(ppu, ppeState, enableHalt);
         instrsExecuted += currentBlock->size / 4;
       }
@@ -632,4 +693,5 @@ void PPU_JIT::ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt, bool
       }
     }
   }
+  return instrsExecuted;
 }
@@ -25,6 +25,8 @@
 #include "Core/XCPU/PPU/PowerPC.h"
 #include "Core/RootBus/RootBus.h"
 
+#include "JITStats.h"
+
 //#define JIT_DEBUG
 
 class PPU;
@@ -237,16 +239,20 @@ public:
   PPU_JIT(PPU *ppu);
   ~PPU_JIT();
 
-  void ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt = true, bool singleBlock = false);
+  // Returns the amount of guest instructions executed
+  u64 ExecuteJITInstrs(u64 numInstrs, bool active, bool enableHalt = true, bool singleBlock = false);
   u64 ExecuteJITBlock(u64 blockStartAddress, bool enableHalt); // returns step count
   std::shared_ptr<JITBlock> BuildJITBlock(u64 blockStartAddress, u64 maxBlockSize);
   void SetupContext(JITBlockBuilder *b);
   void InstrPrologue(JITBlockBuilder *b, u32 instrData);
 
   // Page based indexing and invalidation methods.
-  void InvalidateBlocksForRange(u64 startAddr, u64 endAddr);
-  void InvalidateBlockAt(u64 blockAddr);
-  void InvalidateAllBlocks();
+  void InvalidateBlocksForRange(u64 startAddr, u64 endAddr, eJITInvalidation cause = eJITInvalidation::Range);
+  void InvalidateBlockAt(u64 blockAddr, eJITInvalidation cause = eJITInvalidation::Range);
+  void InvalidateAllBlocks(eJITInvalidation cause = eJITInvalidation::Flush);
+
+  // Statistics, readable from any thread.
+  const sJITStats &GetStats() const { return stats; }
 
 private:
   PPU *ppu = nullptr; // "Linked" PPU
@@ -261,6 +267,8 @@ private:
   std::unordered_map<u64, std::vector<u64>> blockPageList = {};
   // Mutex for thread safety.
   std::mutex jitCacheMutex;
+  // Counters, written by the PPU thread.
+  sJITStats stats{};
   // Internal helpers for page based indexing.
   void RegisterBlockPages(u64 blockStart, u64 blockSize);
   void UnregisterBlock(u64 blockStart);
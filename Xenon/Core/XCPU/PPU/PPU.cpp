@@ -19,14 +19,6 @@
 PPU::PPU(Xe::XCPU::XenonContext *inXenonContext, u64 resetVector, u32 PIR) :
   resetVector(resetVector)
 {
-  traceFile = nullptr;
-#ifdef DEBUG_BUILD
-  if (Config::debug.createTraceFile) {
-    char path[128];
-    snprintf(path, 127, "trace_%d.log", PIR);
-    traceFile = fopen(path, "w");
-  }
-#endif
   u32 executionMode = Base::JoaatStringHash(Config::highlyExperimental.cpuExecutor);
   switch (executionMode) {
   case "Interpreted"_jLower:
@@ -124,13 +116,29 @@ PPU::~PPU() {
   // Signal we're quitting
   ppuThreadState.store(eThreadState::Quiting);
   ppuThreadActive = false;
+  // Let it go if it's parked
+  Unpark();
   // Kill the thread
   if (ppuThread.joinable())
     ppuThread.join();
+  if (ppeState && xenonContext) {
+    for (u8 thrdID = 0; thrdID < 2; thrdID++) {
+      xenonContext->xenonRes.Unregister(ppeState->ppuThread[static_cast<ePPUThreadID>(thrdID)].ppuRes.get());
+    }
+  }
+  // Flushes what's left of the trace
+  SetTraceWriter(nullptr);
   ppuJIT.reset();
   ppeState.reset();
 }
 
+void PPU::SetTraceWriter(std::unique_ptr<Xe::XCPU::TraceWriter> writer) {
+  traceWriter = std::move(writer);
+  if (ppeState) {
+    ppeState->traceWriter = traceWriter.get();
+  }
+}
+
 void PPU::StartExecution(bool setHRMOR) {
   // If we want to start halted, then set the state
   if (Config::debug.startHalted) {
@@ -158,9 +166,9 @@ void PPU::StartExecution(bool setHRMOR) {
 
   // Check for instruction tests.
   if (Config::xcpu.runInstrTests && ppeState->ppuID == 0) {
-    LOG_INFO(Xenon, "Starting PowerPC instruction tests. Testing backend: {}",
-      Config::xcpu.instrTestsMode ? "JITx86" : "Interpreter");
-    RunInstructionTests(ppeState.get(), ppuJIT.get(), static_cast<ePPUTestingMode>(Config::xcpu.instrTestsMode));
+    const ePPUTestingMode testMode = static_cast<ePPUTestingMode>(Config::xcpu.instrTestsMode);
+    LOG_INFO(Xenon, "Starting PowerPC instruction tests. Testing backend: {}", GetTestingModeName(testMode));
+    RunInstructionTests(testMode);
   }
 
   // If we're PPU0,thread0 then enable THRD 0 and set Reset Vector.
@@ -234,11 +242,17 @@ void PPU::Step(int amount) {
 void PPU::PPURunInstructions(u64 numInstrs, bool enableHalt) {
   // Start Profile
   MICROPROFILE_SCOPEI("[Xe::PPU]", "PPURunInstructions", MP_AUTO);
+  u64 retired = 0;
+  // Execution milestone, read once per slice so unarmed runs don't load it every instruction
+  const u64 pcWatch = xenonContext->pcWatch.load(std::memory_order_relaxed);
   for (size_t instrCount = 0; instrCount < numInstrs && ppuThreadActive; ++instrCount) {
     // Halt if needed before executing the next instruction
     if (enableHalt && ppuHaltOn == curThread.NIA) {
       Halt();
     }
+    if (pcWatch && pcWatch == curThread.NIA) [[unlikely]] {
+      PCWatchReached(pcWatch);
+    }
 
     // Read next instruction
     bool readNextInstr = false;
@@ -248,16 +262,19 @@ void PPU::PPURunInstructions(u64 numInstrs, bool enableHalt) {
       readNextInstr = PPUReadNextInstruction();
     }
     if (readNextInstr) {
-#ifdef DEBUG_BUILD
-      if (traceFile) {
-        const std::string instrName = PPCInterpreter::PPCInterpreter_getFullName(_instr.opcode);
-        fprintf(traceFile, "%llx: 0x%x %s\n", curThread.CIA, _instr.opcode, instrName.c_str());
+      Xe::XCPU::TraceWriter *trace = ppeState->traceWriter;
+      const u8 thread = ppeState->currentThread;
+      if (trace) [[unlikely]] {
+        trace->Instr(thread, curThread.CIA, _instr.opcode);
       }
-#endif
       // Start Profile
       MICROPROFILE_SCOPEI("[Xe::PPU]", "ExecuteSingleInstruction", MP_AUTO);
       // Execute instruction
       PPCInterpreter::ppcExecuteSingleInstruction(ppeState.get());
+      ++retired;
+      if (trace && trace->TracesGPRs()) [[unlikely]] {
+        trace->GPRDeltas(thread, ppeState->ppuThread[thread].GPR);
+      }
     }
 
     // Handle pending exceptions
@@ -271,6 +288,16 @@ void PPU::PPURunInstructions(u64 numInstrs, bool enableHalt) {
     if ((enableHalt && ppuThreadState == eThreadState::Halted) || ppuThreadState == eThreadState::Resetting)
       break;
   }
+  RetireInstrs(retired);
+}
+
+// Slow path of CheckPCWatch, only the first thread to get there records the time
+void PPU::PCWatchReached(u64 watch) {
+  if (xenonContext->pcWatch.compare_exchange_strong(watch, 0, std::memory_order_relaxed)) {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    xenonContext->pcWatchHitTime.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(),
+      std::memory_order_release);
+  }
 }
 
 // PPU Thread state machine, handles all execution and codeflow
@@ -303,12 +330,12 @@ void PPU::ThreadStateMachine() {
       if (!ppuThreadResetting && (state & ePPUThreadBit_Zero)) {
         // Thread 1 is running, process instructions until we reach TTR timeout.
         curThreadId = ePPUThread_Zero;
-        ppuJIT->ExecuteJITInstrs(ppeState->SPR.TTR.hexValue, ppuThreadActive, ppuHaltOn != 0);
+        RetireInstrs(ppuJIT->ExecuteJITInstrs(ppeState->SPR.TTR.hexValue, ppuThreadActive, ppuHaltOn != 0));
       }
       if (!ppuThreadResetting && (state & ePPUThreadBit_One)) {
         // Thread 1 is running, process instructions until we reach TTR timeout.
         curThreadId = ePPUThread_One;
-        ppuJIT->ExecuteJITInstrs(ppeState->SPR.TTR.hexValue, ppuThreadActive, ppuHaltOn != 0);
+        RetireInstrs(ppuJIT->ExecuteJITInstrs(ppeState->SPR.TTR.hexValue, ppuThreadActive, ppuHaltOn != 0));
       }
     }
   } break;
@@ -336,14 +363,14 @@ void PPU::ThreadStateMachine() {
       if (state & ePPUThreadBit_Zero) {
         curThreadId = ePPUThread_Zero;
         if (ppuStepAmount > 0) {
-          ppuJIT->ExecuteJITInstrs(ppuStepAmount, ppuThreadActive, false);
+          RetireInstrs(ppuJIT->ExecuteJITInstrs(ppuStepAmount, ppuThreadActive, false));
           ppuStepAmount = 0; // Ensure step mode doesn't continue indefinitely
         }
       }
       if (state & ePPUThreadBit_One) {
         curThreadId = ePPUThread_One;
         if (ppuStepAmount > 0) {
-          ppuJIT->ExecuteJITInstrs(ppuStepAmount, ppuThreadActive, false);
+          RetireInstrs(ppuJIT->ExecuteJITInstrs(ppuStepAmount, ppuThreadActive, false));
           ppuStepAmount = 0; // Ensure step mode doesn't continue indefinitely
         }
       }
@@ -375,7 +402,18 @@ void PPU::ThreadLoop() {
   // Set thread name
   if (ppeState.get())
     Base::SetCurrentThreadName("[Xe] " + ppeState->ppuName);
+  // Guest memory accesses from this thread get traced into this core's writer
+  Xe::XCPU::tracingPPE = ppeState.get();
   while (ppuThreadActive) {
+    // Parked for a save state, in between time slices
+    if (parkRequested.load(std::memory_order_acquire)) {
+      std::unique_lock lock(parkMutex);
+      parked = true;
+      parkCV.notify_all();
+      parkCV.wait(lock, [this] { return !parkRequested.load() || !ppuThreadActive; });
+      parked = false;
+      continue;
+    }
     // Start Profile
     MICROPROFILE_SCOPEI("[Xe::PPU]", "ThreadLoop", MP_AUTO);
     // Run state machine
@@ -393,6 +431,67 @@ void PPU::ThreadLoop() {
   ppuThreadActive = false;
 }
 
+void PPU::RequestPark() {
+  std::lock_guard lock(parkMutex);
+  parkRequested = true;
+}
+
+bool PPU::WaitParked(std::chrono::milliseconds timeout) {
+  std::unique_lock lock(parkMutex);
+  // Not started yet, it parks before running anything
+  if (!ppuThread.joinable())
+    return true;
+  return parkCV.wait_for(lock, timeout, [this] { return parked || !ppuThreadActive; });
+}
+
+void PPU::Unpark() {
+  {
+    std::lock_guard lock(parkMutex);
+    parkRequested = false;
+  }
+  parkCV.notify_all();
+}
+
+void PPU::SerializeState(Xe::SaveState::StateStream &stream) {
+  if (!ppeState)
+    return;
+  for (u8 thrdID = 0; thrdID < 2; thrdID++) {
+    sPPUThread &thread = ppeState->ppuThread[static_cast<ePPUThreadID>(thrdID)];
+    stream.Do(thread.PIA, thread.CIA, thread.NIA, thread.CI, thread.instrFetch, thread.GPR, thread.FPR, thread.SPR,
+      thread.VR, thread.CR, thread.FPSCR, thread.VSCR, thread.SLB, thread.iERAT, thread.dERAT, thread.exceptReg,
+      thread.progExceptionType, thread.exHVSysCall);
+    // Reservation, the context counts the valid ones
+    PPU_RES *res = thread.ppuRes.get();
+    bool resValid = res->valid;
+    u64 resAddr = res->reservedAddr;
+    stream.Do(resValid, resAddr);
+    if (stream.IsLoading() && !stream.Failed()) {
+      xenonContext->xenonRes.LockGuard([&] {
+        if (res->valid)
+          xenonContext->xenonRes.Decrement();
+        if (resValid)
+          xenonContext->xenonRes.Increment();
+        res->reservedAddr = resAddr;
+        res->valid = resValid;
+      });
+    }
+  }
+  stream.Do(ppeState->currentThread, ppeState->SPR, ppeState->TLB);
+
+  // Executing only lasts for a slice, it goes back to Running
+  eThreadState state = ppuThreadState.load();
+  eThreadState previousState = ppuThreadPreviousState.load();
+  if (state == eThreadState::Executing)
+    state = eThreadState::Running;
+  stream.Do(state, previousState, guestHalt);
+  if (stream.IsLoading() && !stream.Failed()) {
+    ppuThreadState.store(state);
+    ppuThreadPreviousState.store(previousState);
+    // Blocks were compiled from the code the state replaced
+    ppuJIT->InvalidateAllBlocks();
+  }
+}
+
 // Returns a pointer to the specified thread.
 sPPUThread *PPU::GetPPUThread(u8 thrdID) {
   return &ppeState->ppuThread[static_cast<ePPUThreadID>(thrdID)];
@@ -656,6 +755,9 @@ bool PPU::PPUCheckExceptions() {
   MICROPROFILE_SCOPEI("[Xe::PPU]", "CheckExceptions", MP_AUTO);
   // Check Exceptions pending and process them in order.
   u16 &exceptions = _ex;
+  if (ppeState->traceWriter) [[unlikely]] {
+    ppeState->traceWriter->Exception(ppeState->currentThread, thread.CIA, exceptions);
+  }
   if (exceptions != ppuNone) {
     // Exceptions are pending, check and process them in order.
 
@@ -4,12 +4,17 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 
 #include "PowerPC.h"
 #include "Core/XCPU/Context/XenonContext.h"
 #include "Core/RootBus/RootBus.h"
 #include "Core/XCPU/MMU/XenonMMU.h"
+#include "Core/XCPU/Trace/TraceRecorder.h"
+#include "Core/SaveState/StateStream.h"
 
 class PPU_JIT;
 
@@ -34,10 +39,20 @@ enum class eThreadState : u8 {
 
 // Current 'testing' mode. Used for execution backend testing.
 enum class ePPUTestingMode : u8 {
- Interpreter, // Regular interpreter mode
- JITx86,      // X86 JIT mode
+ Interpreter,  // Regular interpreter mode
+ JITx86,       // X86 JIT mode
+ Differential, // Both, the JIT's register state is diffed against the interpreter's
 };
 
+inline const char *GetTestingModeName(ePPUTestingMode mode) {
+  switch (mode) {
+  case ePPUTestingMode::Interpreter: return "Interpreter";
+  case ePPUTestingMode::JITx86: return "JITx86";
+  case ePPUTestingMode::Differential: return "Differential";
+  }
+  return "Unknown";
+}
+
 // Power Procesing Unit. Main execution unit inside the PPE's within the Xenon CPU.
 class PPU {
 public:
@@ -91,6 +106,8 @@ public:
   sPPEState *GetPPUState() { return ppeState.get(); }
   // Get ppuJIT
   PPU_JIT *GetPPUJIT() { return ppuJIT.get(); }
+  // Instructions retired on this PPU (both threads) since it was created
+  u64 GetRetiredInstrs() const { return retiredInstrs.load(std::memory_order_relaxed); }
 
   // Updates the current PPU's time base and decrementer based on
   // the amount of tb ticks given.
@@ -100,7 +117,18 @@ public:
   // Returns entrypoint
   u64 loadElfImage(u8 *data, u64 size);
 
-  FILE *traceFile;
+  // Save states. Parks the PPU thread between time slices, so its state can be read or replaced.
+  // A park requested before StartExecution() happens before the first instruction.
+  void RequestPark();
+  // Waits for the thread to park, false on timeout
+  bool WaitParked(std::chrono::milliseconds timeout);
+  void Unpark();
+  // Both threads, the shared SPRs and the TLB. Only while parked, a load drops every JIT block.
+  void SerializeState(Xe::SaveState::StateStream &stream);
+
+  // Attaches a binary trace writer (see Core/XCPU/Trace/TraceRecorder.h), nullptr detaches it.
+  // Only while the PPU thread isn't running.
+  void SetTraceWriter(std::unique_ptr<Xe::XCPU::TraceWriter> writer);
 
   eExecutorMode currentExecMode = eExecutorMode::Interpreter;
 private:
@@ -128,6 +156,15 @@ private:
   // Amount of instructions to step
   u64 ppuStepAmount = 0;
 
+  // Save state parking, see RequestPark()
+  std::atomic<bool> parkRequested = false;
+  bool parked = false;
+  std::mutex parkMutex;
+  std::condition_variable parkCV;
+
+  // Retired instruction counter, only written by the PPU thread
+  std::atomic<u64> retiredInstrs = 0;
+
   // Execution threads inside this PPU.
   std::unique_ptr<sPPEState> ppeState;
 
@@ -140,6 +177,9 @@ private:
   // Initial reset vector
   u32 resetVector = 0;
 
+  // Binary trace of this core, see Config::debug.createTraceFile
+  std::unique_ptr<Xe::XCPU::TraceWriter> traceWriter;
+
   //
   // Exceptions
   //
@@ -180,6 +220,18 @@ private:
   bool PPUCheckExceptions();
   // Gets the current running threads.
   u8 GetCurrentRunningThreads();
+  // Adds to the retired instruction counter
+  void RetireInstrs(u64 count) {
+    retiredInstrs.store(retiredInstrs.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+  }
+  // Checks the execution milestone, see XenonContext::pcWatch
+  void CheckPCWatch(u64 pc) {
+    const u64 watch = xenonContext->pcWatch.load(std::memory_order_relaxed);
+    if (watch && watch == pc) {
+      PCWatchReached(watch);
+    }
+  }
+  void PCWatchReached(u64 watch);
   // Simulates the behavior of the 1BL inside the Xenon Secure ROM.
   bool Simulate1Bl();
 
@@ -187,6 +239,6 @@ private:
   // Testing Utilities
   //
   
-  // Runs instruction tests on the desired backend.
-  bool RunInstructionTests(sPPEState* ppeState, PPU_JIT* ppuJITPtr, ePPUTestingMode testMode);
+  // Runs the instruction tests in Config::filepaths on the desired backend. See Testing.h.
+  bool RunInstructionTests(ePPUTestingMode testMode);
 };
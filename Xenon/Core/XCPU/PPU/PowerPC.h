@@ -13,6 +13,8 @@
 #include "Base/Vector128.h"
 #include "Core/XCPU/Context/Reservations/XenonReservations.h"
 
+namespace Xe::XCPU { class TraceWriter; }
+
 
 // PowerPC Opcode definitions
 /*
@@ -1428,6 +1430,8 @@ struct sPPEState {
   std::string ppuName{};
   // PPU ID
   u8 ppuID = 0;
+  // Binary trace of this core, nullptr when tracing is off. Owned by the PPU.
+  Xe::XCPU::TraceWriter *traceWriter = nullptr;
 };
 
 // Exception Bitmasks for Exception Register
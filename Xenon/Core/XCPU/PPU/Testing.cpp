@@ -3,21 +3,48 @@
 /***************************************************************/
 
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <random>
+#include <thread>
 #include "fmt/format.h"
 
+#include "Base/Config.h"
+#include "Base/Hash.h"
 #include "Base/PathUtil.h"
 #include "Base/StringUtil.h"
+#include "Base/Thread.h"
 #include "Core/XCPU/PPU/PPU.h"
+#include "Core/XCPU/PPU/Testing.h"
+#include "Core/XCPU/Interpreter/InstructionProfiler.h"
 #include "Core/XCPU/Interpreter/PPCInterpreter.h"
+#include "Core/XCPU/JIT/PPU_JIT.h"
 
 #define BLR_OPCODE 0x4e800020
 #define curThreadId   ppeState->currentThread
 #define curThread     ppeState->ppuThread[curThreadId]
 
 const u32 START_ADDRESS = 0x10000000;
+// Scratch RAM of every worker but the first starts this far from it, clear of the addresses MEMORY_IN/OUT use
+const u32 WORKER_SCRATCH_OFFSET = 0x01000000;
+// Guest RAM every worker loads its tests into
+const u32 WORKER_SCRATCH_SIZE = 0x100000;
+const u32 MAX_TEST_WORKERS = 64;
+// Instructions the interpreter runs before a test that never reaches its blr is given up on
+const u32 MAX_TEST_INSTRS = 0x10000;
+// Mismatching fuzz cases reported per opcode, the rest are only counted
+const u32 MAX_FUZZ_REPORTS = 8;
+// Instruction bits a fuzz case randomizes on top of its decoder slot: bits 11-25 (rD/rS/frD/vD, rA, rB).
+// The primary opcode (26-31) and bits 0-10 come from the slot, which is picked at random among every slot
+// decoding to the opcode, so those bits are covered too, over exactly the values that keep the opcode:
+// all of a D-form immediate, Rc/OE, the SH/MB/ME fields of M/MD-forms, the VMX128 register bits.
+// A case whose random bits land on a field the decoder also looks at, and turn it into another opcode, is retried.
+const u32 FUZZ_OPERAND_MASK = 0x03FFF800;
 
-std::filesystem::path testsPath;
 std::filesystem::path testsBinPath;
 
 typedef std::vector<std::pair<std::string, std::string>> AnnotationList;
@@ -93,6 +120,8 @@ bool DiscoverTests(const std::filesystem::path &testsPath,
       testFiles.push_back(testsPath / file.fileName);
     }
   }
+  // Suites are reported in the same order on every run
+  std::sort(testFiles.begin(), testFiles.end());
   return true;
 }
 
@@ -100,6 +129,15 @@ struct TestCase {
   TestCase(u32 execAddress, std::string &tstName)
     : executionAddress(execAddress), testName(tstName) {
   }
+  // Tests touching memory use absolute addresses, they can't be relocated to a worker's scratch RAM.
+  bool UsesMemory() const {
+    for (auto &it : testAnnotations) {
+      if (it.first == "MEMORY_IN" || it.first == "MEMORY_OUT") {
+        return true;
+      }
+    }
+    return false;
+  }
   u32 executionAddress;
   std::string testName;
   AnnotationList testAnnotations;
@@ -128,6 +166,9 @@ public:
         Base::FS::PathToUTF8String(sourceFilePath));
       return false;
     }
+    if (!ReadBinary()) {
+      return false;
+    }
     return true;
   }
 
@@ -135,6 +176,7 @@ public:
   const std::filesystem::path &inSourceFilePath() const { return sourceFilePath; }
   const std::filesystem::path &getMapFilePath() const { return mapFilePath; }
   const std::filesystem::path &getBinFilePath() const { return binFilePath; }
+  const std::vector<u8> &getBinary() const { return binary; }
   std::vector<TestCase> &getTestCases() { return testCases; }
 
 private:
@@ -143,6 +185,8 @@ private:
   std::filesystem::path mapFilePath;
   std::filesystem::path binFilePath;
   std::vector<TestCase> testCases;
+  // Test binary, loaded once and copied into every worker that runs the suite
+  std::vector<u8> binary;
 
   TestCase *FindTestCase(const std::string_view name) {
     for (auto &testCase : testCases) {
@@ -229,102 +273,289 @@ private:
     fclose(f);
     return true;
   }
+
+  bool ReadBinary() {
+    std::ifstream file(binFilePath, std::ios_base::in | std::ios_base::binary);
+    if (!file.is_open()) {
+      LOG_CRITICAL(Xenon, "[Testing]: Unable to open file: {} for reading. Check your file path.", binFilePath.string());
+      return false;
+    }
+    u64 fileSize = 0;
+    // fs::file_size can cause a exception if it is not a valid file
+    try {
+      std::error_code ec;
+      fileSize = std::filesystem::file_size(binFilePath, ec);
+      if (fileSize == -1 || !fileSize) {
+        LOG_ERROR(Base_Filesystem, "[Testing]: Failed to retrieve the file size of {} (Error: {})",
+          binFilePath.string(), ec.message());
+        return false;
+      }
+    } catch (const std::exception &ex) {
+      LOG_ERROR(Base_Filesystem, "[Testing]: Exception trying to get file size. Reason: {}", ex.what());
+      return false;
+    }
+    if (fileSize > WORKER_SCRATCH_SIZE) {
+      LOG_ERROR(Xenon, "[Testing]: {} is {:#x} bytes, larger than the {:#x} bytes of scratch RAM a worker has.",
+        binFilePath.string(), fileSize, WORKER_SCRATCH_SIZE);
+      return false;
+    }
+    binary.resize(fileSize);
+    file.read(reinterpret_cast<char*>(binary.data()), fileSize);
+    return true;
+  }
+};
+
+// User visible register state the backends are compared on.
+// NIA is left out: the interpreter stops in front of the final blr, while JIT blocks execute it.
+struct sRegisterState {
+  u64 GPR[32];
+  u64 FPR[32];
+  Base::Vector128 VR[128];
+  u32 CR;
+  u32 XER;
+  u32 FPSCR;
+  u32 VSCR;
+  u64 LR;
+  u64 CTR;
+
+  void Capture(sPPUThread &thread) {
+    for (u32 i = 0; i != 32; ++i) {
+      GPR[i] = thread.GPR[i];
+      FPR[i] = thread.FPR[i].asU64();
+    }
+    for (u32 i = 0; i != 128; ++i) {
+      VR[i] = thread.VR[i];
+    }
+    CR = thread.CR.CR_Hex;
+    XER = thread.SPR.XER.hexValue;
+    FPSCR = thread.FPSCR.FPSCR_Hex;
+    VSCR = thread.VSCR.hexValue;
+    LR = thread.SPR.LR;
+    CTR = thread.SPR.CTR;
+  }
+
+  void Restore(sPPUThread &thread) const {
+    for (u32 i = 0; i != 32; ++i) {
+      thread.GPR[i] = GPR[i];
+      thread.FPR[i].setValue(FPR[i]);
+    }
+    for (u32 i = 0; i != 128; ++i) {
+      thread.VR[i] = VR[i];
+    }
+    thread.CR.CR_Hex = CR;
+    thread.SPR.XER.hexValue = XER;
+    thread.FPSCR.FPSCR_Hex = FPSCR;
+    thread.VSCR.hexValue = VSCR;
+    thread.SPR.LR = LR;
+    thread.SPR.CTR = CTR;
+  }
+};
+
+// Adds a line for every register the JIT left different from the interpreter.
+void DiffRegisterStates(const sRegisterState &interpreter, const sRegisterState &jit, std::vector<std::string> &diffs) {
+  auto diff = [&diffs](const std::string &regName, u64 interpreterValue, u64 jitValue) {
+    if (interpreterValue != jitValue) {
+      diffs.push_back(FMT("{}: Interpreter {:016X}, JIT {:016X}", regName, interpreterValue, jitValue));
+    }
+  };
+  for (u32 i = 0; i != 32; ++i) {
+    diff(FMT("r{}", i), interpreter.GPR[i], jit.GPR[i]);
+  }
+  for (u32 i = 0; i != 32; ++i) {
+    diff(FMT("f{}", i), interpreter.FPR[i], jit.FPR[i]);
+  }
+  for (u32 i = 0; i != 128; ++i) {
+    const Base::Vector128 &a = interpreter.VR[i];
+    const Base::Vector128 &b = jit.VR[i];
+    if (a != b) {
+      diffs.push_back(FMT("v{}: Interpreter [{:08X}, {:08X}, {:08X}, {:08X}], JIT [{:08X}, {:08X}, {:08X}, {:08X}]", i,
+        a.dword[0], a.dword[1], a.dword[2], a.dword[3], b.dword[0], b.dword[1], b.dword[2], b.dword[3]));
+    }
+  }
+  diff("cr", interpreter.CR, jit.CR);
+  diff("xer", interpreter.XER, jit.XER);
+  diff("fpscr", interpreter.FPSCR, jit.FPSCR);
+  diff("vscr", interpreter.VSCR, jit.VSCR);
+  diff("lr", interpreter.LR, jit.LR);
+  diff("ctr", interpreter.CTR, jit.CTR);
+}
+
+// An opcode the fuzzer generates cases for.
+struct sFuzzOpcode {
+  std::string name;
+  // Decoder slots that decode to it and have a JIT emitter (Rc/OE forms, immediates overlapping extended opcodes)
+  std::vector<u32> slots;
+};
+
+// Outcome of a test case (a fuzzed opcode when fuzzing).
+struct sTestCaseResult {
+  bool skipped = false;
+  std::string skipReason;
+  std::vector<std::string> failures;
+  // Cases executed, one per test, the iterations that ran when fuzzing
+  u32 cases = 0;
+  // Host time spent executing on each backend, JIT compile time excluded
+  u64 interpreterNs = 0;
+  u64 jitNs = 0;
+  u64 jitCompileNs = 0;
+
+  bool Passed() const { return !skipped && failures.empty(); }
+};
+
+struct sTestJob {
+  // Suite name, "fuzz" when fuzzing
+  std::string suiteName;
+  // Test case name, the opcode when fuzzing
+  std::string caseName;
+  // Timing is grouped by this: the suite (every suite tests one opcode), or the fuzzed opcode
+  std::string opcodeName;
+  TestSuite *suite = nullptr;
+  TestCase *testCase = nullptr;
+  const sFuzzOpcode *fuzzOpcode = nullptr;
+  sTestCaseResult result;
 };
 
 class TestRunner {
 public:
-  TestRunner(sPPEState *ppeStatePtr, PPU_JIT* ppuJITPtr, ePPUTestingMode testMode)
-    : ppeState(ppeStatePtr), currentTestMode(testMode), ppuJIT(ppuJITPtr) {
+  TestRunner(PPU *ppuPtr, u32 scratchAddress)
+    : ppeState(ppuPtr->GetPPUState()), ppuJIT(ppuPtr->GetPPUJIT()), scratchBase(scratchAddress) {
   }
 
   ~TestRunner() {}
 
   bool Setup(TestSuite &suite) {
-    // Clear the RAM area at tests load address.
-    PPCInterpreter::MMUMemSet(ppeState, START_ADDRESS, 0x00000000, 0x1000);
+    const std::vector<u8> &binary = suite.getBinary();
+    // Clear the scratch RAM the tests get loaded to.
+    PPCInterpreter::MMUMemSet(ppeState, scratchBase, 0x00000000, std::max<u64>(binary.size(), 0x1000));
 
     // Load the test binary into RAM.
-    std::vector<u8> testBinData;
-    std::ifstream file(suite.getBinFilePath(), std::ios_base::in | std::ios_base::binary);
-    if (!file.is_open()) {
-      LOG_CRITICAL(Xenon, "[Testing]: Unable to open file: {} for reading. Check your file path.", suite.getBinFilePath().string());
-      return false;
-    } else {
-      u64 fileSize = 0;
-      // fs::file_size can cause a exception if it is not a valid file
-      try {
-        std::error_code ec;
-        fileSize = std::filesystem::file_size(suite.getBinFilePath(), ec);
-        if (fileSize == -1 || !fileSize) {
-          fileSize = 0;
-          LOG_ERROR(Base_Filesystem, "[Testing]: Failed to retrieve the file size of {} (Error: {})", 
-            suite.getBinFilePath().string(), ec.message());
-        }
-      } catch (const std::exception &ex) {
-        LOG_ERROR(Base_Filesystem, "[Testing]: Exception trying to get file size. Reason: {}", ex.what());
+    PPCInterpreter::MMUMemCpyFromHost(ppeState, scratchBase, binary.data(), binary.size());
+    return true;
+  }
+
+  bool Run(ePPUTestingMode testMode, TestSuite &suite, TestCase &testCase, sTestCaseResult &result) {
+    // Tests are assembled at START_ADDRESS, only use PC relative branches and can run from anywhere.
+    const u32 address = scratchBase + (testCase.executionAddress - START_ADDRESS);
+
+    if (testMode != ePPUTestingMode::Differential) {
+      if (!SetupTestState(testCase, address)) {
+        result.failures.push_back("Test setup failed");
         return false;
       }
-      testBinData.resize(fileSize);
-      file.read(reinterpret_cast<char*>(testBinData.data()), XE_SROM_SIZE);
-      for (int idx = 0; idx < fileSize; ++idx) {
-        PPCInterpreter::MMUWrite8(ppeState, START_ADDRESS + idx, testBinData[idx]);
+      if (!Execute(testMode, address, result)) {
+        return false;
       }
+      CheckTestResults(testCase, GetTestingModeName(testMode), result.failures);
+      return result.failures.empty();
     }
-    file.close();
-    return true;
-  }
 
-  bool Run(TestCase &testCase) {
-    // Setup test state from annotations.
-    if (!SetupTestState(testCase)) {
-      LOG_ERROR(Xenon, "[Testing]: Test setup failed");
+    // Differential: both backends from the same state, their expectations checked and their results diffed.
+    sRegisterState interpreterState{}, jitState{};
+    if (!SetupTestState(testCase, address) || !Execute(ePPUTestingMode::Interpreter, address, result)) {
       return false;
     }
+    CheckTestResults(testCase, "Interpreter", result.failures);
+    interpreterState.Capture(curThread);
 
-    // Execute test.
-    if (currentTestMode == ePPUTestingMode::Interpreter) {
-      bool testRunning = true;
-      while (testRunning) {
-        sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
-        // Update previous instruction address
-        thread.PIA = thread.CIA;
-        // Update current instruction address
-        thread.CIA = thread.NIA;
-        // Increase next instruction address
-        thread.NIA += 4;
-        // Fetch the instruction from memory
-        thread.CI.opcode = PPCInterpreter::MMURead32(ppeState, thread.CIA, ppeState->currentThread);
-        if (thread.CI.opcode == 0xFFFFFFFF || thread.CI.opcode == 0xCDCDCDCD) {
-          LOG_CRITICAL(Xenon, "[Testing]: Invalid opcode found.");
-          return false;
-        }
+    // Restore the binary too, tests can write to it.
+    Setup(suite);
+    if (!SetupTestState(testCase, address) || !Execute(ePPUTestingMode::JITx86, address, result)) {
+      return false;
+    }
+    CheckTestResults(testCase, "JITx86", result.failures);
+    jitState.Capture(curThread);
 
-        if (_ex & ppuInstrStorageEx || _ex & ppuInstrSegmentEx) {
-          return false;
-        }
+    std::vector<std::string> diffs;
+    DiffRegisterStates(interpreterState, jitState, diffs);
+    for (auto &diff : diffs) {
+      result.failures.push_back("Backend mismatch: " + diff);
+    }
+    return result.failures.empty();
+  }
 
-        if (thread.CI.opcode == BLR_OPCODE) {
-          testRunning = false;
-        } else {
-          PPCInterpreter::ppcExecuteSingleInstruction(ppeState);
-        }
+  // Runs every fuzz iteration of an opcode on both backends.
+  void Fuzz(const sFuzzOpcode &opcode, const sInstrTestOptions &options, sTestCaseResult &result) {
+    // Seeded per opcode, so a case reproduces no matter which worker or in which order it runs.
+    std::mt19937_64 rng(options.fuzzSeed ^ Base::JoaatStringHash(opcode.name, false));
+    u32 mismatches = 0, unencodable = 0, excepted = 0;
+    for (u32 iteration = 0; iteration != options.fuzzIterations; ++iteration) {
+      // Random slot and operand fields (see FUZZ_OPERAND_MASK). Some forms use a few of those bits as extended
+      // opcode, so retry until it still decodes to the opcode being tested.
+      u32 instr = 0;
+      bool encoded = false;
+      for (u32 attempt = 0; attempt != 16 && !encoded; ++attempt) {
+        instr = PPCInterpreter::InstrSlotOpcode(opcode.slots[rng() % opcode.slots.size()]) |
+          (static_cast<u32>(rng()) & FUZZ_OPERAND_MASK);
+        encoded = PPCInterpreter::ppcDecoder.decodeName(instr) == opcode.name &&
+          PPCInterpreter::ppcDecoder.decodeJIT(instr) != &PPCInterpreter::PPCInterpreterJIT_invalid;
       }
-    } else if (currentTestMode == ePPUTestingMode::JITx86) {
-      ppuJIT->ExecuteJITInstrs(0x100, true, false, true);
-    }
+      if (!encoded) {
+        ++unencodable;
+        continue;
+      }
+      PPCInterpreter::MMUWrite32(ppeState, scratchBase, instr);
+      PPCInterpreter::MMUWrite32(ppeState, scratchBase + 4, BLR_OPCODE);
+
+      sRegisterState initialState{}, interpreterState{}, jitState{};
+      RandomizeState(rng);
+      initialState.Capture(curThread);
+
+      if (!Execute(ePPUTestingMode::Interpreter, scratchBase, result)) {
+        return;
+      }
+      // Exceptions leave through different paths on each backend, only plain results are compared.
+      if (curThread.exceptReg) {
+        ++excepted;
+        continue;
+      }
+      interpreterState.Capture(curThread);
 
+      initialState.Restore(curThread);
+      ResetExecutionState(scratchBase, true);
+      if (!Execute(ePPUTestingMode::JITx86, scratchBase, result)) {
+        return;
+      }
+      jitState.Capture(curThread);
+      ++result.cases;
 
-    // Assert test state expectations.
-    bool testResult = CheckTestResults(testCase);
-    if (!testResult) {
-      LOG_ERROR(Xenon, "[Testing]: Test result failed.");
+      std::vector<std::string> diffs;
+      DiffRegisterStates(interpreterState, jitState, diffs);
+      if (diffs.empty()) {
+        continue;
+      }
+      if (++mismatches > MAX_FUZZ_REPORTS) {
+        continue;
+      }
+      std::string report = FMT("Case {}: {:08X} ({})", iteration, instr, PPCInterpreter::PPCInterpreter_getFullName(instr));
+      for (auto &diff : diffs) {
+        report += "\n  " + diff;
+      }
+      result.failures.push_back(report);
+    }
+    if (mismatches > MAX_FUZZ_REPORTS) {
+      result.failures.push_back(FMT("{} more mismatching cases", mismatches - MAX_FUZZ_REPORTS));
     }
+    if (!result.cases) {
+      result.skipped = true;
+      result.skipReason = FMT("No case ran: {} unencodable, {} raised an exception", unencodable, excepted);
+    }
+  }
 
-    return testResult;
+private:
+  // Points the thread at a test and clears what the previous one left behind.
+  void ResetExecutionState(u32 address, bool sixtyFourBit) {
+    sPPUThread &thread = curThread;
+    thread.NIA = address;
+    thread.CIA = thread.PIA = 0;
+    thread.exceptReg = 0;
+    // Set MSR to allow FPU and VXU execution.
+    thread.SPR.MSR.FP = 1;
+    thread.SPR.MSR.VXU = 1;
+    thread.SPR.MSR.SF = sixtyFourBit;
   }
 
-  bool SetupTestState(TestCase &testCase) {
-    sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
+  bool SetupTestState(TestCase &testCase, u32 address) {
+    sPPUThread &thread = curThread;
     // Clear registers involved in tests.
     for (auto &reg : thread.GPR)
       reg = 0;
@@ -338,14 +569,12 @@ public:
     thread.CR.CR_Hex = 0;
     thread.SPR.XER.hexValue = 0;
     thread.FPSCR.FPSCR_Hex = 0;
+    thread.VSCR.hexValue = 0;
+    thread.SPR.LR = 0;
+    thread.SPR.CTR = 0;
 
-    // Set NIA for this test case.
-    thread.NIA = testCase.executionAddress;
-
-    // Set MSR to allow FPU and VXU execution.
-    thread.SPR.MSR.FP = 1;
-    thread.SPR.MSR.VXU = 1;
-    thread.SPR.MSR.SF = 0; // Tests in xenia were designed for 32-bit mode of operation.
+    // Tests in xenia were designed for 32-bit mode of operation.
+    ResetExecutionState(address, false);
 
     for (auto &it : testCase.testAnnotations) {
       if (it.first == "REGISTER_IN") {
@@ -357,8 +586,8 @@ public:
         size_t spacePos = it.second.find(" ");
         auto addressStr = it.second.substr(0, spacePos);
         auto bytesStr = it.second.substr(spacePos + 1);
-        u32 address = std::strtoul(addressStr.c_str(), nullptr, 16);
-        auto p = PPCInterpreter::MMUGetPointerFromRAM(address);
+        u32 memAddress = std::strtoul(addressStr.c_str(), nullptr, 16);
+        auto p = PPCInterpreter::MMUGetPointerFromRAM(memAddress);
         const char *c = bytesStr.c_str();
         while (*c) {
           while (*c == ' ') ++c;
@@ -376,8 +605,96 @@ public:
     return true;
   }
 
-  bool CheckTestResults(TestCase &testCase) {
-    bool any_failed = false;
+  // Random operands. Edge values come up far more often than uniformly random bits would give them.
+  void RandomizeState(std::mt19937_64 &rng) {
+    static constexpr u64 gprEdgeValues[] = {
+      0, 1, 0xFFFFFFFFFFFFFFFF, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0x7FFFFFFFFFFFFFFF, 0x8000000000000000
+    };
+    static constexpr u64 fprEdgeValues[] = {
+      0, 0x8000000000000000,                  // +-0
+      0x3FF0000000000000, 0xBFF0000000000000, // +-1
+      0x7FF0000000000000, 0xFFF0000000000000, // +-Inf
+      0x7FF8000000000000,                     // QNaN
+      0x0000000000000001                      // Denormal
+    };
+    std::uniform_real_distribution<f64> fprRange(-1.0e6, 1.0e6);
+
+    sPPUThread &thread = curThread;
+    for (auto &reg : thread.GPR) {
+      const u64 r = rng();
+      reg = (r & 7) == 0 ? gprEdgeValues[(r >> 3) & 7] : rng();
+    }
+    for (auto &reg : thread.FPR) {
+      const u64 r = rng();
+      switch (r & 3) {
+      case 0: reg.setValue(fprEdgeValues[(r >> 2) & 7]); break;
+      case 1: reg.setValue(static_cast<u64>(rng())); break;
+      default: reg.setValue(fprRange(rng)); break;
+      }
+    }
+    for (auto &reg : thread.VR) {
+      reg.qword[0] = rng();
+      reg.qword[1] = rng();
+    }
+    thread.CR.CR_Hex = static_cast<u32>(rng());
+    // SO, OV and CA
+    thread.SPR.XER.hexValue = static_cast<u32>(rng()) & 0xE0000000;
+    // Rounding mode only, enabled exceptions would divert into the program exception handler
+    thread.FPSCR.FPSCR_Hex = static_cast<u32>(rng()) & 0x3;
+    thread.VSCR.hexValue = 0;
+    thread.SPR.LR = 0;
+    thread.SPR.CTR = rng();
+    ResetExecutionState(scratchBase, true);
+  }
+
+  // Executes from the thread's NIA on one backend until the test's blr.
+  bool Execute(ePPUTestingMode backend, u32 address, sTestCaseResult &result) {
+    const auto start = std::chrono::steady_clock::now();
+    if (backend == ePPUTestingMode::Interpreter) {
+      for (u32 instrCount = 0;; ++instrCount) {
+        sPPUThread &thread = curThread;
+        // Update previous instruction address
+        thread.PIA = thread.CIA;
+        // Update current instruction address
+        thread.CIA = thread.NIA;
+        // Increase next instruction address
+        thread.NIA += 4;
+        // Fetch the instruction from memory
+        thread.CI.opcode = PPCInterpreter::MMURead32(ppeState, thread.CIA, ppeState->currentThread);
+        if (thread.CI.opcode == 0xFFFFFFFF || thread.CI.opcode == 0xCDCDCDCD) {
+          result.failures.push_back(FMT("Interpreter: Invalid opcode found at {:#x}", thread.CIA));
+          return false;
+        }
+
+        if (_ex & ppuInstrStorageEx || _ex & ppuInstrSegmentEx) {
+          result.failures.push_back(FMT("Interpreter: Instruction fetch exception at {:#x}", thread.CIA));
+          return false;
+        }
+
+        if (thread.CI.opcode == BLR_OPCODE) {
+          break;
+        }
+        if (instrCount == MAX_TEST_INSTRS) {
+          result.failures.push_back(FMT("Interpreter: No blr reached after {} instructions", MAX_TEST_INSTRS));
+          return false;
+        }
+        PPCInterpreter::ppcExecuteSingleInstruction(ppeState);
+      }
+      result.interpreterNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    } else {
+      // Scratch RAM is reused by every test, always compile the current one.
+      ppuJIT->InvalidateBlockAt(address);
+      const u64 compileTimeNs = ppuJIT->GetStats().compileTimeNs.Get();
+      ppuJIT->ExecuteJITInstrs(0x100, true, false, true);
+      const u64 compiledNs = ppuJIT->GetStats().compileTimeNs.Get() - compileTimeNs;
+      const u64 elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+      result.jitCompileNs += compiledNs;
+      result.jitNs += elapsedNs > compiledNs ? elapsedNs - compiledNs : 0;
+    }
+    return true;
+  }
+
+  void CheckTestResults(TestCase &testCase, const char *backendName, std::vector<std::string> &failures) {
     for (auto &it : testCase.testAnnotations) {
       if (it.first == "REGISTER_OUT") {
         size_t spacePos = it.second.find(" ");
@@ -386,21 +703,17 @@ public:
         std::string actualValue;
         if (!CompareRegWithString(ppeState,
           regName.c_str(), regValue.c_str(), actualValue)) {
-          any_failed = true;
-          LOG_ERROR(Xenon, "[Testing]: Register {} assert failed:\n", regName);
-          LOG_ERROR(Xenon, "[Testing]:   Expected: {} == {}\n", regName, regValue);
-          LOG_ERROR(Xenon, "[Testing]:     Actual: {} == {}\n", regName, actualValue);
+          failures.push_back(FMT("{}: Register {} assert failed. Expected: {}, Actual: {}",
+            backendName, regName, regValue, actualValue));
         }
       } else if (it.first == "MEMORY_OUT") {
         size_t spacePos = it.second.find(" ");
         auto addressStr = it.second.substr(0, spacePos);
         auto bytesStr = it.second.substr(spacePos + 1);
         u32 address = std::strtoul(addressStr.c_str(), nullptr, 16);
-        auto baseAddress = PPCInterpreter::MMUGetPointerFromRAM(address);
-        auto p = baseAddress;
+        auto p = PPCInterpreter::MMUGetPointerFromRAM(address);
         const char *c = bytesStr.c_str();
         bool failed = false;
-        size_t count = 0;
         std::string expecteds;
         std::string actuals;
         while (*c) {
@@ -410,33 +723,29 @@ public:
           }
           char ccs[3] = { c[0], c[1], 0 };
           c += 2;
-          count++;
-          u32 current_address = address + static_cast<u32>(p - baseAddress);
           u32 expected = std::strtoul(ccs, nullptr, 16);
           u8 actual = *p;
 
-          expecteds.append(" {:02X}", expected);
-          actuals.append(" {:02X}", actual);
+          expecteds += FMT(" {:02X}", expected);
+          actuals += FMT(" {:02X}", actual);
 
           if (expected != actual) {
-            any_failed = true;
             failed = true;
           }
           ++p;
         }
         if (failed) {
-          LOG_ERROR(Xenon, "Memory {} assert failed:\n", addressStr);
-          LOG_ERROR(Xenon, "  Expected:{}\n", expecteds);
-          LOG_ERROR(Xenon, "    Actual:{}\n", actuals);
+          failures.push_back(FMT("{}: Memory {} assert failed. Expected:{}, Actual:{}",
+            backendName, addressStr, expecteds, actuals));
         }
       }
     }
-    return !any_failed;
   }
 
   sPPEState *ppeState;
   PPU_JIT *ppuJIT;
-  ePPUTestingMode currentTestMode;
+  // Guest address of the scratch RAM this runner loads tests to
+  u32 scratchBase;
 };
 
 #ifdef _WIN32
@@ -448,99 +757,336 @@ int filter(unsigned int code) {
 }
 #endif // _WIN32
 
-
-void ProtectedRunTest(TestSuite &testSuite, TestRunner &runner,
-  TestCase &testCase, s32 &failedCount,
-  s32 &passedCount)
-{
+void ProtectedRunTest(TestRunner &runner, const sInstrTestOptions &options, sTestJob &job) {
   try {
-
-    if (!runner.Setup(testSuite)) {
-      LOG_ERROR(Xenon, "[Testing]:     TEST FAILED SETUP");
-      ++failedCount;
+    if (job.fuzzOpcode) {
+      runner.Fuzz(*job.fuzzOpcode, options, job.result);
+      return;
     }
-
-    if (runner.Run(testCase)) {
-      ++passedCount;
-    } else {
-      LOG_ERROR(Xenon, "[Testing]:     TEST FAILED");
-      ++failedCount;
+    if (!runner.Setup(*job.suite)) {
+      job.result.failures.push_back("TEST FAILED SETUP");
+      return;
     }
+    runner.Run(options.mode, *job.suite, *job.testCase, job.result);
+    job.result.cases = 1;
   }
   catch (const std::exception &e) {
-    LOG_ERROR(Xenon, "[Testing]:     TEST FAILED (exception: %s)", e.what());
-    ++failedCount;
+    job.result.failures.push_back(FMT("TEST FAILED (exception: {})", e.what()));
   }
   catch (...) {
-    LOG_ERROR(Xenon, "[Testing]:     TEST FAILED (unknown exception)");
-    ++failedCount;
+    job.result.failures.push_back("TEST FAILED (unknown exception)");
   }
 }
 
-bool PPU::RunInstructionTests(sPPEState *ppeState, PPU_JIT* ppuJITPtr, ePPUTestingMode testMode) {
-  s32 result = 1, failedTestsCount = 0, passedTestsCount = 0;
+// Every ALU, FPU and VXU opcode the JIT can emit, by name.
+std::vector<sFuzzOpcode> CollectFuzzOpcodes(const std::string &filter, std::vector<std::string> &withoutEmitter) {
+  std::map<std::string, sFuzzOpcode> opcodes;
+  std::map<std::string, bool> hasEmitter;
+  for (u32 slot = 0; slot != INSTR_PROFILER_SLOTS; ++slot) {
+    const u32 instr = PPCInterpreter::InstrSlotOpcode(slot);
+    const std::string name = PPCInterpreter::ppcDecoder.decodeName(instr);
+    const std::string category = PPCInterpreter::InstrCategory(name);
+    if (category != "ALU" && category != "FPU" && category != "VXU") {
+      continue;
+    }
+    // External control, goes through memory
+    if (name == "eciwx" || name == "ecowx") {
+      continue;
+    }
+    if (!filter.empty() && name.find(filter) == std::string::npos) {
+      continue;
+    }
+    const bool emitter = PPCInterpreter::ppcDecoder.decodeJIT(instr) != &PPCInterpreter::PPCInterpreterJIT_invalid;
+    hasEmitter[name] |= emitter;
+    if (emitter) {
+      sFuzzOpcode &opcode = opcodes[name];
+      opcode.name = name;
+      opcode.slots.push_back(slot);
+    }
+  }
+  for (auto &[name, emitter] : hasEmitter) {
+    if (!emitter) {
+      withoutEmitter.push_back(name);
+    }
+  }
+  std::vector<sFuzzOpcode> list;
+  for (auto &[name, opcode] : opcodes) {
+    list.push_back(std::move(opcode));
+  }
+  return list;
+}
 
-  // Setup paths.
-  testsPath = Config::filepaths.instrTestsPath;
-  testsBinPath = Config::filepaths.instrTestsBinPath;
+std::string XMLEscape(const std::string &text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char c : text) {
+    switch (c) {
+    case '&': escaped += "&amp;"; break;
+    case '<': escaped += "&lt;"; break;
+    case '>': escaped += "&gt;"; break;
+    case '"': escaped += "&quot;"; break;
+    default: escaped += c; break;
+    }
+  }
+  return escaped;
+}
 
-  auto testsPathDir = testsPath;
-  std::vector<std::filesystem::path> testFilesList;
-  if (!DiscoverTests(testsPathDir, testFilesList)) {
+bool WriteJUnitReport(const std::filesystem::path &path, const std::vector<sTestJob> &jobs, f64 wallSeconds) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR(Xenon, "[Testing]: Unable to open '{}' for writing.", path.string());
     return false;
   }
-  if (!testFilesList.size()) {
-    LOG_ERROR(Xenon, "[Testing]: No tests were discovered. Check your path or correct files.");
+  auto caseSeconds = [](const sTestCaseResult &result) {
+    return (result.interpreterNs + result.jitNs + result.jitCompileNs) / 1e9;
+  };
+  u64 failures = 0, skipped = 0;
+  for (const auto &job : jobs) {
+    failures += !job.result.skipped && !job.result.failures.empty();
+    skipped += job.result.skipped;
+  }
+  file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  file << FMT("<testsuites name=\"Xenon instruction tests\" tests=\"{}\" failures=\"{}\" skipped=\"{}\" time=\"{:.6f}\">\n",
+    jobs.size(), failures, skipped, wallSeconds);
+  // Jobs of a suite are contiguous
+  for (size_t first = 0; first != jobs.size();) {
+    size_t last = first;
+    u64 suiteFailures = 0, suiteSkipped = 0;
+    f64 suiteSeconds = 0.0;
+    while (last != jobs.size() && jobs[last].suiteName == jobs[first].suiteName) {
+      suiteFailures += !jobs[last].result.skipped && !jobs[last].result.failures.empty();
+      suiteSkipped += jobs[last].result.skipped;
+      suiteSeconds += caseSeconds(jobs[last].result);
+      ++last;
+    }
+    file << FMT("  <testsuite name=\"{}\" tests=\"{}\" failures=\"{}\" skipped=\"{}\" time=\"{:.6f}\">\n",
+      XMLEscape(jobs[first].suiteName), last - first, suiteFailures, suiteSkipped, suiteSeconds);
+    for (size_t i = first; i != last; ++i) {
+      const sTestCaseResult &result = jobs[i].result;
+      file << FMT("    <testcase classname=\"{}\" name=\"{}\" time=\"{:.6f}\"",
+        XMLEscape(jobs[i].suiteName), XMLEscape(jobs[i].caseName), caseSeconds(result));
+      if (result.Passed()) {
+        file << "/>\n";
+        continue;
+      }
+      file << ">\n";
+      if (result.skipped) {
+        file << FMT("      <skipped message=\"{}\"/>\n", XMLEscape(result.skipReason));
+      } else {
+        std::string details;
+        for (auto &failure : result.failures) {
+          details += failure + "\n";
+        }
+        file << FMT("      <failure message=\"{}\">{}</failure>\n", XMLEscape(result.failures.front()), XMLEscape(details));
+      }
+      file << "    </testcase>\n";
+    }
+    file << "  </testsuite>\n";
+    first = last;
+  }
+  file << "</testsuites>\n";
+  return true;
+}
+
+bool WriteTimingReport(const std::filesystem::path &path, const std::vector<sTestJob> &jobs) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR(Xenon, "[Testing]: Unable to open '{}' for writing.", path.string());
     return false;
   }
-  LOG_INFO(Xenon, "[Testing]: {} tests have been discovered.", testFilesList.size());
-  LOG_INFO(Xenon, "");
+  struct sOpcodeTiming {
+    u64 cases = 0;
+    u64 interpreterNs = 0;
+    u64 jitNs = 0;
+    u64 jitCompileNs = 0;
+  };
+  std::map<std::string, sOpcodeTiming> timings;
+  for (const auto &job : jobs) {
+    sOpcodeTiming &timing = timings[job.opcodeName];
+    timing.cases += job.result.cases;
+    timing.interpreterNs += job.result.interpreterNs;
+    timing.jitNs += job.result.jitNs;
+    timing.jitCompileNs += job.result.jitCompileNs;
+  }
+  file << "opcode,cases,interpreterNs,jitNs,jitCompileNs,interpreterNsPerCase,jitNsPerCase\n";
+  for (auto &[opcode, timing] : timings) {
+    const u64 cases = std::max<u64>(timing.cases, 1);
+    file << FMT("{},{},{},{},{},{:.1f},{:.1f}\n", opcode, timing.cases, timing.interpreterNs, timing.jitNs,
+      timing.jitCompileNs, static_cast<f64>(timing.interpreterNs) / cases, static_cast<f64>(timing.jitNs) / cases);
+  }
+  return true;
+}
+
+bool RunShardedInstructionTests(Xe::XCPU::XenonContext *xenonContext, const sInstrTestOptions &options) {
+  testsBinPath = options.binPath;
+  // The interpreter's MMU reaches RAM through the global context, which the standalone runner has yet to set
+  PPCInterpreter::xenonContext = xenonContext;
 
   std::vector<TestSuite> testSuites;
+  std::vector<sFuzzOpcode> fuzzOpcodes;
+  std::vector<sTestJob> jobs;
+  if (options.fuzzIterations) {
+    std::vector<std::string> withoutEmitter;
+    fuzzOpcodes = CollectFuzzOpcodes(options.filter, withoutEmitter);
+    LOG_INFO(Xenon, "[Testing]: Fuzzing {} opcodes, {} cases each (seed {:#x}).", fuzzOpcodes.size(),
+      options.fuzzIterations, options.fuzzSeed);
+    for (auto &opcode : fuzzOpcodes) {
+      sTestJob &job = jobs.emplace_back();
+      job.suiteName = "fuzz";
+      job.caseName = job.opcodeName = opcode.name;
+      job.fuzzOpcode = &opcode;
+    }
+    // Reported, so missing JIT coverage shows up next to the mismatches
+    for (auto &name : withoutEmitter) {
+      sTestJob &job = jobs.emplace_back();
+      job.suiteName = "fuzz";
+      job.caseName = job.opcodeName = name;
+      job.result.skipped = true;
+      job.result.skipReason = "No JIT emitter";
+    }
+  } else {
+    std::vector<std::filesystem::path> testFilesList;
+    if (!DiscoverTests(options.testsPath, testFilesList)) {
+      return false;
+    }
+    if (!testFilesList.size()) {
+      LOG_ERROR(Xenon, "[Testing]: No tests were discovered. Check your path or correct files.");
+      return false;
+    }
+    LOG_INFO(Xenon, "[Testing]: {} tests have been discovered.", testFilesList.size());
+
+    bool loadFailed = false;
+    for (auto &testPath : testFilesList) {
+      TestSuite testSuite(testPath);
+      if (!options.filter.empty() && testSuite.name().find(options.filter) == std::string::npos) {
+        continue;
+      }
+      if (!testSuite.Load()) {
+        LOG_ERROR(Xenon, "[Testing]: Test suite {} failed to load.", Base::FS::PathToUTF8String(testPath));
+        loadFailed = true;
+        continue;
+      }
+      testSuites.push_back(std::move(testSuite));
+    }
+    if (loadFailed) {
+      LOG_ERROR(Xenon, "[Testing]: One or more test suites failed to load.");
+    }
+    LOG_INFO(Xenon, "[Testing]: {} tests loaded.", testSuites.size());
 
-  bool loadFailed = false;
-  for (auto &testPath : testFilesList) {
-    TestSuite testSuite(testPath);
-    if (!testSuite.Load()) {
-      LOG_ERROR(Xenon, "[Testing]: Test suite {} failed to load.", Base::FS::PathToUTF8String(testPath));
-      loadFailed = true;
+    for (auto &testSuite : testSuites) {
+      for (auto &testCase : testSuite.getTestCases()) {
+        sTestJob &job = jobs.emplace_back();
+        job.suiteName = job.opcodeName = testSuite.name();
+        job.caseName = testCase.testName;
+        job.suite = &testSuite;
+        job.testCase = &testCase;
+      }
+    }
+  }
+
+  // Tests using memory go to the first worker, whose scratch RAM is where they were assembled for.
+  std::vector<size_t> pinnedJobs, sharedJobs;
+  for (size_t i = 0; i != jobs.size(); ++i) {
+    if (jobs[i].result.skipped) {
       continue;
     }
-    testSuites.push_back(std::move(testSuite));
+    if (jobs[i].testCase && jobs[i].testCase->UsesMemory()) {
+      pinnedJobs.push_back(i);
+    } else {
+      sharedJobs.push_back(i);
+    }
+  }
+
+  u32 workerCount = options.threads ? options.threads : std::thread::hardware_concurrency();
+  workerCount = std::clamp<u32>(workerCount, 1, MAX_TEST_WORKERS);
+  workerCount = std::max<u32>(std::min<u32>(workerCount, static_cast<u32>(sharedJobs.size())), 1);
+  LOG_INFO(Xenon, "[Testing]: Running {} tests on {} workers, backend: {}", pinnedJobs.size() + sharedJobs.size(),
+    workerCount, options.fuzzIterations ? "Differential fuzzing" : GetTestingModeName(options.mode));
+
+  // Each worker owns a PPU, so its sPPEState and JIT block cache. PIRs stay in the range of the real cores.
+  std::vector<std::unique_ptr<PPU>> workerPPUs;
+  for (u32 i = 0; i != workerCount; ++i) {
+    auto &ppu = workerPPUs.emplace_back(std::make_unique<PPU>(xenonContext, 0, (i % 3) * 2));
+    // The hybrid executor would hide missing emitters behind the interpreter
+    ppu->currentExecMode = eExecutorMode::JIT;
+    sPPEState *ppeState = ppu->GetPPUState();
+    // Same state StartExecution sets up
+    ppeState->SPR.LPCR.hexValue = 0x402ULL;
+    ppeState->SPR.HID6.hexValue = 0x1803800000000ULL;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<size_t> nextSharedJob = 0;
+  std::vector<std::thread> workers;
+  for (u32 i = 0; i != workerCount; ++i) {
+    workers.emplace_back([&, i] {
+      Base::SetCurrentThreadName(FMT("[Xe] InstrTests{}", i));
+      const u32 scratchBase = i == 0 ? START_ADDRESS : START_ADDRESS + WORKER_SCRATCH_OFFSET + (i - 1) * WORKER_SCRATCH_SIZE;
+      TestRunner runner(workerPPUs[i].get(), scratchBase);
+      if (i == 0) {
+        for (size_t job : pinnedJobs) {
+          ProtectedRunTest(runner, options, jobs[job]);
+        }
+      }
+      for (size_t next = nextSharedJob++; next < sharedJobs.size(); next = nextSharedJob++) {
+        ProtectedRunTest(runner, options, jobs[sharedJobs[next]]);
+      }
+    });
   }
-  if (loadFailed) {
-    LOG_ERROR(Xenon, "[Testing]: One or more test suites failed to load.");
+  for (auto &worker : workers) {
+    worker.join();
   }
+  const f64 wallSeconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+  workerPPUs.clear();
 
-  LOG_INFO(Xenon, "[Testing]: {} tests loaded.", testSuites.size());
-  TestRunner runner(ppeState, ppuJITPtr, testMode);
-  for (auto &testSuite : testSuites) {
-    LOG_INFO(Xenon, "[Testing]: {}.s:", testSuite.name());
-    for (auto &testCase : testSuite.getTestCases()) {
-      LOG_INFO(Xenon, "[Testing]:   - {}", testCase.testName);
-      ProtectedRunTest(testSuite, runner, testCase, failedTestsCount, passedTestsCount);
+  // Results are logged in order once everything ran
+  s32 failedTestsCount = 0, passedTestsCount = 0, skippedTestsCount = 0;
+  const std::string *currentSuite = nullptr;
+  for (auto &job : jobs) {
+    if (!currentSuite || *currentSuite != job.suiteName) {
+      if (currentSuite) {
+        LOG_INFO(Xenon, "");
+      }
+      currentSuite = &job.suiteName;
+      LOG_INFO(Xenon, "[Testing]: {}{}:", job.suiteName, options.fuzzIterations ? "" : ".s");
+    }
+    if (job.result.skipped) {
+      LOG_WARNING(Xenon, "[Testing]:   - {} SKIPPED ({})", job.caseName, job.result.skipReason);
+      ++skippedTestsCount;
+    } else if (job.result.Passed()) {
+      LOG_INFO(Xenon, "[Testing]:   - {}", job.caseName);
+      ++passedTestsCount;
+    } else {
+      LOG_ERROR(Xenon, "[Testing]:   - {} FAILED", job.caseName);
+      for (auto &failure : job.result.failures) {
+        LOG_ERROR(Xenon, "[Testing]:     {}", failure);
+      }
+      ++failedTestsCount;
     }
-    LOG_INFO(Xenon, "");
   }
 
   LOG_INFO(Xenon, "");
-  LOG_INFO(Xenon, "[Testing]: Total tests executed: {}", failedTestsCount + passedTestsCount);
+  LOG_INFO(Xenon, "[Testing]: Total tests executed: {} in {:.3f}s", failedTestsCount + passedTestsCount, wallSeconds);
   LOG_INFO(Xenon, "[Testing]: Passed: {}", passedTestsCount);
   LOG_INFO(Xenon, "[Testing]: Failed: {}", failedTestsCount);
+  if (skippedTestsCount) {
+    LOG_INFO(Xenon, "[Testing]: Skipped: {}", skippedTestsCount);
+  }
 
-  // Reset the state:
-  sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
-  // Clear registers involved in tests.
-  for (auto& reg : thread.GPR) { reg = 0; }
-  for (auto& reg : thread.FPR) { reg.setValue(0.0); }
-  for (auto& reg : thread.VR) { reg.x = 0; reg.y = 0; reg.z = 0; reg.w = 0; }
-  thread.CR.CR_Hex = 0;
-  thread.SPR.XER.hexValue = 0;
-  thread.SPR.MSR.FP = 0;
-  thread.SPR.MSR.VXU = 0;
-  thread.SPR.MSR.SF = 1;
-  // Set NIA back to default.
-  thread.NIA = 0x100;
+  if (!options.junitPath.empty() && WriteJUnitReport(options.junitPath, jobs, wallSeconds)) {
+    LOG_INFO(Xenon, "[Testing]: JUnit report written to '{}'", options.junitPath.string());
+  }
+  if (!options.timingPath.empty() && WriteTimingReport(options.timingPath, jobs)) {
+    LOG_INFO(Xenon, "[Testing]: Per-opcode timing written to '{}'", options.timingPath.string());
+  }
 
   return failedTestsCount ? false : true;
-}
\ No newline at end of file
+}
+
+bool PPU::RunInstructionTests(ePPUTestingMode testMode) {
+  sInstrTestOptions options{};
+  options.testsPath = Config::filepaths.instrTestsPath;
+  options.binPath = Config::filepaths.instrTestsBinPath;
+  options.mode = testMode;
+  return RunShardedInstructionTests(xenonContext, options);
+}
@@ -0,0 +1,43 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "Core/XCPU/PPU/PPU.h"
+
+//
+// PowerPC instruction conformance tests (xenia's ppc tests: annotated .s sources plus assembled .bin/.map files).
+// The corpus is sharded across host threads. Every worker owns a PPU (its own sPPEState and JIT) and a scratch
+// slice of guest RAM its tests are relocated into, so suites run side by side.
+// - Interpreter/JITx86 check the annotated expectations on one backend.
+// - Differential also runs both backends on every test and diffs their whole user visible register state.
+// - With fuzzIterations set, the corpus is replaced by random operands for every ALU/FPU/VXU opcode the JIT emits,
+//   each one executed by the interpreter and the JIT and their register states compared.
+//
+struct sInstrTestOptions {
+  // Annotated test sources (.s)
+  std::filesystem::path testsPath;
+  // Assembled tests (.bin and .map)
+  std::filesystem::path binPath;
+  // Backend(s) the corpus runs on, fuzzing always runs both
+  ePPUTestingMode mode = ePPUTestingMode::Interpreter;
+  // Worker threads, 0 uses one per hardware thread
+  u32 threads = 0;
+  // Only runs the suites (opcodes when fuzzing) whose name contains this, empty runs everything
+  std::string filter;
+  // JUnit XML report, empty to skip it
+  std::filesystem::path junitPath;
+  // Per-opcode timing CSV, empty to skip it
+  std::filesystem::path timingPath;
+  // Random cases per opcode, 0 runs the test corpus instead
+  u32 fuzzIterations = 0;
+  // Fuzzer seed, the same seed generates the same cases
+  u64 fuzzSeed = 0;
+};
+
+// Runs the tests on PPUs created on the given context, returns true if none failed.
+bool RunShardedInstructionTests(Xe::XCPU::XenonContext *xenonContext, const sInstrTestOptions &options);
@@ -0,0 +1,213 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "GuestProfiler.h"
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+#include "Core/XCPU/PPU/PPU.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace Xe::XCPU {
+
+  namespace {
+    enum eSampleMode : u8 { User = 0, Kernel = 1, Hypervisor = 2 };
+
+    static const char *modeName(u8 mode) {
+      switch (mode) {
+      case Hypervisor: return "hypervisor";
+      case Kernel: return "kernel";
+      default: return "user";
+      }
+    }
+
+    static u8 sampleMode(u64 msr) {
+      uMSR value{ msr };
+      if (value.PR) {
+        return User;
+      }
+      return value.HV ? Hypervisor : Kernel;
+    }
+
+    // Folded stack frames are separated by ';' and end at the first space
+    static std::string frameName(std::string name) {
+      std::replace(name.begin(), name.end(), ';', ':');
+      std::replace(name.begin(), name.end(), ' ', '_');
+      return name;
+    }
+  } // anonymous namespace
+
+  GuestProfiler::GuestProfiler(u32 rateHz) : rateHz(std::clamp<u32>(rateHz, 1, 100000)) {
+  }
+
+  GuestProfiler::~GuestProfiler() {
+    Stop();
+  }
+
+  void GuestProfiler::Start(const std::array<PPU *, 3> &newCores) {
+    Stop();
+    cores = newCores;
+    samplerRunning = true;
+    samplerThread = std::thread(&GuestProfiler::samplerThreadLoop, this);
+    LOG_INFO(Xenon, "[GuestProfiler]: Sampling guest threads at {} Hz.", rateHz);
+  }
+
+  void GuestProfiler::Stop() {
+    if (!samplerRunning.exchange(false)) {
+      return;
+    }
+    if (samplerThread.joinable()) {
+      samplerThread.join();
+    }
+    cores = {};
+    std::lock_guard<std::mutex> lock(profileMutex);
+    collect();
+  }
+
+  void GuestProfiler::Reset() {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    collect();
+    for (auto &threadStacks : stacks) {
+      threadStacks.clear();
+    }
+    totalSamples = 0;
+    droppedSamples.store(0, std::memory_order_relaxed);
+  }
+
+  void GuestProfiler::samplerThreadLoop() {
+    Base::SetCurrentThreadName("[Xe] Guest Profiler");
+
+    const auto period = std::chrono::nanoseconds(1000000000ULL / rateHz);
+    const auto collectInterval = std::chrono::milliseconds(GUEST_PROFILER_COLLECT_INTERVAL_MS);
+    auto nextSample = std::chrono::steady_clock::now();
+    auto nextCollect = nextSample + collectInterval;
+
+    while (samplerRunning.load(std::memory_order_relaxed)) {
+      nextSample += period;
+      std::this_thread::sleep_until(nextSample);
+      const auto now = std::chrono::steady_clock::now();
+      // Don't burst to catch up after the host stalled us
+      if (now - nextSample > period * 4) {
+        nextSample = now;
+      }
+
+      if (!XePaused) {
+        takeSamples();
+      }
+
+      if (now >= nextCollect) {
+        nextCollect = now + collectInterval;
+        std::lock_guard<std::mutex> lock(profileMutex);
+        collect();
+      }
+    }
+  }
+
+  void GuestProfiler::takeSamples() {
+    for (u8 core = 0; core != cores.size(); ++core) {
+      PPU *ppu = cores[core];
+      if (!ppu || ppu->IsHalted()) {
+        continue;
+      }
+      sPPEState *ppeState = ppu->GetPPUState();
+      for (u8 thread = 0; thread != 2; ++thread) {
+        if (!(thread ? ppeState->SPR.CTRL.TE1 : ppeState->SPR.CTRL.TE0)) {
+          continue;
+        }
+        // Read while the core keeps running. Aligned 64 bit reads don't tear, a sample may
+        // mix registers of neighbouring instructions, which a statistical profile doesn't mind.
+        const sPPUThread &ppuThread = ppeState->ppuThread[thread];
+        const sGuestSample sample{ ppuThread.CIA, ppuThread.SPR.LR, ppuThread.SPR.MSR.hexValue };
+        if (!rings[core * 2 + thread].Push(sample)) {
+          droppedSamples.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  void GuestProfiler::collect() {
+    for (u8 thread = 0; thread != GUEST_PROFILER_THREADS; ++thread) {
+      sGuestSample sample;
+      while (rings[thread].Pop(sample)) {
+        stacks[thread][{ sample.CIA, sample.LR, sampleMode(sample.MSR) }]++;
+        totalSamples++;
+      }
+    }
+  }
+
+  void GuestProfiler::LogReport(size_t topN) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    collect();
+
+    if (!totalSamples) {
+      LOG_INFO(Xenon, "[GuestProfiler]: No samples recorded.");
+      return;
+    }
+
+    std::unordered_map<std::string, u64> functions;
+    std::unordered_map<u64, u64> addresses;
+    for (const auto &threadStacks : stacks) {
+      for (const auto &[key, count] : threadStacks) {
+        const sGuestSymbol *symbol = symbols.Find(key.CIA);
+        functions[symbol ? symbol->name : fmt::format("0x{:08X}", key.CIA)] += count;
+        addresses[key.CIA] += count;
+      }
+    }
+
+    auto logTop = [&](const char *title, auto &map, auto &&describe) {
+      std::vector<std::pair<typename std::decay_t<decltype(map)>::key_type, u64>> vec(map.begin(), map.end());
+      std::sort(vec.begin(), vec.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+      const size_t limit = std::min(topN, vec.size());
+      LOG_INFO(Xenon, "[GuestProfiler]: Top {} {}:", limit, title);
+      for (size_t i = 0; i < limit; ++i) {
+        LOG_INFO(Xenon, "  {:3} : {:>10} samples ({:5.2f}%) - {}", i + 1, vec[i].second,
+          100.0 * vec[i].second / totalSamples, describe(vec[i].first));
+      }
+    };
+
+    LOG_INFO(Xenon, "[GuestProfiler]: {} samples at {} Hz, {} dropped, {} symbols.", totalSamples, rateHz,
+      droppedSamples.load(std::memory_order_relaxed), symbols.Size());
+    logTop("functions", functions, [](const std::string &name) { return name; });
+    logTop("addresses", addresses, [this](u64 address) {
+      return fmt::format("0x{:08X} {}", address, symbols.Describe(address));
+    });
+  }
+
+  bool GuestProfiler::WriteFoldedStacks(const std::filesystem::path &path) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    collect();
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[GuestProfiler]: Unable to open '{}' for writing.", path.string());
+      return false;
+    }
+
+    for (u8 thread = 0; thread != GUEST_PROFILER_THREADS; ++thread) {
+      // Samples landing in the same function from the same caller share a line
+      std::unordered_map<std::string, u64> folded;
+      for (const auto &[key, count] : stacks[thread]) {
+        const sGuestSymbol *function = symbols.Find(key.CIA);
+        const sGuestSymbol *caller = key.LR ? symbols.Find(key.LR) : nullptr;
+        std::string stack = fmt::format("PPU{}T{};{}", thread / 2, thread % 2, modeName(key.mode));
+        // Without a symbol a caller is only known by its address, and would split every function
+        // into a frame per call site, leave those out
+        if (caller && caller != function) {
+          stack += ";" + frameName(caller->name);
+        }
+        stack += ";" + frameName(function ? function->name : fmt::format("0x{:08X}", key.CIA));
+        folded[stack] += count;
+      }
+      for (const auto &[stack, count] : folded) {
+        file << stack << ' ' << count << '\n';
+      }
+    }
+
+    LOG_INFO(Xenon, "[GuestProfiler]: {} samples written to '{}'.", totalSamples, path.string());
+    return file.good();
+  }
+
+} // namespace Xe::XCPU
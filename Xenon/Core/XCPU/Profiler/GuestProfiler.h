@@ -0,0 +1,127 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "GuestSymbols.h"
+
+// Hardware threads sampled, 2 per PPU core
+#define GUEST_PROFILER_THREADS 6
+// Samples buffered per hardware thread between collections (power of 2)
+#define GUEST_PROFILER_RING_SIZE 0x1000
+// How often buffered samples are folded into the profile
+#define GUEST_PROFILER_COLLECT_INTERVAL_MS 250
+
+class PPU;
+
+namespace Xe::XCPU {
+
+  // One snapshot of a hardware thread
+  struct sGuestSample {
+    u64 CIA = 0;
+    u64 LR = 0;
+    u64 MSR = 0;
+  };
+
+  // Single producer / single consumer sample ring. The sampler thread produces, whoever
+  // collects (under the profile mutex) consumes. Full rings drop new samples.
+  class GuestSampleRing {
+  public:
+    bool Push(const sGuestSample &sample) {
+      const u32 head = writePos.load(std::memory_order_relaxed);
+      if (head - readPos.load(std::memory_order_acquire) == GUEST_PROFILER_RING_SIZE) {
+        return false;
+      }
+      samples[head & (GUEST_PROFILER_RING_SIZE - 1)] = sample;
+      writePos.store(head + 1, std::memory_order_release);
+      return true;
+    }
+    bool Pop(sGuestSample &sample) {
+      const u32 tail = readPos.load(std::memory_order_relaxed);
+      if (writePos.load(std::memory_order_acquire) == tail) {
+        return false;
+      }
+      sample = samples[tail & (GUEST_PROFILER_RING_SIZE - 1)];
+      readPos.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+  private:
+    alignas(64) std::atomic<u32> writePos = 0;
+    alignas(64) std::atomic<u32> readPos = 0;
+    alignas(64) sGuestSample samples[GUEST_PROFILER_RING_SIZE] = {};
+  };
+
+  //
+  // Guest PC sampling profiler
+  // A timer thread periodically snapshots CIA, LR and MSR of every enabled hardware thread, the guest
+  // threads themselves never do any work for it. Samples are aggregated by (function, caller, privilege)
+  // and symbolized when a report is written, as hot functions / addresses and as folded stacks
+  // (flamegraph.pl / speedscope / inferno input).
+  //
+  class GuestProfiler {
+  public:
+    GuestProfiler(u32 rateHz);
+    ~GuestProfiler();
+
+    // Starts sampling the given cores. Cores may be nullptr.
+    void Start(const std::array<PPU *, 3> &cores);
+    // Stops sampling. Collected samples are kept until Reset().
+    void Stop();
+    // Drops every collected sample.
+    void Reset();
+
+    // Symbols used by reports.
+    GuestSymbols &Symbols() { return symbols; }
+
+    // Logs the topN hottest functions and addresses.
+    void LogReport(size_t topN = 20);
+    // Writes the profile as folded stacks: "PPU0T0;kernel;caller;function count".
+    // The caller frame is taken from LR, which is only exact while the function hasn't made a call itself.
+    bool WriteFoldedStacks(const std::filesystem::path &path);
+
+  private:
+    struct sStackKey {
+      u64 CIA;
+      u64 LR;
+      // 0 user, 1 kernel, 2 hypervisor
+      u8 mode;
+      bool operator==(const sStackKey &) const = default;
+    };
+    struct sStackKeyHash {
+      size_t operator()(const sStackKey &key) const {
+        return std::hash<u64>()(key.CIA * 0x9E3779B97F4A7C15ULL ^ key.LR ^ static_cast<u64>(key.mode) << 62);
+      }
+    };
+
+    // Sampler thread
+    void samplerThreadLoop();
+    void takeSamples();
+    // Folds buffered samples into the profile. Expects profileMutex to be held.
+    void collect();
+
+    const u32 rateHz = 0;
+    std::array<PPU *, 3> cores{};
+    std::thread samplerThread{};
+    std::atomic<bool> samplerRunning{ false };
+
+    // Filled by the sampler thread
+    GuestSampleRing rings[GUEST_PROFILER_THREADS];
+    std::atomic<u64> droppedSamples{ 0 };
+
+    // Aggregated profile, guarded by profileMutex
+    std::mutex profileMutex;
+    std::unordered_map<sStackKey, u64, sStackKeyHash> stacks[GUEST_PROFILER_THREADS];
+    u64 totalSamples = 0;
+
+    GuestSymbols symbols{};
+  };
+
+} // namespace Xe::XCPU
@@ -0,0 +1,206 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "GuestSymbols.h"
+
+#include "Base/Logging/Log.h"
+#include "Core/XCPU/ElfABI.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Xe::XCPU {
+
+  namespace {
+    // ELF fields are in the file's byte order
+    template <typename T>
+    T elfValue(T value, bool bigEndian) {
+      return bigEndian ? byteswap_be<T>(value) : byteswap_le<T>(value);
+    }
+
+    // Parses a hex token, with or without 0x. Returns false if it isn't one.
+    bool parseHex(const std::string &token, u64 &value) {
+      if (token.empty()) {
+        return false;
+      }
+      size_t consumed = 0;
+      try {
+        value = std::stoull(token, &consumed, 16);
+      } catch (const std::exception &) {
+        return false;
+      }
+      return consumed == token.size();
+    }
+
+    template <typename Ehdr, typename Shdr, typename Sym>
+    u32 readElfSymbols(const std::vector<u8> &image, bool bigEndian, std::vector<sGuestSymbol> &out) {
+      const Ehdr *header = reinterpret_cast<const Ehdr *>(image.data());
+      const u64 shOff = elfValue(header->e_shoff, bigEndian);
+      const u16 shNum = elfValue(header->e_shnum, bigEndian);
+      if (!shOff || shOff + static_cast<u64>(shNum) * sizeof(Shdr) > image.size()) {
+        return 0;
+      }
+      const Shdr *sections = reinterpret_cast<const Shdr *>(image.data() + shOff);
+
+      u32 added = 0;
+      for (u16 i = 0; i != shNum; ++i) {
+        if (elfValue(sections[i].sh_type, bigEndian) != SHT_SYMTAB) {
+          continue;
+        }
+        const u32 link = elfValue(sections[i].sh_link, bigEndian);
+        if (link >= shNum) {
+          continue;
+        }
+        const u64 symOff = elfValue(sections[i].sh_offset, bigEndian);
+        const u64 symSize = elfValue(sections[i].sh_size, bigEndian);
+        const u64 strOff = elfValue(sections[link].sh_offset, bigEndian);
+        const u64 strSize = elfValue(sections[link].sh_size, bigEndian);
+        if (symOff + symSize > image.size() || strOff + strSize > image.size()) {
+          continue;
+        }
+
+        const Sym *syms = reinterpret_cast<const Sym *>(image.data() + symOff);
+        for (u64 s = 0; s != symSize / sizeof(Sym); ++s) {
+          if (ELF_ST_TYPE(syms[s].st_info) != STT_FUNC) {
+            continue;
+          }
+          const u32 nameOff = elfValue(syms[s].st_name, bigEndian);
+          const u64 value = elfValue(syms[s].st_value, bigEndian);
+          if (!value || nameOff >= strSize) {
+            continue;
+          }
+          const char *name = reinterpret_cast<const char *>(image.data() + strOff + nameOff);
+          out.push_back({ value, elfValue(syms[s].st_size, bigEndian),
+            std::string(name, strnlen(name, strSize - nameOff)) });
+          added++;
+        }
+      }
+      return added;
+    }
+  } // anonymous namespace
+
+  bool GuestSymbols::Load(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[4] = {};
+    file.read(magic, sizeof(magic));
+    if (file.gcount() == sizeof(magic) && magic[EI_MAG0] == ELFMAG0 && magic[EI_MAG1] == ELFMAG1 &&
+      magic[EI_MAG2] == ELFMAG2 && magic[EI_MAG3] == ELFMAG3) {
+      return LoadElf(path);
+    }
+    return LoadMap(path);
+  }
+
+  bool GuestSymbols::LoadElf(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[GuestSymbols]: Unable to open '{}'.", path.string());
+      return false;
+    }
+    std::vector<u8> image{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    if (image.size() < sizeof(Elf64_Ehdr) || image[EI_MAG0] != ELFMAG0 || image[EI_MAG1] != ELFMAG1 ||
+      image[EI_MAG2] != ELFMAG2 || image[EI_MAG3] != ELFMAG3) {
+      LOG_ERROR(Xenon, "[GuestSymbols]: '{}' is not an ELF file.", path.string());
+      return false;
+    }
+
+    const bool bigEndian = image[EI_DATA] == ELFDATA2MSB;
+    const u32 added = image[EI_CLASS] == ELFCLASS64 ?
+      readElfSymbols<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(image, bigEndian, symbols) :
+      readElfSymbols<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(image, bigEndian, symbols);
+    Finalize();
+
+    if (!added) {
+      LOG_WARNING(Xenon, "[GuestSymbols]: '{}' has no function symbols (stripped?).", path.string());
+      return false;
+    }
+    LOG_INFO(Xenon, "[GuestSymbols]: Loaded {} function symbols from '{}'.", added, path.string());
+    return true;
+  }
+
+  bool GuestSymbols::LoadMap(const std::filesystem::path &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[GuestSymbols]: Unable to open '{}'.", path.string());
+      return false;
+    }
+
+    u32 added = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream stream(line);
+      std::vector<std::string> tokens;
+      for (std::string token; stream >> token && tokens.size() != 3;) {
+        tokens.push_back(token);
+      }
+      if (tokens.size() < 2) {
+        continue;
+      }
+
+      u64 address = 0;
+      std::string name;
+      if (tokens[0].find(':') != std::string::npos) {
+        // MSVC/XDK map: " 0001:00000000  ?Foo@@YAXXZ  82000000 f  foo.obj"
+        if (tokens.size() < 3 || !parseHex(tokens[2], address)) {
+          continue;
+        }
+        name = tokens[1];
+      } else if (parseHex(tokens[0], address)) {
+        // nm: "82000000 T Foo", plain: "82000000 Foo"
+        name = tokens.size() == 3 && tokens[1].size() == 1 ? tokens[2] : tokens[1];
+      } else {
+        continue;
+      }
+      if (!address) {
+        continue;
+      }
+      symbols.push_back({ address, 0, name });
+      added++;
+    }
+    Finalize();
+
+    if (!added) {
+      LOG_WARNING(Xenon, "[GuestSymbols]: No symbols found in '{}'.", path.string());
+      return false;
+    }
+    LOG_INFO(Xenon, "[GuestSymbols]: Loaded {} symbols from '{}'.", added, path.string());
+    return true;
+  }
+
+  void GuestSymbols::Finalize() {
+    std::stable_sort(symbols.begin(), symbols.end(), [](const sGuestSymbol &a, const sGuestSymbol &b) {
+      return a.address < b.address;
+    });
+    // The first name given to an address wins
+    symbols.erase(std::unique(symbols.begin(), symbols.end(), [](const sGuestSymbol &a, const sGuestSymbol &b) {
+      return a.address == b.address;
+    }), symbols.end());
+  }
+
+  const sGuestSymbol *GuestSymbols::Find(u64 address) const {
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), address, [](u64 value, const sGuestSymbol &symbol) {
+      return value < symbol.address;
+    });
+    if (it == symbols.begin()) {
+      return nullptr;
+    }
+    --it;
+    if (it->size && address - it->address >= it->size) {
+      return nullptr;
+    }
+    return &*it;
+  }
+
+  std::string GuestSymbols::Describe(u64 address) const {
+    const sGuestSymbol *symbol = Find(address);
+    if (!symbol) {
+      return fmt::format("0x{:08X}", address);
+    }
+    if (address == symbol->address) {
+      return symbol->name;
+    }
+    return fmt::format("{}+0x{:X}", symbol->name, address - symbol->address);
+  }
+
+} // namespace Xe::XCPU
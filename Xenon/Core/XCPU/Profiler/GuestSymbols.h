@@ -0,0 +1,47 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Xe::XCPU {
+
+  // A named guest function
+  struct sGuestSymbol {
+    u64 address = 0;
+    // 0 when unknown, the symbol then covers everything up to the next one
+    u64 size = 0;
+    std::string name{};
+  };
+
+  // Guest symbol table, used to put names on sampled addresses.
+  class GuestSymbols {
+  public:
+    // Loads an ELF or a map file, whichever the file is.
+    bool Load(const std::filesystem::path &path);
+    // Adds the function symbols of a PowerPC ELF's .symtab.
+    bool LoadElf(const std::filesystem::path &path);
+    // Adds the symbols of a map file. Understands "address name", nm's "address type name" and
+    // MSVC/XDK linker maps (" section:offset name rva+base flags object").
+    bool LoadMap(const std::filesystem::path &path);
+
+    // Returns the function containing the address, nullptr if there's none.
+    const sGuestSymbol *Find(u64 address) const;
+    // Returns "name+0xOffset" for the address, or the bare address.
+    std::string Describe(u64 address) const;
+
+    size_t Size() const { return symbols.size(); }
+    bool Empty() const { return symbols.empty(); }
+
+  private:
+    // Sorts by address and drops duplicates, after a load.
+    void Finalize();
+
+    std::vector<sGuestSymbol> symbols{};
+  };
+
+} // namespace Xe::XCPU
@@ -0,0 +1,144 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+//
+// Binary execution trace (.xtrace) layout, shared by the recorder and the reader.
+//
+// File: sTraceFileHeader, then any number of chunks.
+// Chunk: sTraceChunkHeader, then storedSize bytes of a (possibly compressed) record stream.
+// Every chunk holds records of a single PPU core, in execution order. Chunks of different cores are interleaved
+// in the order they were filled, so records of one core are ordered, but not across cores.
+//
+// A record is a eTraceRecord byte followed by its fixed size payload, little endian:
+//   Thread     u8 PIR                      the following records belong to this hardware thread
+//   Instr      u64 CIA, u32 opcode         an instruction about to execute
+//   InstrNext  u32 opcode                  same, at the previous CIA + 4
+//   GPR        u8 index, u64 value         a GPR the previous instruction changed
+//   MemRead    u64 EA, u64 RA, u8 size     a data access, after translation
+//   MemWrite   u64 EA, u64 RA, u8 size
+//   MMIORead   u64 RA, u8 size, u64 value  a SoC / bus device access, value is zero extended
+//   MMIOWrite  u64 RA, u8 size, u64 value
+//   Exception  u64 CIA, u16 pending        the pending exception mask changed (see eExceptionBitmask)
+//   TLBFill    u8 source, u8 set, u8 index, u64 VA, u64 RA
+//   Post       u64 code                    POST bus write
+//   JITBlock   u64 address, u32 instrs     a JIT block was entered, its instructions aren't traced one by one
+// Every chunk starts with a Thread record, and the first instruction of each thread in it is a full Instr, so
+// chunks decode on their own.
+//
+
+#define XE_TRACE_MAGIC 0x43525458 // 'XTRC'
+#define XE_TRACE_CHUNK_MAGIC 0x4B4E4843 // 'CHNK'
+#define XE_TRACE_VERSION 1
+// Uncompressed chunk size the writers fill before handing a chunk off
+#define XE_TRACE_CHUNK_SIZE 0x100000
+
+namespace Xe::XCPU {
+
+  enum class eTraceRecord : u8 {
+    Thread,
+    Instr,
+    InstrNext,
+    GPR,
+    MemRead,
+    MemWrite,
+    MMIORead,
+    MMIOWrite,
+    Exception,
+    TLBFill,
+    Post,
+    JITBlock,
+    Count
+  };
+
+  // How a chunk's record stream is stored
+  enum class eTraceCodec : u8 {
+    None,
+    Zstd,
+    Zlib
+  };
+
+  // What filled a TLB/ERAT entry
+  enum class eTraceTLBSource : u8 {
+    Software, // tlbwe style write of PPE_TLB_Index/VPN/RPN, VA is the VPN
+    ERAT      // ERAT reload after a translation, VA is the EA
+  };
+
+  // Optional record kinds, the others are always written
+  enum eTraceFlags : u32 {
+    TraceFlag_GPR = 1 << 0,
+    TraceFlag_Memory = 1 << 1
+  };
+
+#pragma pack(push, 1)
+  struct sTraceFileHeader {
+    u32 magic = XE_TRACE_MAGIC;
+    u32 version = XE_TRACE_VERSION;
+    // Host time the trace started at (ns since the unix epoch)
+    u64 startTime = 0;
+    // eTraceFlags
+    u32 flags = 0;
+    u32 reserved = 0;
+  };
+
+  struct sTraceChunkHeader {
+    u32 magic = XE_TRACE_CHUNK_MAGIC;
+    // Bytes following this header
+    u32 storedSize = 0;
+    // Bytes of records once decompressed
+    u32 rawSize = 0;
+    eTraceCodec codec = eTraceCodec::None;
+    // PPU core (0-2) the records belong to
+    u8 core = 0;
+    u16 reserved = 0;
+    // Sequence number of the chunk, in submission order
+    u64 sequence = 0;
+  };
+#pragma pack(pop)
+
+  // Payload size of every record kind, without the kind byte
+  inline constexpr u8 traceRecordSizes[static_cast<u8>(eTraceRecord::Count)] = {
+    1,      // Thread
+    12,     // Instr
+    4,      // InstrNext
+    9,      // GPR
+    17,     // MemRead
+    17,     // MemWrite
+    17,     // MMIORead
+    17,     // MMIOWrite
+    10,     // Exception
+    19,     // TLBFill
+    8,      // Post
+    12,     // JITBlock
+  };
+
+  inline const char *GetTraceRecordName(eTraceRecord record) {
+    switch (record) {
+    case eTraceRecord::Thread: return "Thread";
+    case eTraceRecord::Instr: return "Instr";
+    case eTraceRecord::InstrNext: return "InstrNext";
+    case eTraceRecord::GPR: return "GPR";
+    case eTraceRecord::MemRead: return "MemRead";
+    case eTraceRecord::MemWrite: return "MemWrite";
+    case eTraceRecord::MMIORead: return "MMIORead";
+    case eTraceRecord::MMIOWrite: return "MMIOWrite";
+    case eTraceRecord::Exception: return "Exception";
+    case eTraceRecord::TLBFill: return "TLBFill";
+    case eTraceRecord::Post: return "Post";
+    case eTraceRecord::JITBlock: return "JITBlock";
+    default: return "Unknown";
+    }
+  }
+
+  inline const char *GetTraceCodecName(eTraceCodec codec) {
+    switch (codec) {
+    case eTraceCodec::None: return "none";
+    case eTraceCodec::Zstd: return "zstd";
+    case eTraceCodec::Zlib: return "zlib";
+    }
+    return "unknown";
+  }
+
+} // namespace Xe::XCPU
@@ -0,0 +1,193 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "TraceReader.h"
+
+#include <cstring>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Base/Logging/Log.h"
+
+namespace Xe::XCPU {
+
+  namespace {
+    template <typename T>
+    T readField(const u8 *&cursor) {
+      T value{};
+      memcpy(&value, cursor, sizeof(T));
+      cursor += sizeof(T);
+      return value;
+    }
+  } // anonymous namespace
+
+  bool TraceReader::Open(const std::filesystem::path &path) {
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[Trace]: Unable to open '{}'.", path.string());
+      return false;
+    }
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != XE_TRACE_MAGIC) {
+      LOG_ERROR(Xenon, "[Trace]: '{}' isn't a trace.", path.string());
+      return false;
+    }
+    if (header.version != XE_TRACE_VERSION) {
+      LOG_ERROR(Xenon, "[Trace]: '{}' is version {}, expected {}.", path.string(), header.version, XE_TRACE_VERSION);
+      return false;
+    }
+    return true;
+  }
+
+  bool TraceReader::ReadChunk(sTraceChunkHeader &chunkHeader, std::vector<u8> &records) {
+    file.read(reinterpret_cast<char *>(&chunkHeader), sizeof(chunkHeader));
+    if (file.gcount() == 0) {
+      return false;
+    }
+    // Cleared again once the chunk made it through
+    broken = true;
+    if (!file || chunkHeader.magic != XE_TRACE_CHUNK_MAGIC || chunkHeader.rawSize > XE_TRACE_CHUNK_SIZE) {
+      LOG_ERROR(Xenon, "[Trace]: Broken chunk header at offset {:#x}.", static_cast<u64>(file.tellg()));
+      return false;
+    }
+    // Writers only keep a compressed chunk when it shrank, anything else is stored as is
+    if (chunkHeader.codec == eTraceCodec::None ? chunkHeader.storedSize != chunkHeader.rawSize
+                                               : chunkHeader.storedSize >= chunkHeader.rawSize) {
+      LOG_ERROR(Xenon, "[Trace]: Chunk {} stores {:#x} bytes for {:#x}.", chunkHeader.sequence,
+        chunkHeader.storedSize, chunkHeader.rawSize);
+      return false;
+    }
+    records.resize(chunkHeader.rawSize);
+    if (chunkHeader.codec == eTraceCodec::None) {
+      file.read(reinterpret_cast<char *>(records.data()), chunkHeader.storedSize);
+      broken = !file;
+      return !broken;
+    }
+    stored.resize(chunkHeader.storedSize);
+    file.read(reinterpret_cast<char *>(stored.data()), chunkHeader.storedSize);
+    if (!file) {
+      LOG_ERROR(Xenon, "[Trace]: Chunk {} is truncated.", chunkHeader.sequence);
+      return false;
+    }
+    switch (chunkHeader.codec) {
+#ifdef HAVE_ZSTD
+    case eTraceCodec::Zstd: {
+      const size_t result = ZSTD_decompress(records.data(), records.size(), stored.data(), stored.size());
+      if (ZSTD_isError(result) || result != records.size()) {
+        LOG_ERROR(Xenon, "[Trace]: Chunk {} doesn't decompress: {}.", chunkHeader.sequence, ZSTD_getErrorName(result));
+        return false;
+      }
+      broken = false;
+      return true;
+    }
+#endif
+#ifdef HAVE_ZLIB
+    case eTraceCodec::Zlib: {
+      uLongf size = static_cast<uLongf>(records.size());
+      if (uncompress(records.data(), &size, stored.data(), static_cast<uLong>(stored.size())) != Z_OK ||
+        size != records.size()) {
+        LOG_ERROR(Xenon, "[Trace]: Chunk {} doesn't decompress.", chunkHeader.sequence);
+        return false;
+      }
+      broken = false;
+      return true;
+    }
+#endif
+    default:
+      LOG_ERROR(Xenon, "[Trace]: Chunk {} is {} compressed, which this build doesn't support.", chunkHeader.sequence,
+        GetTraceCodecName(chunkHeader.codec));
+      return false;
+    }
+  }
+
+  bool TraceReader::ForEach(const std::function<bool(const sTraceEvent &)> &callback) {
+    // Last instruction of every hardware thread, kept across chunks for the records that precede a chunk's first Instr
+    u64 threadCIA[6] = {};
+    sTraceChunkHeader chunkHeader{};
+    std::vector<u8> records{};
+    while (ReadChunk(chunkHeader, records)) {
+      const u8 *cursor = records.data();
+      const u8 *end = cursor + records.size();
+      u8 PIR = chunkHeader.core * 2;
+      while (cursor < end) {
+        const eTraceRecord type = static_cast<eTraceRecord>(*cursor++);
+        if (type >= eTraceRecord::Count || end - cursor < traceRecordSizes[static_cast<u8>(type)]) {
+          LOG_ERROR(Xenon, "[Trace]: Chunk {} has a broken record at offset {:#x}.", chunkHeader.sequence,
+            static_cast<u64>(cursor - records.data() - 1));
+          return false;
+        }
+        if (type == eTraceRecord::Thread) {
+          PIR = readField<u8>(cursor);
+          continue;
+        }
+        sTraceEvent event{};
+        event.type = type;
+        event.core = chunkHeader.core;
+        event.PIR = PIR;
+        u64 &CIA = threadCIA[event.PIR % 6];
+        switch (type) {
+        case eTraceRecord::Instr:
+          CIA = readField<u64>(cursor);
+          event.opcode = readField<u32>(cursor);
+          break;
+        case eTraceRecord::InstrNext:
+          CIA += 4;
+          event.opcode = readField<u32>(cursor);
+          // Reported as a regular instruction, InstrNext is only an encoding
+          event.type = eTraceRecord::Instr;
+          break;
+        case eTraceRecord::GPR:
+          event.index = readField<u8>(cursor);
+          event.value = readField<u64>(cursor);
+          break;
+        case eTraceRecord::MemRead:
+        case eTraceRecord::MemWrite:
+          event.address = readField<u64>(cursor);
+          event.RA = readField<u64>(cursor);
+          event.index = readField<u8>(cursor);
+          break;
+        case eTraceRecord::MMIORead:
+        case eTraceRecord::MMIOWrite:
+          event.address = readField<u64>(cursor);
+          event.index = readField<u8>(cursor);
+          event.value = readField<u64>(cursor);
+          break;
+        case eTraceRecord::Exception:
+          event.address = readField<u64>(cursor);
+          event.opcode = readField<u16>(cursor);
+          break;
+        case eTraceRecord::TLBFill:
+          event.source = readField<u8>(cursor);
+          event.set = readField<u8>(cursor);
+          event.index = readField<u8>(cursor);
+          event.address = readField<u64>(cursor);
+          event.RA = readField<u64>(cursor);
+          break;
+        case eTraceRecord::Post:
+          event.address = readField<u64>(cursor);
+          break;
+        case eTraceRecord::JITBlock:
+          event.address = readField<u64>(cursor);
+          event.opcode = readField<u32>(cursor);
+          // The block's last instruction, what the interpreter continues after
+          CIA = event.address + (event.opcode ? event.opcode - 1 : 0) * 4;
+          break;
+        default:
+          break;
+        }
+        event.CIA = CIA;
+        if (!callback(event)) {
+          return true;
+        }
+      }
+    }
+    return !broken;
+  }
+
+} // namespace Xe::XCPU
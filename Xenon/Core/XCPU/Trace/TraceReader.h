@@ -0,0 +1,64 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "TraceFormat.h"
+
+namespace Xe::XCPU {
+
+  // A decoded trace record, with the decoder state it applies to
+  struct sTraceEvent {
+    eTraceRecord type = eTraceRecord::Thread;
+    // PPU core and hardware thread (PIR) the record belongs to
+    u8 core = 0;
+    u8 PIR = 0;
+    // Address of the thread's last instruction (the instruction itself for Instr records)
+    u64 CIA = 0;
+    // Instr: opcode. JITBlock: instruction count. Exception: pending mask
+    u32 opcode = 0;
+    // MemRead/MemWrite: EA. MMIO: RA. TLBFill: VA. JITBlock: address. Exception: CIA. Post: code
+    u64 address = 0;
+    // MemRead/MemWrite/TLBFill: RA
+    u64 RA = 0;
+    // GPR/MMIO: value
+    u64 value = 0;
+    // GPR: index. Mem/MMIO: access size. TLBFill: index
+    u8 index = 0;
+    // TLBFill: eTraceTLBSource and set
+    u8 source = 0;
+    u8 set = 0;
+  };
+
+  //
+  // Reads .xtrace files written by TraceRecorder, chunk by chunk.
+  //
+  class TraceReader {
+  public:
+    // Opens a trace and checks its header, returns false if it isn't one.
+    bool Open(const std::filesystem::path &path);
+
+    const sTraceFileHeader &GetHeader() const { return header; }
+
+    // Reads and decompresses the next chunk. Returns false at the end of the file or on a broken chunk.
+    bool ReadChunk(sTraceChunkHeader &chunkHeader, std::vector<u8> &records);
+
+    // Decodes every record from the current position on, in file order, stopping early when callback returns false.
+    // Returns false if the trace ended with a broken chunk.
+    bool ForEach(const std::function<bool(const sTraceEvent &)> &callback);
+
+  private:
+    std::ifstream file{};
+    sTraceFileHeader header{};
+    std::vector<u8> stored{};
+    // Set when the last chunk read was damaged
+    bool broken = false;
+  };
+
+} // namespace Xe::XCPU
@@ -0,0 +1,181 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "TraceRecorder.h"
+
+#include <chrono>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#elif defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "Base/Logging/Log.h"
+#include "Base/Thread.h"
+
+namespace Xe::XCPU {
+
+  //
+  // TraceWriter
+  //
+
+  TraceWriter::TraceWriter(TraceRecorder *recorder, u8 core, u32 flags) :
+    recorder(recorder), core(core), flags(flags), chunk(XE_TRACE_CHUNK_SIZE)
+  {}
+
+  TraceWriter::~TraceWriter() {
+    Flush();
+  }
+
+  void TraceWriter::Flush() {
+    if (!used) {
+      return;
+    }
+    recorder->Submit(core, chunk, used);
+    used = 0;
+    lastThread = 0xFF;
+    lastCIA[0] = lastCIA[1] = ~0ULL;
+  }
+
+  //
+  // TraceRecorder
+  //
+
+  TraceRecorder::TraceRecorder(const std::filesystem::path &path, u32 flags) :
+    path(path), flags(flags)
+  {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR(Xenon, "[Trace]: Unable to create '{}', tracing is disabled.", path.string());
+      return;
+    }
+#ifdef HAVE_ZSTD
+    codec = eTraceCodec::Zstd;
+    compressionContext = ZSTD_createCCtx();
+#elif defined(HAVE_ZLIB)
+    codec = eTraceCodec::Zlib;
+#endif
+    sTraceFileHeader header{};
+    header.startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+    header.flags = flags;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    writerThread = std::thread(&TraceRecorder::writerThreadLoop, this);
+    LOG_INFO(Xenon, "[Trace]: Recording to '{}' ({} compression).", path.string(), GetTraceCodecName(codec));
+  }
+
+  TraceRecorder::~TraceRecorder() {
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      stopping = true;
+    }
+    queueCondition.notify_all();
+    if (writerThread.joinable()) {
+      writerThread.join();
+    }
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx *>(compressionContext));
+#endif
+    if (file.is_open()) {
+      LogStats();
+      file.close();
+    }
+  }
+
+  std::unique_ptr<TraceWriter> TraceRecorder::CreateWriter(u8 core) {
+    if (!IsOpen()) {
+      return nullptr;
+    }
+    return std::make_unique<TraceWriter>(this, core, flags);
+  }
+
+  void TraceRecorder::Submit(u8 core, std::vector<u8> &chunk, size_t size) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    spaceCondition.wait(lock, [this] { return pending.size() < XE_TRACE_MAX_PENDING_CHUNKS || stopping; });
+    if (stopping) {
+      return;
+    }
+    std::vector<u8> replacement{};
+    if (!freeBuffers.empty()) {
+      replacement = std::move(freeBuffers.back());
+      freeBuffers.pop_back();
+    } else {
+      replacement.resize(chunk.size());
+    }
+    pending.push_back({ std::move(chunk), size, core, nextSequence++ });
+    chunk = std::move(replacement);
+    lock.unlock();
+    queueCondition.notify_one();
+  }
+
+  void TraceRecorder::LogStats() {
+    const u64 raw = rawBytes.load(std::memory_order_relaxed);
+    const u64 stored = storedBytes.load(std::memory_order_relaxed);
+    LOG_INFO(Xenon, "[Trace]: {} chunks, {} KiB of records stored in {} KiB ({:.1f}%).",
+      chunksWritten.load(std::memory_order_relaxed), raw / 1024, stored / 1024,
+      raw ? stored * 100.0 / raw : 0.0);
+  }
+
+  void TraceRecorder::writerThreadLoop() {
+    Base::SetCurrentThreadName("[Xe] Trace Writer");
+    std::unique_lock<std::mutex> lock(queueMutex);
+    for (;;) {
+      queueCondition.wait(lock, [this] { return !pending.empty() || stopping; });
+      // Drain everything, even when stopping, so the trace ends where execution did
+      if (pending.empty()) {
+        break;
+      }
+      sPendingChunk chunk = std::move(pending.front());
+      pending.pop_front();
+      lock.unlock();
+      spaceCondition.notify_all();
+
+      writeChunk(chunk);
+
+      lock.lock();
+      freeBuffers.push_back(std::move(chunk.data));
+    }
+  }
+
+  void TraceRecorder::writeChunk(const sPendingChunk &chunk) {
+    sTraceChunkHeader header{};
+    header.rawSize = static_cast<u32>(chunk.size);
+    header.core = chunk.core;
+    header.sequence = chunk.sequence;
+    const u8 *data = chunk.data.data();
+    size_t size = chunk.size;
+
+    // Chunks that don't shrink are stored as is
+#ifdef HAVE_ZSTD
+    compressed.resize(ZSTD_compressBound(chunk.size));
+    const size_t result = ZSTD_compressCCtx(static_cast<ZSTD_CCtx *>(compressionContext),
+      compressed.data(), compressed.size(), chunk.data.data(), chunk.size, 1);
+    if (!ZSTD_isError(result) && result < chunk.size) {
+      header.codec = eTraceCodec::Zstd;
+      data = compressed.data();
+      size = result;
+    }
+#elif defined(HAVE_ZLIB)
+    uLongf compressedSize = compressBound(static_cast<uLong>(chunk.size));
+    compressed.resize(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, chunk.data.data(), static_cast<uLong>(chunk.size),
+      Z_BEST_SPEED) == Z_OK && compressedSize < chunk.size) {
+      header.codec = eTraceCodec::Zlib;
+      data = compressed.data();
+      size = compressedSize;
+    }
+#endif
+
+    header.storedSize = static_cast<u32>(size);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data), size);
+
+    chunksWritten.fetch_add(1, std::memory_order_relaxed);
+    rawBytes.fetch_add(chunk.size, std::memory_order_relaxed);
+    storedBytes.fetch_add(sizeof(header) + size, std::memory_order_relaxed);
+  }
+
+} // namespace Xe::XCPU
@@ -0,0 +1,193 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TraceFormat.h"
+
+struct sPPEState;
+
+// Chunks waiting for the writer thread before PPU threads block on it
+#define XE_TRACE_MAX_PENDING_CHUNKS 64
+
+namespace Xe::XCPU {
+
+  class TraceRecorder;
+
+  // PPE state of the core the calling thread runs, set by every PPU thread. A TraceWriter is only ever used by
+  // its core's thread, so guest memory accesses from anywhere else (the debugger) check this and aren't traced.
+  inline thread_local const sPPEState *tracingPPE = nullptr;
+
+  //
+  // Per PPU core trace buffer, only ever used by the core's own thread.
+  // Records are appended to an uncompressed chunk, which is handed to the recorder once full, so
+  // recording an instruction is a few stores. See TraceFormat.h for the records.
+  //
+  class TraceWriter {
+  public:
+    TraceWriter(TraceRecorder *recorder, u8 core, u32 flags);
+    ~TraceWriter();
+
+    // Optional records, callers skip the work of producing them when off
+    bool TracesGPRs() const { return flags & TraceFlag_GPR; }
+    bool TracesMemory() const { return flags & TraceFlag_Memory; }
+
+    // An instruction about to execute on the given hardware thread (0/1) of this core
+    void Instr(u8 thread, u64 CIA, u32 opcode) {
+      reserve(thread, 13);
+      if (CIA == lastCIA[thread] + 4) {
+        put(eTraceRecord::InstrNext, opcode);
+      } else {
+        put(eTraceRecord::Instr, CIA, opcode);
+      }
+      lastCIA[thread] = CIA;
+    }
+    // GPRs changed since the last call for this thread
+    void GPRDeltas(u8 thread, const u64 *GPR) {
+      u64 *shadow = shadowGPR[thread];
+      reserve(thread, 32 * 10);
+      for (u8 i = 0; i != 32; ++i) {
+        if (GPR[i] != shadow[i]) {
+          shadow[i] = GPR[i];
+          put(eTraceRecord::GPR, i, GPR[i]);
+        }
+      }
+    }
+    // A data access, EA before and RA after translation
+    void MemAccess(u8 thread, u64 EA, u64 RA, u8 size, bool write) {
+      reserve(thread, 18);
+      put(write ? eTraceRecord::MemWrite : eTraceRecord::MemRead, EA, RA, size);
+    }
+    // A SoC or bus device access
+    void MMIO(u8 thread, u64 RA, const u8 *data, u8 size, bool write) {
+      u64 value = 0;
+      memcpy(&value, data, size < 8 ? size : 8);
+      reserve(thread, 18);
+      put(write ? eTraceRecord::MMIOWrite : eTraceRecord::MMIORead, RA, size, value);
+    }
+    // Pending exceptions, only recorded when the mask changed
+    void Exception(u8 thread, u64 CIA, u16 pending) {
+      if (pending == lastPending[thread]) {
+        return;
+      }
+      lastPending[thread] = pending;
+      reserve(thread, 11);
+      put(eTraceRecord::Exception, CIA, pending);
+    }
+    void TLBFill(u8 thread, eTraceTLBSource source, u8 set, u8 index, u64 VA, u64 RA) {
+      reserve(thread, 20);
+      put(eTraceRecord::TLBFill, static_cast<u8>(source), set, index, VA, RA);
+    }
+    void Post(u8 thread, u64 code) {
+      reserve(thread, 9);
+      put(eTraceRecord::Post, code);
+    }
+    void JITBlock(u8 thread, u64 address, u32 instrs) {
+      reserve(thread, 13);
+      put(eTraceRecord::JITBlock, address, instrs);
+      // Whatever the interpreter runs next isn't known to follow the block
+      lastCIA[thread] = ~0ULL;
+    }
+
+    // Hands the records buffered so far to the recorder.
+    void Flush();
+
+  private:
+    // Makes room for a record of up to bytes, and selects the thread records go to.
+    void reserve(u8 thread, size_t bytes) {
+      if (used + bytes + 2 > chunk.size()) {
+        Flush();
+      }
+      if (thread != lastThread) {
+        lastThread = thread;
+        put(eTraceRecord::Thread, static_cast<u8>(core * 2 + thread));
+      }
+    }
+    template <typename... T>
+    void put(eTraceRecord record, T... fields) {
+      chunk[used++] = static_cast<u8>(record);
+      ((memcpy(&chunk[used], &fields, sizeof(T)), used += sizeof(T)), ...);
+    }
+
+    TraceRecorder *recorder = nullptr;
+    const u8 core = 0;
+    const u32 flags = 0;
+    std::vector<u8> chunk{};
+    size_t used = 0;
+    // Decoder state the next record is relative to, reset on every chunk
+    u8 lastThread = 0xFF;
+    u64 lastCIA[2] = { ~0ULL, ~0ULL };
+    // Last recorded register values and exception masks
+    u64 shadowGPR[2][32] = {};
+    u16 lastPending[2] = {};
+  };
+
+  //
+  // Binary execution trace recorder
+  // Owns the trace file and a writer thread that compresses (zstd, else zlib, else stored as is) and
+  // writes the chunks TraceWriters hand off. Producers only block when the writer falls behind by
+  // XE_TRACE_MAX_PENDING_CHUNKS chunks, records are never dropped.
+  //
+  class TraceRecorder {
+  public:
+    TraceRecorder(const std::filesystem::path &path, u32 flags);
+    ~TraceRecorder();
+
+    bool IsOpen() const { return file.is_open(); }
+
+    // Returns a writer for the given PPU core, it must be destroyed before the recorder.
+    std::unique_ptr<TraceWriter> CreateWriter(u8 core);
+    // Queues size bytes of chunk for writing. chunk is replaced by an empty buffer of the same size.
+    void Submit(u8 core, std::vector<u8> &chunk, size_t size);
+
+    // Logs how many records were written and how well they compressed.
+    void LogStats();
+
+  private:
+    struct sPendingChunk {
+      std::vector<u8> data;
+      size_t size = 0;
+      u8 core = 0;
+      u64 sequence = 0;
+    };
+
+    void writerThreadLoop();
+    void writeChunk(const sPendingChunk &chunk);
+
+    const std::filesystem::path path;
+    const u32 flags = 0;
+    std::ofstream file{};
+    eTraceCodec codec = eTraceCodec::None;
+
+    // Filled chunks and recycled buffers, guarded by queueMutex
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::condition_variable spaceCondition;
+    std::deque<sPendingChunk> pending{};
+    std::vector<std::vector<u8>> freeBuffers{};
+    u64 nextSequence = 0;
+    bool stopping = false;
+
+    std::thread writerThread{};
+    // Only used by the writer thread
+    std::vector<u8> compressed{};
+    void *compressionContext = nullptr;
+
+    std::atomic<u64> chunksWritten = 0;
+    std::atomic<u64> rawBytes = 0;
+    std::atomic<u64> storedBytes = 0;
+  };
+
+} // namespace Xe::XCPU
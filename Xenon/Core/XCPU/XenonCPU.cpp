@@ -4,6 +4,7 @@
 
 #include "Base/Thread.h"
 #include "Base/Logging/Log.h"
+#include "Base/PathUtil.h"
 #include "Core/XCPU/XenonCPU.h"
 #include "Interpreter/PPCInterpreter.h"
 
@@ -122,23 +123,52 @@ namespace Xe::XCPU {
     // Setup SOC blocks.
     xenonContext->socPRVBlock.get()->PowerOnResetStatus.AsBITS.SecureMode = 1; // CB Checks this.
     xenonContext->socPRVBlock.get()->PowerManagementControl.AsULONGLONG = 0x382C00000000B001ULL; // Power Management Control.
+
+    // Setup the guest profiler, it starts with the cores.
+    if (Config::debug.guestProfilerRate) {
+      guestProfiler = std::make_unique<STRIP_UNIQUE(guestProfiler)>(Config::debug.guestProfilerRate);
+      if (Config::debug.guestProfilerSymbols != "none") {
+        guestProfiler->Symbols().Load(Config::debug.guestProfilerSymbols);
+      }
+    }
+
+    // Setup the trace recorder, the cores get their writers when created.
+    if (Config::debug.createTraceFile) {
+      const u32 traceFlags = (Config::debug.traceRegisters ? TraceFlag_GPR : 0) |
+        (Config::debug.traceMemory ? TraceFlag_Memory : 0);
+      traceRecorder = std::make_unique<STRIP_UNIQUE(traceRecorder)>(
+        Base::FS::GetUserPath(Base::FS::PathType::LogDir) / "xenon.xtrace", traceFlags);
+    }
   }
 
   XenonCPU::~XenonCPU() {
     // First kill timer thread.
     timeBaseThreadActive.store(false);
 
+    // Then the profiler, it reads the cores' state.
+    if (guestProfiler) {
+      guestProfiler->Stop();
+      guestProfiler->LogReport();
+      guestProfiler->WriteFoldedStacks(Base::FS::GetUserPath(Base::FS::PathType::LogDir) / "guest_profile.folded");
+      guestProfiler.reset();
+    }
+
     LOG_INFO(Xenon, "Shutting PPU cores down...");
     ppu0.reset();
     ppu1.reset();
     ppu2.reset();
+    // After the cores, their writers flush into it
+    traceRecorder.reset();
     xenonContext.reset();
   }
 
-  void XenonCPU::Start(u64 resetVector) {
+  void XenonCPU::Start(u64 resetVector, bool parked) {
     // If we already have active objects, halt cpu and kill threads
     if (ppu0.get()) {
       Halt();
+      if (guestProfiler) {
+        guestProfiler->Stop();
+      }
       ppu0.reset();
       ppu1.reset();
       ppu2.reset();
@@ -147,20 +177,34 @@ namespace Xe::XCPU {
     ppu0 = std::make_unique<STRIP_UNIQUE(ppu0)>(xenonContext.get(), resetVector, 0); // Threads 0-1
     ppu1 = std::make_unique<STRIP_UNIQUE(ppu1)>(xenonContext.get(), resetVector, 2); // Threads 2-3
     ppu2 = std::make_unique<STRIP_UNIQUE(ppu2)>(xenonContext.get(), resetVector, 4); // Threads 4-5
+    attachTraceWriters();
+    if (parked) {
+      pauseTimeBase();
+      ppu0->RequestPark();
+      ppu1->RequestPark();
+      ppu2->RequestPark();
+    }
     // Start execution on the main thread
     ppu0->StartExecution();
     // Start execution on the other threads
     ppu1->StartExecution();
     ppu2->StartExecution();
+    if (guestProfiler) {
+      guestProfiler->Start({ ppu0.get(), ppu1.get(), ppu2.get() });
+    }
   }
 
   void XenonCPU::LoadElf(const std::string path) {
+    if (guestProfiler) {
+      guestProfiler->Stop();
+    }
     ppu0.reset();
     ppu1.reset();
     ppu2.reset();
     ppu0 = std::make_unique<STRIP_UNIQUE(ppu0)>(xenonContext.get(), 0, 0); // Threads 0-1
     ppu1 = std::make_unique<STRIP_UNIQUE(ppu1)>(xenonContext.get(), 0, 2); // Threads 2-3
     ppu2 = std::make_unique<STRIP_UNIQUE(ppu2)>(xenonContext.get(), 0, 4); // Threads 4-5
+    attachTraceWriters();
     std::filesystem::path filePath{ path };
     std::ifstream file{ filePath, std::ios_base::in | std::ios_base::binary };
     u64 fileSize = 0;
@@ -187,6 +231,11 @@ namespace Xe::XCPU {
     // Start execution on the other threads
     ppu1->StartExecution(false);
     ppu2->StartExecution(false);
+    if (guestProfiler) {
+      // The ELF's own symbols, on top of any configured ones
+      guestProfiler->Symbols().LoadElf(filePath);
+      guestProfiler->Start({ ppu0.get(), ppu1.get(), ppu2.get() });
+    }
   }
 
   void XenonCPU::Reset() {
@@ -276,6 +325,81 @@ namespace Xe::XCPU {
     return nullptr;
   }
 
+  bool XenonCPU::Quiesce(std::chrono::milliseconds timeout) {
+    pauseTimeBase();
+    if (!ppu0.get()) {
+      return true;
+    }
+    PPU *ppus[] = { ppu0.get(), ppu1.get(), ppu2.get() };
+    for (PPU *ppu : ppus) {
+      ppu->RequestPark();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (PPU *ppu : ppus) {
+      const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      if (!ppu->WaitParked(std::max(remaining, std::chrono::milliseconds(0)))) {
+        LOG_ERROR(Xenon, "PPU{} didn't park within {}ms", ppu->GetPPUState()->ppuID, timeout.count());
+        Resume();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void XenonCPU::Resume() {
+    if (ppu0.get()) {
+      ppu0->Unpark();
+      ppu1->Unpark();
+      ppu2->Unpark();
+    }
+    resumeTimeBase();
+  }
+
+  void XenonCPU::SerializeState(Xe::SaveState::StateStream &stream) {
+    xenonContext->SerializeState(stream);
+    stream.DoMarker("PPU0");
+    ppu0->SerializeState(stream);
+    stream.DoMarker("PPU1");
+    ppu1->SerializeState(stream);
+    stream.DoMarker("PPU2");
+    ppu2->SerializeState(stream);
+  }
+
+  void XenonCPU::attachTraceWriters() {
+    if (!traceRecorder) {
+      return;
+    }
+    ppu0->SetTraceWriter(traceRecorder->CreateWriter(0));
+    ppu1->SetTraceWriter(traceRecorder->CreateWriter(1));
+    ppu2->SetTraceWriter(traceRecorder->CreateWriter(2));
+  }
+
+  void XenonCPU::pauseTimeBase() {
+    std::lock_guard lock(timeBaseMutex);
+    timeBasePaused.store(true);
+    // A tick that saw the time base running finishes first
+    while (timeBaseTicking.load()) {
+      std::this_thread::yield();
+    }
+  }
+
+  void XenonCPU::resumeTimeBase() {
+    std::lock_guard lock(timeBaseMutex);
+    timeBasePaused.store(false);
+  }
+
+  void XenonCPU::tickTimeBase(u64 ticks) {
+    // Flag the tick before checking the pause, pauseTimeBase does it the other way around
+    timeBaseTicking.store(true);
+    if (xenonContext->timeBaseActive && !timeBasePaused.load()) {
+      xenonContext->timeBaseGlobalCounter.fetch_add(ticks, std::memory_order_relaxed);
+      ppu0->UpdateTimeBase(ticks);
+      ppu1->UpdateTimeBase(ticks);
+      ppu2->UpdateTimeBase(ticks);
+    }
+    timeBaseTicking.store(false, std::memory_order_release);
+  }
+
   // TimeBase thread for increasing global timer counter.
   void XenonCPU::timeBaseThreadLoop() {
     Base::SetCurrentThreadName("[Xe] CPU Timer Thread");
@@ -295,11 +419,7 @@ namespace Xe::XCPU {
       while (__rdtsc() < nextCycle) {}
 
       // We're waiting for approx 2500 Ns, which represent 125 XenonCPU cycles.
-      if (xenonContext->timeBaseActive) {
-        ppu0->UpdateTimeBase(125);
-        ppu1->UpdateTimeBase(125);
-        ppu2->UpdateTimeBase(125);
-      }
+      tickTimeBase(125);
       // Update our start cycle.
       startCycle = __rdtsc();
       // Add our target cycles amount.
@@ -322,12 +442,8 @@ namespace Xe::XCPU {
       // ticks = elapsed_ns / 20
       u64 ticks = static_cast<u64>(elapsed) / 20ULL;
       if (ticks == 0) continue;
-      // Accumulate globally
-      if (xenonContext->timeBaseActive) {
-        ppu0->UpdateTimeBase(ticks);
-        ppu1->UpdateTimeBase(ticks);
-        ppu2->UpdateTimeBase(ticks);
-      }
+      // Accumulate globally, unless held for a save state
+      tickTimeBase(ticks);
     }
 #endif // _WIN32
   }
@@ -7,6 +7,8 @@
 #include <filesystem>
 
 #include "Core/XCPU/PPU/PPU.h"
+#include "Core/XCPU/Profiler/GuestProfiler.h"
+#include "Core/XCPU/Trace/TraceRecorder.h"
 #include "Core/RootBus/RootBus.h"
 
 namespace Xe::XCPU {
@@ -27,7 +29,8 @@ namespace Xe::XCPU {
     ~XenonCPU();
 
     // Starts the CPU at the given reset vector. (Usually address 0x100).
-    void Start(u64 resetVector = 0x100);
+    // Started parked, it's left quiesced before running anything, for a save state to be loaded into it.
+    void Start(u64 resetVector = 0x100, bool parked = false);
     // Resets the CPU to POR state and efectively restarts execution.
     void Reset();
     // Halts one or more cores.
@@ -44,10 +47,29 @@ namespace Xe::XCPU {
     bool IsHalted();
     // Returns true of the halt was due to a 'trap' guest exception.
     bool IsHaltedByGuest();
+    // Save states. Parks every PPU in between time slices and holds the time base.
+    // Returns false if a PPU didn't park in time, everything is left running then.
+    bool Quiesce(std::chrono::milliseconds timeout);
+    void Resume();
+    // The CPU context and every PPU, only while quiesced.
+    void SerializeState(Xe::SaveState::StateStream &stream);
     // Returns the IIC pointer from our context.  
     XenonIIC *GetIICPointer() { return &xenonContext->iic; }
     // Returns a pointer to a given PPU.
     PPU *GetPPU(u8 ppuID);
+    // Returns the time base ticks elapsed since power on (50MHz), stops while the time base is off.
+    u64 GetTimeBase() const { return xenonContext->timeBaseGlobalCounter.load(std::memory_order_relaxed); }
+    // Returns the guest sampling profiler, nullptr when it's disabled.
+    GuestProfiler *GetGuestProfiler() { return guestProfiler.get(); }
+    // Returns the binary trace recorder, nullptr when it's disabled.
+    TraceRecorder *GetTraceRecorder() { return traceRecorder.get(); }
+    // Arms the execution milestone on the given address, 0 disarms it. See XenonContext::pcWatch.
+    void WatchPC(u64 address) {
+      xenonContext->pcWatchHitTime.store(0, std::memory_order_relaxed);
+      xenonContext->pcWatch.store(address, std::memory_order_release);
+    }
+    // Returns the host steady_clock time (ns) the watched address was reached at, 0 if it wasn't yet.
+    u64 GetPCWatchHitTime() const { return xenonContext->pcWatchHitTime.load(std::memory_order_acquire); }
 
   private:
     // Global Xenon CPU Content (shared between PPUs)
@@ -59,13 +81,32 @@ namespace Xe::XCPU {
     // High resolution timer thread for accumulating timebase ticks.
     std::thread timeBaseThread{};
     std::atomic<bool> timeBaseThreadActive{ false };
+    // Time base held for a save state. The timer thread flags each tick in timeBaseTicking and checks
+    // timeBasePaused inside it, so pausing only has to wait out a tick that was already underway.
+    // timeBaseMutex serializes pausing and resuming, the timer thread never takes it.
+    std::mutex timeBaseMutex{};
+    std::atomic<bool> timeBasePaused{ false };
+    std::atomic<bool> timeBaseTicking{ false };
+    // Holds the time base, returns once no tick is in flight
+    void pauseTimeBase();
+    void resumeTimeBase();
+    // Advances every core's time base, unless it's held
+    void tickTimeBase(u64 ticks);
     // Timer thread loop function.
     void timeBaseThreadLoop();
+    // Gives every core a writer of the trace recorder, if there's one.
+    void attachTraceWriters();
 
     // Power Processing Units, the effective execution units inside the Xbox 360 CPU.
     std::unique_ptr<PPU> ppu0{};
     std::unique_ptr<PPU> ppu1{};
     std::unique_ptr<PPU> ppu2{};
+
+    // Guest PC sampling profiler, see Config::debug.guestProfilerRate
+    std::unique_ptr<GuestProfiler> guestProfiler{};
+
+    // Binary execution trace, see Config::debug.createTraceFile
+    std::unique_ptr<TraceRecorder> traceRecorder{};
   };
 
 } // Xe::XCPU
\ No newline at end of file
@@ -42,7 +42,12 @@ CommandProcessor::CommandProcessor(RAM *ramPtr, XenosState *statePtr, Render::Re
 }
 
 CommandProcessor::~CommandProcessor() {
-  cpWorkerThreadRunning = false;
+  {
+    // Wakes it up if it's paused
+    std::lock_guard lock(cpPauseMutex);
+    cpWorkerThreadRunning = false;
+  }
+  cpPauseCV.notify_all();
   if (cpWorkerThread.joinable()) {
     cpWorkerThread.join();
   }
@@ -96,6 +101,7 @@ void CommandProcessor::CPUpdateRBBase(u32 address) {
   if (!address)
     return;
 
+  cpRingBufferBaseAddress = address;
   cpRingBufferBasePtr = ram->GetPointerToAddress(address);
   LOG_DEBUG(Xenos, "CP: Updating RingBuffer Base Address: 0x{:X}", address);
   
@@ -115,6 +121,57 @@ void CommandProcessor::CPUpdateRBWritePointer(u32 offset) {
   cpWritePtrIndex = offset;
 }
 
+bool CommandProcessor::Pause(std::chrono::milliseconds timeout) {
+  std::unique_lock lock(cpPauseMutex);
+  cpPauseRequested = true;
+  if (!cpPauseCV.wait_for(lock, timeout, [this] { return cpPaused || !cpWorkerThreadRunning; })) {
+    cpPauseRequested = false;
+    lock.unlock();
+    cpPauseCV.notify_all();
+    LOG_ERROR(Xenos, "CP: Didn't park within {}ms", timeout.count());
+    return false;
+  }
+  return true;
+}
+
+void CommandProcessor::Resume() {
+  {
+    std::lock_guard lock(cpPauseMutex);
+    cpPauseRequested = false;
+  }
+  cpPauseCV.notify_all();
+}
+
+bool CommandProcessor::cpCheckPause() {
+  if (!cpPauseRequested.load(std::memory_order_relaxed))
+    return false;
+  std::unique_lock lock(cpPauseMutex);
+  cpPaused = true;
+  cpPauseCV.notify_all();
+  cpPauseCV.wait(lock, [this] { return !cpPauseRequested.load() || !cpWorkerThreadRunning; });
+  cpPaused = false;
+  return std::exchange(cpStateLoaded, false);
+}
+
+void CommandProcessor::SerializeState(Xe::SaveState::StateStream &stream) {
+  size_t ringBufferSize = cpRingBufferSize.load();
+  u64 ringBufferSize64 = ringBufferSize;
+  u32 writePtrIndex = cpWritePtrIndex.load();
+  stream.Do(cpRingBufferBaseAddress, ringBufferSize64, cpReadPtrIndex, writePtrIndex);
+  stream.Do(cpPFPuCodeAddress, cpMEuCodeWriteAddress, cpMEuCodeReadAddress, cpMEuCodeSize, cpPFPuCodeSize);
+  stream.DoMap(cpMEuCodeData);
+  stream.DoMap(cpPFPuCodeData);
+  stream.DoVector(cpME_PM4_ME_INIT_Data);
+  stream.Do(binSelect, binMask);
+  if (stream.IsLoading() && !stream.Failed()) {
+    cpRingBufferSize = static_cast<size_t>(ringBufferSize64);
+    cpWritePtrIndex = writePtrIndex;
+    cpRingBufferBasePtr = cpRingBufferBaseAddress ? ram->GetPointerToAddress(cpRingBufferBaseAddress) : nullptr;
+    std::lock_guard lock(cpPauseMutex);
+    cpStateLoaded = true;
+  }
+}
+
 void CommandProcessor::cpWorkerThreadLoop() {
   Base::SetCurrentThreadName("[Xe] Command Processor");
   while (cpWorkerThreadRunning) {
@@ -122,11 +179,13 @@ void CommandProcessor::cpWorkerThreadLoop() {
     while (cpWorkerThreadRunning && (cpRingBufferBasePtr == nullptr || cpReadPtrIndex == writePtrIndex)) {
       // Stall until we're told otherwise
       std::this_thread::sleep_for(10ns);
+      cpCheckPause();
       writePtrIndex = cpWritePtrIndex.load();
     }
 
     // Shutdown if we were told to
-    cpWorkerThreadRunning = XeRunning;
+    if (!XeRunning)
+      cpWorkerThreadRunning = false;
     if (!cpWorkerThreadRunning)
       break;
 
@@ -150,9 +209,16 @@ u32 CommandProcessor::cpExecutePrimaryBuffer(u32 readIndex, u32 writeIndex) {
       break;
     }
     // Shutdown if we were told to
-    cpWorkerThreadRunning = XeRunning;
+    if (!XeRunning)
+      cpWorkerThreadRunning = false;
     if (!cpWorkerThreadRunning)
       break;
+    // Parked for a save state, the read index so far is part of it
+    if (cpPauseRequested.load(std::memory_order_relaxed)) {
+      cpReadPtrIndex = static_cast<u32>(cpRingBufer.readOffset() / sizeof(u32));
+      if (cpCheckPause())
+        return cpReadPtrIndex;
+    }
   } while (cpRingBufer.readCount() && cpWorkerThreadRunning);
 
   return writeIndex; // Set Read and Write index equal, signaling buffer processed.
@@ -173,7 +239,8 @@ void CommandProcessor::cpExecuteIndirectBuffer(u32 bufferPtr, u32 bufferSize) {
       break;
     }
     // Shutdown if we were told to
-    cpWorkerThreadRunning = XeRunning;
+    if (!XeRunning)
+      cpWorkerThreadRunning = false;
     if (!cpWorkerThreadRunning)
       break;
   } while (ringBufer.readCount() && cpWorkerThreadRunning);
@@ -237,7 +304,8 @@ bool CommandProcessor::ExecutePacketType0(RingBuffer *ringBuffer, u32 packetData
 
   for (u64 idx = 0; cpWorkerThreadRunning && idx < regCount; idx++) {
     // Shutdown if we were told to
-    cpWorkerThreadRunning = XeRunning;
+    if (!XeRunning)
+      cpWorkerThreadRunning = false;
     if (!cpWorkerThreadRunning)
       break;
     // Get the data to be written to the (internal) Register.
@@ -371,6 +439,9 @@ bool CommandProcessor::ExecutePacketType3(RingBuffer *ringBuffer, u32 packetData
   case Xe::XGPU::PM4_EVENT_WRITE_SHD:
     result = ExecutePacketType3_EVENT_WRITE_SHD(ringBuffer, packetData, dataCount);
     break;
+  case Xe::XGPU::PM4_MEM_WRITE:
+    result = ExecutePacketType3_MEM_WRITE(ringBuffer, packetData, dataCount);
+    break;
   case Xe::XGPU::PM4_SET_BIN_MASK_LO:
     result = ExecutePacketType3_SET_BIN_MASK_LO(ringBuffer, packetData, dataCount);
     break;
@@ -504,6 +575,7 @@ bool CommandProcessor::ExecutePacketType3_COND_WRITE(RingBuffer *ringBuffer, u32
       u8 *addrPtr = ram->GetPointerToAddress(static_cast<u32>(writeReg) & ~0x3);
       writeData = xeEndianSwap(writeData, endianness);
       memcpy(addrPtr, &writeData, sizeof(writeData));
+      ram->MarkWritten(static_cast<u32>(writeReg) & ~0x3, sizeof(writeData));
     } else { // Register
       state->WriteRegister(writeReg, writeData);
     }
@@ -679,10 +751,7 @@ bool CommandProcessor::ExecutePacketType3_IM_LOAD(RingBuffer *ringBuffer, u32 pa
     };
     LOG_DEBUG(Xenos, "[CP::IM_LOAD] {}Shader CRC: 0x{:08X}", shaderType == eShaderType::Pixel ? "Pixel" : "Vertex", crc);
 
-    {
-      std::lock_guard<std::mutex> qlock(render->renderQueueMutex);
-      render->renderQueue.push(std::move(cmd));
-    }
+    render->SubmitCommand(std::move(cmd));
 #endif
   } break;
   case eShaderType::Unknown:
@@ -743,10 +812,7 @@ bool CommandProcessor::ExecutePacketType3_IM_LOAD_IMMEDIATE(RingBuffer *ringBuff
     };
     LOG_DEBUG(Xenos, "[CP::IM_LOAD_IMMEDIATE] {}Shader CRC: 0x{:08X}", shaderType == eShaderType::Pixel ? "Pixel" : "Vertex", crc);
 
-    {
-      std::lock_guard<std::mutex> qlock(render->renderQueueMutex);
-      render->renderQueue.push(std::move(cmd));
-    }
+    render->SubmitCommand(std::move(cmd));
 #endif
   } break;
   case eShaderType::Unknown:
@@ -804,7 +870,6 @@ bool CommandProcessor::ExecutePacketType3_INTERRUPT(RingBuffer *ringBuffer, u32
   // CPU(s) to interrupt
   const u32 cpuMask = ringBuffer->ReadAndSwap<u32>();
   LOG_DEBUG(Xenos, "[CP]: Executing Packet3 XPS INTERRUPT. CPU Mask {:#x}", cpuMask);
-  std::this_thread::sleep_for(100ms);
   parentBus->RouteInterrupt(PRIO_XPS, cpuMask);
   return true;
 }
@@ -864,6 +929,30 @@ bool CommandProcessor::ExecutePacketType3_EVENT_WRITE_SHD(RingBuffer *ringBuffer
 
   u8 *addrPtr = ram->GetPointerToAddress(address);
   memcpy(addrPtr, &writeValue, sizeof(writeValue));
+  ram->MarkWritten(address, sizeof(writeValue));
+
+  return true;
+}
+
+bool CommandProcessor::ExecutePacketType3_MEM_WRITE(RingBuffer *ringBuffer, u32 packetData, u32 dataCount) {
+  // Writes N 32-bit words to memory
+  u32 address = ringBuffer->ReadAndSwap<u32>();
+  const u32 wordCount = dataCount - 1;
+  const auto endianness = static_cast<eEndian>(address & 0x3);
+  address &= ~0x3;
+
+  u8 *addrPtr = ram->GetPointerToAddress(address);
+  if (!addrPtr) {
+    LOG_ERROR(Xenos, "[CP][PT3](MEM_WRITE): Invalid address {:#x}", address);
+    ringBuffer->AdvanceRead(wordCount * sizeof(u32));
+    return true;
+  }
+
+  for (u32 i = 0; i != wordCount; ++i) {
+    const u32 value = xeEndianSwap(ringBuffer->ReadAndSwap<u32>(), endianness);
+    memcpy(addrPtr + i * sizeof(u32), &value, sizeof(value));
+  }
+  ram->MarkWritten(address, wordCount * sizeof(u32));
 
   return true;
 }
@@ -874,13 +963,13 @@ bool CommandProcessor::ExecutePacketType3_WAIT_REG_MEM(RingBuffer *ringBuffer, u
   const u32 pollReg = ringBuffer->ReadAndSwap<u32>();
   const u32 ref = ringBuffer->ReadAndSwap<u32>();
   const u32 mask = ringBuffer->ReadAndSwap<u32>();
-  // Time to live
-  const u32 wait = ringBuffer->ReadAndSwap<u32>();
+  // Poll interval, unused as we get woken up by the write itself
+  [[maybe_unused]] const u32 wait = ringBuffer->ReadAndSwap<u32>();
 
   const bool isMemory = (waitInfo & 0x10) != 0;
 
-  bool matched = false;
-  do {
+  // Evaluated again every time the polled address/register gets written
+  auto poll = [&]() -> bool {
     u32 value = 0;
     if (isMemory) {
       u32 addr = pollReg & ~0x3;
@@ -909,45 +998,34 @@ bool CommandProcessor::ExecutePacketType3_WAIT_REG_MEM(RingBuffer *ringBuffer, u
     }
     switch (waitInfo & 0x7) {
     case 0: // Never
-      matched = false;
-      break;
+      return false;
     case 1: // Less than reference
-      matched = (value & mask) < ref;
-      break;
+      return (value & mask) < ref;
     case 2: // Less than or equal to reference
-      matched = (value & mask) <= ref;
-      break;
+      return (value & mask) <= ref;
     case 3: // Equal to reference
-      matched = (value & mask) == ref;
-      break;
+      return (value & mask) == ref;
     case 4: // Not equal to reference
-      matched = (value & mask) != ref;
-      break;
+      return (value & mask) != ref;
     case 5: // Greater than or equal to reference
-      matched = (value & mask) >= ref;
-      break;
+      return (value & mask) >= ref;
     case 6: // Greater than reference
-      matched = (value & mask) > ref;
-      break;
+      return (value & mask) > ref;
     case 7: // Always
-      matched = true;
-      break;
-    }
-
-    if (!matched) {
-#ifndef NO_GFX
-      render->waiting = true;
-      render->waitTime = wait;
-#endif
-      if (wait >= 0x100) {
-        // Wait
-        std::this_thread::sleep_for(std::chrono::milliseconds(wait / 0x100));
-      } else {
-        // Yield
-        std::this_thread::yield();
-      }
+      return true;
     }
-  } while (!matched);
+    return false;
+  };
+  auto stop = [this]() -> bool {
+    return !cpWorkerThreadRunning || !XeRunning;
+  };
+
+  // Sleep until a write satisfies the condition
+  if (isMemory) {
+    ram->GetWriteWaiters().WaitUntil(pollReg & ~0x3, sizeof(u32), poll, stop);
+  } else {
+    state->registerWaiters.WaitUntil(pollReg, 1, poll, stop);
+  }
   return true;
 }
 
@@ -1082,10 +1160,7 @@ bool CommandProcessor::ExecutePacketType3_DRAW(RingBuffer *ringBuffer, u32 packe
       cmd.type = Render::RenderCommandType::CopyResolve;
       cmd.payload = Render::RenderCommand::CopyResolveCmd{ state };
 
-      {
-        std::lock_guard<std::mutex> lock(render->renderQueueMutex);
-        render->renderQueue.push(cmd);
-      }
+      render->SubmitCommand(std::move(cmd));
 #endif
       return true;
     }
@@ -1113,10 +1188,7 @@ bool CommandProcessor::ExecutePacketType3_DRAW(RingBuffer *ringBuffer, u32 packe
       cmd.payload = Render::RenderCommand::DrawCmd{ params };
     }
 
-    {
-      std::lock_guard<std::mutex> lock(render->renderQueueMutex);
-      render->renderQueue.push(std::move(cmd));
-    }
+    render->SubmitCommand(std::move(cmd));
 #endif
 #ifndef NO_GFX
     LOG_DEBUG(Xenos, "[CP] Draw {}: PrimType {}, IndexCount {}",
@@ -1198,32 +1270,37 @@ bool CommandProcessor::ExecutePacketType3_LOAD_ALU_CONSTANT(RingBuffer* ringBuff
     u32 data = 0;
     u8 *dataPtr = ram->GetPointerToAddress(readAddress + n * 4);
     memcpy(&data, dataPtr, sizeof(data));
+    // Goes through the register file, so constant dirty tracking sees it
+    state->WriteRegister(static_cast<XeRegister>(index), byteswap_be(data));
+  }
 #ifndef NO_GFX
-    Render::RenderCommand cmd{};
-    cmd.type = Render::RenderCommandType::UploadBuffer;
-
-    cmd.payload = Render::RenderCommand::UploadBufferCmd{
-      "ALUConsts"_j,
-      {},
-      Render::eBufferType::Storage,
-      Render::eBufferUsage::DynamicDraw
-    };
-
-    auto &upload = std::get<Render::RenderCommand::UploadBufferCmd>(cmd.payload);
-
-    upload.data.resize(sizeInDwords * 4);
+  // Nothing was loaded, nothing to upload
+  if (sizeInDwords == 0)
+    return true;
+  // Payload lives in the upload arena, one command for the whole range
+  u64 arenaMark = 0;
+  const u64 uploadSize = static_cast<u64>(sizeInDwords) * 4;
+  u8 *upload = render->AllocateUpload(uploadSize, arenaMark);
+  if (!upload)
+    return true;
 
-    for (u32 i = 0; i < sizeInDwords; ++i) {
-      u32 v = state->ReadRegister(static_cast<XeRegister>(index - sizeInDwords + i));
-      memcpy(upload.data.data() + i * 4, &v, 4);
-    }
+  for (u32 i = 0; i < sizeInDwords; ++i) {
+    u32 v = state->ReadRegister(static_cast<XeRegister>(index - sizeInDwords + i));
+    memcpy(upload + i * 4, &v, 4);
+  }
 
-    {
-      std::lock_guard<std::mutex> lock(render->renderQueueMutex);
-      render->renderQueue.push(std::move(cmd));
-    }
+  Render::RenderCommand cmd{};
+  cmd.type = Render::RenderCommandType::UploadBuffer;
+  cmd.payload = Render::RenderCommand::UploadBufferCmd{
+    "ALUConsts"_j,
+    upload,
+    uploadSize,
+    arenaMark,
+    Render::eBufferType::Storage,
+    Render::eBufferUsage::DynamicDraw
+  };
+  render->SubmitCommand(std::move(cmd));
 #endif
-  }
   return true;
 }
 
@@ -18,8 +18,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 
@@ -28,6 +30,7 @@
 
 #include "Core/RAM/RAM.h"
 #include "Core/PCI/Bridge/PCIBridge.h"
+#include "Core/SaveState/StateStream.h"
 #include "Core/XGPU/Microcode/ASTBlock.h"
 #include "Core/XGPU/PM4Opcodes.h"
 #include "Core/XGPU/RingBuffer.h"
@@ -104,6 +107,13 @@ public:
 
   void CPSetSQProgramCntl(u32 value);
 
+  // Save states. Parks the worker in between primary buffer packets (or while idle), false on timeout.
+  // Packets waiting on memory or a register keep it from parking until the wait is over.
+  bool Pause(std::chrono::milliseconds timeout);
+  void Resume();
+  // Ring buffer, microcode and bin state, only while paused. A load restarts the worker at the loaded read index.
+  void SerializeState(Xe::SaveState::StateStream &stream);
+
 private:
   // PCI Bridge pointer. Used for interrupts
   PCIBridge *parentBus{};
@@ -123,6 +133,17 @@ private:
   // Worker thread running
   volatile bool cpWorkerThreadRunning = true;
 
+  // Save state parking, see Pause()
+  std::atomic<bool> cpPauseRequested = false;
+  bool cpPaused = false;
+  // A state was loaded while parked, the worker drops the buffer it was in
+  bool cpStateLoaded = false;
+  std::mutex cpPauseMutex;
+  std::condition_variable cpPauseCV;
+
+  // Parks the worker if a pause was requested, returns true if a state was loaded meanwhile
+  bool cpCheckPause();
+
   // Command Processor Worker Thread Loop
   // Whenever there's valid commands in the read/write Ptrs, this will process 
   // all commands and perform tasks associated with them
@@ -154,8 +175,9 @@ private:
   // Since we don't have to deal with buffers, and simply read/write to memory, 
   // we can directly use pointers to real memory like hardware does.
 
-  // CP RingBuffer Base Address in memory.
+  // CP RingBuffer Base Address in memory, and the guest address it points to.
   std::atomic<u8*> cpRingBufferBasePtr = nullptr;
+  u32 cpRingBufferBaseAddress = 0;
   
   // RingBuffer Size.
   std::atomic<size_t> cpRingBufferSize = 0;
@@ -194,6 +216,7 @@ private:
   bool ExecutePacketType3_SET_CONSTANT2(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
   bool ExecutePacketType3_SET_SHADER_CONSTANTS(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
   bool ExecutePacketType3_EVENT_WRITE_SHD(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
+  bool ExecutePacketType3_MEM_WRITE(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
   bool ExecutePacketType3_IM_LOAD(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
   bool ExecutePacketType3_IM_LOAD_IMMEDIATE(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
   bool ExecutePacketType3_SET_CONSTANT(RingBuffer *ringBuffer, u32 packetData, u32 dataCount);
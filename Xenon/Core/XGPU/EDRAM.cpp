@@ -47,6 +47,17 @@ Xe::XGPU::EDRAM::~EDRAM() {
   edramState.reset();
 }
 
+void Xe::XGPU::EDRAM::SerializeState(Xe::SaveState::StateStream &stream) {
+  EDRAMState &state = *edramState;
+  stream.Do(state.edramBusy, state.readRegisterIndex, state.writeRegisterIndex, state.readData, state.az0BCRegIndex,
+    state.az1BCRegIndex, state.reg41Index, state.reg1041Index);
+  stream.DoVector(state.edramRegs);
+  stream.DoVector(state.az0Data);
+  stream.DoVector(state.az1Data);
+  stream.DoVector(state.reg41Data);
+  stream.DoVector(state.reg1041Data);
+}
+
 void Xe::XGPU::EDRAM::SetRWRegIndex(eRegIndexType indexType, u32 index) {
   switch (indexType) {
   case Xe::XGPU::readIndex:
@@ -8,6 +8,7 @@
 
 #include "Base/Types.h"
 #include "Base/Logging/Log.h"
+#include "Core/SaveState/StateStream.h"
 
 namespace Xe::XGPU {
 
@@ -81,6 +82,9 @@ public:
   u32 ReadCRC_AZ0_BC();
   u32 ReadCRC_AZ1_BC();
 
+  // Save states
+  void SerializeState(Xe::SaveState::StateStream &stream);
+
   // Returns true if the edram is currently busy with work.
   bool isEdramBusy() { return edramState.get()->edramBusy; };
 private:
@@ -0,0 +1,290 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "FrameDumper.h"
+
+#include <fstream>
+
+#include "Base/Arch.h"
+#include "Base/CRCHash.h"
+#include "Base/Logging/Log.h"
+
+#if defined(ARCH_X86_64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace Xe::XGPU {
+
+// Offset (in pixels) of (x, y) inside a 2D tiled surface of the given pitch (see GetTiledPitch).
+// Same math as the fb_deswizzle compute shader.
+// Pixels x..x+3 (with x aligned to 4) are always contiguous, which is what the SIMD paths rely on.
+static inline u32 GetTiledOffset(u32 pitch, u32 x, u32 y) {
+  return ((((y & ~31u) * pitch) + (x & ~31u) * 32) +
+         (((x & 3) + ((y & 1) << 2) + ((x & 28) << 1) + ((y & 30) << 5)) ^
+         ((y & 8) << 2)));
+}
+
+// ARGB (BGRA in memory) -> RGBA
+static inline void ConvertPixel(const u8 *src, u8 *dst) {
+  dst[0] = src[2];
+  dst[1] = src[1];
+  dst[2] = src[0];
+  dst[3] = src[3];
+}
+
+static void UntileRowScalar(const u8 *tiled, u8 *row, u32 width, u32 y, u32 x) {
+  const u32 pitch = GetTiledPitch(width);
+  for (; x < width; ++x) {
+    ConvertPixel(tiled + GetTiledOffset(pitch, x, y) * sizeof(u32), row + x * sizeof(u32));
+  }
+}
+
+static void UntileSurfaceScalar(const u8 *tiled, u8 *rgba, u32 width, u32 height) {
+  for (u32 y = 0; y != height; ++y) {
+    UntileRowScalar(tiled, rgba + static_cast<u64>(y) * width * sizeof(u32), width, y, 0);
+  }
+}
+
+#if defined(ARCH_X86_64)
+#ifdef __GNUC__
+__attribute__((target("sse4.1")))
+#endif
+static void UntileSurfaceSSE4(const u8 *tiled, u8 *rgba, u32 width, u32 height) {
+  const __m128i shuffle = _mm_set_epi8(
+    15, 12, 13, 14,
+    11, 8, 9, 10,
+    7, 4, 5, 6,
+    3, 0, 1, 2
+  );
+  const u32 pitch = GetTiledPitch(width);
+  const u32 vectorWidth = width & ~3u;
+  for (u32 y = 0; y != height; ++y) {
+    u8 *row = rgba + static_cast<u64>(y) * width * sizeof(u32);
+    for (u32 x = 0; x != vectorWidth; x += 4) {
+      const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tiled + GetTiledOffset(pitch, x, y) * sizeof(u32)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(row + x * sizeof(u32)), _mm_shuffle_epi8(pixels, shuffle));
+    }
+    UntileRowScalar(tiled, row, width, y, vectorWidth);
+  }
+}
+
+#ifdef __GNUC__
+__attribute__((target("avx2")))
+#endif
+static void UntileSurfaceAVX2(const u8 *tiled, u8 *rgba, u32 width, u32 height) {
+  const __m256i shuffle = _mm256_set_epi8(
+    15, 12, 13, 14,
+    11, 8, 9, 10,
+    7, 4, 5, 6,
+    3, 0, 1, 2,
+    15, 12, 13, 14,
+    11, 8, 9, 10,
+    7, 4, 5, 6,
+    3, 0, 1, 2
+  );
+  const u32 pitch = GetTiledPitch(width);
+  const u32 vectorWidth = width & ~7u;
+  for (u32 y = 0; y != height; ++y) {
+    u8 *row = rgba + static_cast<u64>(y) * width * sizeof(u32);
+    for (u32 x = 0; x != vectorWidth; x += 8) {
+      // Two runs of 4 contiguous pixels
+      const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tiled + GetTiledOffset(pitch, x, y) * sizeof(u32)));
+      const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tiled + GetTiledOffset(pitch, x + 4, y) * sizeof(u32)));
+      const __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + x * sizeof(u32)), _mm256_shuffle_epi8(pixels, shuffle));
+    }
+    UntileRowScalar(tiled, row, width, y, vectorWidth);
+  }
+}
+
+static bool CPUSupportsAVX2() {
+#ifdef __GNUC__
+  return __builtin_cpu_supports("avx2");
+#else
+  s32 info[4] = {};
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+static bool CPUSupportsSSE41() {
+#ifdef __GNUC__
+  return __builtin_cpu_supports("sse4.1");
+#else
+  s32 info[4] = {};
+  __cpuid(info, 1);
+  return (info[2] & (1 << 19)) != 0;
+#endif
+}
+#endif
+
+void UntileSurface(const u8 *tiled, u8 *rgba, u32 width, u32 height) {
+#if defined(ARCH_X86_64)
+  static const bool hasAVX2 = CPUSupportsAVX2();
+  static const bool hasSSE41 = CPUSupportsSSE41();
+  if (hasAVX2) {
+    UntileSurfaceAVX2(tiled, rgba, width, height);
+    return;
+  }
+  if (hasSSE41) {
+    UntileSurfaceSSE4(tiled, rgba, width, height);
+    return;
+  }
+#endif
+  UntileSurfaceScalar(tiled, rgba, width, height);
+}
+
+// Cheap 64-bit hash of a surface, four independent lanes so it runs at memory speed
+static u64 HashSurface(const u8 *data, u64 size) {
+  u64 lanes[4] = { 0xCBF29CE484222325ULL, 0x84222325CBF29CE4ULL, 0x9E3779B97F4A7C15ULL, 0x7F4A7C159E3779B9ULL };
+  u64 i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (u32 lane = 0; lane != 4; ++lane) {
+      u64 word = 0;
+      memcpy(&word, data + i + lane * sizeof(u64), sizeof(word));
+      lanes[lane] = (lanes[lane] ^ word) * 0x100000001B3ULL;
+    }
+  }
+  u64 hash = lanes[0] ^ (lanes[1] << 1) ^ (lanes[2] << 2) ^ (lanes[3] << 3);
+  for (; i != size; ++i)
+    hash = (hash ^ data[i]) * 0x100000001B3ULL;
+  return hash ^ (hash >> 29);
+}
+
+FrameDumper::FrameDumper(const std::filesystem::path &path, eFrameDumpFormat dumpFormat) :
+  outputPath(path), format(dumpFormat) {
+  std::error_code ec;
+  std::filesystem::create_directories(outputPath, ec);
+  if (ec) {
+    LOG_ERROR(Xenos, "FrameDumper: Failed to create '{}': {}", outputPath.string(), ec.message());
+  }
+  LOG_INFO(Xenos, "FrameDumper: Writing {} frames to '{}'", format == eFrameDumpFormat::PNG ? "PNG" : "raw", outputPath.string());
+}
+
+bool FrameDumper::Capture(const u8 *surface, u32 width, u32 height) {
+  if (!surface || width == 0 || height == 0)
+    return false;
+
+  // Nothing changed since the last frame, skip the conversion entirely.
+  // Only a hash is kept, no copy of the surface is made until it changes.
+  const u64 hash = HashSurface(surface, GetTiledSurfaceSize(width, height));
+  if (width == lastWidth && height == lastHeight && hash == lastHash) {
+    return false;
+  }
+  lastHash = hash;
+  lastWidth = width;
+  lastHeight = height;
+
+  pixels.resize(static_cast<u64>(width) * height * sizeof(u32));
+  UntileSurface(surface, pixels.data(), width, height);
+
+  bool result = false;
+  if (format == eFrameDumpFormat::PNG) {
+    result = WritePNG(outputPath / FMT("frame_{:06}.png", frameCount), width, height);
+  } else {
+    result = WriteRaw(outputPath / FMT("frame_{:06}_{}x{}.rgba", frameCount, width, height));
+  }
+  if (result)
+    ++frameCount;
+  return result;
+}
+
+// Big endian u32, as PNG wants it
+static void PutU32(std::vector<u8> &out, u32 value) {
+  out.push_back(static_cast<u8>(value >> 24));
+  out.push_back(static_cast<u8>(value >> 16));
+  out.push_back(static_cast<u8>(value >> 8));
+  out.push_back(static_cast<u8>(value));
+}
+
+static void WritePNGChunk(std::ofstream &file, const char type[4], const u8 *data, u64 size) {
+  std::vector<u8> header{};
+  PutU32(header, static_cast<u32>(size));
+  header.insert(header.end(), type, type + 4);
+  u32 crc = CRC32::CRC32::calc(reinterpret_cast<const u8 *>(type), 4);
+  crc = CRC32::CRC32::calc(data, size, crc);
+  std::vector<u8> footer{};
+  PutU32(footer, crc);
+  file.write(reinterpret_cast<const char *>(header.data()), header.size());
+  file.write(reinterpret_cast<const char *>(data), size);
+  file.write(reinterpret_cast<const char *>(footer.data()), footer.size());
+}
+
+// Image data is written as stored (uncompressed) deflate blocks. It's bigger on disk, but costs
+// nothing to produce and needs no zlib.
+bool FrameDumper::WritePNG(const std::filesystem::path &filePath, u32 width, u32 height) {
+  std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file) {
+    LOG_ERROR(Xenos, "FrameDumper: Failed to open {} for writing", filePath.string());
+    return false;
+  }
+
+  static constexpr u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+  // IHDR: 8 bit RGBA, no interlacing
+  std::vector<u8> ihdr{};
+  PutU32(ihdr, width);
+  PutU32(ihdr, height);
+  ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });
+  WritePNGChunk(file, "IHDR", ihdr.data(), ihdr.size());
+
+  // Scanlines, each prefixed with filter type 0 (none)
+  const u64 rowSize = static_cast<u64>(width) * sizeof(u32);
+  scanlines.resize((rowSize + 1) * height);
+  for (u32 y = 0; y != height; ++y) {
+    u8 *line = scanlines.data() + (rowSize + 1) * y;
+    line[0] = 0;
+    memcpy(line + 1, pixels.data() + rowSize * y, rowSize);
+  }
+
+  // zlib stream made of stored blocks
+  constexpr u64 maxBlockSize = 0xFFFF;
+  const u64 blockCount = (scanlines.size() + maxBlockSize - 1) / maxBlockSize;
+  std::vector<u8> idat{};
+  idat.reserve(scanlines.size() + blockCount * 5 + 6);
+  idat.push_back(0x78);
+  idat.push_back(0x01);
+  u32 adlerA = 1, adlerB = 0;
+  for (u64 offset = 0; offset < scanlines.size(); offset += maxBlockSize) {
+    const u16 blockSize = static_cast<u16>(std::min(maxBlockSize, scanlines.size() - offset));
+    const bool lastBlock = offset + blockSize == scanlines.size();
+    idat.push_back(lastBlock ? 1 : 0);
+    idat.push_back(static_cast<u8>(blockSize));
+    idat.push_back(static_cast<u8>(blockSize >> 8));
+    idat.push_back(static_cast<u8>(~blockSize));
+    idat.push_back(static_cast<u8>(~blockSize >> 8));
+    const u8 *block = scanlines.data() + offset;
+    idat.insert(idat.end(), block, block + blockSize);
+    // 5552 is the largest run that can't overflow before the modulo
+    for (u32 i = 0; i != blockSize;) {
+      const u32 runEnd = std::min<u32>(blockSize, i + 5552);
+      for (; i != runEnd; ++i) {
+        adlerA += block[i];
+        adlerB += adlerA;
+      }
+      adlerA %= 65521;
+      adlerB %= 65521;
+    }
+  }
+  PutU32(idat, (adlerB << 16) | adlerA);
+  WritePNGChunk(file, "IDAT", idat.data(), idat.size());
+  WritePNGChunk(file, "IEND", nullptr, 0);
+  return file.good();
+}
+
+bool FrameDumper::WriteRaw(const std::filesystem::path &filePath) {
+  std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file) {
+    LOG_ERROR(Xenos, "FrameDumper: Failed to open {} for writing", filePath.string());
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+  return file.good();
+}
+
+} // namespace Xe::XGPU
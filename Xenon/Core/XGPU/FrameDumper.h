@@ -0,0 +1,67 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Base/Types.h"
+
+/*
+ *	FrameDumper.h CPU side framebuffer untiling, for headless runs (Dummy backend, NO_GFX builds).
+ */
+
+namespace Xe::XGPU {
+
+// Pitch in pixels of a 2D tiled surface, rows are made of whole 32x32 tiles
+inline u32 GetTiledPitch(u32 width) {
+  return (width + 31) & ~31u;
+}
+
+// Size in bytes of a 2D tiled 32bpp surface, both dimensions padded to whole tiles
+inline u64 GetTiledSurfaceSize(u32 width, u32 height) {
+  return static_cast<u64>((height + 31) & ~31u) * GetTiledPitch(width) * sizeof(u32);
+}
+
+// Untiles a 2D tiled 32bpp surface, and converts it from ARGB (as the guest stores it) to RGBA8.
+// tiled must hold GetTiledSurfaceSize bytes, rgba width * height * 4 bytes.
+// Picks AVX2/SSE4.1 at runtime, falls back to scalar code.
+void UntileSurface(const u8 *tiled, u8 *rgba, u32 width, u32 height);
+
+enum class eFrameDumpFormat : u8 {
+  PNG,
+  Raw
+};
+
+// Writes the guest framebuffer to disk, only when it changed since the last capture
+class FrameDumper {
+public:
+  FrameDumper(const std::filesystem::path &path, eFrameDumpFormat dumpFormat);
+
+  // Converts and writes the surface if it differs from the last one.
+  // Returns true if a frame was written.
+  bool Capture(const u8 *surface, u32 width, u32 height);
+
+  // Frames written so far
+  u64 GetFrameCount() const { return frameCount; }
+private:
+  bool WritePNG(const std::filesystem::path &filePath, u32 width, u32 height);
+  bool WriteRaw(const std::filesystem::path &filePath);
+
+  // Output directory
+  std::filesystem::path outputPath{};
+  eFrameDumpFormat format = eFrameDumpFormat::PNG;
+  // Hash of the last captured surface, used to skip unchanged frames
+  u64 lastHash = 0;
+  u32 lastWidth = 0;
+  u32 lastHeight = 0;
+  // Converted pixels
+  std::vector<u8> pixels{};
+  // PNG scanlines (filter byte + row)
+  std::vector<u8> scanlines{};
+  u64 frameCount = 0;
+};
+
+} // namespace Xe::XGPU
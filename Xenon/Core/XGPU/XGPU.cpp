@@ -111,6 +111,13 @@ Xe::Xenos::XGPU::XGPU(Render::Renderer *renderer, RAM *ram, PCIBridge *pciBridge
   commandProcessor = std::make_unique<STRIP_UNIQUE(commandProcessor)>(ramPtr, xenosState.get(), render, parentBus);
   xenosState->commandProcessor = commandProcessor.get(); // CP expects xenosState, xenosState expects CP, this fixes it.
 
+  // CPU side frame dumps, for headless runs (doesn't need a GPU)
+  if (Config::xgpu.frameDumpPath != "none") {
+    const Xe::XGPU::eFrameDumpFormat format = Base::JoaatStringHash(Config::xgpu.frameDumpFormat) == "raw"_jLower ?
+      Xe::XGPU::eFrameDumpFormat::Raw : Xe::XGPU::eFrameDumpFormat::PNG;
+    frameDumper = std::make_unique<STRIP_UNIQUE(frameDumper)>(Config::xgpu.frameDumpPath, format);
+  }
+
   xeVSyncWorkerThread = std::thread(&XGPU::xeVSyncWorkerThreadLoop, this);
 }
 
@@ -252,18 +259,54 @@ void Xe::Xenos::XGPU::DumpFB(const std::filesystem::path &path, s32 pitch) {
   f.close();
 }
 
+bool Xe::Xenos::XGPU::Pause(std::chrono::milliseconds timeout) {
+  if (!commandProcessor->Pause(timeout))
+    return false;
+  std::lock_guard lock(vsyncPauseMutex);
+  vsyncPaused = true;
+  return true;
+}
+
+void Xe::Xenos::XGPU::Resume() {
+  {
+    std::lock_guard lock(vsyncPauseMutex);
+    vsyncPaused = false;
+  }
+  commandProcessor->Resume();
+}
+
+void Xe::Xenos::XGPU::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lck(mutex);
+  stream.Do(xgpuConfigSpace, pciDevSizes);
+  xenosState->SerializeState(stream);
+  stream.DoMarker("EDRAM");
+  edram->SerializeState(stream);
+  stream.DoMarker("CP");
+  commandProcessor->SerializeState(stream);
+}
+
 void Xe::Xenos::XGPU::xeVSyncWorkerThreadLoop() {
   LOG_INFO(Xenos, "Entering VSYNC Worker thread.");
 
   // VSync timer start
   std::chrono::steady_clock::time_point timerStart =
     std::chrono::steady_clock::now();
+  // Frame dump timer start
+  std::chrono::steady_clock::time_point dumpTimerStart = timerStart;
 
   while (xeVsyncWorkerThreadRunning) {
     // Ensure we haven't shutdown elsewhere
-    xeVsyncWorkerThreadRunning = XeRunning;
+    if (!XeRunning)
+      xeVsyncWorkerThreadRunning = false;
     if (!xeVsyncWorkerThreadRunning)
       break;
+    // Held for a save state
+    std::unique_lock pauseLock(vsyncPauseMutex);
+    if (vsyncPaused) {
+      pauseLock.unlock();
+      std::this_thread::sleep_for(1ms);
+      continue;
+    }
     // Measure elapsed time since last check.
     std::chrono::steady_clock::time_point timerNow =
       std::chrono::steady_clock::now();
@@ -279,6 +322,16 @@ void Xe::Xenos::XGPU::xeVSyncWorkerThreadLoop() {
       // Update internal timer.
       timerStart = std::chrono::steady_clock::now();
     }
+
+    // Dump the framebuffer at ~60Hz. The dumper skips the untile entirely if the surface didn't change.
+    if (frameDumper && RenderingTo2DFramebuffer() && timerNow >= dumpTimerStart + 16ms) {
+      const u32 surface = GetSurface();
+      const u32 width = GetWidth();
+      const u32 height = GetHeight();
+      if (surface + Xe::XGPU::GetTiledSurfaceSize(width, height) <= ramPtr->GetSize())
+        frameDumper->Capture(ramPtr->GetPointerToAddress(surface), width, height);
+      dumpTimerStart = timerNow;
+    }
   }
   LOG_INFO(Xenos, "Exiting VSYNC Worker thread.");
 }
\ No newline at end of file
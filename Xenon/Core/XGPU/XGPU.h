@@ -5,6 +5,7 @@
 #pragma once
 
 #include <fstream>
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <mutex>
@@ -16,6 +17,7 @@
 #include "Core/XGPU/XGPUConfig.h"
 #include "Core/XGPU/XenosRegisters.h"
 #include "Core/XGPU/CommandProcessor.h"
+#include "Core/XGPU/FrameDumper.h"
 #include "Core/PCI/PCIe.h"
 
 /*
@@ -44,6 +46,12 @@ public:
 
   bool IsAddressMappedInBAR(u32 address);
 
+  // Save states. Parks the command processor, then holds the VSync interrupt. False if the CP didn't park in time.
+  bool Pause(std::chrono::milliseconds timeout);
+  void Resume();
+  // Config space, registers, EDRAM and the CP, only while paused.
+  void SerializeState(Xe::SaveState::StateStream &stream);
+
   // Dump framebuffer from RAM
   void DumpFB(const std::filesystem::path &path, s32 pitch);
 
@@ -83,6 +91,8 @@ private:
 
   // Command Processor
   std::unique_ptr<Xe::XGPU::CommandProcessor> commandProcessor = {};
+  // Headless frame dumps
+  std::unique_ptr<Xe::XGPU::FrameDumper> frameDumper = {};
 
   // Vertical Sync Worker thread
   std::thread xeVSyncWorkerThread;
@@ -90,6 +100,10 @@ private:
   // VSYNC Worker thread running
   volatile bool xeVsyncWorkerThreadRunning = true;
 
+  // VSync interrupt held for a save state. The worker only fires it with vsyncPauseMutex held.
+  std::mutex vsyncPauseMutex;
+  bool vsyncPaused = false;
+
   // Vertical Sync Worker Thread Loop
   // Should fire an interrupt to a given CPU every time a vertical sync event happens.
   // Normally this is the spped of the display's refresh rate.
@@ -19,15 +19,43 @@ Xe::XGPU::XenosState::XenosState(RAM *ram, EDRAM *edramPtr, CommandProcessor *co
   internalHeight(720)
 #endif
 {
-  Regs = std::make_unique<STRIP_UNIQUE_ARR(Regs)>(0xFFFFF);
-  memset(Regs.get(), 0, 0xFFFFF);
+  Regs = std::make_unique<STRIP_UNIQUE_ARR(Regs)>(RegsSize);
+  memset(Regs.get(), 0, RegsSize);
   memset(RegMask, 0, sizeof(RegMask));
+  // Everything needs to be uploaded once
+  memset(FloatConstMask, 0xFF, sizeof(FloatConstMask));
 }
 
 Xe::XGPU::XenosState::~XenosState() {
   Regs.reset();
 }
 
+void Xe::XGPU::XenosState::SerializeState(Xe::SaveState::StateStream &stream) {
+  std::lock_guard lck(mutex);
+  stream.Do(fbSurfaceAddress, framebufferDisable, configControl, scratchMask, scratchAddr, scratch, waitUntil);
+  stream.Do(rbbmControl, rbbmDebug, rbbmStatus, rbbmSoftReset);
+  stream.Do(surfaceInfo, colorInfo, depthInfo, color1Info, color2Info, color3Info, blendRed, blendGreen, blendBlue,
+    blendAlpha, stencilReferenceMask, depthControl, blendControl0, tileControl, modeControl, blendControl1,
+    blendControl2, blendControl3, copyControl, copyDestBase, copyDestPitch, copyDestInfo, depthClear, clearColor,
+    clearColorLo, copyFunction, copyReference, copyMask);
+  stream.Do(maxVertexIndex, minVertexIndex, indexOffset, multiPrimitiveIndexBufferResetIndex, currentBinIdMin,
+    vgtDrawInitiator, vgtDMABase, vgtDMASize);
+  stream.Do(viewportControl, windowOffset, windowScissorTl, windowScissorBr, viewportXOffset, viewportYOffset,
+    viewportZOffset, viewportXScale, viewportYScale, viewportZScale);
+  stream.Do(programCntl, crtcControl, modeViewportSize, vCounter, vblankStatus, vblankVlineStatus, d1modeIntMask);
+  stream.Do(mhStatus, coherencySizeHost, coherencyBaseHost, coherencyStatusHost, edramTiming, edramInfo, dcLutAutofill);
+  stream.Do(xdvoEnable, xdvoBitDepthControl, xdvoClockInv, xdvoControl, xdvoCrcEnable, xdvoCrcControl,
+    xdvoCrcMaskSignalRGB, xdvoCrcMaskSignalControl, xdvoCrcSignalRGB, xdvoCrcSignalControl, xdvoStrengthControl,
+    xdvoDataStrengthControl, xdvoForceOutputControl, xdvoRegisterIndex, xdvoRegisterData);
+  stream.Do(floatConsts, boolConsts);
+  stream.DoBytes(Regs.get(), RegsSize);
+  if (stream.IsLoading()) {
+    SetDirtyState();
+    memset(FloatConstMask, 0xFF, sizeof(FloatConstMask));
+    BoolConstDirty = true;
+  }
+}
+
 u32 Xe::XGPU::XenosState::ReadRawRegister(u32 addr, u32 size) {
   // Set a lock
   std::lock_guard lck(mutex);
@@ -467,6 +495,7 @@ void Xe::XGPU::XenosState::WriteRawRegister(u32 addr, u32 value) {
 #endif
       u8 *memPtr = ramPtr->GetPointerToAddress(memAddr);
       memcpy(memPtr, &scratch[scratchRegIndex], sizeof(scratch[scratchRegIndex]));
+      ramPtr->MarkWritten(memAddr, sizeof(scratch[scratchRegIndex]));
     }
   } break;
   case XeRegister::MH_STATUS:
@@ -740,6 +769,15 @@ void Xe::XGPU::XenosState::WriteRawRegister(u32 addr, u32 value) {
     memcpy(&Regs[addr], &tmp, sizeof(tmp));
   }
   // Set dirty state
-  const u64 mask = 1ull << (addr % BitCount);
-  RegMask[(addr / 4) / BitCount] |= mask;
+  const u64 mask = 1ull << (regIndex % BitCount);
+  RegMask[regIndex / BitCount] |= mask;
+  // Track shader constants for the renderer
+  if (regIndex >= static_cast<u32>(XeRegister::SHADER_CONSTANT_000_X) && regIndex <= static_cast<u32>(XeRegister::SHADER_CONSTANT_511_W)) {
+    const u32 vec4Index = (regIndex - static_cast<u32>(XeRegister::SHADER_CONSTANT_000_X)) / 4;
+    FloatConstMask[vec4Index / BitCount] |= 1ull << (vec4Index % BitCount);
+  } else if (regIndex >= static_cast<u32>(XeRegister::SHADER_CONSTANT_BOOL_000_031) && regIndex <= static_cast<u32>(XeRegister::SHADER_CONSTANT_BOOL_224_255)) {
+    BoolConstDirty = true;
+  }
+  // Wake the CP if it's waiting on this register
+  registerWaiters.Notify(regIndex, 1);
 }
@@ -8,6 +8,9 @@
 #include <mutex>
 #include <string>
 
+#include "Base/WaitTable.h"
+#include "Core/SaveState/StateStream.h"
+
 #include "Core/RAM/RAM.h"
 
 #include "EDRAM.h"
@@ -32,6 +35,10 @@ class CommandProcessor;
 
 class XenosState {
 public:
+  // Float constants are tracked for upload in vec4 (4 register) units
+  static constexpr u32 FloatConstVec4Count = sizeof(XeShaderFloatConsts::values) / (sizeof(f32) * 4);
+  static constexpr u32 FloatConstDirtyBlocks = FloatConstVec4Count / (sizeof(u64) * 8);
+
   XenosState() = default;
   XenosState(RAM *ram, EDRAM *edramPtr, CommandProcessor *commandProcessorPtr);
 
@@ -60,7 +67,7 @@ public:
 
   bool RegisterDirty(XeRegister reg) {
     std::lock_guard lck(mutex);
-    u64 index = static_cast<u32>(reg) * 4;
+    u64 index = static_cast<u32>(reg);
     const u64 mask = 1ull << (index % BitCount);
     return (RegMask[index / BitCount] & mask) != 0;
   }
@@ -80,6 +87,25 @@ public:
     return RegMask[firstIndex / BitCount];
   }
 
+  // Takes the float constants (in vec4 units) written since the last call, and clears them
+  void ConsumeFloatConstDirty(u64 (&dirty)[FloatConstDirtyBlocks]) {
+    std::lock_guard lck(mutex);
+    memcpy(dirty, FloatConstMask, sizeof(FloatConstMask));
+    memset(FloatConstMask, 0, sizeof(FloatConstMask));
+  }
+
+  // Returns whether any bool constant was written since the last call, and clears it
+  bool ConsumeBoolConstDirty() {
+    std::lock_guard lck(mutex);
+    const bool dirty = BoolConstDirty;
+    BoolConstDirty = false;
+    return dirty;
+  }
+
+  // Save states: every register, the raw register file and the shader constants.
+  // A load marks everything dirty, so the renderer uploads it all again.
+  void SerializeState(Xe::SaveState::StateStream &stream);
+
   // Mutex
   std::recursive_mutex mutex{};
 
@@ -218,10 +244,19 @@ public:
 
   // Registers
   std::unique_ptr<u8[]> Regs;
+  static constexpr u32 RegsSize = 0xFFFFF;
   static constexpr u32 NumRegs = 0x5004;
   static constexpr u32 BitCount = sizeof(u64) * 8;
   static constexpr u32 BlockCount = (NumRegs + BitCount - 1) / BitCount;
   u64 RegMask[BlockCount] = {};
+
+  // Shader constant upload tracking. Unlike RegMask (which the CP clears after every draw),
+  // these are only cleared by the renderer once it has uploaded the data.
+  u64 FloatConstMask[FloatConstDirtyBlocks] = {};
+  bool BoolConstDirty = true;
+
+  // CP WAIT_REG_MEM register waits, keyed by register index
+  Base::WaitTable registerWaiters{};
 };
 
 } // namespace Xe::XGPU
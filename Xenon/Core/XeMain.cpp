@@ -4,17 +4,23 @@
 
 #include "XeMain.h"
 
+#include "Core/SaveState/SaveState.h"
 #include "Render/Backends/Vulkan/VulkanRenderer.h"
 
-void XeMain::Create() {
+void XeMain::Create(const std::function<void()> &applyOverrides) {
   MICROPROFILE_SCOPEI("[Xe::Main]", "Create", MP_AUTO);
-  Base::Log::Initialize();
+  // Already up in a forked child (see ReleaseForFork)
+  if (!Base::Log::IsActive())
+    Base::Log::Initialize();
   Base::Log::Start();
   LOG_INFO(System, "Starting Xenon.");
   rootDirectory = Base::FS::GetUserPath(Base::FS::PathType::RootDir);
   LoadConfig();
+  if (applyOverrides)
+    applyOverrides();
   Base::Log::Filter logFilter{ Config::log.currentLevel };
   Base::Log::SetGlobalFilter(logFilter);
+  Base::Log::ApplyConfig();
 #ifndef NO_GFX
   switch (Base::JoaatStringHash(Config::rendering.backend)) {
   case "OpenGL"_jLower:
@@ -32,8 +38,9 @@ void XeMain::Create() {
   }
 #endif
 
-  // Create RAM
-  ram = std::make_shared<STRIP_UNIQUE(ram)>("RAM", RAM_START_ADDR, Config::xcpu.ramSize, false);
+  // Create RAM, unless it was kept across a fork
+  if (!ram)
+    ram = std::make_shared<STRIP_UNIQUE(ram)>("RAM", RAM_START_ADDR, Config::xcpu.ramSize, false);
 
   // Create bridges
   CreateBridges();
@@ -82,7 +89,8 @@ void XeMain::Shutdown() {
   XeRunning = false;
 
   // Save config
-  SaveConfig();
+  if (saveConfigOnShutdown)
+    SaveConfig();
 
   // Shutdown the XCPU
   xenonCPU.reset();
@@ -120,7 +128,7 @@ void XeMain::LoadConfig() {
   Config::loadConfig(rootDirectory / "config.toml");
 }
 
-void XeMain::StartCPU() {
+void XeMain::StartCPU(bool parked) {
   LOG_INFO(Xenon, "Starting CPU...");
   if (!xenonCPU.get()) {
     LOG_CRITICAL(Xenon, "Failed to initialize Xenon's CPU!");
@@ -132,7 +140,10 @@ void XeMain::StartCPU() {
     return;
   }
 
-  if (Config::xcpu.elfLoader) {
+  if (parked) {
+    // A state gets loaded over it, where it would have started doesn't matter
+    xenonCPU->Start(0x20000000100, true);
+  } else if (Config::xcpu.elfLoader) {
     // Load the elf
     xenonCPU->LoadElf(Config::filepaths.elfBinary);
   } else if (!sfcx || !nand) {
@@ -147,6 +158,87 @@ void XeMain::StartCPU() {
   CPUStarted = true;
 }
 
+bool XeMain::Quiesce() {
+  // The GPU goes first, CP waits on guest memory only resolve while the CPU still runs
+  if (xenos && !xenos->Pause(1s)) {
+    return false;
+  }
+  if (!xenonCPU->Quiesce(1s)) {
+    if (xenos)
+      xenos->Resume();
+    return false;
+  }
+  pciBridge->QuiesceDevices();
+  return true;
+}
+
+void XeMain::Resume() {
+  pciBridge->ResumeDevices();
+  xenonCPU->Resume();
+  if (xenos)
+    xenos->Resume();
+}
+
+void XeMain::ReleaseForFork() {
+  // Threads first (PPUs, timebase, CP, VSync, device threads), then what they use
+  xenonCPU.reset();
+  CPUStarted = false;
+  hostBridge.reset();
+  xenos.reset();
+  pciBridge.reset();
+  rootBus.reset();
+  ohci0.reset();
+  ohci1.reset();
+  ehci0.reset();
+  ehci1.reset();
+  audioController.reset();
+  ethernet.reset();
+  xma.reset();
+  odd.reset();
+  hdd.reset();
+  smcCore.reset();
+  nand.reset();
+  sfcx.reset();
+#ifndef NO_GFX
+  if (renderer) {
+    renderer->Shutdown();
+    renderer.reset();
+  }
+#endif
+  Xe::PCIDev::DeviceWorkerPool::Get().Stop();
+  Xe::PCIDev::DeviceWorkerPool::GetStorage().Stop();
+  Base::Log::Stop();
+}
+
+bool XeMain::SaveState(const std::filesystem::path &path, const std::filesystem::path &basePath) {
+  if (!CPUStarted || !Quiesce()) {
+    LOG_ERROR(Xenon, "Unable to save state, the system isn't running or didn't stop.");
+    return false;
+  }
+  const bool result = Xe::SaveState::Save(path, basePath);
+  Resume();
+  return result;
+}
+
+bool XeMain::LoadState(const std::filesystem::path &path) {
+  if (!CPUStarted) {
+    StartCPU(true);
+    if (!CPUStarted)
+      return false;
+  }
+  if (!Quiesce()) {
+    LOG_ERROR(Xenon, "Unable to load state, the system didn't stop.");
+    return false;
+  }
+  if (!Xe::SaveState::Load(path)) {
+    // Whatever got loaded is inconsistent, keep it stopped
+    LOG_CRITICAL(Xenon, "Failed to load state '{}', the system stays stopped.", path.string());
+    return false;
+  }
+  Resume();
+  return true;
+}
+
 void XeMain::ShutdownCPU() {
   if (!CPUStarted) {
     return;
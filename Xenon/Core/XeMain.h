@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Base/Logging/Backend.h"
 #include "Base/Logging/Log.h"
 #include "Base/Config.h"
@@ -34,10 +36,12 @@
 // Global thread state
 namespace XeMain {
 
-extern void Create();
+// applyOverrides runs after the config was loaded, before anything is created from it
+extern void Create(const std::function<void()> &applyOverrides = {});
 extern void Shutdown();
 
-extern void StartCPU();
+// parked starts the PPUs parked at their first instruction, for a state load to fill in (see LoadState)
+extern void StartCPU(bool parked);
 
 extern void ShutdownCPU();
 
@@ -54,6 +58,21 @@ extern void CreateRootBus();
 
 extern Xe::XCPU::XenonCPU *GetCPU();
 
+// Save states (see Core/SaveState/SaveState.h)
+//  Brings every thread touching guest state (CP, VSync, PPUs, timebase, devices) to a safe point and holds it there.
+//  Returns false, with everything running again, if something didn't get there in time
+extern bool Quiesce();
+extern void Resume();
+//  Quiesces, saves, resumes. With a base path, only the RAM/NAND pages that differ from it get stored
+extern bool SaveState(const std::filesystem::path &path, const std::filesystem::path &basePath = {});
+//  Starts the CPU parked if it wasn't running, quiesces, loads, resumes
+extern bool LoadState(const std::filesystem::path &path);
+
+// Fork launcher (see Launcher/Launcher.cpp)
+//  Destroys everything but RAM, then stops the device workers and the log thread, leaving the process with a
+//  single thread so it can fork. Create rebuilds the system around the same RAM (copy-on-write in a child).
+extern void ReleaseForFork();
+
 // Main objects
 //  Base path
 inline std::filesystem::path rootDirectory = {};
@@ -69,6 +88,8 @@ inline std::unique_ptr<Render::Renderer> renderer{};
 #endif
 // CPU started flag
 inline bool CPUStarted = false;
+// Write the config back on shutdown. Tools overriding it in memory turn this off
+inline bool saveConfigOnShutdown = true;
 
 // PCI Devices
 //  SMC
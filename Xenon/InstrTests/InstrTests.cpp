@@ -0,0 +1,93 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-instr-tests
+// Runs the PowerPC instruction tests (see Core/XCPU/PPU/Testing.h) without booting a console: only RAM and the
+// CPU context are created. Returns 0 when every test passed.
+//
+// Examples:
+//   xenon-instr-tests -tests tests -bin bin -mode Differential -junit instr.xml -timing instr.csv
+//   xenon-instr-tests -fuzz 1000 -seed 0x1234 -filter vadd
+//
+
+#include "Base/Config.h"
+#include "Base/Hash.h"
+#include "Base/Logging/Backend.h"
+#include "Base/Param.h"
+#include "Base/Thread.h"
+#include "Core/RAM/RAM.h"
+#include "Core/RootBus/RootBus.h"
+#include "Core/XCPU/PPU/Testing.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(tests, "Directory with the annotated test sources (.s), defaults to tests");
+PARAM(bin, "Directory with the assembled tests (.bin and .map), defaults to bin");
+PARAM(mode, "Backend: Interpreter, JITx86 or Differential (both, with their register states diffed). Defaults to Differential");
+PARAM(threads, "Worker threads, defaults to one per hardware thread");
+PARAM(filter, "Only runs the suites (opcodes when fuzzing) whose name contains this");
+PARAM(junit, "Writes a JUnit XML report to this path");
+PARAM(timing, "Writes per-opcode timing (CSV) to this path");
+PARAM(fuzz, "Differential fuzzing instead of the test corpus: random cases per ALU/FPU/VXU opcode");
+PARAM(seed, "Fuzzer seed (hex), defaults to 0");
+PARAM(log, "Log level, defaults to Info");
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present()) {
+    ::Base::Param::Help();
+    return 0;
+  }
+
+  sInstrTestOptions options{};
+  options.testsPath = PARAM_tests.Present() ? PARAM_tests.Get() : Config::filepaths.instrTestsPath;
+  options.binPath = PARAM_bin.Present() ? PARAM_bin.Get() : Config::filepaths.instrTestsBinPath;
+  options.mode = ePPUTestingMode::Differential;
+  if (PARAM_mode.Present()) {
+    switch (Base::JoaatStringHash(PARAM_mode.Get())) {
+    case "Interpreter"_jLower: options.mode = ePPUTestingMode::Interpreter; break;
+    case "JITx86"_jLower: options.mode = ePPUTestingMode::JITx86; break;
+    case "Differential"_jLower: options.mode = ePPUTestingMode::Differential; break;
+    default:
+      fmt::print("Invalid mode '{}', expected Interpreter, JITx86 or Differential\n", PARAM_mode.Get());
+      return 1;
+    }
+  }
+  options.threads = PARAM_threads.Present() ? std::max(PARAM_threads.Get<s32>(), 0) : 0;
+  options.filter = PARAM_filter.Present() ? PARAM_filter.Get() : "";
+  options.junitPath = PARAM_junit.Present() ? PARAM_junit.Get() : "";
+  options.timingPath = PARAM_timing.Present() ? PARAM_timing.Get() : "";
+  options.fuzzIterations = PARAM_fuzz.Present() ? std::max(PARAM_fuzz.Get<s32>(), 0) : 0;
+  options.fuzzSeed = PARAM_seed.Present() ? PARAM_seed.Get<u64>() : 0;
+
+  Base::SetCurrentThreadName("[Xe] InstrTests");
+  Base::Log::Initialize();
+  Base::Log::Start();
+  Config::log.currentLevel = Base::Log::Level::Info;
+  if (PARAM_log.Present()) {
+    switch (Base::JoaatStringHash(PARAM_log.Get())) {
+    case "Trace"_jLower: Config::log.currentLevel = Base::Log::Level::Trace; break;
+    case "Debug"_jLower: Config::log.currentLevel = Base::Log::Level::Debug; break;
+    case "Warning"_jLower: Config::log.currentLevel = Base::Log::Level::Warning; break;
+    case "Error"_jLower: Config::log.currentLevel = Base::Log::Level::Error; break;
+    default: break;
+    }
+  }
+  Base::Log::Filter logFilter{ Config::log.currentLevel };
+  Base::Log::SetGlobalFilter(logFilter);
+
+  // The tests only ever touch RAM
+  auto ram = std::make_shared<RAM>("RAM", RAM_START_ADDR, Config::xcpu.ramSize, false);
+  auto rootBus = std::make_unique<RootBus>();
+  rootBus->AddDevice(ram);
+  auto xenonContext = std::make_unique<Xe::XCPU::XenonContext>(rootBus.get(), ram.get());
+
+  const bool passed = RunShardedInstructionTests(xenonContext.get(), options);
+
+  xenonContext.reset();
+  rootBus.reset();
+  ram.reset();
+  Base::Log::Stop();
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-launcher
+// Boots the configured NAND (or an ELF) headless once, or loads a save state, then forks instances off it.
+// Once the system is warm (-post reached, -warmup elapsed, or the state loaded), every thread is brought to a safe
+// point, the machine state is captured in memory and everything but guest RAM is torn down, so the process forks
+// with a single thread. Every instance shares guest RAM copy-on-write, rebuilds the rest of the system with its
+// own backends (HDD/NAND overlays, UART, disc image) and writes everything to its own directory:
+//   <out>/<instance>/xenon.log, uart.log, hdd.overlay, nand.overlay, traces and profiles when enabled
+// Instances run for -runtime seconds, or until the guest shuts down, under the resource limits given.
+//
+// Example: xenon-launcher -post 0x7F -instances 64 -jobs 32 -odd a.iso -odd b.iso -runtime 300 -maxmem 4096
+//
+
+#include <csignal>
+#include <fstream>
+#include <thread>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Base/Hangup.h"
+#include "Base/Param.h"
+#include "Base/Thread.h"
+#include "Core/SaveState/SaveState.h"
+#include "Core/XeMain.h"
+#include "Core/XCPU/Context/PostBus/PostBus.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(nand, "NAND image to boot, defaults to the configured one");
+PARAM(elf, "ELF binary to load instead of booting the NAND");
+PARAM(loadstate, "Save state to start from instead of booting");
+PARAM(post, "Forks once the guest wrote this POST code (hex)");
+PARAM(warmup, "Forks after running this many seconds");
+PARAM(boottimeout, "Seconds to wait for -post before giving up, defaults to 120");
+PARAM(instances, "Instances to fork, defaults to 1");
+PARAM(jobs, "Instances running at once, defaults to the host's thread count");
+PARAM(runtime, "Seconds every instance runs for, defaults to 60");
+PARAM(odd, "Disc images, instance i gets image i modulo their count. Defaults to the configured one");
+PARAM(out, "Output directory, every instance gets a numbered directory in it. Defaults to xenon-launcher");
+PARAM(maxmem, "Address space limit of every instance, in MiB");
+PARAM(maxcpu, "CPU time limit of every instance, in seconds");
+PARAM(maxfsize, "Size limit of the files every instance writes, in MiB");
+PARAM(maxfiles, "Open file limit of every instance");
+PARAM(log, "Log level, defaults to Warning");
+
+namespace {
+
+  // How often the parent checks for -post, and instances for their runtime
+  constexpr auto POLL_INTERVAL = 10ms;
+
+  struct sInstance {
+    fs::path directory;
+    std::string disc;
+    pid_t pid = -1;
+    std::chrono::steady_clock::time_point start{};
+    f64 wallMs = 0.0;
+    s32 exitCode = -1;
+    s32 signal = 0;
+  };
+
+  std::atomic<bool> postReached = false;
+  u64 postCode = 0;
+  volatile std::sig_atomic_t interrupted = 0;
+
+  void onPOST(u64 code) {
+    if (code == postCode) {
+      postReached.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  // Stops forking new instances, the running ones get the same signal and shut down on their own
+  void onInterrupt(s32) {
+    interrupted = 1;
+  }
+
+  // Settings every process (parent and instances) runs with
+  void applyCommonOverrides() {
+    Config::rendering.backend = "Dummy";
+    Config::rendering.enable = false;
+    Config::network.enabled = false;
+    Config::network.backend = "none";
+    Config::network.captureFile = "";
+    Config::debug.haltOnAddress = 0;
+    Config::debug.haltOnReadAddress = 0;
+    Config::debug.haltOnWriteAddress = 0;
+    Config::debug.softHaltOnAssertions = false;
+    Config::debug.autoContinueOnGuestAssertion = true;
+    // Instances must never write into the images they share
+    Config::filepaths.nandMapping = "Private";
+    Config::log.currentLevel = Base::Log::Level::Warning;
+    if (PARAM_log.Present()) {
+      switch (Base::JoaatStringHash(PARAM_log.Get())) {
+      case "Trace"_jLower: Config::log.currentLevel = Base::Log::Level::Trace; break;
+      case "Debug"_jLower: Config::log.currentLevel = Base::Log::Level::Debug; break;
+      case "Info"_jLower: Config::log.currentLevel = Base::Log::Level::Info; break;
+      case "Error"_jLower: Config::log.currentLevel = Base::Log::Level::Error; break;
+      default: break;
+      }
+    }
+    if (PARAM_nand.Present()) {
+      Config::filepaths.nand = PARAM_nand.Get();
+    }
+    Config::xcpu.elfLoader = PARAM_elf.Present();
+    if (PARAM_elf.Present()) {
+      Config::filepaths.elfBinary = PARAM_elf.Get();
+    }
+  }
+
+  // Backends writing somewhere go to directory. Leftovers of an earlier launch are removed first,
+  // overlays would otherwise be applied over the image
+  void applyOutputOverrides(const fs::path &directory) {
+    std::error_code error{};
+    fs::remove(directory / "hdd.overlay", error);
+    fs::remove(directory / "nand.overlay", error);
+    Config::filepaths.hddOverlay = (directory / "hdd.overlay").string();
+    Config::filepaths.hddOverlayOnExit = "Keep";
+    Config::smc.uartSystem = "file";
+    Config::smc.uartFile = (directory / "uart.log").string();
+  }
+
+  bool setLimit(s32 resource, const char *name, u64 value) {
+    rlimit limit{ static_cast<rlim_t>(value), static_cast<rlim_t>(value) };
+    if (setrlimit(resource, &limit) != 0) {
+      fmt::print("Unable to set {} to {}: {}\n", name, value, strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+  bool applyLimits() {
+    bool result = true;
+    if (PARAM_maxmem.Present()) {
+      result &= setLimit(RLIMIT_AS, "RLIMIT_AS", std::max<s64>(PARAM_maxmem.Get<s64>(), 1) * 1_MiB);
+    }
+    if (PARAM_maxcpu.Present()) {
+      result &= setLimit(RLIMIT_CPU, "RLIMIT_CPU", std::max<s64>(PARAM_maxcpu.Get<s64>(), 1));
+    }
+    if (PARAM_maxfsize.Present()) {
+      result &= setLimit(RLIMIT_FSIZE, "RLIMIT_FSIZE", std::max<s64>(PARAM_maxfsize.Get<s64>(), 1) * 1_MiB);
+    }
+    if (PARAM_maxfiles.Present()) {
+      result &= setLimit(RLIMIT_NOFILE, "RLIMIT_NOFILE", std::max<s64>(PARAM_maxfiles.Get<s64>(), 1));
+    }
+    return result;
+  }
+
+  // Runs in the forked child: rebuilds the system around the inherited RAM, restores the captured state and runs it.
+  // Returns the child's exit code.
+  s32 runInstance(const sInstance &instance, const Xe::SaveState::sMachineState &state, std::chrono::seconds runtime) {
+    if (!applyLimits()) {
+      return 4;
+    }
+    if (Base::InstallHangup() != 0) {
+      fmt::print("Instance in '{}': failed to install signal handler. Clean shutdown is not possible through console\n",
+        instance.directory.string());
+    }
+    Base::FS::SetUserPath(Base::FS::PathType::LogDir, instance.directory);
+    Base::Log::SetLogFile(instance.directory / "xenon.log");
+    Xe::PCIDev::DeviceWorkerPool::Get().Start();
+    Xe::PCIDev::DeviceWorkerPool::GetStorage().Start();
+
+    XeMain::Create([&] {
+      applyCommonOverrides();
+      applyOutputOverrides(instance.directory);
+      Config::filepaths.nandOverlay = (instance.directory / "nand.overlay").string();
+      if (!instance.disc.empty()) {
+        Config::filepaths.oddImage = instance.disc;
+      }
+    });
+    XeMain::StartCPU(true);
+    if (!XeMain::Quiesce() || !Xe::SaveState::RestoreMachine(state)) {
+      LOG_CRITICAL(Xenon, "Unable to restore the captured state, the instance is stopping.");
+      XeMain::Shutdown();
+      return 3;
+    }
+    XeMain::Resume();
+    LOG_INFO(Xenon, "Instance running from the captured state.");
+
+    const auto deadline = std::chrono::steady_clock::now() + runtime;
+    while (XeRunning && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+    XeMain::Shutdown();
+    return 0;
+  }
+
+  std::string jsonEscape(const std::string &str) {
+    std::string escaped;
+    for (const char c : str) {
+      switch (c) {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      default:
+        if (static_cast<u8>(c) < 0x20) {
+          escaped += fmt::format("\\u{:04x}", static_cast<u8>(c));
+        } else {
+          escaped += c;
+        }
+        break;
+      }
+    }
+    return escaped;
+  }
+
+} // anonymous namespace
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present()) {
+    ::Base::Param::Help();
+    return 0;
+  }
+  if (!PARAM_loadstate.Present() && !PARAM_post.Present() && !PARAM_warmup.Present()) {
+    fmt::print("Nothing says when the system is ready to fork, give -post, -warmup or -loadstate\n");
+    ::Base::Param::Help();
+    return 1;
+  }
+  const u32 instanceCount = PARAM_instances.Present() ? std::max(PARAM_instances.Get<s32>(), 1) : 1;
+  const u32 jobs = PARAM_jobs.Present() ? std::max(PARAM_jobs.Get<s32>(), 1) : std::max(std::thread::hardware_concurrency(), 1u);
+  const std::chrono::seconds runtime{ PARAM_runtime.Present() ? std::max(PARAM_runtime.Get<s32>(), 1) : 60 };
+  const fs::path outDirectory = fs::absolute(PARAM_out.Present() ? PARAM_out.Get() : "xenon-launcher");
+  const std::vector<std::string> discs = PARAM_odd.GetAll();
+
+  std::error_code error{};
+  const fs::path parentDirectory = outDirectory / "parent";
+  fs::create_directories(parentDirectory, error);
+  if (error) {
+    fmt::print("Unable to create '{}': {}\n", parentDirectory.string(), error.message());
+    return 1;
+  }
+  Base::SetCurrentThreadName("[Xe] Launcher");
+  Base::FS::SetUserPath(Base::FS::PathType::LogDir, parentDirectory);
+
+  // Boot (or load) once
+  XeMain::saveConfigOnShutdown = false;
+  XeMain::Create([&] {
+    applyCommonOverrides();
+    applyOutputOverrides(parentDirectory);
+    // Its writes are captured along with the rest of the NAND
+    Config::filepaths.nandOverlay = "none";
+    // Instances get theirs from the captured state
+    Config::filepaths.hddOverlayOnExit = "Discard";
+  });
+  if (PARAM_loadstate.Present()) {
+    if (!XeMain::LoadState(PARAM_loadstate.Get())) {
+      XeMain::Shutdown();
+      return 1;
+    }
+  } else {
+    postCode = PARAM_post.Get<u64>();
+    Xe::XCPU::POSTBUS::SetObserver(onPOST);
+    XeMain::StartCPU();
+    const auto start = std::chrono::steady_clock::now();
+    const auto warmup = std::chrono::seconds{ PARAM_warmup.Present() ? PARAM_warmup.Get<s32>() : 0 };
+    const auto deadline = start + std::chrono::seconds{ PARAM_boottimeout.Present() ? PARAM_boottimeout.Get<s32>() : 120 };
+    while (XeRunning && XeMain::CPUStarted) {
+      const auto now = std::chrono::steady_clock::now();
+      if (PARAM_post.Present() ? postReached.load(std::memory_order_relaxed) : now >= start + warmup) {
+        break;
+      }
+      if (PARAM_post.Present() && now >= deadline) {
+        fmt::print("POST 0x{:X} wasn't reached within the boot timeout\n", postCode);
+        XeMain::Shutdown();
+        return 1;
+      }
+      std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+    Xe::XCPU::POSTBUS::SetObserver(nullptr);
+    if (!XeRunning || !XeMain::CPUStarted) {
+      XeMain::Shutdown();
+      return 1;
+    }
+  }
+
+  // Safe point, capture, then tear down to a single thread
+  if (!XeMain::Quiesce()) {
+    fmt::print("The system didn't reach a safe point\n");
+    XeMain::Shutdown();
+    return 1;
+  }
+  Xe::SaveState::sMachineState state{};
+  Xe::SaveState::CaptureMachine(state, true);
+  XeMain::ReleaseForFork();
+  fmt::print("System captured, forking {} instances, {} at a time\n", instanceCount, jobs);
+
+  std::signal(SIGINT, onInterrupt);
+  std::signal(SIGTERM, onInterrupt);
+  std::vector<sInstance> instances(instanceCount);
+  u32 next = 0;
+  u32 running = 0;
+  while ((next != instanceCount && !interrupted) || running) {
+    while (running != jobs && next != instanceCount && !interrupted) {
+      sInstance &instance = instances[next];
+      instance.directory = outDirectory / std::to_string(next);
+      instance.disc = discs.empty() ? "" : discs[next % discs.size()];
+      fs::create_directories(instance.directory, error);
+      ++next;
+      // Its log, overlays and output would go nowhere, leave it out of the run (reported as not started)
+      if (error) {
+        fmt::print("Unable to create '{}' for instance {}: {}\n", instance.directory.string(), next - 1, error.message());
+        continue;
+      }
+      std::fflush(nullptr);
+      instance.start = std::chrono::steady_clock::now();
+      instance.pid = fork();
+      if (instance.pid == 0) {
+        const s32 exitCode = runInstance(instance, state, runtime);
+        std::fflush(nullptr);
+        // Nothing the parent set up gets torn down twice
+        _exit(exitCode);
+      }
+      if (instance.pid < 0) {
+        fmt::print("Unable to fork instance {}: {}\n", next - 1, strerror(errno));
+        continue;
+      }
+      ++running;
+    }
+    if (!running) {
+      continue;
+    }
+    s32 status = 0;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    for (u32 i = 0; i != next; ++i) {
+      sInstance &instance = instances[i];
+      if (instance.pid != pid) {
+        continue;
+      }
+      instance.wallMs = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - instance.start).count();
+      if (WIFEXITED(status)) {
+        instance.exitCode = WEXITSTATUS(status);
+      } else if (WIFSIGNALED(status)) {
+        instance.signal = WTERMSIG(status);
+      }
+      fmt::print("Instance {} {} {} after {:.0f}ms\n", i, instance.signal ? "killed by signal" : "exited with",
+        instance.signal ? instance.signal : instance.exitCode, instance.wallMs);
+      --running;
+      break;
+    }
+  }
+
+  s32 exitCode = 0;
+  const fs::path reportPath = outDirectory / "launcher.json";
+  std::ofstream report(reportPath, std::ios::trunc);
+  report << fmt::format("{{\n  \"runtimeSeconds\": {},\n  \"instances\": [", runtime.count());
+  for (u32 i = 0; i != instanceCount; ++i) {
+    const sInstance &instance = instances[i];
+    if (instance.exitCode != 0) {
+      exitCode = 2;
+    }
+    report << fmt::format("{}\n    {{ \"directory\": \"{}\", \"disc\": \"{}\", \"started\": {}, \"exitCode\": {}, "
+      "\"signal\": {}, \"wallMs\": {:.3f} }}", i ? "," : "", jsonEscape(instance.directory.string()),
+      jsonEscape(instance.disc), instance.pid > 0, instance.exitCode, instance.signal, instance.wallMs);
+  }
+  report << "\n  ]\n}\n";
+  report.close();
+  fmt::print("Report written to '{}'\n", reportPath.string());
+  return exitCode;
+}
@@ -0,0 +1,85 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-log
+// Converts binary logs (see Base/Logging/BinaryLog.h) to text, the same text the log file would have held.
+//
+// Examples:
+//   xenon-log -in xenon_1-1-2025_12-0-0.xlog -out xenon.txt
+//   xenon-log -in xenon_1-1-2025_12-0-0.xlog -level Warning
+//
+
+#include <cstdio>
+
+#include "Base/Hash.h"
+#include "Base/Logging/Backend.h"
+#include "Base/Logging/BinaryLog.h"
+#include "Base/Logging/TextFormatter.h"
+#include "Base/Param.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(in, "Binary log to read");
+PARAM(out, "Text output path, defaults to stdout");
+PARAM(level, "Only prints messages at or above this level (Trace, Debug, Info, Warning, Error, Critical, Guest)");
+PARAM(advanced, "Prints the file, function and line of every message", false);
+PARAM(timestamps, "Prefixes every message with its time since the log started", false);
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present() || !PARAM_in.Present()) {
+    ::Base::Param::Help();
+    return PARAM_help.Present() ? 0 : 1;
+  }
+
+  Base::Log::Level minLevel = Base::Log::Level::Trace;
+  if (PARAM_level.Present()) {
+    bool found = false;
+    for (u8 i = 0; i != static_cast<u8>(Base::Log::Level::Count); ++i) {
+      if (Base::JoaatStringHash(PARAM_level.Get()) == Base::JoaatStringHash(Base::Log::GetLevelName(static_cast<Base::Log::Level>(i)))) {
+        minLevel = static_cast<Base::Log::Level>(i);
+        found = true;
+      }
+    }
+    if (!found) {
+      fmt::print("Invalid level '{}'\n", PARAM_level.Get());
+      return 1;
+    }
+  }
+  Config::log.advanced = PARAM_advanced.Present();
+  const bool timestamps = PARAM_timestamps.Present();
+
+  Base::Log::Initialize();
+  Base::Log::Start();
+
+  FILE *out = stdout;
+  if (PARAM_out.Present()) {
+    out = fopen(PARAM_out.Get().c_str(), "w");
+    if (!out) {
+      fmt::print("Unable to open '{}' for writing\n", PARAM_out.Get());
+      Base::Log::Stop();
+      return 1;
+    }
+  }
+
+  const bool complete = Base::Log::ReadBinaryLog(PARAM_in.Get(), [&](const Base::Log::Entry &entry) {
+    if (static_cast<u8>(entry.logLevel) < static_cast<u8>(minLevel)) {
+      return true;
+    }
+    if (!entry.formatted) {
+      fmt::print(out, "{}", entry.message);
+    } else if (timestamps) {
+      fmt::print(out, "[{:>12.6f}] {}\n", entry.timestamp.count() / 1000000.0, Base::Log::FormatLogMessage(entry));
+    } else {
+      fmt::print(out, "{}\n", Base::Log::FormatLogMessage(entry));
+    }
+    return true;
+  });
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  Base::Log::Stop();
+  return complete ? 0 : 1;
+}
@@ -9,6 +9,7 @@
 #include "Base/Thread.h"
 
 PARAM(help, "Prints this message", false);
+PARAM(loadstate, "Save state to resume from instead of booting");
 
 #define AUTO_FLIP 1
 s32 main(s32 argc, char *argv[]) {
@@ -39,7 +40,12 @@ s32 main(s32 argc, char *argv[]) {
   // Give errors a second to catch up, incase of the async backend
   std::this_thread::sleep_for(200ms);
   // Start execution of the emulator
-  XeMain::StartCPU();
+  if (PARAM_loadstate.Present()) {
+    if (!XeMain::LoadState(PARAM_loadstate.Get()))
+      XeRunning = false;
+  } else {
+    XeMain::StartCPU();
+  }
 #ifndef NO_GFX
   // Wait for ImGui to be initialized
   if (XeMain::renderer.get()) {
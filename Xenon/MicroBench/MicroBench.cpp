@@ -0,0 +1,560 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-microbench
+// Per-opcode micro benchmarks of the interpreter handlers (PPC_ALU/PPC_FPU/PPC_VXU) and of the JIT emitters.
+// Every ALU, FPU and VXU opcode is measured on both backends in two shapes:
+// - throughput: a run of the opcode writing a rotating set of registers, no dependencies between them.
+// - latency:    a run of the opcode reading what the previous one wrote (rD == rA).
+// The interpreter calls the decoded handler in a loop, minus the cost of the loop with no instructions. The JIT
+// compiles a block of the repeated opcode through PPU_JIT::BuildJITBlock and times calls of it, minus the cost of
+// an empty block. Opcodes without an emitter are timed as hybrid blocks calling the interpreter, and flagged so,
+// that's where slow paths hide.
+// Latency chains read a register holding 1.0 as their second operand, and registers are reset every
+// RESET_INTERVAL iterations outside the timed region, so values don't drift to infinities or denormals.
+// Iterations are calibrated until a repetition runs for the minimum time, the median repetition is reported.
+//
+// Results go to a JSON file with one benchmark per line. Given a previous one with -compare, benchmarks that got
+// slower than -threshold percent are listed and the exit code is 2.
+//
+// Example: xenon-microbench -category VXU -filter 128 -out vmx128.json -compare vmx128-main.json
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+#include "Base/Config.h"
+#include "Base/Hash.h"
+#include "Base/Logging/Backend.h"
+#include "Base/Param.h"
+#include "Base/Thread.h"
+#include "Core/RAM/RAM.h"
+#include "Core/RootBus/RootBus.h"
+#include "Core/XCPU/PPU/PPU.h"
+#include "Core/XCPU/Interpreter/InstructionProfiler.h"
+#include "Core/XCPU/Interpreter/PPCInterpreter.h"
+#include "Core/XCPU/JIT/PPU_JIT.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(category, "Opcode categories to measure: ALU, FPU, VXU. Defaults to all three");
+PARAM(filter, "Only measures opcodes whose name contains this");
+PARAM(backend, "Backends to measure: Interpreter, JIT. Defaults to both");
+PARAM(instrs, "Instructions per JIT block and per interpreter batch, defaults to 64");
+PARAM(mintime, "Minimum milliseconds a repetition runs for, defaults to 20");
+PARAM(repetitions, "Repetitions per benchmark, the median is reported. Defaults to 5");
+PARAM(out, "Path of the JSON results, defaults to xenon-microbench.json");
+PARAM(compare, "Previous JSON results to check for regressions against");
+PARAM(threshold, "Percent a benchmark may get slower before it's a regression, defaults to 10");
+
+namespace {
+
+  // Where the benchmarked code is written to
+  constexpr u32 CODE_ADDRESS = 0x10000000;
+  constexpr u32 BLR_OPCODE = 0x4E800020;
+  // Registers the throughput shape rotates its destination over
+  constexpr u32 THROUGHPUT_DESTINATIONS = 8;
+  constexpr u32 FIRST_THROUGHPUT_DESTINATION = 8;
+  // Register the latency shape chains through, and the one holding 1.0 (x * 1, x / 1, ... stay put) it reads
+  constexpr u32 LATENCY_REGISTER = 4;
+  constexpr u32 IDENTITY_REGISTER = 2;
+  // Timed iterations between two (untimed) register resets
+  constexpr u64 RESET_INTERVAL = 16;
+
+  enum class eShape : u8 {
+    Throughput,
+    Latency
+  };
+
+  struct sOpcode {
+    std::string name;
+    std::string category;
+    // Instructions of each shape, one per block slot
+    std::vector<u32> throughput;
+    std::vector<u32> latency;
+    bool jitEmitter = false;
+  };
+
+  struct sResult {
+    std::string name;
+    std::string opcode;
+    std::string category;
+    std::string backend;
+    std::string shape;
+    u32 instr = 0;
+    bool jitEmitter = false;
+    u64 iterations = 0;
+    f64 nsPerInstr = 0.0;
+    f64 minNsPerInstr = 0.0;
+    f64 stddevNsPerInstr = 0.0;
+    u64 compileNs = 0;
+    u64 hostCodeBytes = 0;
+  };
+
+  struct sSettings {
+    u32 instrs = 64;
+    std::chrono::nanoseconds minTime = 20ms;
+    u32 repetitions = 5;
+  };
+
+  // Sets the operand fields of a standard form instruction. VMX128 keeps the low bits of its registers there too.
+  u32 withFields(u32 instr, u32 d, u32 a, u32 b) {
+    return (instr & ~0x03FFF800u) | ((d & 0x1F) << 21) | ((a & 0x1F) << 16) | ((b & 0x1F) << 11);
+  }
+
+  // Builds both shapes for an opcode. Forms using the operand fields as extended opcode bits keep their encoding.
+  bool buildShapes(sOpcode &opcode, u32 slotInstr, u32 count) {
+    auto decodesTo = [&opcode](u32 instr) {
+      return PPCInterpreter::ppcDecoder.decodeName(instr) == opcode.name;
+    };
+    for (u32 i = 0; i != count; ++i) {
+      u32 throughput = withFields(slotInstr, FIRST_THROUGHPUT_DESTINATION + i % THROUGHPUT_DESTINATIONS, 1, 2);
+      u32 latency = withFields(slotInstr, LATENCY_REGISTER, LATENCY_REGISTER, IDENTITY_REGISTER);
+      opcode.throughput.push_back(decodesTo(throughput) ? throughput : slotInstr);
+      opcode.latency.push_back(decodesTo(latency) ? latency : slotInstr);
+    }
+    return decodesTo(slotInstr);
+  }
+
+  std::vector<sOpcode> collectOpcodes(const std::vector<std::string> &categories, const std::string &filter, u32 count) {
+    std::map<std::string, sOpcode> opcodes;
+    for (u32 slot = 0; slot != INSTR_PROFILER_SLOTS; ++slot) {
+      const u32 instr = PPCInterpreter::InstrSlotOpcode(slot);
+      const std::string name = PPCInterpreter::ppcDecoder.decodeName(instr);
+      // First slot of every opcode only, its plain (Rc = 0, OE = 0) form
+      if (name.empty() || opcodes.contains(name)) {
+        continue;
+      }
+      const std::string category = PPCInterpreter::InstrCategory(name);
+      if (std::find(categories.begin(), categories.end(), category) == categories.end()) {
+        continue;
+      }
+      // External control, goes through memory
+      if (name == "eciwx" || name == "ecowx") {
+        continue;
+      }
+      if (!filter.empty() && name.find(filter) == std::string::npos) {
+        continue;
+      }
+      sOpcode opcode{};
+      opcode.name = name;
+      opcode.category = category;
+      opcode.jitEmitter = PPCInterpreter::ppcDecoder.decodeJIT(instr) != &PPCInterpreter::PPCInterpreterJIT_invalid;
+      if (buildShapes(opcode, instr, count)) {
+        opcodes.emplace(name, std::move(opcode));
+      }
+    }
+    std::vector<sOpcode> list;
+    for (auto &[name, opcode] : opcodes) {
+      list.push_back(std::move(opcode));
+    }
+    return list;
+  }
+
+  // Finite, normal operands, so nothing benchmarks the denormal slow paths by accident.
+  void resetState(sPPUThread &thread) {
+    for (u32 i = 0; i != 32; ++i) {
+      thread.GPR[i] = 0x0000000100000000ULL * i + 0x12345 + i;
+      thread.FPR[i].setValue(1.0 + i * 0.25);
+    }
+    for (u32 i = 0; i != 128; ++i) {
+      thread.VR[i] = Base::Vector128f(1.0f + i, 2.0f + i, 0.5f + i, 0.25f + i);
+    }
+    thread.GPR[IDENTITY_REGISTER] = 1;
+    thread.FPR[IDENTITY_REGISTER].setValue(1.0);
+    thread.VR[IDENTITY_REGISTER] = Base::Vector128f(1.0f, 1.0f, 1.0f, 1.0f);
+    thread.CR.CR_Hex = 0;
+    thread.SPR.XER.hexValue = 0;
+    thread.FPSCR.FPSCR_Hex = 0;
+    thread.VSCR.hexValue = 0;
+    thread.SPR.LR = CODE_ADDRESS;
+    thread.SPR.CTR = 0;
+    thread.exceptReg = 0;
+    thread.SPR.MSR.FP = 1;
+    thread.SPR.MSR.VXU = 1;
+    thread.SPR.MSR.SF = 1;
+    thread.NIA = CODE_ADDRESS;
+  }
+
+  struct sTiming {
+    u64 iterations = 0;
+    std::vector<f64> nsPerIteration;
+  };
+
+  // Google Benchmark style: grows the iteration count until a run lasts minTime, then repeats it.
+  // reset runs every RESET_INTERVAL iterations, and isn't timed.
+  template <typename F, typename R>
+  sTiming measure(const sSettings &settings, F &&iteration, R &&reset) {
+    using clock = std::chrono::steady_clock;
+    auto run = [&iteration, &reset](u64 count) {
+      std::chrono::nanoseconds elapsed{};
+      for (u64 done = 0; done != count;) {
+        const u64 chunk = std::min(count - done, RESET_INTERVAL);
+        reset();
+        const auto start = clock::now();
+        for (u64 i = 0; i != chunk; ++i) {
+          iteration();
+        }
+        elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+        done += chunk;
+      }
+      return elapsed;
+    };
+    sTiming timing{};
+    u64 count = 1;
+    for (;;) {
+      const auto elapsed = run(count);
+      if (elapsed >= settings.minTime || count >= (1ULL << 40)) {
+        break;
+      }
+      const f64 scale = elapsed.count() ? static_cast<f64>(settings.minTime.count()) / elapsed.count() * 1.4 : 10.0;
+      count = std::max<u64>(count * 2, static_cast<u64>(count * std::min(scale, 10.0)));
+    }
+    timing.iterations = count;
+    for (u32 r = 0; r != settings.repetitions; ++r) {
+      timing.nsPerIteration.push_back(static_cast<f64>(run(count).count()) / count);
+    }
+    return timing;
+  }
+
+  void summarize(const sTiming &timing, f64 overheadNs, u32 instrs, sResult &result) {
+    std::vector<f64> perInstr;
+    for (f64 ns : timing.nsPerIteration) {
+      perInstr.push_back(std::max(ns - overheadNs, 0.0) / instrs);
+    }
+    std::sort(perInstr.begin(), perInstr.end());
+    f64 mean = 0.0;
+    for (f64 ns : perInstr) {
+      mean += ns;
+    }
+    mean /= perInstr.size();
+    f64 variance = 0.0;
+    for (f64 ns : perInstr) {
+      variance += (ns - mean) * (ns - mean);
+    }
+    result.iterations = timing.iterations;
+    result.nsPerInstr = perInstr[perInstr.size() / 2];
+    result.minNsPerInstr = perInstr.front();
+    result.stddevNsPerInstr = std::sqrt(variance / perInstr.size());
+  }
+
+  class MicroBench {
+  public:
+    MicroBench(Xe::XCPU::XenonContext *xenonContext, const sSettings &inSettings) : settings(inSettings) {
+      ppu = std::make_unique<PPU>(xenonContext, 0, 0);
+      ppeState = ppu->GetPPUState();
+      ppuJIT = ppu->GetPPUJIT();
+      ppeState->SPR.LPCR.hexValue = 0x402ULL;
+      ppeState->SPR.HID6.hexValue = 0x1803800000000ULL;
+    }
+
+    // Instructions the opcode raises an exception on can't be timed, the handlers would run instead.
+    bool Probe(const sOpcode &opcode) {
+      sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
+      resetState(thread);
+      thread.CI.opcode = opcode.throughput.front();
+      PPCInterpreter::ppcDecoder.decode(thread.CI.opcode)(ppeState);
+      return thread.exceptReg == 0;
+    }
+
+    bool Interpreter(const sOpcode &opcode, eShape shape, sResult &result) {
+      const std::vector<u32> &instrs = shape == eShape::Throughput ? opcode.throughput : opcode.latency;
+      const sTiming timing = MeasureHandlers(instrs, PPCInterpreter::ppcDecoder.decode(instrs.front()));
+      summarize(timing, LoopOverhead(), static_cast<u32>(instrs.size()), result);
+      return true;
+    }
+
+    bool JIT(const sOpcode &opcode, eShape shape, sResult &result) {
+      const std::vector<u32> &instrs = shape == eShape::Throughput ? opcode.throughput : opcode.latency;
+      // Without an emitter the block calls the interpreter, as the hybrid executor would
+      ppu->currentExecMode = opcode.jitEmitter ? eExecutorMode::JIT : eExecutorMode::Hybrid;
+
+      const u64 compileNs = ppuJIT->GetStats().compileTimeNs.Get();
+      const u64 codeBytes = ppuJIT->GetStats().hostCodeBytes.Get();
+      const auto block = Build(instrs);
+      if (!block) {
+        return false;
+      }
+      result.compileNs = ppuJIT->GetStats().compileTimeNs.Get() - compileNs;
+      result.hostCodeBytes = ppuJIT->GetStats().hostCodeBytes.Get() - codeBytes;
+
+      const sTiming timing = MeasureBlock(*block);
+      summarize(timing, BlockOverhead(), static_cast<u32>(instrs.size()), result);
+      return true;
+    }
+
+  private:
+    // Times the interpreter loop over instrs, calling handler for each
+    template <typename H>
+    sTiming MeasureHandlers(const std::vector<u32> &instrs, H handler) {
+      sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
+      return measure(settings, [&] {
+        for (u32 instr : instrs) {
+          thread.CI.opcode = instr;
+          handler(ppeState);
+        }
+      }, [&] { resetState(thread); });
+    }
+
+    // Times calls of a compiled block
+    sTiming MeasureBlock(JITBlock &block) {
+      sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
+      return measure(settings, [&] {
+        thread.NIA = CODE_ADDRESS;
+        block.codePtr(ppu.get(), ppeState, false);
+      }, [&] { resetState(thread); });
+    }
+
+    // Writes the instructions and a blr, and compiles them into one block.
+    std::shared_ptr<JITBlock> Build(const std::vector<u32> &instrs) {
+      for (u32 i = 0; i != instrs.size(); ++i) {
+        PPCInterpreter::MMUWrite32(ppeState, CODE_ADDRESS + i * 4, instrs[i]);
+      }
+      PPCInterpreter::MMUWrite32(ppeState, CODE_ADDRESS + static_cast<u32>(instrs.size()) * 4, BLR_OPCODE);
+      ppuJIT->InvalidateBlockAt(CODE_ADDRESS);
+      sPPUThread &thread = ppeState->ppuThread[ppeState->currentThread];
+      thread.NIA = CODE_ADDRESS;
+      return ppuJIT->BuildJITBlock(CODE_ADDRESS, instrs.size() + 1);
+    }
+
+    // Cost of calling a block holding only its blr, taken off every JIT timing.
+    f64 BlockOverhead() {
+      if (blockOverheadNs >= 0.0) {
+        return blockOverheadNs;
+      }
+      const auto block = Build({});
+      blockOverheadNs = median(MeasureBlock(*block));
+      return blockOverheadNs;
+    }
+
+    // Cost of an interpreter loop iteration over no instructions, taken off every interpreter timing.
+    f64 LoopOverhead() {
+      if (loopOverheadNs >= 0.0) {
+        return loopOverheadNs;
+      }
+      const std::vector<u32> none{};
+      loopOverheadNs = median(MeasureHandlers(none, PPCInterpreter::ppcDecoder.decode(BLR_OPCODE)));
+      return loopOverheadNs;
+    }
+
+    static f64 median(const sTiming &timing) {
+      std::vector<f64> samples = timing.nsPerIteration;
+      std::sort(samples.begin(), samples.end());
+      return samples[samples.size() / 2];
+    }
+
+    sSettings settings;
+    std::unique_ptr<PPU> ppu;
+    sPPEState *ppeState = nullptr;
+    PPU_JIT *ppuJIT = nullptr;
+    f64 blockOverheadNs = -1.0;
+    f64 loopOverheadNs = -1.0;
+  };
+
+  void writeResults(const std::string &path, const sSettings &settings, const std::vector<sResult> &results) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+      fmt::print("Unable to open '{}' for writing\n", path);
+      return;
+    }
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+    file << fmt::format("{{\n  \"context\": {{ \"unixTime\": {}, \"instrs\": {}, \"minTimeMs\": {}, \"repetitions\": {} }},\n",
+      now.count(), settings.instrs, std::chrono::duration_cast<std::chrono::milliseconds>(settings.minTime).count(),
+      settings.repetitions);
+    file << "  \"benchmarks\": [";
+    for (size_t i = 0; i != results.size(); ++i) {
+      const sResult &r = results[i];
+      file << fmt::format("{}\n    {{ \"name\": \"{}\", \"opcode\": \"{}\", \"category\": \"{}\", \"backend\": \"{}\", "
+        "\"shape\": \"{}\", \"instr\": \"0x{:08X}\", \"jitEmitter\": {}, \"iterations\": {}, \"nsPerInstr\": {:.4f}, "
+        "\"minNsPerInstr\": {:.4f}, \"stddevNsPerInstr\": {:.4f}, \"compileNs\": {}, \"hostCodeBytes\": {} }}",
+        i ? "," : "", r.name, r.opcode, r.category, r.backend, r.shape, r.instr, r.jitEmitter, r.iterations,
+        r.nsPerInstr, r.minNsPerInstr, r.stddevNsPerInstr, r.compileNs, r.hostCodeBytes);
+    }
+    file << "\n  ]\n}\n";
+    fmt::print("Results written to '{}'\n", path);
+  }
+
+  // Reads name -> nsPerInstr back from a file writeResults made, one benchmark per line.
+  std::map<std::string, f64> readResults(const std::string &path) {
+    std::map<std::string, f64> results;
+    std::ifstream file(path);
+    std::string line;
+    auto field = [&line](const std::string &key) -> std::string {
+      const std::string token = "\"" + key + "\": ";
+      const size_t start = line.find(token);
+      if (start == std::string::npos) {
+        return {};
+      }
+      size_t begin = start + token.size();
+      if (line[begin] == '"') {
+        ++begin;
+        return line.substr(begin, line.find('"', begin) - begin);
+      }
+      return line.substr(begin, line.find_first_of(",}", begin) - begin);
+    };
+    while (std::getline(file, line)) {
+      const std::string name = field("name");
+      const std::string ns = field("nsPerInstr");
+      if (!name.empty() && !ns.empty()) {
+        results[name] = std::strtod(ns.c_str(), nullptr);
+      }
+    }
+    return results;
+  }
+
+} // anonymous namespace
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present()) {
+    ::Base::Param::Help();
+    return 0;
+  }
+
+  sSettings settings{};
+  if (PARAM_instrs.Present()) {
+    settings.instrs = std::clamp(PARAM_instrs.Get<s32>(), 1, 4096);
+  }
+  if (PARAM_mintime.Present()) {
+    settings.minTime = std::chrono::milliseconds(std::max(PARAM_mintime.Get<s32>(), 1));
+  }
+  if (PARAM_repetitions.Present()) {
+    settings.repetitions = std::max(PARAM_repetitions.Get<s32>(), 1);
+  }
+  std::vector<std::string> categories = PARAM_category.GetAll();
+  if (categories.empty()) {
+    categories = { "ALU", "FPU", "VXU" };
+  }
+  for (auto &category : categories) {
+    std::transform(category.begin(), category.end(), category.begin(), ::toupper);
+  }
+  bool runInterpreter = !PARAM_backend.Present(), runJIT = !PARAM_backend.Present();
+  for (const std::string &backend : PARAM_backend.GetAll()) {
+    switch (Base::JoaatStringHash(backend)) {
+    case "Interpreter"_jLower: runInterpreter = true; break;
+    case "JIT"_jLower: runJIT = true; break;
+    default:
+      fmt::print("Invalid backend '{}', expected Interpreter or JIT\n", backend);
+      return 1;
+    }
+  }
+#if !defined(ARCH_X86) && !defined(ARCH_X86_64)
+  if (runJIT) {
+    fmt::print("The JIT only emits x86 code, skipping it\n");
+    runJIT = false;
+  }
+#endif
+  const std::string outPath = PARAM_out.Present() ? PARAM_out.Get() : "xenon-microbench.json";
+  const f64 threshold = PARAM_threshold.Present() ? std::max(PARAM_threshold.Get<s32>(), 0) : 10;
+
+  Base::SetCurrentThreadName("[Xe] MicroBench");
+  Base::Log::Initialize();
+  Base::Log::Start();
+  Base::Log::Filter logFilter{ Base::Log::Level::Warning };
+  Base::Log::SetGlobalFilter(logFilter);
+
+  // Handlers only ever touch registers, the code goes to RAM
+  auto ram = std::make_shared<RAM>("RAM", RAM_START_ADDR, Config::xcpu.ramSize, false);
+  auto rootBus = std::make_unique<RootBus>();
+  rootBus->AddDevice(ram);
+  auto xenonContext = std::make_unique<Xe::XCPU::XenonContext>(rootBus.get(), ram.get());
+  PPCInterpreter::xenonContext = xenonContext.get();
+
+  const std::vector<sOpcode> opcodes = collectOpcodes(categories, PARAM_filter.Present() ? PARAM_filter.Get() : "",
+    settings.instrs);
+  fmt::print("Measuring {} opcodes, {} instructions per batch, {} repetitions of at least {}ms\n", opcodes.size(),
+    settings.instrs, settings.repetitions, std::chrono::duration_cast<std::chrono::milliseconds>(settings.minTime).count());
+
+  std::vector<sResult> results;
+  {
+    MicroBench bench(xenonContext.get(), settings);
+    for (const sOpcode &opcode : opcodes) {
+      if (!bench.Probe(opcode)) {
+        fmt::print("{:<14} skipped, raises an exception\n", opcode.name);
+        continue;
+      }
+      for (eShape shape : { eShape::Throughput, eShape::Latency }) {
+        const char *shapeName = shape == eShape::Throughput ? "throughput" : "latency";
+        auto makeResult = [&](const char *backend) {
+          sResult result{};
+          result.opcode = opcode.name;
+          result.category = opcode.category;
+          result.backend = backend;
+          result.shape = shapeName;
+          result.name = fmt::format("{}/{}/{}/{}", backend, opcode.category, opcode.name, shapeName);
+          result.instr = shape == eShape::Throughput ? opcode.throughput.front() : opcode.latency.front();
+          result.jitEmitter = opcode.jitEmitter;
+          return result;
+        };
+        if (runInterpreter) {
+          sResult result = makeResult("Interpreter");
+          if (bench.Interpreter(opcode, shape, result)) {
+            results.push_back(result);
+          }
+        }
+        if (runJIT) {
+          sResult result = makeResult(opcode.jitEmitter ? "JIT" : "Hybrid");
+          if (bench.JIT(opcode, shape, result)) {
+            results.push_back(result);
+          }
+        }
+      }
+      for (size_t i = results.size(); i != 0 && results[i - 1].opcode == opcode.name; --i) {
+        const sResult &r = results[i - 1];
+        fmt::print("{:<44} {:>9.2f} ns/instr (min {:.2f}, stddev {:.2f})\n", r.name, r.nsPerInstr,
+          r.minNsPerInstr, r.stddevNsPerInstr);
+      }
+    }
+  }
+  writeResults(outPath, settings, results);
+
+  // The opcodes the JIT gains the least on, usually fallbacks and scalar loops
+  std::vector<std::pair<f64, std::string>> speedups;
+  std::map<std::string, f64> interpreterNs;
+  for (const sResult &r : results) {
+    if (r.backend == "Interpreter" && r.shape == "throughput") {
+      interpreterNs[r.opcode] = r.nsPerInstr;
+    }
+  }
+  for (const sResult &r : results) {
+    if (r.backend != "Interpreter" && r.shape == "throughput" && interpreterNs.contains(r.opcode) && r.nsPerInstr > 0.0) {
+      speedups.emplace_back(interpreterNs[r.opcode] / r.nsPerInstr, fmt::format("{} ({})", r.opcode, r.backend));
+    }
+  }
+  std::sort(speedups.begin(), speedups.end());
+  if (!speedups.empty()) {
+    fmt::print("Smallest JIT speedups over the interpreter:\n");
+    for (size_t i = 0; i != std::min<size_t>(speedups.size(), 10); ++i) {
+      fmt::print("  {:<30} {:.2f}x\n", speedups[i].second, speedups[i].first);
+    }
+  }
+
+  s32 exitCode = 0;
+  if (PARAM_compare.Present()) {
+    const std::map<std::string, f64> baseline = readResults(PARAM_compare.Get());
+    u32 regressions = 0;
+    for (const sResult &r : results) {
+      auto it = baseline.find(r.name);
+      if (it == baseline.end() || it->second <= 0.0) {
+        continue;
+      }
+      const f64 change = (r.nsPerInstr / it->second - 1.0) * 100.0;
+      if (change > threshold) {
+        fmt::print("Regression: {} {:.2f} -> {:.2f} ns/instr (+{:.1f}%)\n", r.name, it->second, r.nsPerInstr, change);
+        ++regressions;
+      }
+    }
+    fmt::print("{} regressions against '{}' (threshold {}%)\n", regressions, PARAM_compare.Get(), threshold);
+    exitCode = regressions ? 2 : 0;
+  }
+
+  xenonContext.reset();
+  rootBus.reset();
+  ram.reset();
+  Base::Log::Stop();
+  return exitCode;
+}
@@ -0,0 +1,147 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#include "GuestBufferCache.h"
+
+#ifndef NO_GFX
+#include <algorithm>
+
+#include "Base/Logging/Log.h"
+
+namespace Render {
+
+std::shared_ptr<Buffer> GuestBufferCache::GetOrUpload(const GuestBufferKey &key, eBufferType type) {
+  if (key.size == 0)
+    return nullptr;
+
+  SyncInvalidations();
+
+  Entry &entry = entries[key];
+  entry.lastUse = ++useClock;
+  if (entry.buffer && entry.valid) {
+    ++hits;
+    return entry.buffer;
+  }
+
+  const u8 *data = ram->GetPointerToAddress(key.guestBase);
+  if (!data || static_cast<u64>(key.guestBase) + key.size > ram->GetSize()) {
+    LOG_WARNING(Render, "GuestBufferCache: Range {:#x} (size {:#x}) is not backed by RAM", key.guestBase, key.size);
+    entries.erase(key);
+    return nullptr;
+  }
+
+  // Arm the watch before reading, so a write racing with the upload still invalidates us
+  ram->WatchRange(key.guestBase, key.size);
+  const void *hostData = ConvertToHost(key, data);
+  std::shared_ptr<Buffer> buffer = entry.buffer;
+  if (!buffer) {
+    buffer = resourceFactory->CreateBuffer();
+    buffer->CreateBuffer(key.size, hostData, eBufferUsage::StaticDraw, type);
+    entry.buffer = buffer;
+    cachedBytes += key.size;
+  } else {
+    buffer->UpdateBuffer(0, key.size, hostData);
+  }
+  entry.valid = true;
+  ++uploads;
+  // The returned buffer is referenced here, so eviction can't drop it
+  if (entries.size() > GUEST_BUFFER_CACHE_MAX_ENTRIES || cachedBytes > GUEST_BUFFER_CACHE_MAX_BYTES)
+    Evict();
+  return buffer;
+}
+
+void GuestBufferCache::Clear() {
+  for (auto &[key, entry] : entries) {
+    if (entry.buffer)
+      entry.buffer->DestroyBuffer();
+  }
+  entries.clear();
+  cachedBytes = 0;
+}
+
+void GuestBufferCache::Evict() {
+  // Evict down to 3/4 of the bounds, so a cache sitting at its limit doesn't sort on every upload
+  const u64 maxEntries = GUEST_BUFFER_CACHE_MAX_ENTRIES / 4 * 3;
+  const u64 maxBytes = GUEST_BUFFER_CACHE_MAX_BYTES / 4 * 3;
+  std::vector<std::pair<u64, GuestBufferKey>> candidates{};
+  candidates.reserve(entries.size());
+  for (const auto &[key, entry] : entries) {
+    // Still bound by the renderer
+    if (entry.buffer && entry.buffer.use_count() > 1)
+      continue;
+    candidates.emplace_back(entry.lastUse, key);
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  for (const auto &[lastUse, key] : candidates) {
+    if (entries.size() <= maxEntries && cachedBytes <= maxBytes)
+      break;
+    const auto it = entries.find(key);
+    if (it->second.buffer) {
+      it->second.buffer->DestroyBuffer();
+      cachedBytes -= key.size;
+    }
+    entries.erase(it);
+    ++evictions;
+  }
+}
+
+void GuestBufferCache::SyncInvalidations() {
+  const u64 generation = ram->GetWriteGeneration();
+  if (generation == lastGeneration)
+    return;
+  lastGeneration = generation;
+
+  // Gather the pages written since the last sync
+  const u64 blockCount = ram->GetTrackBlockCount();
+  writtenPages.resize(blockCount);
+  bool anyWritten = false;
+  for (u64 i = 0; i != blockCount; ++i) {
+    writtenPages[i] = ram->ConsumeWrittenPages(i);
+    anyWritten |= writtenPages[i] != 0;
+  }
+  if (!anyWritten)
+    return;
+
+  for (auto &[key, entry] : entries) {
+    if (!entry.valid)
+      continue;
+    const u64 firstPage = (key.guestBase - RAM_START_ADDR) >> RAM_TRACK_PAGE_SHIFT;
+    const u64 lastPage = (key.guestBase - RAM_START_ADDR + key.size - 1) >> RAM_TRACK_PAGE_SHIFT;
+    for (u64 page = firstPage; page <= lastPage && (page >> 6) < blockCount; ++page) {
+      if (writtenPages[page >> 6] & (1ull << (page & 63))) {
+        entry.valid = false;
+        ++invalidations;
+        break;
+      }
+    }
+  }
+}
+
+const void *GuestBufferCache::ConvertToHost(const GuestBufferKey &key, const u8 *data) {
+  if (key.endian == eEndian::xeNone)
+    return data;
+
+  scratch.resize(key.size);
+  if (key.format == eGuestBufferFormat::Index16) {
+    const u64 count = key.size / sizeof(u16);
+    for (u64 i = 0; i != count; ++i) {
+      u16 value = 0;
+      memcpy(&value, data + i * sizeof(u16), sizeof(value));
+      value = xeEndianSwap(value, key.endian);
+      memcpy(scratch.data() + i * sizeof(u16), &value, sizeof(value));
+    }
+  } else {
+    const u64 count = key.size / sizeof(u32);
+    for (u64 i = 0; i != count; ++i) {
+      u32 value = 0;
+      memcpy(&value, data + i * sizeof(u32), sizeof(value));
+      value = xeEndianSwap(value, key.endian);
+      memcpy(scratch.data() + i * sizeof(u32), &value, sizeof(value));
+    }
+  }
+  return scratch.data();
+}
+
+} // namespace Render
+#endif
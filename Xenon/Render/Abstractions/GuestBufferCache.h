@@ -0,0 +1,104 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Base/Types.h"
+
+#include "Core/RAM/RAM.h"
+#include "Core/XGPU/Xenos.h"
+#include "Render/Abstractions/Buffer.h"
+#include "Render/Abstractions/Factory/ResourceFactory.h"
+
+// Bounds of the guest buffer cache, least recently used buffers past them are dropped
+#define GUEST_BUFFER_CACHE_MAX_ENTRIES 4096
+#define GUEST_BUFFER_CACHE_MAX_BYTES 256_MiB
+
+#ifndef NO_GFX
+namespace Render {
+
+// Element layout of a cached guest buffer, decides how the endian swap is applied
+enum class eGuestBufferFormat : u8 {
+  Vertex32,
+  Index16,
+  Index32
+};
+
+struct GuestBufferKey {
+  u32 guestBase = 0;
+  u32 size = 0;
+  eEndian endian = eEndian::xeNone;
+  eGuestBufferFormat format = eGuestBufferFormat::Vertex32;
+
+  bool operator==(const GuestBufferKey &other) const = default;
+};
+
+struct GuestBufferKeyHash {
+  u64 operator()(const GuestBufferKey &key) const {
+    return (static_cast<u64>(key.guestBase) << 32 | key.size) ^
+      (static_cast<u64>(key.endian) << 8 | static_cast<u64>(key.format)) * 0x9E3779B97F4A7C15ull;
+  }
+};
+
+// Host copies of guest vertex/index buffers.
+// Buffers are converted and uploaded once, then reused until the guest writes to one of the pages
+// backing them (CPU stores, CP memory writes and device DMA all report through RAM::MarkWritten).
+// The cache is bounded (see GUEST_BUFFER_CACHE_MAX_*), buffers the renderer still holds are never dropped.
+// Render thread only.
+class GuestBufferCache {
+public:
+  GuestBufferCache(RAM *ramPtr, ResourceFactory *factory) :
+    ram(ramPtr), resourceFactory(factory)
+  {}
+
+  // Returns the host buffer for a guest range, uploading it if it is missing or stale.
+  // Returns nullptr if the range is not backed by RAM.
+  std::shared_ptr<Buffer> GetOrUpload(const GuestBufferKey &key, eBufferType type);
+
+  // Drops every cached buffer
+  void Clear();
+
+  // Stats
+  u64 hits = 0;
+  u64 uploads = 0;
+  u64 invalidations = 0;
+  u64 evictions = 0;
+private:
+  struct Entry {
+    std::shared_ptr<Buffer> buffer{};
+    bool valid = false;
+    // useClock at the last lookup
+    u64 lastUse = 0;
+  };
+
+  // Drops the least recently used entries until the cache is back within its bounds
+  void Evict();
+
+  // Picks up pages written since the last call and invalidates the entries using them
+  void SyncInvalidations();
+
+  // Converts guest data to host endian, returns the pointer to upload from
+  const void *ConvertToHost(const GuestBufferKey &key, const u8 *data);
+
+  RAM *ram = nullptr;
+  ResourceFactory *resourceFactory = nullptr;
+  std::unordered_map<GuestBufferKey, Entry, GuestBufferKeyHash> entries{};
+  // Bumped on every lookup
+  u64 useClock = 0;
+  // Size of every uploaded buffer
+  u64 cachedBytes = 0;
+  // Last RAM write generation we synced against
+  u64 lastGeneration = 0;
+  // Written page bitmap gathered during a sync
+  std::vector<u64> writtenPages{};
+  // Endian conversion scratch, reused across uploads
+  std::vector<u8> scratch{};
+};
+
+} // namespace Render
+#endif
@@ -81,6 +81,9 @@ void Renderer::CreateHandles() {
   // Create factories
   BackendStart();
 
+  // Create the guest buffer cache
+  bufferCache = std::make_unique<GuestBufferCache>(ramPointer, resourceFactory.get());
+
   // Create our backbuffer
   backbuffer = resourceFactory->CreateTexture();
   // Init texture
@@ -107,8 +110,15 @@ void Renderer::CreateHandles() {
 }
 
 void Renderer::Shutdown() {
+  // Nothing was created when rendering is disabled
+  if (!mainWindow)
+    return;
   if (gui)
     gui->Shutdown();
+  if (bufferCache)
+    bufferCache->Clear();
+  vertexFetchBuffers.clear();
+  activeIndexBuffer.reset();
   backbuffer->DestroyTexture();
   pixelSSBO->DestroyBuffer();
   shaderFactory->Destroy();
@@ -116,6 +126,7 @@ void Renderer::Shutdown() {
   resourceFactory.reset();
   backbuffer.reset();
   pixelSSBO.reset();
+  bufferCache.reset();
   gui.reset();
   BackendShutdown();
   BackendSDLShutdown();
@@ -194,66 +205,155 @@ void Renderer::HandleEvents() {
   }
 }
 
-void Renderer::UpdateConstants(Xe::XGPU::XenosState *state) {
-  XeShaderFloatConsts &floatConsts = state->floatConsts;
-  XeShaderBoolConsts &boolConsts = state->boolConsts;
+void Renderer::SubmitCommand(RenderCommand &&cmd) {
+  // Nobody is going to drain the ring, drop it
+  if (!threadRunning)
+    return;
+  // Ring is full, wait for the render thread to catch up
+  while (!renderQueue.TryEmplace(std::move(cmd))) {
+    if (!threadRunning)
+      return;
+    std::this_thread::yield();
+  }
+}
 
-  // Vertex shader constants
-  constexpr u64 FLOAT_CONST_WORDS = sizeof(floatConsts.values) / sizeof(floatConsts.values[0]);
-  u32 *regPtr = reinterpret_cast<u32 *>(state->GetRegisterPointer(XeRegister::SHADER_CONSTANT_000_X));
-  for (u64 i = 0; i != FLOAT_CONST_WORDS; ++i) {
-    u32 word = regPtr[i];
-    f32 f;
-    ::memcpy(&f, &word, sizeof(word));
-    floatConsts.values[i] = f;
+u8 *Renderer::AllocateUpload(u64 size, u64 &arenaMark) {
+  // The arena never hands out empty allocations, waiting for one would never end
+  if (size == 0)
+    return nullptr;
+  if (size > uploadArena.Capacity()) {
+    LOG_ERROR(Render, "Upload of {:#x} bytes does not fit in the upload arena ({:#x} bytes)", size, uploadArena.Capacity());
+    return nullptr;
   }
+  u8 *ptr = nullptr;
+  // Arena is full, wait for the render thread to retire a frame
+  while (threadRunning && !(ptr = uploadArena.TryAllocate(size, arenaMark))) {
+    std::this_thread::yield();
+  }
+  return ptr;
+}
 
-  // Boolean shader constants
-  {
-    // SHADER_CONSTANT_BOOL_000_031 - SHADER_CONSTANT_BOOL_224_255
-    u32 begin = static_cast<u32>(XeRegister::SHADER_CONSTANT_BOOL_000_031);
-    const u64 mask = state->GetDirtyBlock(begin);
-    if (mask & 0xFF) {
-      u32 *ptr = reinterpret_cast<u32 *>(state->GetRegisterPointer(static_cast<XeRegister>(begin)));
-      u32 *dest = &boolConsts.values[begin];
-      std::memcpy(dest, ptr, sizeof(u32) * 8);
+void Renderer::UploadBuffer(u32 bufferHash, const void *data, u64 size, eBufferType type, eBufferUsage usage) {
+  auto &buffer = createdBuffers[bufferHash];
+  if (!buffer) {
+    buffer = resourceFactory->CreateBuffer();
+    buffer->CreateBuffer(size, data, usage, type);
+  } else {
+    buffer->UpdateBuffer(0, size, data);
+  }
+}
+
+std::shared_ptr<Buffer> Renderer::GetVertexBuffer(const Xe::VertexFetchConstant &fetch) {
+  if (fetch.Size == 0 || fetch.BaseAddress == 0)
+    return nullptr;
+  GuestBufferKey key{};
+  key.guestBase = fetch.BaseAddress << 2;
+  key.size = fetch.Size << 2;
+  key.endian = static_cast<eEndian>(fetch.Endian);
+  key.format = eGuestBufferFormat::Vertex32;
+  return bufferCache->GetOrUpload(key, eBufferType::Vertex);
+}
+
+std::shared_ptr<Buffer> Renderer::GetIndexBuffer(const Xe::XGPU::XeIndexBufferInfo &indexInfo) {
+  if (indexInfo.length == 0)
+    return nullptr;
+  GuestBufferKey key{};
+  key.guestBase = indexInfo.guestBase;
+  key.size = static_cast<u32>(indexInfo.length);
+  key.endian = indexInfo.endianness;
+  key.format = indexInfo.indexFormat == eIndexFormat::xeInt16 ? eGuestBufferFormat::Index16 : eGuestBufferFormat::Index32;
+  return bufferCache->GetOrUpload(key, eBufferType::Index);
+}
+
+void Renderer::BindVertexFetches(const Xe::XGPU::XeShader &shader) {
+  if (!shader.vertexShader)
+    return;
+  for (const auto &[fetchKey, location] : shader.vertexShader->attributeLocationMap) {
+    const auto buffer = vertexFetchBuffers.find(fetchKey.slot);
+    if (buffer == vertexFetchBuffers.end())
+      continue;
+    for (const auto *fetch : shader.vertexShader->vertexFetches) {
+      if (fetch->fetchSlot == fetchKey.slot && fetch->fetchOffset == fetchKey.offset &&
+        fetch->fetchStride == fetchKey.stride) {
+        // Attributes capture the buffer bound when they are specified
+        buffer->second->Bind();
+        VertexFetch(location, fetch->GetComponentCount(), fetch->isFloat, fetch->isNormalized,
+          fetch->fetchOffset * 4, fetch->fetchStride * 4);
+        break;
+      }
+    }
+  }
+}
+
+// Walks a vec4 dirty bitmap and calls func(first, count) for every coalesced run of set bits.
+// Runs separated by only a few clean vec4s are merged, a few extra bytes are cheaper than another upload.
+template <u64 N, typename F>
+static void ForEachDirtyRange(const u64 (&bitmap)[N], F &&func) {
+  constexpr u32 totalBits = N * 64;
+  constexpr u32 mergeGap = 4;
+  // Finds the next set (or clear) bit at or after from
+  auto nextBit = [&bitmap](u32 from, bool set) -> u32 {
+    while (from < totalBits) {
+      u64 block = set ? bitmap[from / 64] : ~bitmap[from / 64];
+      block &= ~0ull << (from % 64);
+      if (block)
+        return (from & ~63u) + std::countr_zero(block);
+      from = (from & ~63u) + 64;
+    }
+    return totalBits;
+  };
+  u32 first = nextBit(0, true);
+  while (first < totalBits) {
+    u32 end = nextBit(first, false);
+    u32 next = nextBit(end, true);
+    while (next < totalBits && next - end <= mergeGap) {
+      end = nextBit(next, false);
+      next = nextBit(end, true);
     }
+    func(first, end - first);
+    first = next;
   }
+}
 
-  // Upload float constants
+void Renderer::UpdateConstants(Xe::XGPU::XenosState *state) {
+  XeShaderFloatConsts &floatConsts = state->floatConsts;
+  XeShaderBoolConsts &boolConsts = state->boolConsts;
+
+  // Vertex shader constants, the register file already holds the raw float bits
   {
-    RenderCommand cmd{};
-    cmd.type = RenderCommandType::UploadBuffer;
-    cmd.payload = RenderCommand::UploadBufferCmd{
-      "FloatConsts"_j,
-      std::vector<u8>(
-        reinterpret_cast<u8*>(floatConsts.values),
-        reinterpret_cast<u8*>(floatConsts.values) + sizeof(floatConsts.values)
-      ),
-      eBufferType::Storage,
-      eBufferUsage::DynamicDraw
-    };
-
-    std::lock_guard<std::mutex> lock(renderQueueMutex);
-    renderQueue.push(std::move(cmd));
+    u64 dirty[Xe::XGPU::XenosState::FloatConstDirtyBlocks] = {};
+    state->ConsumeFloatConstDirty(dirty);
+    const u8 *regPtr = state->GetRegisterPointer(XeRegister::SHADER_CONSTANT_000_X);
+    auto &buffer = createdBuffers["FloatConsts"_j];
+    if (!buffer) {
+      std::memcpy(floatConsts.values, regPtr, sizeof(floatConsts.values));
+      UploadBuffer("FloatConsts"_j, floatConsts.values, sizeof(floatConsts.values), eBufferType::Storage, eBufferUsage::DynamicDraw);
+    } else {
+      // Only convert and upload what was touched
+      ForEachDirtyRange(dirty, [&](u32 firstVec4, u32 vec4Count) {
+        const u64 offset = static_cast<u64>(firstVec4) * 4 * sizeof(f32);
+        const u64 size = static_cast<u64>(vec4Count) * 4 * sizeof(f32);
+        u8 *dest = reinterpret_cast<u8 *>(floatConsts.values) + offset;
+        std::memcpy(dest, regPtr + offset, size);
+        buffer->UpdateBuffer(offset, size, dest);
+      });
+    }
   }
 
-  // Upload bool constants
+  // Boolean shader constants
   {
-    RenderCommand cmd{};
-    cmd.type = RenderCommandType::UploadBuffer;
-    cmd.payload = RenderCommand::UploadBufferCmd{
-      "CommonBoolConsts"_j,
-      std::vector<u8>(
-        reinterpret_cast<u8*>(boolConsts.values),
-        reinterpret_cast<u8*>(boolConsts.values) + sizeof(boolConsts.values)
-      ),
-      eBufferType::Storage,
-      eBufferUsage::DynamicDraw
-    };
-
-    std::lock_guard<std::mutex> lock(renderQueueMutex);
-    renderQueue.push(std::move(cmd));
+    // SHADER_CONSTANT_BOOL_000_031 - SHADER_CONSTANT_BOOL_224_255
+    constexpr u64 boolConstSize = sizeof(u32) * 8;
+    const bool dirty = state->ConsumeBoolConstDirty();
+    auto &buffer = createdBuffers["CommonBoolConsts"_j];
+    if (dirty || !buffer) {
+      const u8 *ptr = state->GetRegisterPointer(XeRegister::SHADER_CONSTANT_BOOL_000_031);
+      std::memcpy(boolConsts.values, ptr, boolConstSize);
+      if (!buffer)
+        UploadBuffer("CommonBoolConsts"_j, boolConsts.values, sizeof(boolConsts.values), eBufferType::Storage, eBufferUsage::DynamicDraw);
+      else
+        buffer->UpdateBuffer(0, boolConstSize, boolConsts.values);
+    }
   }
 }
 
@@ -280,6 +380,7 @@ bool Renderer::IssueCopy(Xe::XGPU::XenosState *state) {
   const u32 destHeight = state->copyDestPitch.copyDestHeight;
 
   Xe::XGPU::XeShader *shader = activeShader;
+  vertexFetchBuffers.clear();
   if (shader && shader->vertexShader) {
     for (const auto *fetch : shader->vertexShader->vertexFetches) {
       u32 fetchSlot = fetch->fetchSlot;
@@ -292,39 +393,13 @@ bool Renderer::IssueCopy(Xe::XGPU::XenosState *state) {
       if (fetchData.Size == 0 || fetchData.BaseAddress == 0)
         continue;
 
-      u32 byteAddress = fetchData.BaseAddress << 2;
-      u32 byteSize = fetchData.Size << 2;
-
-      u8 *data = ramPointer->GetPointerToAddress(byteAddress);
-      if (!data) {
-        LOG_WARNING(Xenos, "VertexFetch: Invalid memory for slot {} (addr=0x{:X})", fetchSlot, byteAddress);
+      // Only re-uploaded when the guest touched the backing pages
+      std::shared_ptr<Buffer> buffer = GetVertexBuffer(fetchData);
+      if (!buffer) {
+        LOG_WARNING(Xenos, "VertexFetch: Invalid memory for slot {} (addr=0x{:X})", fetchSlot, fetchData.BaseAddress << 2);
         continue;
       }
-
-      const u64 wordCount = fetchData.Size;
-      std::vector<u32> rawWords(wordCount);
-      memcpy(rawWords.data(), data, wordCount * sizeof(u32));
-
-      std::vector<u8> uploadBytes(wordCount * 4);
-      for (u64 i = 0; i != wordCount; ++i) {
-        u32 w = rawWords[i];
-        ::memcpy(&uploadBytes[i * 4], &w, 4);
-      }
-
-      RenderCommand cmd{};
-      cmd.type = RenderCommandType::UploadBuffer;
-      cmd.payload = RenderCommand::UploadBufferCmd{
-        "VertexFetch"_j,          // or some hash based on slot/address if you want reuse
-        std::move(uploadBytes),
-        eBufferType::Vertex,
-        eBufferUsage::StaticDraw
-      };
-
-      {
-        std::lock_guard<std::mutex> lock(renderQueueMutex);
-        renderQueue.push(std::move(cmd));
-      }
-      LOG_INFO(Xenos, "Uploaded vertex fetch buffer: slot={}, addr=0x{:X}, size={} bytes", fetchSlot, byteAddress, byteSize);
+      vertexFetchBuffers[fetchSlot] = buffer;
     }
   }
   // Clear
@@ -436,46 +511,13 @@ Xe::XGPU::XeShader *Renderer::GetOrCreateShader(u32 vsHash, u32 psHash) {
         // Vertex shader texture fetches skipped for now
         continue;
       } else if (fetchData.Vertex[0].Type == Xe::eConstType::Vertex) {
-        u32 fetchAddress = fetchData.Vertex[0].BaseAddress << 2;
-        u32 fetchSize    = fetchData.Vertex[0].Size        << 2;
-
-        u8 *data = ramPointer->GetPointerToAddress(fetchAddress);
-        if (!data) {
+        std::shared_ptr<Buffer> buffer = GetVertexBuffer(fetchData.Vertex[0]);
+        if (!buffer) {
           LOG_WARNING(Xenos, "VertexFetch: Invalid memory for slot {} (addr=0x{:X})",
-                      fetchSlot, fetchAddress);
+                      fetchSlot, fetchData.Vertex[0].BaseAddress << 2);
           continue;
         }
 
-        const u64 wordCount = fetchSize / 4;
-        std::vector<u32> rawWords(wordCount);
-        memcpy(rawWords.data(), data, wordCount * sizeof(u32));
-
-        std::vector<f32> dataVec;
-        dataVec.resize(wordCount);
-        for (u64 i = 0; i != wordCount; ++i) {
-          dataVec[i] = std::bit_cast<f32, u32>(rawWords[i]);
-        }
-
-        u64 bufferKey = (static_cast<u64>(fetchAddress) << 32) | fetchSize;
-
-        std::shared_ptr<Buffer> buffer = nullptr;
-        auto it = createdBuffers.find(bufferKey);
-        if (it != createdBuffers.end()) {
-          buffer = it->second;
-          if (buffer->GetSize() < fetchSize) {
-            buffer->DestroyBuffer();
-            buffer->CreateBuffer(static_cast<u32>(fetchSize), dataVec.data(),
-                                 Render::eBufferUsage::StaticDraw, Render::eBufferType::Vertex);
-          } else {
-            buffer->UpdateBuffer(0, static_cast<u32>(fetchSize), dataVec.data());
-          }
-        } else {
-          buffer = resourceFactory->CreateBuffer();
-          buffer->CreateBuffer(static_cast<u32>(fetchSize), dataVec.data(),
-                               Render::eBufferUsage::StaticDraw, Render::eBufferType::Vertex);
-          createdBuffers.insert({ bufferKey, buffer });
-        }
-
         // Bind the buffer to the current VAO
         buffer->Bind();
 
@@ -544,16 +586,10 @@ void Renderer::Thread() {
       }
     }
 
-    std::vector<RenderCommand> frameCommands;
-    {
-      std::lock_guard<std::mutex> lock(renderQueueMutex);
-      while (!renderQueue.empty()) {
-        frameCommands.push_back(std::move(renderQueue.front()));
-        renderQueue.pop();
-      }
-    }
-
-    for (auto &cmd : frameCommands) {
+    // Drain the command ring. Bounded so a busy CP can't starve presentation
+    u64 retireMark = 0;
+    RenderCommand cmd{};
+    for (u64 processed = 0; processed != RENDER_QUEUE_SIZE && renderQueue.TryPop(cmd); ++processed) {
       switch (cmd.type) {
         case RenderCommandType::BindShader: {
           auto &c = std::get<RenderCommand::BindShaderCmd>(cmd.payload);
@@ -563,14 +599,8 @@ void Renderer::Thread() {
 
         case RenderCommandType::UploadBuffer: {
           auto &c = std::get<RenderCommand::UploadBufferCmd>(cmd.payload);
-
-          auto &buffer = createdBuffers[c.bufferHash];
-          if (!buffer) {
-            buffer = resourceFactory->CreateBuffer();
-            buffer->CreateBuffer(c.data.size(), c.data.data(), c.usage, c.type);
-          } else {
-            buffer->UpdateBuffer(0, c.data.size(), c.data.data());
-          }
+          UploadBuffer(c.bufferHash, c.data, c.size, c.type, c.usage);
+          retireMark = c.arenaMark;
           break;
         }
 
@@ -601,8 +631,10 @@ void Renderer::Thread() {
 
         case RenderCommandType::DrawIndexed: {
           auto &c = std::get<RenderCommand::DrawIndexedCmd>(cmd.payload);
-          if (activeShader && activeShader->program)
+          if (activeShader && activeShader->program) {
+            activeIndexBuffer = GetIndexBuffer(c.indexInfo);
             DrawIndexed(*activeShader, c.params, c.indexInfo);
+          }
           break;
         }
 
@@ -613,14 +645,9 @@ void Renderer::Thread() {
       }
     }
 
-    if (waiting) {
-      waiting = false;
-      if (waitTime >= 0x100) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(waitTime / 0x100));
-      } else {
-        std::this_thread::yield();
-      }
-    }
+    // Frame is done with its payloads, hand the arena space back to the CP
+    if (retireMark)
+      uploadArena.Retire(retireMark);
 
     // Render the GUI
     if (gui.get() && !focusLost) {
@@ -5,7 +5,6 @@
 #pragma once
 
 #include <fstream>
-#include <queue>
 #include <thread>
 #include <unordered_map>
 #include <variant>
@@ -17,6 +16,7 @@
 #include <backends/imgui_impl_sdl3.h>
 #endif
 
+#include "Base/BoundedQueue.h"
 #include "Base/Hash.h"
 #include "Base/Types.h"
 
@@ -27,11 +27,17 @@
 #include "Core/XGPU/ShaderConstants.h"
 #include "Render/Abstractions/Factory/ResourceFactory.h"
 #include "Render/Abstractions/Factory/ShaderFactory.h"
+#include "Render/Abstractions/GuestBufferCache.h"
+#include "Render/Abstractions/UploadArena.h"
 
 #ifndef NO_GFX
 // ARGB (Console is BGRA)
 #define COLOR(r, g, b, a) ((a) << 24 | (r) << 16 | (g) << 8 | (b) << 0)
 #define TILE(x) ((x + 31) >> 5) << 5
+// Render command ring size (in commands)
+#define RENDER_QUEUE_SIZE 0x4000
+// Upload arena size, shared by all in-flight command payloads
+#define RENDER_UPLOAD_ARENA_SIZE 16_MiB
 namespace Render {
 
 class GUI;
@@ -59,7 +65,11 @@ struct RenderCommand {
 
   struct UploadBufferCmd {
     u32 bufferHash;
-    std::vector<u8> data;
+    // Points into the upload arena, valid until the frame is retired
+    const u8 *data;
+    u64 size;
+    // Arena offset to retire once this command has been processed
+    u64 arenaMark;
     eBufferType type;
     eBufferUsage usage;
   };
@@ -140,6 +150,23 @@ public:
   void Shutdown();
   void Resize(u32 x, u32 y);
 
+  // Queues a command for the render thread (CP thread only)
+  void SubmitCommand(RenderCommand &&cmd);
+
+  // Allocates payload storage in the upload arena (CP thread only), nullptr for an empty upload
+  u8 *AllocateUpload(u64 size, u64 &arenaMark);
+
+  // Creates or updates a buffer (render thread only)
+  void UploadBuffer(u32 bufferHash, const void *data, u64 size, eBufferType type, eBufferUsage usage);
+
+  // Fetches the host copy of a vertex fetch constant's guest buffer (render thread only)
+  std::shared_ptr<Buffer> GetVertexBuffer(const Xe::VertexFetchConstant &fetch);
+  // Binds the vertex buffer of every fetch slot the shader reads and points its attributes at it
+  void BindVertexFetches(const Xe::XGPU::XeShader &shader);
+
+  // Fetches the host copy of a draw's guest index buffer (render thread only)
+  std::shared_ptr<Buffer> GetIndexBuffer(const Xe::XGPU::XeIndexBufferInfo &indexInfo);
+
   void UpdateConstants(Xe::XGPU::XenosState *state);
 
   bool IssueCopy(Xe::XGPU::XenosState *state);
@@ -182,9 +209,10 @@ public:
   // Backbuffer texture
   std::unique_ptr<Texture> backbuffer{};
 
-  // Command queue
-  std::mutex renderQueueMutex{};
-  std::queue<RenderCommand> renderQueue = {};
+  // Command queue, the CP thread is the only producer
+  Base::SPSCQueue<RenderCommand, RENDER_QUEUE_SIZE> renderQueue{};
+  // Storage for large command payloads
+  UploadArena uploadArena{ RENDER_UPLOAD_ARENA_SIZE };
 
   // GUI Helpers
   bool DebuggerActive();
@@ -192,6 +220,12 @@ public:
   void SetDebuggerActive(s8 specificPPU = -1);
 
   std::unordered_map<u64, std::shared_ptr<Buffer>> createdBuffers{};
+  // Host copies of guest vertex/index buffers
+  std::unique_ptr<GuestBufferCache> bufferCache{};
+  // Vertex buffer bound to every vertex fetch slot, by slot
+  std::unordered_map<u32, std::shared_ptr<Buffer>> vertexFetchBuffers{};
+  // Index buffer of the indexed draw being processed
+  std::shared_ptr<Buffer> activeIndexBuffer{};
 
   // Recompiled shaders
   std::mutex programLinkMutex{};
@@ -199,9 +233,6 @@ public:
   std::unordered_map<u32, std::pair<Xe::Microcode::AST::Shader *, std::vector<u32>>> pendingPixelShaders{};
   std::unordered_map<u64, Xe::XGPU::XeShader> linkedShaderPrograms{};
   Xe::XGPU::XeShader *activeShader = nullptr;
-  // Frame wait
-  std::atomic<bool> waiting = false;
-  std::atomic<u32> waitTime = 0;
   // Internal swap counter
   std::atomic<u32> swapCount;
 
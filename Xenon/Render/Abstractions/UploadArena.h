@@ -0,0 +1,67 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "Base/Types.h"
+
+#ifndef NO_GFX
+namespace Render {
+
+// Linear upload arena used for large render command payloads.
+// The CP thread (producer) bump-allocates payload storage, the render thread (consumer)
+// retires everything up to the last command it processed once the frame is done.
+// Offsets are monotonic byte counters, the physical position is (offset % capacity).
+class UploadArena {
+public:
+  explicit UploadArena(u64 arenaCapacity) :
+    capacity(arenaCapacity),
+    storage(std::make_unique<u8[]>(arenaCapacity))
+  {}
+
+  // Producer side. Reserves size bytes, returns nullptr if there is no room right now.
+  // endMark receives the value the consumer must retire to release this allocation.
+  u8 *TryAllocate(u64 size, u64 &endMark) {
+    // Keep allocations 16 byte aligned
+    size = (size + 15) & ~15ull;
+    if (size == 0 || size > capacity)
+      return nullptr;
+    u64 offset = head;
+    const u64 position = offset % capacity;
+    // Never split an allocation across the wrap point, skip the tail instead
+    if (position + size > capacity)
+      offset += capacity - position;
+    const u64 end = offset + size;
+    if (end - tail.load(std::memory_order_acquire) > capacity)
+      return nullptr;
+    head = end;
+    endMark = end;
+    return storage.get() + (offset % capacity);
+  }
+
+  // Consumer side. Releases every allocation up to (and including) endMark.
+  void Retire(u64 endMark) {
+    if (endMark > tail.load(std::memory_order_relaxed))
+      tail.store(endMark, std::memory_order_release);
+  }
+
+  // Upper bound of a single allocation
+  u64 Capacity() const { return capacity; }
+
+private:
+  // Arena size in bytes
+  const u64 capacity = 0;
+  // Backing storage
+  std::unique_ptr<u8[]> storage;
+  // Producer write offset, only touched by the producer
+  alignas(128) u64 head = 0;
+  // Consumer retire offset
+  alignas(128) std::atomic<u64> tail = 0;
+};
+
+} // namespace Render
+#endif
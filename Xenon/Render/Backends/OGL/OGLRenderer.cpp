@@ -205,9 +205,8 @@ void OGLRenderer::Draw(Xe::XGPU::XeShader shader, Xe::XGPU::XeDrawParams params)
     buffer->second->Bind(1);
   // Bind the VAO
   glBindVertexArray(VAO);
-  // Bind the VBO
-  if (auto buffer = createdBuffers.find("VertexFetch"_jLower); buffer != createdBuffers.end())
-    buffer->second->Bind();
+  // Bind the vertex buffers of every fetch slot
+  BindVertexFetches(shader);
   // Bind textures
   for (u32 i = 0; i != shader.textures.size(); ++i) {
     glActiveTexture(GL_TEXTURE0 + i);
@@ -238,12 +237,16 @@ void OGLRenderer::DrawIndexed(Xe::XGPU::XeShader shader, Xe::XGPU::XeDrawParams
     shader.program->Bind();
   // Bind the VAO
   glBindVertexArray(VAO);
-  // Bind the VBO
-  if (auto buffer = createdBuffers.find("VertexFetch"_jLower); buffer != createdBuffers.end())
-    buffer->second->Bind();
-  // Bind and upload index buffer (TODO: Fix this)
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferInfo.count, indexBufferInfo.elements, GL_STATIC_DRAW);
+  // Bind the vertex buffers of every fetch slot
+  BindVertexFetches(shader);
+  // Bind the index buffer, it only gets re-uploaded when the guest writes to it
+  if (activeIndexBuffer) {
+    activeIndexBuffer->Bind();
+  } else {
+    // Not backed by RAM, nothing sane to draw from
+    glBindVertexArray(0);
+    return;
+  }
   // Bind textures
   for (u32 i = 0; i != shader.textures.size(); ++i) {
     glActiveTexture(GL_TEXTURE0 + i);
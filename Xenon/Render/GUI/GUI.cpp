@@ -872,6 +872,8 @@ void SMCSettings(Render::GUI *gui) {
   gui->Tooltip("Decides which IP the UART netcat/socat implementation listens for");
   gui->InputInt("Socket Port", &Config::smc.socketPort);
   gui->Tooltip("Decides which port the UART netcat/socat implementation listens for");
+  Config::smc.uartFile = gui->InputText("UART File", Config::smc.uartFile);
+  gui->Tooltip("File the 'file' UART system writes to");
   gui->InputInt("Power On Reason", &Config::smc.powerOnReason);
   gui->Tooltip("17 is Power Button, 18 is Eject Button");
 }
@@ -19,13 +19,15 @@ void Render::OGLBuffer::CreateBuffer(u64 size, const void *data, eBufferUsage us
 }
 
 void Render::OGLBuffer::UpdateBuffer(u64 offset, u64 size, const void *data) {
-  if (size >= GetSize()) {
+  if (offset == 0 && size >= GetSize()) {
     CreateBuffer(size, data, ConvertGLUsage(GLUsage), ConvertGLBufferType(GLTarget));
-  } else {
-    SetSize(size);
+  } else if (offset + size <= GetSize()) {
+    // Partial update, keep the rest of the buffer intact
     glBindBuffer(GLTarget, BufferHandle);
     glBufferSubData(GLTarget, offset, size, data);
     glBindBuffer(GLTarget, 0);
+  } else {
+    LOG_ERROR(Render, "OGLBuffer::UpdateBuffer: Range {:#x}+{:#x} is outside of the buffer ({:#x})", offset, size, GetSize());
   }
 }
 
@@ -0,0 +1,223 @@
+/***************************************************************/
+/* Copyright 2025 Xenon Emulator Project. All rights reserved. */
+/***************************************************************/
+
+//
+// xenon-trace
+// Converts binary execution traces (see Core/XCPU/Trace/TraceFormat.h) to text, or queries them.
+// Filters combine, a record is printed when it passes all of them.
+//
+// Examples:
+//   xenon-trace -in xenon.xtrace -out trace.txt
+//   xenon-trace -in xenon.xtrace -stats
+//   xenon-trace -in xenon.xtrace -kind MMIOWrite -kind Post -thread 0
+//   xenon-trace -in xenon.xtrace -ea 0x7FEA1800 -limit 100
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+#include "Base/Hash.h"
+#include "Base/Logging/Backend.h"
+#include "Base/Param.h"
+#include "Core/XCPU/Interpreter/PPCInterpreter.h"
+#include "Core/XCPU/Trace/TraceReader.h"
+
+PARAM(help, "Prints this message", false);
+PARAM(in, "Trace to read, defaults to xenon.xtrace");
+PARAM(out, "Text output path, defaults to stdout");
+PARAM(stats, "Prints record counts and the hottest instruction addresses instead of the records", false);
+PARAM(kind, "Only prints these record kinds (Instr, GPR, MemRead, MemWrite, MMIORead, MMIOWrite, Exception, TLBFill, Post, JITBlock)");
+PARAM(thread, "Only prints records of these hardware threads (PIR 0-5)");
+PARAM(pc, "Only prints records of the instruction at this address (hex)");
+PARAM(from, "Only prints records of instructions at or above this address (hex)");
+PARAM(to, "Only prints records of instructions below this address (hex)");
+PARAM(ea, "Only prints accesses, MMIO and TLB fills covering this address (hex)");
+PARAM(limit, "Stops after printing this many records");
+
+namespace {
+
+  struct sFilter {
+    u32 kinds = ~0u;
+    u8 threads = 0xFF;
+    bool hasPC = false;
+    u64 pc = 0;
+    u64 from = 0;
+    u64 to = ~0ULL;
+    bool hasEA = false;
+    u64 ea = 0;
+
+    bool Matches(const Xe::XCPU::sTraceEvent &event) const {
+      using Xe::XCPU::eTraceRecord;
+      if (!(kinds & (1u << static_cast<u8>(event.type))) || !(threads & (1u << event.PIR))) {
+        return false;
+      }
+      if ((hasPC && event.CIA != pc) || event.CIA < from || event.CIA >= to) {
+        return false;
+      }
+      if (hasEA) {
+        switch (event.type) {
+        case eTraceRecord::MemRead:
+        case eTraceRecord::MemWrite:
+          return (ea >= event.address && ea < event.address + event.index) ||
+            (ea >= event.RA && ea < event.RA + event.index);
+        case eTraceRecord::MMIORead:
+        case eTraceRecord::MMIOWrite:
+          return ea >= event.address && ea < event.address + event.index;
+        case eTraceRecord::TLBFill:
+          return (ea & ~0xFFFULL) == (event.address & ~0xFFFULL) || (ea & ~0xFFFULL) == (event.RA & ~0xFFFULL);
+        default:
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  std::string formatEvent(const Xe::XCPU::sTraceEvent &event) {
+    using Xe::XCPU::eTraceRecord;
+    const std::string prefix = fmt::format("T{} {:016X}", event.PIR, event.CIA);
+    switch (event.type) {
+    case eTraceRecord::Instr:
+      return fmt::format("{}: 0x{:08X} {}", prefix, event.opcode, PPCInterpreter::PPCInterpreter_getFullName(event.opcode));
+    case eTraceRecord::GPR:
+      return fmt::format("{}:   r{} = 0x{:016X}", prefix, event.index, event.value);
+    case eTraceRecord::MemRead:
+    case eTraceRecord::MemWrite:
+      return fmt::format("{}:   {} {} bytes EA 0x{:X} RA 0x{:X}", prefix, event.type == eTraceRecord::MemRead ? "read" : "write",
+        event.index, event.address, event.RA);
+    case eTraceRecord::MMIORead:
+    case eTraceRecord::MMIOWrite:
+      return fmt::format("{}:   MMIO {} 0x{:X} ({} bytes) = 0x{:X}", prefix,
+        event.type == eTraceRecord::MMIORead ? "read" : "write", event.address, event.index, event.value);
+    case eTraceRecord::Exception:
+      return fmt::format("{}:   exceptions pending 0x{:04X}", prefix, event.opcode);
+    case eTraceRecord::TLBFill:
+      if (event.source == static_cast<u8>(Xe::XCPU::eTraceTLBSource::Software)) {
+        return fmt::format("{}:   TLB[{:X}:{}] VPN 0x{:X} -> RPN 0x{:X}", prefix, event.set, event.index, event.address, event.RA);
+      }
+      return fmt::format("{}:   {}ERAT 0x{:X} -> 0x{:X}", prefix, event.set ? "I" : "D", event.address, event.RA);
+    case eTraceRecord::Post:
+      return fmt::format("{}:   POST 0x{:X}", prefix, event.address);
+    case eTraceRecord::JITBlock:
+      return fmt::format("{}:   JIT block 0x{:X}, {} instructions", prefix, event.address, event.opcode);
+    default:
+      return fmt::format("{}:   {}", prefix, Xe::XCPU::GetTraceRecordName(event.type));
+    }
+  }
+
+} // anonymous namespace
+
+s32 main(s32 argc, char *argv[]) {
+  Base::Param::Init(argc, argv);
+  if (PARAM_help.Present()) {
+    ::Base::Param::Help();
+    return 0;
+  }
+
+  sFilter filter{};
+  if (PARAM_kind.Present()) {
+    filter.kinds = 0;
+    for (const std::string &kind : PARAM_kind.GetAll()) {
+      bool found = false;
+      for (u8 i = 0; i != static_cast<u8>(Xe::XCPU::eTraceRecord::Count); ++i) {
+        if (Base::JoaatStringHash(kind) == Base::JoaatStringHash(Xe::XCPU::GetTraceRecordName(static_cast<Xe::XCPU::eTraceRecord>(i)))) {
+          filter.kinds |= 1u << i;
+          found = true;
+        }
+      }
+      if (!found) {
+        fmt::print("Invalid record kind '{}'\n", kind);
+        return 1;
+      }
+    }
+  }
+  if (PARAM_thread.Present()) {
+    filter.threads = 0;
+    for (const std::string &thread : PARAM_thread.GetAll()) {
+      filter.threads |= 1u << std::clamp(std::atoi(thread.c_str()), 0, 5);
+    }
+  }
+  filter.hasPC = PARAM_pc.Present();
+  filter.pc = PARAM_pc.Get<u64>();
+  filter.from = PARAM_from.Get<u64>();
+  filter.to = PARAM_to.Present() ? PARAM_to.Get<u64>() : ~0ULL;
+  filter.hasEA = PARAM_ea.Present();
+  filter.ea = PARAM_ea.Get<u64>();
+  const u64 limit = PARAM_limit.Present() ? std::max<s64>(PARAM_limit.Get<s64>(), 0) : ~0ULL;
+
+  Base::Log::Initialize();
+  Base::Log::Start();
+
+  Xe::XCPU::TraceReader reader{};
+  if (!reader.Open(PARAM_in.Present() ? PARAM_in.Get() : "xenon.xtrace")) {
+    Base::Log::Stop();
+    return 1;
+  }
+
+  FILE *out = stdout;
+  if (PARAM_out.Present()) {
+    out = fopen(PARAM_out.Get().c_str(), "w");
+    if (!out) {
+      fmt::print("Unable to open '{}' for writing\n", PARAM_out.Get());
+      Base::Log::Stop();
+      return 1;
+    }
+  }
+
+  const bool stats = PARAM_stats.Present();
+  u64 printed = 0;
+  u64 counts[static_cast<u8>(Xe::XCPU::eTraceRecord::Count)] = {};
+  u64 threadInstrs[6] = {};
+  std::unordered_map<u64, u64> hotAddresses{};
+  const bool complete = reader.ForEach([&](const Xe::XCPU::sTraceEvent &event) {
+    if (!filter.Matches(event)) {
+      return true;
+    }
+    if (stats) {
+      counts[static_cast<u8>(event.type)]++;
+      if (event.type == Xe::XCPU::eTraceRecord::Instr) {
+        threadInstrs[event.PIR % 6]++;
+        hotAddresses[event.CIA]++;
+      } else if (event.type == Xe::XCPU::eTraceRecord::JITBlock) {
+        threadInstrs[event.PIR % 6] += event.opcode;
+      }
+      return true;
+    }
+    fmt::print(out, "{}\n", formatEvent(event));
+    return ++printed < limit;
+  });
+
+  if (stats) {
+    const auto &header = reader.GetHeader();
+    fmt::print(out, "Trace flags: {}{}\n", header.flags & Xe::XCPU::TraceFlag_GPR ? "GPR " : "",
+      header.flags & Xe::XCPU::TraceFlag_Memory ? "Memory" : "");
+    fmt::print(out, "Records:\n");
+    for (u8 i = 0; i != static_cast<u8>(Xe::XCPU::eTraceRecord::Count); ++i) {
+      if (counts[i]) {
+        fmt::print(out, "  {:<10} {}\n", Xe::XCPU::GetTraceRecordName(static_cast<Xe::XCPU::eTraceRecord>(i)), counts[i]);
+      }
+    }
+    fmt::print(out, "Instructions per hardware thread (JIT blocks included):\n");
+    for (u8 i = 0; i != 6; ++i) {
+      if (threadInstrs[i]) {
+        fmt::print(out, "  T{} {}\n", i, threadInstrs[i]);
+      }
+    }
+    std::vector<std::pair<u64, u64>> hottest(hotAddresses.begin(), hotAddresses.end());
+    const size_t top = std::min<size_t>(hottest.size(), 20);
+    std::partial_sort(hottest.begin(), hottest.begin() + top, hottest.end(),
+      [](const auto &a, const auto &b) { return a.second > b.second; });
+    fmt::print(out, "Hottest interpreted addresses:\n");
+    for (size_t i = 0; i != top; ++i) {
+      fmt::print(out, "  {:016X} {}\n", hottest[i].first, hottest[i].second);
+    }
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  Base::Log::Stop();
+  return complete ? 0 : 1;
+}